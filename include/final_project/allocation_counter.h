@@ -0,0 +1,34 @@
+/**
+ * @file allocation_counter.h
+ * @brief Per-thread count of the heap allocations, to check that the hot path of the mission allocates nothing.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_ALLOCATION_COUNTER_H
+#define FINAL_PROJECT_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+namespace final_project {
+
+/**
+ * @brief Method to check if the heap allocations are counted.
+ *
+ * They are in the builds defining FINAL_PROJECT_COUNT_ALLOCATIONS, the Debug builds of the package, which replace
+ * the global operator new and delete of the process with counting ones.
+ */
+bool allocations_counted();
+
+/**
+ * @brief Method to get the number of heap allocations made by the calling thread so far, wait-free.
+ *
+ * @return std::uint64_t Number of allocations, always 0 if allocations_counted() is false.
+ */
+std::uint64_t thread_allocations();
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_ALLOCATION_COUNTER_H
@@ -0,0 +1,81 @@
+/**
+ * @file bench_report.h
+ * @brief Results of the benchmark trials, written as CSV and JSON.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_BENCH_REPORT_H
+#define FINAL_PROJECT_BENCH_REPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Struct holding the outcome of one benchmark trial.
+ *
+ */
+struct BenchTrial {
+  // Member 'trial' contains the index of the trial.
+  int trial = 0;
+  // Member 'seed' contains the seed the marker placements were drawn from.
+  std::uint32_t seed = 0;
+  // Member 'mode' contains the ~mission_mode the trial ran in.
+  std::string mode;
+  // Member 'completed' is raised if the follower got back home before the trial timeout.
+  bool completed = false;
+  // Member 'mission_time' contains the time from the end of the startup to the end of the mission, in seconds.
+  double mission_time = 0;
+  // Member 'target_times' contains the time each lookup target got its marker, -1 if never, in seconds.
+  std::vector<double> target_times;
+  // Member 'markers' contains the number of markers localized.
+  std::size_t markers = 0;
+  // Members 'explorer_distance' and 'follower_distance' contain the distance driven by each role, in meters.
+  double explorer_distance = 0;
+  double follower_distance = 0;
+  // Members 'tf_failures' and 'tf_time_lost' contain the failed map->camera lookups and the time they took.
+  std::uint64_t tf_failures = 0;
+  double tf_time_lost = 0;
+  // Member 'rotation_time' contains the total time spent rotating at the targets, in seconds.
+  double rotation_time = 0;
+};
+
+/**
+ * @brief Method to write one CSV row per trial, the target times joined by ';' in a single column.
+ *
+ * @param path File to write, replaced if it exists.
+ * @param trials Trials to write.
+ * @return true if the file was written.
+ * @return false otherwise.
+ */
+bool write_bench_csv(const std::string &path, const std::vector<BenchTrial> &trials);
+
+/**
+ * @brief Method to write the trials as a JSON array of objects, with the same fields as the CSV.
+ *
+ * @param path File to write, replaced if it exists.
+ * @param trials Trials to write.
+ * @return true if the file was written.
+ * @return false otherwise.
+ */
+bool write_bench_json(const std::string &path, const std::vector<BenchTrial> &trials);
+
+/**
+ * @brief Method to read back the trials of a CSV written by write_bench_csv().
+ *
+ * @param path File to read.
+ * @param trials Receives the trials of the file.
+ * @return true if the file was read, every row of it.
+ * @return false otherwise, 'trials' then holds the rows before the first bad one.
+ */
+bool read_bench_csv(const std::string &path, std::vector<BenchTrial> &trials);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_BENCH_REPORT_H
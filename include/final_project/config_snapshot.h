@@ -0,0 +1,126 @@
+/**
+ * @file config_snapshot.h
+ * @brief Immutable snapshots of a configuration, swapped atomically so that readers never take a lock.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_CONFIG_SNAPSHOT_H
+#define FINAL_PROJECT_CONFIG_SNAPSHOT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Class holding the current version of a configuration, read from any thread without a lock.
+ *
+ * Every publish() copies the configuration into a new immutable snapshot and swaps the current pointer to it.
+ * A reader loads the pointer once and keeps a consistent configuration while it works on it. The snapshots
+ * replaced since are freed by reclaim(), at a quiescent point where no reader holds a reference, e.g. between two
+ * missions, and by the destructor. At most 'max_retired' replaced snapshots are held in between, publish() frees
+ * the oldest beyond that, so a reader must not hold a configuration across more publish() calls than that. The
+ * mission reads the tuning within one stage and dynamic_reconfigure publishes once per update, a slider dragged
+ * through a long mission costs at most 'max_retired' + 1 snapshots.
+ *
+ * @tparam T Type of the configuration, must be copy constructible.
+ */
+template <typename T>
+class ConfigSnapshot {
+ public:
+  /**
+   * @brief Construct a new Config Snapshot object.
+   *
+   * @param initial First configuration.
+   * @param max_retired Most replaced snapshots held until reclaim(), at least one.
+   */
+  explicit ConfigSnapshot(const T &initial = T(), std::size_t max_retired = 64)
+      : max_retired_(std::max<std::size_t>(max_retired, 1)) {
+    publish(initial);
+  }
+  ConfigSnapshot(const ConfigSnapshot &) = delete;
+  ConfigSnapshot &operator=(const ConfigSnapshot &) = delete;
+
+  /**
+   * @brief Method to get the current configuration, wait-free.
+   */
+  const T &get() const { return current_.load(std::memory_order_acquire)->value; }
+
+  /**
+   * @brief Method to get the current configuration and its version, wait-free.
+   *
+   * @param version Receives the version of the configuration, it grows by one on every publish().
+   */
+  const T &get(std::uint64_t &version) const {
+    const Snapshot *snapshot = current_.load(std::memory_order_acquire);
+    version = snapshot->version;
+    return snapshot->value;
+  }
+
+  /**
+   * @brief Method to make a configuration the current one, from any thread.
+   *
+   * @param value Configuration to copy.
+   * @return std::uint64_t Version of the new configuration.
+   */
+  std::uint64_t publish(const T &value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::uint64_t version = snapshots_.empty() ? 1 : snapshots_.back()->version + 1;
+    snapshots_.emplace_back(new Snapshot{version, value});
+    current_.store(snapshots_.back().get(), std::memory_order_release);
+    if (snapshots_.size() > max_retired_ + 1) {
+      // The oldest was replaced 'max_retired_' publish() calls ago, no reader holds it any more.
+      snapshots_.erase(snapshots_.begin());
+    }
+    return version;
+  }
+
+  /**
+   * @brief Method to free every snapshot but the current one.
+   *
+   * Only safe at a quiescent point: no reader may still hold a configuration it got before the call. Writers may
+   * publish concurrently.
+   */
+  void reclaim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Snapshot *current = current_.load(std::memory_order_relaxed);
+    snapshots_.erase(std::remove_if(snapshots_.begin(), snapshots_.end(),
+                                    [current](const std::unique_ptr<const Snapshot> &snapshot) {
+                                      return snapshot.get() != current;
+                                    }),
+                     snapshots_.end());
+  }
+
+  /**
+   * @brief Method to get the number of snapshots held, the current one included.
+   */
+  std::size_t held() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshots_.size();
+  }
+
+ private:
+  struct Snapshot {
+    std::uint64_t version;
+    const T value;
+  };
+
+  std::atomic<const Snapshot *> current_{nullptr};
+  // Member 'max_retired_' contains the most replaced snapshots held.
+  const std::size_t max_retired_;
+  // Member 'mutex_' orders the writers only, the readers never take it.
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<const Snapshot>> snapshots_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_CONFIG_SNAPSHOT_H
@@ -0,0 +1,93 @@
+/**
+ * @file detector_gate.h
+ * @brief Turns the marker detector of an explorer on and off, and hides the markers already localized from it.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_DETECTOR_GATE_H
+#define FINAL_PROJECT_DETECTOR_GATE_H
+
+#include <ros/ros.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Class driving the control surface of an aruco_detect node.
+ *
+ * aruco_detect stops processing images while its 'enable_detections' service (std_srvs/SetBool) is false,
+ * and skips the fiducials listed on its 'ignore_fiducials' topic (std_msgs/String). The service is called
+ * from a worker thread, so the mission never waits on it; only the latest requested state is applied.
+ */
+class DetectorGate {
+ public:
+  /**
+   * @brief Construct a new Detector Gate object.
+   *
+   * @param nh Nodehandle the service client and the publisher are created on.
+   * @param detector Name of the aruco_detect node, e.g. "/aruco_detect".
+   */
+  DetectorGate(ros::NodeHandle &nh, const std::string &detector);
+
+  /**
+   * @brief Destroy the Detector Gate object, after applying the last requested state.
+   */
+  ~DetectorGate();
+
+  DetectorGate(const DetectorGate &) = delete;
+  DetectorGate &operator=(const DetectorGate &) = delete;
+
+  /**
+   * @brief Method to request the detector on or off. Never blocks.
+   *
+   * @param enabled The detector processes images.
+   */
+  void set_enabled(bool enabled);
+
+  /**
+   * @brief Method to make the detector skip a fiducial from now on. Never blocks.
+   *
+   * @param fiducial_id fiducial_id of the marker to skip.
+   */
+  void ignore(int fiducial_id);
+
+  /**
+   * @brief Method to format fiducial_ids the way the 'ignore_fiducials' parameter and topic expect them.
+   *
+   * @param ids fiducial_ids, in any order.
+   * @return std::string Comma separated ids, consecutive ids merged into ranges, e.g. "1,3-5".
+   */
+  static std::string ignore_list(std::vector<int> ids);
+
+ private:
+  void run();
+
+  // Member 'detector_' is the name of the aruco_detect node, for the log.
+  std::string detector_;
+  // Member 'enable_client_' calls the 'enable_detections' service of the detector.
+  ros::ServiceClient enable_client_;
+  // Member 'ignore_pub_' publishes the fiducials to skip, latched so a restarted detector gets them.
+  ros::Publisher ignore_pub_;
+  // Member 'mutex_' guards the members below.
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  // Member 'desired_' is the last requested state, 'applied_' the last one the detector accepted.
+  bool desired_ = true;
+  bool applied_ = true;
+  bool stop_ = false;
+  // Member 'ignored_' contains the fiducials the detector skips.
+  std::vector<int> ignored_;
+  std::thread worker_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_DETECTOR_GATE_H
@@ -0,0 +1,208 @@
+/**
+ * @file distance_field.h
+ * @brief Path lengths over the static map, precomputed from the known targets and cached on disk.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_DISTANCE_FIELD_H
+#define FINAL_PROJECT_DISTANCE_FIELD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Class holding the blocked cells of a map_server map, one bit per cell, row-major from the bottom row.
+ *
+ */
+class OccupancyBitmap {
+ public:
+  /**
+   * @brief Method to load a map in the map_server format, a YAML description and a PGM image.
+   *
+   * @param yaml_path Path of the YAML description.
+   * @param bitmap Receives the map, occupied and unknown cells are blocked.
+   * @param error Receives the reason of a failure, may be null.
+   * @return true if the map was loaded.
+   * @return false otherwise.
+   */
+  static bool load(const std::string &yaml_path, OccupancyBitmap &bitmap, std::string *error = nullptr);
+
+  /**
+   * @brief Method to block every cell closer than a radius to a blocked cell.
+   *
+   * @param radius Inflation radius, in meters.
+   */
+  void inflate(double radius);
+
+  /**
+   * @brief Method to check if a cell is blocked, cells outside the map are.
+   */
+  bool blocked(int col, int row) const {
+    if (col < 0 || row < 0 || col >= width_ || row >= height_) {
+      return true;
+    }
+    const std::size_t index = static_cast<std::size_t>(row) * width_ + col;
+    return (bits_[index >> 6] >> (index & 63)) & 1u;
+  }
+
+  /**
+   * @brief Method to set whether a cell is blocked.
+   */
+  void set_blocked(int col, int row, bool blocked);
+
+  /**
+   * @brief Method to get the cell holding a point of the map frame.
+   */
+  void cell(double x, double y, int &col, int &row) const;
+
+  /**
+   * @brief Method to get a 64-bit FNV-1a hash of the geometry and the blocked cells.
+   */
+  std::uint64_t checksum() const;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  double resolution() const { return resolution_; }
+  double origin_x() const { return origin_x_; }
+  double origin_y() const { return origin_y_; }
+
+ private:
+  int width_ = 0;
+  int height_ = 0;
+  double resolution_ = 0;
+  double origin_x_ = 0;
+  double origin_y_ = 0;
+  // Member 'bits_' holds one bit per cell, set when the cell is blocked.
+  std::vector<std::uint64_t> bits_;
+};
+
+/**
+ * @brief Class holding one distance field per known point, the path length from that point to every cell.
+ *
+ * The fields are computed with Dijkstra over the 8-connected free cells and written to a cache file
+ * that is memory-mapped, so later launches over the same map and points only map the file. Paths are
+ * symmetric, so a path with a source at either end is answered from the field of that source. Fields
+ * from other points are computed on demand, the most recently used few are kept in memory.
+ */
+class DistanceFieldCache {
+ public:
+  /**
+   * @brief Construct a new Distance Field Cache object.
+   *
+   * @param transient_fields Number of fields computed on demand kept in memory, at least one.
+   */
+  explicit DistanceFieldCache(std::size_t transient_fields = 4);
+  ~DistanceFieldCache();
+  DistanceFieldCache(const DistanceFieldCache &) = delete;
+  DistanceFieldCache &operator=(const DistanceFieldCache &) = delete;
+
+  /**
+   * @brief Method to map the cached fields, computing and writing them first if the cache is missing or stale.
+   *
+   * @param cache_path Path of the cache file.
+   * @param bitmap Map the paths go through, kept by reference.
+   * @param sources Points the fields are computed from.
+   * @param error Receives the reason of a failure, may be null.
+   * @return true if the fields are available, even if the cache could not be written.
+   * @return false otherwise.
+   */
+  bool open(const std::string &cache_path, const OccupancyBitmap &bitmap,
+            const std::vector<std::array<double, 2>> &sources, std::string *error = nullptr);
+
+  /**
+   * @brief Method to get the path length between two points of the map frame. A field is computed on demand only
+   * if neither point is a source.
+   *
+   * @return double Path length in meters, infinity if there is no path.
+   */
+  double path_length(double ax, double ay, double bx, double by);
+
+  /**
+   * @brief Method to get the shortest path between two points of the map frame, by descending the field of 'b'.
+   * The field is computed on demand unless 'b' is a source.
+   *
+   * @param waypoints Receives the centers of the cells along the path, from the cell next to 'a' to the cell of
+   * 'b', empty if there is no path.
+   * @return true if there is a path.
+   * @return false otherwise.
+   */
+  bool path(double ax, double ay, double bx, double by, std::vector<std::array<double, 2>> &waypoints);
+
+  /**
+   * @brief Method to get the path length from a source to a point of the map frame.
+   *
+   * @param source Index of the source in the list given to open().
+   * @return double Path length in meters, infinity if there is no path.
+   */
+  double distance(std::size_t source, double x, double y) const;
+
+  /**
+   * @brief Method to get the source closest to a point of the map frame, in a straight line.
+   *
+   * @return std::size_t Index of the source in the list given to open(), source_count() if there is none.
+   */
+  std::size_t nearest_source(double x, double y) const;
+
+  /**
+   * @brief Method to get a source as given to open().
+   *
+   * @param source Index of the source, below source_count().
+   */
+  const std::array<double, 2> &source(std::size_t source) const { return sources_[source]; }
+
+  /**
+   * @brief Method to check if the fields were mapped from an existing cache instead of computed.
+   */
+  bool loaded_from_cache() const { return loaded_from_cache_; }
+
+  std::size_t source_count() const { return source_count_; }
+
+ private:
+  /**
+   * @brief Struct holding a field computed on demand.
+   */
+  struct TransientField {
+    // Member 'cell' is the index of the cell the field is computed from.
+    std::size_t cell = 0;
+    // Member 'used' is the value of 'transient_clock_' when the field was last looked up.
+    std::uint64_t used = 0;
+    std::vector<float> field;
+  };
+
+  void close();
+  void compute_field(int col, int row, std::vector<float> &field) const;
+  float lookup(const float *field, double x, double y) const;
+  const float *source_field(double x, double y) const;
+  const float *field_from(double x, double y);
+
+  const OccupancyBitmap *bitmap_ = nullptr;
+  std::vector<std::array<double, 2>> sources_;
+  std::vector<std::array<int, 2>> source_cells_;
+  std::size_t source_count_ = 0;
+  std::size_t cells_ = 0;
+  // Members 'mapping_' and 'mapping_size_' describe the memory-mapped cache file.
+  void *mapping_ = nullptr;
+  std::size_t mapping_size_ = 0;
+  // Member 'fields_' points to the first field, in the mapping or in 'owned_'.
+  const float *fields_ = nullptr;
+  // Member 'owned_' holds the fields when the cache could not be mapped.
+  std::vector<float> owned_;
+  // Member 'transient_' holds the fields computed on demand, the least recently used one is computed over when a
+  // new point needs one and 'transient_capacity_' are held, so its memory is bounded and reused.
+  std::vector<TransientField> transient_;
+  std::size_t transient_capacity_;
+  std::uint64_t transient_clock_ = 0;
+  bool loaded_from_cache_ = false;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_DISTANCE_FIELD_H
@@ -0,0 +1,131 @@
+/**
+ * @file flat_index_map.h
+ * @brief Open-addressing hash map from an integer key to a dense index.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_FLAT_INDEX_MAP_H
+#define FINAL_PROJECT_FLAT_INDEX_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Maps integer keys such as fiducial ids to indices into a dense array.
+ *
+ * Keys and indices are stored side by side in one flat table probed linearly, so a lookup touches one or two
+ * cache lines whatever the key range. Entries are never erased, which is all a registry that only grows needs.
+ */
+class FlatIndexMap {
+ public:
+  /**
+   * @brief Method to get the index stored for a key.
+   *
+   * @param key Key to look up.
+   * @return int Index of the key, -1 if the key was never inserted.
+   */
+  int find(int key) const {
+    if (slots_.empty()) {
+      return -1;
+    }
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+      if (slots_[i].key == key) {
+        return slots_[i].index;
+      }
+      if (slots_[i].key == kEmpty) {
+        return -1;
+      }
+    }
+  }
+
+  /**
+   * @brief Method to store the index of a key, replacing the previous index of the key.
+   *
+   * @param key Key to insert, any value but the smallest int.
+   * @param index Index to store.
+   */
+  void insert(int key, int index) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+      grow();
+    }
+    Slot &slot = probe(key);
+    if (slot.key == kEmpty) {
+      slot.key = key;
+      size_++;
+    }
+    slot.index = index;
+  }
+
+  /**
+   * @brief Method to remove every key, the table is kept.
+   */
+  void clear() {
+    slots_.assign(slots_.size(), Slot());
+    size_ = 0;
+  }
+
+  /**
+   * @brief Method to make room for a number of keys, so inserting up to that many never allocates.
+   */
+  void reserve(std::size_t keys) {
+    while (keys * 2 > slots_.size()) {
+      grow();
+    }
+  }
+
+  /**
+   * @brief Method to get the number of keys.
+   */
+  std::size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    int key = kEmpty;
+    int index = -1;
+  };
+
+  static constexpr int kEmpty = std::numeric_limits<int>::min();
+
+  // Fibonacci hashing spreads consecutive ids over the table.
+  static std::size_t hash(int key) {
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(key)) *
+                                     UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+  }
+
+  Slot &probe(int key) {
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t i = hash(key) & mask;
+    while (slots_[i].key != key && slots_[i].key != kEmpty) {
+      i = (i + 1) & mask;
+    }
+    return slots_[i];
+  }
+
+  void grow() {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.assign(old.empty() ? 16 : old.size() * 2, Slot());
+    for (const Slot &slot : old) {
+      if (slot.key != kEmpty) {
+        probe(slot.key) = slot;
+      }
+    }
+  }
+
+  // Member 'slots_' is the probing table, its size is a power of two at most half full.
+  std::vector<Slot> slots_;
+  // Member 'size_' is the number of keys in the table.
+  std::size_t size_ = 0;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_FLAT_INDEX_MAP_H
@@ -0,0 +1,85 @@
+/**
+ * @file fleet.h
+ * @brief Description of the robots taking part in the mission.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_FLEET_H
+#define FINAL_PROJECT_FLEET_H
+
+#include <string>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Job of a robot in the mission.
+ *
+ */
+enum class RobotRole {
+  // The robot drives to the lookup targets and localizes the markers.
+  Explorer,
+  // The robot drives to the follower locations of the localized markers.
+  Follower
+};
+
+/**
+ * @brief Struct holding the names and home position of one robot.
+ *
+ */
+struct RobotSpec {
+  // Member 'name' is the namespace the robot is spawned in, e.g. "explorer".
+  std::string name;
+  // Member 'role' is the job of the robot.
+  RobotRole role = RobotRole::Explorer;
+  // Member 'move_base_action' is the move_base action server of the robot.
+  std::string move_base_action;
+  // Member 'planner' is the make_plan service of the move_base node of the robot.
+  std::string planner;
+  // Member 'cmd_vel' is the velocity command topic of the robot.
+  std::string cmd_vel;
+  // Member 'base_frame' is the base frame of the robot in the TF tree.
+  std::string base_frame;
+  // Member 'camera_frame' is the optical frame of the camera the markers are detected in.
+  std::string camera_frame;
+  // Member 'fiducial_topic' is the topic the marker detector of the camera publishes on.
+  std::string fiducial_topic;
+  // Member 'detector' is the aruco_detect node of the camera, switched off while its detections are not needed.
+  std::string detector;
+  // Member 'home_x' contains x-coordinate of the spawn position in map frame, the robot finishes there.
+  double home_x = 0;
+  // Member 'home_y' contains y-coordinate of the spawn position in map frame.
+  double home_y = 0;
+};
+
+/**
+ * @brief Method to describe a robot spawned by launch/single_robot.launch in the namespace 'name'.
+ *
+ * @param name Namespace of the robot, also the prefix of its tf_prefix and move_base node.
+ * @param role Job of the robot.
+ * @param home_x x-coordinate of the spawn position in map frame.
+ * @param home_y y-coordinate of the spawn position in map frame.
+ * @return RobotSpec The robot with the topic, service and frame names the launch files give it.
+ */
+RobotSpec make_robot_spec(const std::string &name, RobotRole role, double home_x, double home_y);
+
+/**
+ * @brief Method to get the fleet spawned by launch/multiple_robots.launch, one explorer and one follower.
+ */
+std::vector<RobotSpec> default_fleet();
+
+/**
+ * @brief Method to find the robots with a given role.
+ *
+ * @param fleet Robots of the mission.
+ * @param role Role to look for.
+ * @return std::vector<int> Indices of the robots in 'fleet', in fleet order.
+ */
+std::vector<int> robots_with_role(const std::vector<RobotSpec> &fleet, RobotRole role);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_FLEET_H
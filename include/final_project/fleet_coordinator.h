@@ -0,0 +1,149 @@
+/**
+ * @file fleet_coordinator.h
+ * @brief Per-robot task deques with work stealing between the robots of one role.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_FLEET_COORDINATOR_H
+#define FINAL_PROJECT_FLEET_COORDINATOR_H
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Hands out tasks at known locations to a group of robots.
+ *
+ * Every robot owns a deque of tasks it drives to in order. A robot whose deque runs dry steals the pending task
+ * of another robot that is cheapest to reach from where it stands, so no robot idles while work is left. Tasks
+ * finished by some other means, e.g. a marker localized in transit, are marked complete and skipped.
+ *
+ * The class is not thread-safe, the caller guards it.
+ */
+class FleetCoordinator {
+ public:
+  // Travel cost between two points in map frame.
+  using CostFunction = std::function<double(const std::array<double, 2> &, const std::array<double, 2> &)>;
+
+  /**
+   * @brief Construct a coordinator for 'robots' robots starting at the origin, using straight distances.
+   */
+  explicit FleetCoordinator(std::size_t robots = 0);
+
+  /**
+   * @brief Method to set the travel cost, the straight distance when it is empty.
+   */
+  void set_cost(CostFunction cost);
+
+  /**
+   * @brief Method to set where a robot is, the reference for its next steal.
+   */
+  void set_position(int robot, const std::array<double, 2> &position);
+
+  /**
+   * @brief Method to add a task, not yet queued for any robot.
+   *
+   * @return int Index of the task, the tasks are numbered in the order they are added.
+   */
+  int add_task(const std::array<double, 2> &location);
+
+  /**
+   * @brief Method to queue every task added so far and not queued yet.
+   *
+   * The robot with the least queued travel takes the unqueued task nearest to the end of its deque until none
+   * is left, which keeps each deque compact and the deques balanced.
+   */
+  void distribute();
+
+  /**
+   * @brief Method to queue one task for the robot that would reach it first, at the end of its deque.
+   *
+   * @param task Index of a task that is not queued.
+   * @return int Robot the task was queued for.
+   */
+  int assign(int task);
+
+  /**
+   * @brief Method to take the next task of a robot, stealing one when its own deque is empty.
+   *
+   * @param robot Robot asking for work.
+   * @param stolen Receives whether the task was stolen, may be null.
+   * @return int Index of the task, -1 when no task is pending anywhere.
+   */
+  int next(int robot, bool *stolen = nullptr);
+
+  /**
+   * @brief Method to hand a task a robot took back, at the end of the deque of the robot.
+   *
+   * The other robots may steal it from there. Used for a task the robot could not reach, to try it again last.
+   *
+   * @param robot Robot that took the task.
+   * @param task Index of the task, taken by the robot and not complete.
+   */
+  void defer(int robot, int task);
+
+  /**
+   * @brief Method to mark a task complete, it is skipped if it is still queued.
+   */
+  void complete(int task);
+
+  /**
+   * @brief Method to check if a task is complete.
+   */
+  bool completed(int task) const { return completed_[task]; }
+
+  /**
+   * @brief Method to get the location of a task.
+   */
+  const std::array<double, 2> &location(int task) const { return locations_[task]; }
+
+  /**
+   * @brief Method to get the number of tasks neither complete nor handed to a robot.
+   */
+  std::size_t pending() const;
+
+  /**
+   * @brief Method to get the number of tasks added.
+   */
+  std::size_t task_count() const { return locations_.size(); }
+
+  /**
+   * @brief Method to get the number of robots.
+   */
+  std::size_t robot_count() const { return queues_.size(); }
+
+  /**
+   * @brief Method to get the number of tasks taken from another robot's deque.
+   */
+  std::size_t steals() const { return steals_; }
+
+ private:
+  double cost(const std::array<double, 2> &from, const std::array<double, 2> &to) const;
+  // Travel of a robot through its queued tasks, from its position.
+  double queued_cost(int robot) const;
+  // Location a new task of the robot is reached from, the last queued task or its position.
+  const std::array<double, 2> &tail(int robot) const;
+
+  CostFunction cost_;
+  // Member 'queues_' holds the queued tasks of each robot, front first.
+  std::vector<std::deque<int>> queues_;
+  // Member 'positions_' holds where each robot was last seen or sent.
+  std::vector<std::array<double, 2>> positions_;
+  // The members below are indexed by task.
+  std::vector<std::array<double, 2>> locations_;
+  std::vector<bool> queued_;
+  std::vector<bool> taken_;
+  std::vector<bool> completed_;
+  std::size_t steals_ = 0;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_FLEET_COORDINATOR_H
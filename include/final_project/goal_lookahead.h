@@ -0,0 +1,76 @@
+/**
+ * @file goal_lookahead.h
+ * @brief Decides when a robot is close enough to its goal to be sent the next one without stopping.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_GOAL_LOOKAHEAD_H
+#define FINAL_PROJECT_GOAL_LOOKAHEAD_H
+
+namespace final_project {
+
+/**
+ * @brief Class watching the move_base feedback of one robot against its current goal.
+ *
+ * move_base slows down to a stop at every goal it reaches. A goal the robot only drives through is counted as
+ * reached once the robot is within the lookahead radius of it, so the next goal preempts it at speed. Goals the
+ * robot has to stop at, e.g. to rotate there or at the end of its route, hold until move_base reaches them.
+ * The class is not thread-safe, the caller guards it.
+ */
+class GoalLookahead {
+ public:
+  /**
+   * @brief Construct a new Goal Lookahead object.
+   *
+   * @param radius Distance to the goal, in meters, the next goal is sent at. 0 disables the lookahead.
+   */
+  explicit GoalLookahead(double radius = 0.0) : radius_(radius) {}
+
+  /**
+   * @brief Method to watch a new goal, replacing the current one.
+   *
+   * @param x Goal in the map frame.
+   * @param y Goal in the map frame.
+   * @param hold The robot has to stop at the goal, it is never passed.
+   */
+  void arm(double x, double y, bool hold);
+
+  /**
+   * @brief Method to stop watching the current goal, once it is reached or passed.
+   */
+  void disarm() { armed_ = false; }
+
+  /**
+   * @brief Method to check if the robot may be sent its next goal from where it is.
+   *
+   * @param x Position of the robot from the move_base feedback, in the map frame.
+   * @param y Position of the robot from the move_base feedback, in the map frame.
+   * @return true if the current goal does not hold and the robot is within the radius of it.
+   * @return false otherwise.
+   */
+  bool passed(double x, double y) const;
+
+  /**
+   * @brief Method to get the lookahead radius, in meters.
+   */
+  double radius() const { return radius_; }
+
+  /**
+   * @brief Method to change the lookahead radius, for the next arm().
+   */
+  void set_radius(double radius) { radius_ = radius; }
+
+ private:
+  double radius_;
+  double x_ = 0;
+  double y_ = 0;
+  bool hold_ = true;
+  bool armed_ = false;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_GOAL_LOOKAHEAD_H
@@ -0,0 +1,137 @@
+/**
+ * @file goal_refiner.h
+ * @brief Moves a follower goal to a free, reachable spot of the costmap near it, facing its marker.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_GOAL_REFINER_H
+#define FINAL_PROJECT_GOAL_REFINER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Struct holding a refined follower goal.
+ *
+ */
+struct RefinedGoal {
+  // Members 'x', 'y' and 'yaw' contain the goal in the map frame, the yaw looks at the marker.
+  double x = 0;
+  double y = 0;
+  double yaw = 0;
+  // Member 'cost' contains the costmap cost of the goal cell, 0 to 100, -1 if it is not known.
+  int cost = -1;
+  // Member 'moved' is raised if the goal is not the nominal one.
+  bool moved = false;
+};
+
+/**
+ * @brief Class keeping the last costmap of a follower and searching it for a better goal near the nominal one.
+ *
+ * The nominal goal sits a fixed distance in front of the marker, often in the inflation of the wall the marker
+ * hangs on, where move_base plans a long way round or aborts. The search floods out from the nominal cell over
+ * the cells the robot may drive through, within a radius, and keeps the cell of lowest distance plus weighted
+ * cost that is cheap enough, within camera range of the marker and sees it. Costs are those of a published
+ * nav_msgs/OccupancyGrid, 0 to 100, unknown cells are -1 and never chosen. The snapshot is guarded, the
+ * costmap may be replaced while goals are refined from other threads.
+ */
+class GoalRefiner {
+ public:
+  /**
+   * @brief Struct holding the tuning of the search.
+   *
+   */
+  struct Params {
+    // Member 'search_radius' bounds the distance from the nominal goal a cell is looked for at, in meters.
+    double search_radius = 0.5;
+    // Member 'max_cost' is the highest cost a goal may have. Dearer cells are only driven through.
+    int max_cost = 50;
+    // Member 'lethal_cost' is the lowest cost the robot cannot stand on, 99 is the inscribed cost of costmap_2d.
+    int lethal_cost = 99;
+    // Member 'cost_weight' trades cost against distance to the nominal goal, in meters per unit of cost.
+    double cost_weight = 0.005;
+    // Members 'min_marker_distance' and 'max_marker_distance' bound the distance of the goal to the marker.
+    double min_marker_distance = 0.25;
+    double max_marker_distance = 1.0;
+  };
+
+  GoalRefiner() = default;
+  explicit GoalRefiner(const Params &params) : params_(params) {}
+  GoalRefiner(const GoalRefiner &) = delete;
+  GoalRefiner &operator=(const GoalRefiner &) = delete;
+
+  /**
+   * @brief Method to replace the costmap.
+   *
+   * @param width Number of columns.
+   * @param height Number of rows.
+   * @param resolution Size of a cell, in meters.
+   * @param origin_x Map-frame position of the corner of cell 0,0.
+   * @param origin_y Map-frame position of the corner of cell 0,0.
+   * @param data Costs, row-major from the bottom row, width * height of them.
+   */
+  void set_costmap(int width, int height, double resolution, double origin_x, double origin_y,
+                   const std::vector<std::int8_t> &data);
+
+  /**
+   * @brief Method to overwrite a window of the costmap, as sent by a costmap_updates topic.
+   *
+   * @param x First column of the window.
+   * @param y First row of the window.
+   * @param width Number of columns of the window.
+   * @param height Number of rows of the window.
+   * @param data Costs of the window, row-major, width * height of them.
+   * @return true if the window lies inside the costmap.
+   * @return false otherwise or with no costmap yet, nothing is changed.
+   */
+  bool update_costmap(int x, int y, int width, int height, const std::vector<std::int8_t> &data);
+
+  /**
+   * @brief Method to check if a costmap was received.
+   */
+  bool has_costmap() const;
+
+  /**
+   * @brief Method to search for the goal the follower should look at a marker from.
+   *
+   * @param x Nominal goal in the map frame.
+   * @param y Nominal goal in the map frame.
+   * @param marker_x Marker in the map frame.
+   * @param marker_y Marker in the map frame.
+   * @param goal Receives the goal, the nominal goal facing the marker if the search finds nothing better.
+   * @return true if a cell was found, possibly the nominal one.
+   * @return false if there is no costmap or no cell qualifies.
+   */
+  bool refine(double x, double y, double marker_x, double marker_y, RefinedGoal &goal) const;
+
+  const Params &params() const { return params_; }
+
+ private:
+  int cost(int col, int row) const;
+  bool sees(int col, int row, double marker_x, double marker_y) const;
+
+  Params params_;
+  // Member 'mutex_' guards the snapshot below.
+  mutable std::mutex mutex_;
+  int width_ = 0;
+  int height_ = 0;
+  double resolution_ = 0;
+  double origin_x_ = 0;
+  double origin_y_ = 0;
+  std::vector<std::int8_t> costs_;
+  // Members 'visited_' and 'frontier_' are the scratch of the search, kept to not allocate on every goal.
+  mutable std::vector<std::uint32_t> visited_;
+  mutable std::uint32_t generation_ = 0;
+  mutable std::vector<std::size_t> frontier_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_GOAL_REFINER_H
@@ -0,0 +1,132 @@
+/**
+ * @file goal_retry.h
+ * @brief Decides what becomes of the goals move_base fails, and how long each goal may take.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_GOAL_RETRY_H
+#define FINAL_PROJECT_GOAL_RETRY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace final_project {
+
+/**
+ * @brief Class keeping the failures of the goals of one route, so a goal move_base cannot reach never stalls it.
+ *
+ * A failed goal, aborted, rejected or past its deadline, is first sent again a few times, each time moved a
+ * little further around its nominal location in case the goal itself is the problem. It then goes to the end of
+ * the route, the robot may reach it from another side later. Once it failed there too it is given up. Goals are
+ * named by the caller, e.g. by target or marker index, and a goal that succeeds is forgotten. The class is not
+ * thread-safe, the caller guards it.
+ */
+class GoalRetryPolicy {
+ public:
+  /**
+   * @brief Struct holding the tuning of the policy.
+   *
+   */
+  struct Params {
+    // Member 'max_retries' is the number of times a failed goal is sent again before it is deferred.
+    int max_retries = 2;
+    // Member 'max_deferrals' is the number of times a goal goes to the end of the route before it is given up.
+    int max_deferrals = 1;
+    // Member 'perturbation' is the distance a retried goal is moved by, in meters, times the number of the retry.
+    double perturbation = 0.15;
+    // Member 'speed' is the average speed the ETA of a goal assumes, in m/s.
+    double speed = 0.15;
+    // Members 'deadline_factor' and 'min_deadline' give a goal that many times its ETA, and at least that many
+    // seconds. A 'deadline_factor' of 0 lets the goals take as long as move_base does.
+    double deadline_factor = 3.0;
+    double min_deadline = 20.0;
+  };
+
+  // What becomes of a failed goal.
+  enum class Decision : std::uint8_t { Retry, Defer, GiveUp };
+
+  GoalRetryPolicy() = default;
+  explicit GoalRetryPolicy(const Params &params) : params_(params) {}
+
+  /**
+   * @brief Method to record a failure of a goal and decide what becomes of it.
+   *
+   * @param goal Name of the goal.
+   * @param deferrable The goal may go to the end of the route, false for the last goal of a route, e.g. home.
+   * @return Decision Retry while the retries are not used up, then Defer while the deferrals are not, GiveUp last.
+   * The retries start over after a deferral.
+   */
+  Decision failed(int goal, bool deferrable);
+
+  /**
+   * @brief Method to forget the failures of a goal once it is reached.
+   */
+  void succeeded(int goal) { attempts_.erase(goal); }
+
+  /**
+   * @brief Method to get the number of times a goal was sent again since it was last deferred.
+   */
+  int retries(int goal) const;
+
+  /**
+   * @brief Method to move a goal around its nominal location for its current retry.
+   *
+   * The retries go round the nominal location by the golden angle, so no two of them are in the same direction.
+   *
+   * @param goal Name of the goal.
+   * @param location Nominal location, in the map frame.
+   * @return std::array<double, 2> Location to send, the nominal one if the goal was not retried.
+   */
+  std::array<double, 2> perturb(int goal, const std::array<double, 2> &location) const;
+
+  /**
+   * @brief Method to get the time a goal may take.
+   *
+   * @param path_length Length of the path to the goal, in meters.
+   * @return double Deadline in seconds from the time the goal is sent, 0 if the goals have no deadline.
+   */
+  double deadline(double path_length) const;
+
+  /**
+   * @brief Method to get the number of failures recorded, of every goal.
+   */
+  std::size_t failures() const { return failures_; }
+
+  /**
+   * @brief Method to get the number of goals given up.
+   */
+  std::size_t given_up() const { return given_up_; }
+
+  const Params &params() const { return params_; }
+
+  /**
+   * @brief Method to change the tuning, the failures recorded so far are kept.
+   */
+  void set_params(const Params &params) { params_ = params; }
+
+ private:
+  struct Attempts {
+    int retries = 0;
+    int deferrals = 0;
+  };
+
+  Params params_;
+  // Member 'attempts_' holds the failures of each goal that failed and was not reached since.
+  std::unordered_map<int, Attempts> attempts_;
+  std::size_t failures_ = 0;
+  std::size_t given_up_ = 0;
+};
+
+/**
+ * @brief Method to get the name of a decision, for the logs.
+ */
+const char *to_string(GoalRetryPolicy::Decision decision);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_GOAL_RETRY_H
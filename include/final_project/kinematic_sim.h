@@ -0,0 +1,228 @@
+/**
+ * @file kinematic_sim.h
+ * @brief Lightweight simulation of the robots and their marker detector, for runs much faster than realtime.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_KINEMATIC_SIM_H
+#define FINAL_PROJECT_KINEMATIC_SIM_H
+
+#include <array>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "final_project/distance_field.h"
+
+namespace final_project {
+
+/**
+ * @brief Struct holding a pose in the map frame.
+ *
+ */
+struct UnicyclePose {
+  double x = 0;
+  double y = 0;
+  double yaw = 0;
+};
+
+/**
+ * @brief Struct holding an aruco marker of the simulated world.
+ *
+ */
+struct SimMarker {
+  // Member 'fiducial_id' contains the fiducial_id the detector reports for the marker.
+  int fiducial_id = -1;
+  // Members 'x', 'y' and 'z' contain the center of the marker in the map frame.
+  double x = 0;
+  double y = 0;
+  double z = 0;
+  // Member 'yaw' contains the heading of the marker normal, which points out of the marker face.
+  double yaw = 0;
+};
+
+/**
+ * @brief Struct holding the camera and the noise of the simulated detector.
+ *
+ */
+struct SimCamera {
+  // Member 'forward' and 'height' place the camera on the robot, in meters from the base footprint.
+  double forward = 0.064;
+  double height = 0.122;
+  // Member 'fov' is the horizontal field of view, in radians.
+  double fov = 1.047;
+  // Members 'min_range' and 'max_range' bound the distance a marker is detected at, in meters.
+  double min_range = 0.2;
+  double max_range = 3.0;
+  // Member 'max_incidence' is the largest angle between the marker normal and the line of sight, in radians.
+  double max_incidence = 1.2;
+  // Member 'range_noise' is the standard deviation of the range error, as a fraction of the range.
+  double range_noise = 0.01;
+  // Member 'bearing_noise' is the standard deviation of the bearing error, in radians.
+  double bearing_noise = 0.005;
+  // Member 'yaw_noise' is the standard deviation of the marker heading error, in radians.
+  double yaw_noise = 0.05;
+  // Member 'image_error_per_meter' is the reprojection error reported per meter of range, in pixels.
+  double image_error_per_meter = 0.3;
+};
+
+/**
+ * @brief Struct holding one synthetic fiducial transform, in the camera optical frame.
+ *
+ */
+struct SimDetection {
+  int fiducial_id = -1;
+  // Member 'translation' contains the marker center, x right, y down and z forward.
+  std::array<double, 3> translation{};
+  // Member 'rotation' contains the orientation of the marker as a quaternion x, y, z, w, its z-axis out of the face.
+  std::array<double, 4> rotation{{0, 0, 0, 1}};
+  double image_error = 0;
+  double object_error = 0;
+};
+
+/**
+ * @brief Class moving unicycle robots over a map_server map, driving them along the shortest path to their goal.
+ *
+ * Goals are planned over the inflated map and followed with a lookahead on the path, then the robot turns to
+ * the goal heading. Without a goal a robot follows its velocity command until the command times out.
+ */
+class KinematicSim {
+ public:
+  /**
+   * @brief Struct holding the limits and tolerances of the robots, those of a TurtleBot3 Waffle by default.
+   *
+   */
+  struct Params {
+    double max_linear = 0.26;
+    double max_angular = 1.82;
+    // Member 'heading_gain' turns the heading error into an angular velocity, in 1/s.
+    double heading_gain = 2.5;
+    double lookahead = 0.3;
+    double xy_tolerance = 0.15;
+    double yaw_tolerance = 0.2;
+    // Member 'command_timeout' stops a robot whose velocity command is older, in seconds.
+    double command_timeout = 0.5;
+  };
+
+  // State of the goal of a robot.
+  enum class GoalState { Idle, Active, Succeeded, Aborted };
+
+  /**
+   * @brief Construct a new Kinematic Sim object.
+   *
+   * @param map Map the line of sight and the velocity commands are checked against, kept by reference.
+   * @param fields Distance fields over the inflated map the goals are planned with, kept by reference.
+   * @param params Limits and tolerances of the robots.
+   */
+  KinematicSim(const OccupancyBitmap &map, DistanceFieldCache &fields, const Params &params);
+
+  /**
+   * @brief Method to add a robot.
+   *
+   * @return int Index of the robot.
+   */
+  int add_robot(const UnicyclePose &start);
+
+  /**
+   * @brief Method to give a robot a goal, replacing the current one.
+   *
+   * @return true if there is a path to the goal.
+   * @return false otherwise, the goal is aborted.
+   */
+  bool set_goal(int robot, const UnicyclePose &goal);
+
+  /**
+   * @brief Method to drop the goal of a robot, it stops where it is.
+   */
+  void cancel_goal(int robot);
+
+  /**
+   * @brief Method to get the state of the goal of a robot.
+   */
+  GoalState goal_state(int robot) const { return robots_[robot].state; }
+
+  /**
+   * @brief Method to put a robot somewhere else, dropping its goal and its velocity command.
+   */
+  void set_pose(int robot, const UnicyclePose &pose);
+
+  /**
+   * @brief Method to set the velocity command of a robot, followed while it has no active goal.
+   */
+  void set_velocity(int robot, double linear, double angular);
+
+  /**
+   * @brief Method to advance the simulation.
+   *
+   * @param dt Time step, in seconds.
+   */
+  void step(double dt);
+
+  /**
+   * @brief Method to get the pose of a robot.
+   */
+  const UnicyclePose &pose(int robot) const { return robots_[robot].pose; }
+
+  /**
+   * @brief Method to get the last velocities of a robot.
+   */
+  std::array<double, 2> velocity(int robot) const { return {{robots_[robot].linear, robots_[robot].angular}}; }
+
+  /**
+   * @brief Method to get the simulated time, in seconds.
+   */
+  double time() const { return time_; }
+
+  /**
+   * @brief Method to get the markers the camera of a robot sees, with noise.
+   *
+   * @param robot Index of the robot carrying the camera.
+   * @param camera Camera and noise model.
+   * @param markers Markers of the world.
+   * @param rng Random generator of the noise.
+   * @return std::vector<SimDetection> Detected markers, in the order of 'markers'.
+   */
+  std::vector<SimDetection> detect(int robot, const SimCamera &camera, const std::vector<SimMarker> &markers,
+                                   std::mt19937 &rng) const;
+
+  /**
+   * @brief Method to check if the segment between two points crosses no blocked cell of the map.
+   */
+  bool line_of_sight(double x0, double y0, double x1, double y1) const;
+
+  /**
+   * @brief Method to guess the heading of the normal of a marker on a wall, across the wall edge near the marker.
+   *
+   * The marker may sit inside the wall cells. Without a wall edge nearby, the direction with the most free space.
+   */
+  static double marker_facing(const OccupancyBitmap &map, double x, double y);
+
+ private:
+  struct Robot {
+    UnicyclePose pose;
+    GoalState state = GoalState::Idle;
+    UnicyclePose goal;
+    std::vector<std::array<double, 2>> path;
+    std::size_t next = 0;
+    double linear = 0;
+    double angular = 0;
+    double command_linear = 0;
+    double command_angular = 0;
+    double command_time = -1;
+  };
+
+  void follow_goal(Robot &robot, double &linear, double &angular);
+
+  const OccupancyBitmap &map_;
+  DistanceFieldCache &fields_;
+  Params params_;
+  std::vector<Robot> robots_;
+  double time_ = 0;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_KINEMATIC_SIM_H
@@ -0,0 +1,131 @@
+/**
+ * @file latency_histogram.h
+ * @brief Lock-free fixed-bucket histograms of the durations of the mission stages.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_LATENCY_HISTOGRAM_H
+#define FINAL_PROJECT_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace final_project {
+
+/**
+ * @brief Struct holding a consistent-enough copy of a histogram, to compute statistics from.
+ *
+ */
+struct HistogramSnapshot {
+  // Number of buckets, bucket i > 0 holds the durations in [2^(i-1), 2^i) times the resolution.
+  static constexpr std::size_t kBuckets = 32;
+  // Member 'buckets' contains the number of durations in each bucket.
+  std::array<std::uint64_t, kBuckets> buckets{};
+  // Member 'count' contains the number of recorded durations.
+  std::uint64_t count = 0;
+  // Members 'sum' and 'max' contain the total and the largest recorded duration, in seconds.
+  double sum = 0;
+  double max = 0;
+
+  /**
+   * @brief Method to get the mean duration, in seconds, 0 if nothing was recorded.
+   */
+  double mean() const { return count > 0 ? sum / count : 0.0; }
+
+  /**
+   * @brief Method to estimate a quantile from the buckets.
+   *
+   * @param q Quantile in [0, 1].
+   * @return double Quantile interpolated inside its bucket, in seconds, capped at the largest duration.
+   */
+  double quantile(double q) const;
+};
+
+/**
+ * @brief Histogram of durations with power-of-two buckets, from 100 us to about 60 hours.
+ *
+ * record() is wait-free and may be called from any thread, including the ROS callbacks. A snapshot taken
+ * while other threads record may be off by the durations in flight, never more.
+ */
+class LatencyHistogram {
+ public:
+  // Member 'kResolution' is the upper bound of the first bucket, in seconds.
+  static constexpr double kResolution = 1e-4;
+
+  /**
+   * @brief Method to record one duration.
+   *
+   * @param seconds Duration in seconds, negative durations count as 0.
+   */
+  void record(double seconds);
+
+  /**
+   * @brief Method to copy the histogram.
+   */
+  HistogramSnapshot snapshot() const;
+
+  /**
+   * @brief Method to forget every recorded duration. Not atomic with concurrent record() calls.
+   */
+  void reset();
+
+ private:
+  // Member 'buckets_' contains the number of durations in each bucket, a snapshot counts them by their sum.
+  std::array<std::atomic<std::uint64_t>, HistogramSnapshot::kBuckets> buckets_{};
+  // Members 'sum_ticks_' and 'max_ticks_' are in units of 'kResolution', so they stay integers.
+  std::atomic<std::uint64_t> sum_ticks_{0};
+  std::atomic<std::uint64_t> max_ticks_{0};
+};
+
+/**
+ * @brief Struct holding the histograms of every instrumented stage of the mission.
+ *
+ */
+struct MissionMetrics {
+  // Member 'detection_latency' is the time from the image stamp to the fiducial callback.
+  LatencyHistogram detection_latency;
+  // Member 'localization_latency' is the time from the fiducial callback to the localization of the detection.
+  LatencyHistogram localization_latency;
+  // Member 'tf_lookup' is the time spent in map->camera lookups that succeeded.
+  LatencyHistogram tf_lookup;
+  // Member 'tf_failure' is the time lost in map->camera lookups that failed, its count is the number of failures.
+  LatencyHistogram tf_failure;
+  // Member 'explorer_goal' is the time from sending an explorer goal to its success.
+  LatencyHistogram explorer_goal;
+  // Member 'follower_goal' is the time from sending a follower goal to its success.
+  LatencyHistogram follower_goal;
+  // Member 'rotation' is the time spent rotating at a target, its sum is the total rotation time.
+  LatencyHistogram rotation;
+
+  // Number of stages, in the order of stage().
+  static constexpr std::size_t kStages = 7;
+
+  /**
+   * @brief Method to get a stage by index, to iterate over all of them.
+   *
+   * @param index Index in [0, kStages).
+   * @param name Receives the name of the stage.
+   * @return const LatencyHistogram& Histogram of the stage.
+   */
+  const LatencyHistogram &stage(std::size_t index, std::string &name) const;
+
+  /**
+   * @brief Method to forget every recorded duration.
+   */
+  void reset();
+
+  /**
+   * @brief Method to get one line per stage with its count, mean, p50, p90, p99, max and total.
+   */
+  std::string report() const;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_LATENCY_HISTOGRAM_H
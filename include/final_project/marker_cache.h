@@ -0,0 +1,101 @@
+/**
+ * @file marker_cache.h
+ * @brief Fused marker poses kept on disk between launches, tied to the map they were localized in.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_MARKER_CACHE_H
+#define FINAL_PROJECT_MARKER_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "final_project/pose_fusion.h"
+
+namespace final_project {
+
+/**
+ * @brief Struct holding one cached marker, written to the cache file as is.
+ *
+ */
+struct CachedMarker {
+  std::int32_t fiducial_id = -1;
+  std::uint32_t samples = 0;
+  // Members 'x', 'y' and 'yaw' contain the fused pose in the map frame.
+  double x = 0;
+  double y = 0;
+  double yaw = 0;
+  // Members 'cov_xx', 'cov_xy', 'cov_yy' and 'yaw_std' contain the spread of the observations.
+  double cov_xx = 0;
+  double cov_xy = 0;
+  double cov_yy = 0;
+  double yaw_std = 0;
+  // Member 'effective_samples' contains the number of equally weighted observations the estimate is worth.
+  double effective_samples = 0;
+  // Member 'localized_at' contains the wall time the marker was last localized by the explorer, in seconds.
+  double localized_at = 0;
+};
+
+/**
+ * @brief Struct holding when a cached marker can be used without looking at it again.
+ *
+ */
+struct MarkerCacheFreshness {
+  // Member 'max_age' is the oldest localization that is trusted, in seconds, 0 to trust any age.
+  double max_age = 7 * 24 * 3600.0;
+  // Member 'max_std_error' is the largest standard error of the cached position that is trusted, in meters.
+  double max_std_error = 0.03;
+};
+
+/**
+ * @brief Method to get a fused estimate as a cached marker.
+ */
+CachedMarker to_cached_marker(const Se2Estimate &estimate, double localized_at);
+
+/**
+ * @brief Method to get a cached marker as a fused estimate, converged as the caller decides.
+ */
+Se2Estimate to_estimate(const CachedMarker &marker);
+
+/**
+ * @brief Method to check if a cached marker is recent and precise enough to skip its lookup.
+ *
+ * @param marker Cached marker.
+ * @param now Current wall time, in seconds.
+ * @param freshness Age and precision limits.
+ */
+bool marker_cache_trusted(const CachedMarker &marker, double now, const MarkerCacheFreshness &freshness);
+
+/**
+ * @brief Method to read the cached markers, memory-mapping the cache file.
+ *
+ * @param path Path of the cache file.
+ * @param map_checksum Checksum of the map the markers are expected in, see OccupancyBitmap::checksum().
+ * @param markers Receives the markers, empty on failure.
+ * @param error Receives the reason of a failure, may be null.
+ * @return true if the file exists, is intact and was written for the same map.
+ * @return false otherwise.
+ */
+bool read_marker_cache(const std::string &path, std::uint64_t map_checksum, std::vector<CachedMarker> &markers,
+                       std::string *error = nullptr);
+
+/**
+ * @brief Method to replace the cache file, through a temporary file so a reader never sees a partial cache.
+ *
+ * @param path Path of the cache file.
+ * @param map_checksum Checksum of the map the markers were localized in.
+ * @param markers Markers to write.
+ * @param error Receives the reason of a failure, may be null.
+ * @return true if the file was written.
+ * @return false otherwise.
+ */
+bool write_marker_cache(const std::string &path, std::uint64_t map_checksum, const std::vector<CachedMarker> &markers,
+                        std::string *error = nullptr);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_MARKER_CACHE_H
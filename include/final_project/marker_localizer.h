@@ -0,0 +1,137 @@
+/**
+ * @file marker_localizer.h
+ * @brief Localizes detected aruco markers in the map without going through /tf.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_MARKER_LOCALIZER_H
+#define FINAL_PROJECT_MARKER_LOCALIZER_H
+
+#include <geometry_msgs/Transform.h>
+#include <ros/ros.h>
+#include <tf2_ros/buffer.h>
+
+#include <string>
+
+#include "final_project/pose_kernels.h"
+
+namespace final_project {
+
+/**
+ * @brief Struct turning the error fields of a fiducial transform into the weight of its observation.
+ *
+ * The weight is 1 for a perfect detection and falls off with the reprojection error of the marker corners
+ * and with the error of the estimated pose, so far or oblique markers count less in the fusion.
+ */
+struct DetectionWeighting {
+  // Member 'image_error_scale' is the reprojection error, in pixels, that halves the weight on its own.
+  double image_error_scale = 1.0;
+  // Member 'object_error_scale' is the pose error, in meters, that halves the weight on its own.
+  double object_error_scale = 0.05;
+  // Member 'min_weight' is the floor on the weight, so a poor detection still counts a little.
+  double min_weight = 0.01;
+
+  /**
+   * @brief Method to get the weight of a detection.
+   *
+   * @param image_error 'image_error' field of the fiducial transform.
+   * @param object_error 'object_error' field of the fiducial transform.
+   * @return double Weight in [min_weight, 1], min_weight if an error is negative or not a number.
+   */
+  double weight(double image_error, double object_error) const;
+};
+
+/**
+ * @brief Method to convert a transform message to the pose of the kernels of pose_kernels.h.
+ */
+Pose3 to_pose3(const geometry_msgs::Transform &transform);
+
+/**
+ * @brief Class composing map->camera, camera->marker and the fixed follower offset in-process.
+ *
+ * The map->camera transform is the only lookup, done once at the detection stamp. The marker
+ * and offset frames are never broadcast.
+ */
+class MarkerLocalizer {
+ public:
+  /**
+   * @brief Construct a new Marker Localizer object.
+   *
+   * @param buffer Buffer holding the map->camera chain.
+   * @param map_frame Frame the marker is localized in.
+   * @param camera_frame Frame the fiducial transforms are expressed in.
+   * @param offset Distance in front of the marker, along its z-axis, where the follower should go.
+   */
+  MarkerLocalizer(const tf2_ros::Buffer &buffer, std::string map_frame = "map",
+                  std::string camera_frame = "explorer_tf/camera_rgb_optical_frame", double offset = 0.4);
+
+  /**
+   * @brief Method to compute the follower location in front of a marker.
+   *
+   * @param stamp Stamp of the detection, map->camera is looked up at this time.
+   * @param camera_to_marker Pose of the marker in the camera frame.
+   * @param timeout Maximum time to wait for map->camera to become available.
+   * @param map_to_goal Receives the follower location in the map frame.
+   * @return true if the marker was localized.
+   * @return false if map->camera was not available, the reason is logged.
+   */
+  bool localize(const ros::Time &stamp, const geometry_msgs::Transform &camera_to_marker,
+                const ros::Duration &timeout, geometry_msgs::Transform &map_to_goal) const;
+
+  /**
+   * @brief Method to look up the camera pose once for every marker detected in the same image.
+   *
+   * @param stamp Stamp of the image, map->camera is looked up at this time.
+   * @param timeout Maximum time to wait for map->camera to become available.
+   * @param map_to_camera Receives the pose of the camera in the map frame, to pass to compose().
+   * @return true if map->camera was available.
+   * @return false otherwise, the reason is logged.
+   */
+  bool lookup_camera(const ros::Time &stamp, const ros::Duration &timeout,
+                     geometry_msgs::Transform &map_to_camera) const;
+
+  /**
+   * @brief Method to compose an already known map->camera transform with a detection.
+   *
+   * @param map_to_camera Pose of the camera in the map frame.
+   * @param camera_to_marker Pose of the marker in the camera frame.
+   * @return geometry_msgs::Transform Follower location in the map frame.
+   */
+  geometry_msgs::Transform compose(const geometry_msgs::Transform &map_to_camera,
+                                   const geometry_msgs::Transform &camera_to_marker) const;
+
+  /**
+   * @brief Method to get the map heading that looks at the marker from the follower location.
+   *
+   * @param map_to_goal Follower location returned by localize() or compose().
+   * @return double Heading that points back along the marker z-axis, in radians.
+   */
+  static double facing_yaw(const geometry_msgs::Transform &map_to_goal);
+
+  /**
+   * @brief Method to get the frame the fiducial transforms are expressed in.
+   */
+  const std::string &camera_frame() const { return camera_frame_; }
+
+  /**
+   * @brief Method to get the distance in front of the marker where the follower should go.
+   */
+  double offset() const { return offset_; }
+
+ private:
+  // Member 'buffer_' holds the map->camera chain.
+  const tf2_ros::Buffer &buffer_;
+  // Member 'map_frame_' is the frame the marker is localized in.
+  std::string map_frame_;
+  // Member 'camera_frame_' is the frame the fiducial transforms are expressed in.
+  std::string camera_frame_;
+  // Member 'offset_' is the distance in front of the marker where the follower should go.
+  double offset_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_MARKER_LOCALIZER_H
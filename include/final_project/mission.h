@@ -0,0 +1,184 @@
+/**
+ * @file mission.h
+ * @brief Entry point of the explorer/follower mission, shared by the node and the nodelet.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_MISSION_H
+#define FINAL_PROJECT_MISSION_H
+
+#include <ros/ros.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "final_project/fleet.h"
+#include "final_project/latency_histogram.h"
+#include "final_project/mission_state.h"
+
+namespace final_project {
+
+/**
+ * @brief Struct holding how the process running the mission serves its callbacks and ends it.
+ *
+ */
+struct MissionHost {
+  // Member 'spin' lets the mission spin the callbacks of 'nh' itself, the nodelet manager spins them otherwise.
+  bool spin = true;
+  // Member 'on_finished' is called once when the mission is over, the node shuts down there.
+  std::function<void()> on_finished;
+};
+
+/**
+ * @brief Struct holding the outcome of the last mission, for benchmarks.
+ *
+ */
+struct MissionResult {
+  // Member 'completed' is raised if the follower got back home, not if the mission was stopped or timed out.
+  bool completed = false;
+  // Member 'duration' contains the time from the end of the startup to the end of the mission, in seconds.
+  double duration = 0;
+  // Member 'target_times' contains the time each lookup target got its marker after the startup, -1 if never.
+  std::vector<double> target_times;
+  // Member 'markers' contains the number of markers localized.
+  std::size_t markers = 0;
+  // Member 'stages' contains the histogram of each instrumented stage, by name.
+  std::vector<std::pair<std::string, HistogramSnapshot>> stages;
+  // Member 'transitions' contains the state transitions of the robots, the first kMaxLoggedTransitions, and
+  // MissionStateMachine::replay() reproduces them.
+  std::vector<StateTransition> transitions;
+  // Member 'goal_failures' counts the goals move_base failed or that missed their deadline, 'goals_given_up' those
+  // that were then given up.
+  std::size_t goal_failures = 0;
+  std::size_t goals_given_up = 0;
+  // Member 'hot_path_allocations' counts the heap allocations of the detections that made no marker stable, in
+  // the Debug builds only, it should stay 0.
+  std::uint64_t hot_path_allocations = 0;
+};
+
+/**
+ * @brief Struct holding the fused pose of one marker at the end of a replayed bag.
+ *
+ */
+struct ReplayMarker {
+  int fiducial_id = -1;
+  // Members 'x', 'y' and 'yaw' contain the follower location of the marker in the map frame.
+  double x = 0;
+  double y = 0;
+  double yaw = 0;
+  // Members 'std_error' and 'yaw_std' contain the standard error of the position, in meters, and the spread
+  // of the headings, in radians.
+  double std_error = 0;
+  double yaw_std = 0;
+  // Members 'samples' and 'rejected' count the observations fused and rejected as outliers.
+  std::size_t samples = 0;
+  std::size_t rejected = 0;
+  // Member 'converged_after' contains the bag time the estimate became stable at, after the first message, -1 if
+  // it never did.
+  double converged_after = -1;
+};
+
+/**
+ * @brief Struct holding the outcome of replaying a bag through the marker localization.
+ *
+ */
+struct ReplayResult {
+  // Member 'opened' is raised if the bag could be read.
+  bool opened = false;
+  // Member 'messages' counts the messages read, of every replayed topic.
+  std::size_t messages = 0;
+  // Member 'detections' counts the images with at least one marker, 'localized' those whose camera pose was found.
+  std::size_t detections = 0;
+  std::size_t localized = 0;
+  // Member 'bag_duration' contains the time between the first and the last message read, in seconds.
+  double bag_duration = 0;
+  // Member 'wall_time' contains the time the replay took, in seconds.
+  double wall_time = 0;
+  // Member 'explorer_distance' contains the distance driven by the explorers, from their odometry, in meters.
+  double explorer_distance = 0;
+  // Member 'markers' contains the fused markers, by fiducial_id.
+  std::vector<ReplayMarker> markers;
+  // Member 'stages' contains the histogram of each instrumented stage, by name.
+  std::vector<std::pair<std::string, HistogramSnapshot>> stages;
+};
+
+/**
+ * @brief Method to get the robots the mission runs with, ~fleet or the default fleet.
+ *
+ * @param pnh Private nodehandle the mission reads its tuning from.
+ */
+std::vector<RobotSpec> read_fleet(ros::NodeHandle &pnh);
+
+/**
+ * @brief Class running the explorer/follower mission.
+ *
+ * Every Mission holds its own targets, robots, tuning and metrics, with no globals of its own. Only one runs per
+ * process all the same: it spins the global callback queue, runs while ros::ok() and its host may shut ROS down, and
+ * ROS1 allows one node and one clock per process.
+ */
+class Mission {
+ public:
+  /**
+   * @brief Construct a new Mission object.
+   *
+   * @param host How the calling process serves the callbacks and ends the mission.
+   */
+  explicit Mission(const MissionHost &host = MissionHost());
+
+  /**
+   * @brief Destroy the Mission object, run() must have returned.
+   */
+  ~Mission();
+
+  Mission(const Mission &) = delete;
+  Mission &operator=(const Mission &) = delete;
+
+  /**
+   * @brief Method to run the whole mission, configured from the private parameters, until it is over.
+   *
+   * @param nh Nodehandle the topics, services and timers of the mission are created on.
+   * @param pnh Private nodehandle the tuning is read from.
+   * @return int 0 if the mission ran, non-zero if it could not start.
+   */
+  int run(ros::NodeHandle &nh, ros::NodeHandle &pnh);
+
+  /**
+   * @brief Method to make a running mission return, from any thread.
+   */
+  void stop();
+
+  /**
+   * @brief Method to get the outcome of the last mission, once run() has returned.
+   */
+  MissionResult last_result() const;
+
+  /**
+   * @brief Method to stream a recorded bag through the localization and fusion of the mission, as fast as it is
+   * read.
+   *
+   * The fiducial transforms of every explorer of the fleet are localized against the /tf and /tf_static of the
+   * bag, with the tuning of the mission. Replaces the markers of the mission, never call it while run() does.
+   *
+   * @param pnh Private nodehandle the tuning is read from.
+   * @param path Bag to replay.
+   * @return ReplayResult Fused markers and timings, 'opened' is lowered if the bag could not be read.
+   */
+  ReplayResult replay_bag(ros::NodeHandle &pnh, const std::string &path);
+
+ private:
+  class Impl;
+  // Member 'impl_' holds the state of the mission and its stages, see mission.cpp.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_MISSION_H
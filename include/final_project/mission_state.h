@@ -0,0 +1,192 @@
+/**
+ * @file mission_state.h
+ * @brief States of the robots of a mission and the table of the transitions between them.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_MISSION_STATE_H
+#define FINAL_PROJECT_MISSION_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "final_project/fleet.h"
+
+namespace final_project {
+
+/**
+ * @brief State of one robot of the mission.
+ *
+ */
+enum class RobotState : std::uint8_t {
+  // The robot has no goal, it waits for its next task.
+  Idle,
+  // The robot drives to a lookup target or a follower location.
+  Driving,
+  // The explorer turns at a lookup target until the marker is localized.
+  Looking,
+  // The robot drives to its home position, it has no task left.
+  HeadingHome,
+  // The robot is back home, its part of the mission is over.
+  Home
+};
+
+/**
+ * @brief Event moving a robot of the mission from one state to the next.
+ *
+ */
+enum class RobotEvent : std::uint8_t {
+  // A goal at a lookup target or a follower location was sent, preempting the current one.
+  GoalSent,
+  // move_base reached the current goal.
+  GoalReached,
+  // move_base gave up on the current goal, or it was preempted from outside.
+  GoalFailed,
+  // The marker of the target of the explorer was localized, while looking or on the way.
+  MarkerLocalized,
+  // The robot was sent to its home position.
+  SentHome
+};
+
+constexpr std::size_t kRobotStates = 5;
+constexpr std::size_t kRobotEvents = 5;
+// Most transitions a MissionStateMachine logs between two clear() calls, about 1.5 MB.
+constexpr std::size_t kMaxLoggedTransitions = std::size_t(1) << 16;
+
+/**
+ * @brief Struct holding one transition a robot went through, enough to replay the mission.
+ *
+ */
+struct StateTransition {
+  // Member 'time' contains the time of the event, in seconds.
+  double time = 0;
+  // Member 'robot' contains the index of the robot in the state machine.
+  int robot = 0;
+  RobotState from = RobotState::Idle;
+  RobotEvent event = RobotEvent::GoalSent;
+  RobotState to = RobotState::Idle;
+};
+
+/**
+ * @brief Class holding the state of every robot of a mission, moved only through the transition table of its role.
+ *
+ * Events that are not allowed in the current state are rejected and leave the state unchanged, so a late
+ * callback cannot move a robot backwards. The accepted transitions are logged in order, up to
+ * kMaxLoggedTransitions. The class is not thread-safe, the caller guards it.
+ */
+class MissionStateMachine {
+ public:
+  /**
+   * @brief Method to get the state an event leads to, from the transition table of a role.
+   *
+   * @param role Role of the robot, explorers look for markers and followers do not.
+   * @param state Current state of the robot.
+   * @param event Event to apply.
+   * @param next Receives the next state.
+   * @return true if the event is allowed in 'state'.
+   * @return false otherwise, 'next' is 'state'.
+   */
+  static bool next(RobotRole role, RobotState state, RobotEvent event, RobotState &next);
+
+  /**
+   * @brief Method to add a robot, Idle.
+   *
+   * @return int Index of the robot.
+   */
+  int add_robot(RobotRole role);
+
+  /**
+   * @brief Method to apply an event to a robot.
+   *
+   * @param robot Index of the robot.
+   * @param event Event to apply.
+   * @param time Time of the event, in seconds, only logged.
+   * @return true if the event was allowed and the robot moved to the next state.
+   * @return false if it was rejected.
+   */
+  bool dispatch(int robot, RobotEvent event, double time = 0);
+
+  /**
+   * @brief Method to get the state of a robot.
+   */
+  RobotState state(int robot) const { return states_[robot]; }
+
+  /**
+   * @brief Method to check if a robot is in a state.
+   */
+  bool in(int robot, RobotState state) const { return states_[robot] == state; }
+
+  /**
+   * @brief Method to check if a robot has a goal or is looking for a marker.
+   */
+  bool busy(int robot) const;
+
+  /**
+   * @brief Method to get the role of a robot.
+   */
+  RobotRole role(int robot) const { return roles_[robot]; }
+
+  /**
+   * @brief Method to get the number of robots in a state.
+   */
+  std::size_t count(RobotState state) const;
+
+  /**
+   * @brief Method to get the number of robots.
+   */
+  std::size_t robot_count() const { return states_.size(); }
+
+  /**
+   * @brief Method to get the accepted transitions, in the order they happened.
+   */
+  const std::vector<StateTransition> &transitions() const { return log_; }
+
+  /**
+   * @brief Method to get the number of accepted transitions left out of the log once it was full.
+   */
+  std::size_t unlogged() const { return unlogged_; }
+
+  /**
+   * @brief Method to apply logged transitions to the robots, checking that each leads where it did.
+   *
+   * The log starts empty at clear(), which the mission calls when it starts, and keeps the first
+   * kMaxLoggedTransitions transitions only, so a longer mission replays up to there, see unlogged().
+   *
+   * @param transitions Transitions of a machine with the same robots, from the start of its mission.
+   * @return true if every transition was allowed and reached the logged state.
+   * @return false at the first one that did not, the robots are left where it stopped.
+   */
+  bool replay(const std::vector<StateTransition> &transitions);
+
+  /**
+   * @brief Method to remove every robot and the log.
+   */
+  void clear();
+
+ private:
+  // The members below are indexed by robot.
+  std::vector<RobotRole> roles_;
+  std::vector<RobotState> states_;
+  // Member 'log_' holds the accepted transitions, the first kMaxLoggedTransitions ones.
+  std::vector<StateTransition> log_;
+  // Member 'unlogged_' counts the accepted transitions left out of 'log_'.
+  std::size_t unlogged_ = 0;
+};
+
+/**
+ * @brief Method to get the name of a state, e.g. "HeadingHome".
+ */
+const char *to_string(RobotState state);
+
+/**
+ * @brief Method to get the name of an event, e.g. "GoalReached".
+ */
+const char *to_string(RobotEvent event);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_MISSION_STATE_H
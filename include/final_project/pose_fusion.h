@@ -0,0 +1,174 @@
+/**
+ * @file pose_fusion.h
+ * @brief Incremental per-fiducial fusion of marker pose observations in SE(2).
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_POSE_FUSION_H
+#define FINAL_PROJECT_POSE_FUSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "final_project/flat_index_map.h"
+
+namespace final_project {
+
+/**
+ * @brief Struct holding the fused pose of one marker.
+ *
+ */
+struct Se2Estimate {
+  // Member 'fiducial_id' contains the fiducial_id of the marker.
+  int fiducial_id = -1;
+  // Members 'x', 'y' and 'yaw' contain the weighted mean pose in the map frame.
+  double x = 0;
+  double y = 0;
+  double yaw = 0;
+  // Members 'cov_xx', 'cov_xy' and 'cov_yy' contain the weighted covariance of the observed positions.
+  double cov_xx = 0;
+  double cov_xy = 0;
+  double cov_yy = 0;
+  // Member 'yaw_std' contains the circular standard deviation of the observed yaws.
+  double yaw_std = 0;
+  // Member 'samples' contains the number of accepted observations.
+  std::uint32_t samples = 0;
+  // Member 'effective_samples' contains the number of equally weighted observations the weights are worth.
+  double effective_samples = 0;
+  // Member 'rejected' contains the number of observations rejected as outliers.
+  std::uint32_t rejected = 0;
+  // Member 'converged' is raised once the estimate is stable.
+  bool converged = false;
+};
+
+/**
+ * @brief Class fusing every observation of every marker into a running mean and covariance.
+ *
+ * The state of all markers is kept as a struct of arrays, one slot per fiducial_id, so updates touch
+ * only a few contiguous doubles. Observations far from the current estimate, in Mahalanobis distance,
+ * are rejected once enough samples are in.
+ */
+class PoseFusion {
+ public:
+  /**
+   * @brief Struct holding the tuning of the estimator.
+   *
+   */
+  struct Params {
+    // Member 'min_samples' is the number of observations accepted before outliers are rejected.
+    std::uint32_t min_samples = 5;
+    // Member 'gate_sigma' is the Mahalanobis distance above which an observation is an outlier.
+    double gate_sigma = 3.0;
+    // Member 'min_sigma' is the floor on the position standard deviation used by the gate, in meters.
+    double min_sigma = 0.05;
+    // Member 'max_yaw_error' is the largest yaw difference to the estimate that is accepted, in radians.
+    double max_yaw_error = 0.5;
+    // Member 'converged_std_error' is the standard error of the mean position below which the estimate is stable.
+    double converged_std_error = 0.02;
+    // Member 'converged_yaw_std' is the yaw spread below which the estimate is stable, in radians.
+    double converged_yaw_std = 0.2;
+    // Member 'reset_after_rejects' restarts an estimate after this many consecutive outliers.
+    std::uint32_t reset_after_rejects = 10;
+  };
+
+  PoseFusion();
+  explicit PoseFusion(const Params &params);
+
+  /**
+   * @brief Method to fuse one observation of a marker.
+   *
+   * @param fiducial_id fiducial_id of the observed marker, must not be negative.
+   * @param x x-coordinate of the observation in the map frame.
+   * @param y y-coordinate of the observation in the map frame.
+   * @param yaw Heading of the observation in the map frame.
+   * @param weight Weight of the observation, larger is more trusted.
+   * @return true if the observation was accepted.
+   * @return false if it was rejected as an outlier.
+   */
+  bool add(int fiducial_id, double x, double y, double yaw, double weight = 1.0);
+
+  /**
+   * @brief Method to get the fused pose of a marker.
+   *
+   * @param fiducial_id fiducial_id of the marker.
+   * @param estimate Receives the fused pose.
+   * @return true if the marker was observed at least once.
+   * @return false otherwise.
+   */
+  bool estimate(int fiducial_id, Se2Estimate &estimate) const;
+
+  /**
+   * @brief Method to check if the fused pose of a marker is stable.
+   */
+  bool converged(int fiducial_id) const;
+
+  /**
+   * @brief Method to replace the observations of a marker by a previous estimate, e.g. one read from disk.
+   *
+   * The estimate stands for 'effective_samples' observations of weight one, so later observations move it as
+   * much as they would have moved the original. Converged is recomputed, not taken from the estimate.
+   *
+   * @param estimate Estimate to restore, its fiducial_id must not be negative.
+   */
+  void restore(const Se2Estimate &estimate);
+
+  /**
+   * @brief Method to forget every observation of a marker.
+   */
+  void reset(int fiducial_id);
+
+  /**
+   * @brief Method to make room for a number of markers, so the first observations of up to that many markers
+   * never allocate.
+   */
+  void reserve(std::size_t markers);
+
+  /**
+   * @brief Method to get the fiducial_ids observed so far, in order of first observation.
+   */
+  const std::vector<int> &fiducial_ids() const { return ids_; }
+
+  /**
+   * @brief Method to get the tuning of the estimator.
+   */
+  const Params &params() const { return params_; }
+
+  /**
+   * @brief Method to change the tuning, the observations fused so far are kept.
+   */
+  void set_params(const Params &params) { params_ = params; }
+
+ private:
+  int slot(int fiducial_id) const;
+  int add_slot(int fiducial_id);
+  void clear_slot(int index);
+  bool is_converged(int index) const;
+
+  Params params_;
+  // Member 'slot_of_id_' maps a fiducial_id to its slot, so sparse or large ids cost no memory.
+  FlatIndexMap slot_of_id_;
+  // The members below are the struct of arrays, indexed by slot.
+  std::vector<int> ids_;
+  std::vector<std::uint32_t> samples_;
+  std::vector<std::uint32_t> rejected_;
+  std::vector<std::uint32_t> consecutive_rejects_;
+  std::vector<double> weight_sum_;
+  std::vector<double> weight_sq_sum_;
+  std::vector<double> mean_x_;
+  std::vector<double> mean_y_;
+  // Weighted sums of squared deviations, the covariance is m2 / weight_sum.
+  std::vector<double> m2_xx_;
+  std::vector<double> m2_xy_;
+  std::vector<double> m2_yy_;
+  // Weighted sums of the unit heading vectors.
+  std::vector<double> yaw_cos_;
+  std::vector<double> yaw_sin_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_POSE_FUSION_H
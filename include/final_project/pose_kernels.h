@@ -0,0 +1,207 @@
+/**
+ * @file pose_kernels.h
+ * @brief Fixed-size pose composition and projection to the plane, for every marker of an image at once.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_POSE_KERNELS_H
+#define FINAL_PROJECT_POSE_KERNELS_H
+
+#include <cmath>
+#include <cstddef>
+
+namespace final_project {
+
+/**
+ * @brief Struct holding a 3D vector.
+ *
+ */
+struct Vec3 {
+  double x = 0;
+  double y = 0;
+  double z = 0;
+};
+
+/**
+ * @brief Struct holding a unit quaternion, in the order of geometry_msgs.
+ *
+ */
+struct Quat {
+  double x = 0;
+  double y = 0;
+  double z = 0;
+  double w = 1;
+};
+
+/**
+ * @brief Struct holding a rigid transform, the rotation applies before the translation.
+ *
+ */
+struct Pose3 {
+  Vec3 translation;
+  Quat rotation;
+};
+
+/**
+ * @brief Struct holding a pose in the plane of the map.
+ *
+ */
+struct PlanarPose {
+  double x = 0;
+  double y = 0;
+  double yaw = 0;
+};
+
+constexpr Vec3 operator+(const Vec3 &a, const Vec3 &b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+
+constexpr Vec3 operator*(double s, const Vec3 &v) { return {s * v.x, s * v.y, s * v.z}; }
+
+constexpr Vec3 cross(const Vec3 &a, const Vec3 &b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+/**
+ * @brief Method to rotate a vector by a unit quaternion, v + 2w (u x v) + 2 u x (u x v) with u the vector part.
+ */
+constexpr Vec3 rotate(const Quat &q, const Vec3 &v) {
+  return v + (2.0 * q.w) * cross({q.x, q.y, q.z}, v) + 2.0 * cross({q.x, q.y, q.z}, cross({q.x, q.y, q.z}, v));
+}
+
+/**
+ * @brief Method to get the z-axis of a rotation, rotate(q, {0, 0, 1}) with the zero terms left out.
+ */
+constexpr Vec3 z_axis(const Quat &q) {
+  return {2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y)};
+}
+
+/**
+ * @brief Method to compose two rotations, a then b.
+ */
+constexpr Quat multiply(const Quat &a, const Quat &b) {
+  return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y, a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+          a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w, a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+/**
+ * @brief Method to compose two transforms, a_to_c = a_to_b * b_to_c.
+ */
+constexpr Pose3 compose(const Pose3 &a_to_b, const Pose3 &b_to_c) {
+  return {a_to_b.translation + rotate(a_to_b.rotation, b_to_c.translation),
+          multiply(a_to_b.rotation, b_to_c.rotation)};
+}
+
+/**
+ * @brief Method to move a transform along its own z-axis, compose(pose, {{0, 0, offset}, identity}) without the
+ * rotation product.
+ */
+constexpr Pose3 offset_along_z(const Pose3 &pose, double offset) {
+  return {pose.translation + offset * z_axis(pose.rotation), pose.rotation};
+}
+
+/**
+ * @brief Method to project the follower location of a marker to the plane, facing back along the marker z-axis.
+ *
+ * @param map_to_goal Follower location, the marker pose moved along its z-axis.
+ * @return PlanarPose Position in the plane, and the heading that looks at the marker.
+ */
+inline PlanarPose project_facing(const Pose3 &map_to_goal) {
+  const Vec3 normal = z_axis(map_to_goal.rotation);
+  return {map_to_goal.translation.x, map_to_goal.translation.y, std::atan2(-normal.y, -normal.x)};
+}
+
+/**
+ * @brief Struct holding the marker poses of one image in the camera frame, one array per component.
+ *
+ * The unused slots stay at zero and give finite results, so the kernel runs over all N of them with no branch and
+ * the compiler vectorizes it for the target, two doubles per SSE2 or NEON register, four per AVX register.
+ *
+ * @tparam N Most markers of an image.
+ */
+template <std::size_t N>
+struct MarkerBatch {
+  static_assert(N > 0, "A batch holds at least one marker");
+
+  /**
+   * @brief Method to add a marker, ignored once the batch is full.
+   *
+   * @return std::size_t Slot of the marker, N if it was ignored.
+   */
+  std::size_t push(const Pose3 &camera_to_marker) {
+    if (count == N) {
+      return N;
+    }
+    tx[count] = camera_to_marker.translation.x;
+    ty[count] = camera_to_marker.translation.y;
+    tz[count] = camera_to_marker.translation.z;
+    qx[count] = camera_to_marker.rotation.x;
+    qy[count] = camera_to_marker.rotation.y;
+    qz[count] = camera_to_marker.rotation.z;
+    qw[count] = camera_to_marker.rotation.w;
+    return count++;
+  }
+
+  std::size_t count = 0;
+  double tx[N] = {};
+  double ty[N] = {};
+  double tz[N] = {};
+  double qx[N] = {};
+  double qy[N] = {};
+  double qz[N] = {};
+  double qw[N] = {};
+};
+
+/**
+ * @brief Method to localize the follower location of every marker of an image, map_to_camera * camera_to_marker
+ * moved 'offset' along the marker z-axis, projected to the plane.
+ *
+ * Only the rows of the camera rotation that reach the plane are computed, the marker rotation is never composed,
+ * its z-axis is all the follower location and its heading need.
+ *
+ * @param map_to_camera Pose of the camera in the map frame, looked up once for the image.
+ * @param batch Marker poses in the camera frame.
+ * @param offset Distance in front of the markers the follower locations are at.
+ * @param goals Receives the follower location of each marker of the batch, in batch order.
+ * @return std::size_t Number of markers localized, that of the batch.
+ */
+template <std::size_t N>
+std::size_t localize_markers(const Pose3 &map_to_camera, const MarkerBatch<N> &batch, double offset,
+                             PlanarPose (&goals)[N]) {
+  // First two rows of the camera rotation matrix.
+  const Quat &q = map_to_camera.rotation;
+  const double r00 = 1.0 - 2.0 * (q.y * q.y + q.z * q.z);
+  const double r01 = 2.0 * (q.x * q.y - q.w * q.z);
+  const double r02 = 2.0 * (q.x * q.z + q.w * q.y);
+  const double r10 = 2.0 * (q.x * q.y + q.w * q.z);
+  const double r11 = 1.0 - 2.0 * (q.x * q.x + q.z * q.z);
+  const double r12 = 2.0 * (q.y * q.z - q.w * q.x);
+  double gx[N];
+  double gy[N];
+  double nx[N];
+  double ny[N];
+  for (std::size_t i = 0; i < N; ++i) {
+    // z-axis of the marker in the camera frame, it points out of the marker face.
+    const double zx = 2.0 * (batch.qx[i] * batch.qz[i] + batch.qw[i] * batch.qy[i]);
+    const double zy = 2.0 * (batch.qy[i] * batch.qz[i] - batch.qw[i] * batch.qx[i]);
+    const double zz = 1.0 - 2.0 * (batch.qx[i] * batch.qx[i] + batch.qy[i] * batch.qy[i]);
+    const double px = batch.tx[i] + offset * zx;
+    const double py = batch.ty[i] + offset * zy;
+    const double pz = batch.tz[i] + offset * zz;
+    gx[i] = map_to_camera.translation.x + r00 * px + r01 * py + r02 * pz;
+    gy[i] = map_to_camera.translation.y + r10 * px + r11 * py + r12 * pz;
+    nx[i] = r00 * zx + r01 * zy + r02 * zz;
+    ny[i] = r10 * zx + r11 * zy + r12 * zz;
+  }
+  for (std::size_t i = 0; i < batch.count; ++i) {
+    goals[i].x = gx[i];
+    goals[i].y = gy[i];
+    goals[i].yaw = std::atan2(-ny[i], -nx[i]);
+  }
+  return batch.count;
+}
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_POSE_KERNELS_H
@@ -0,0 +1,90 @@
+/**
+ * @file preserialized.h
+ * @brief Message serialized once and published as is, however many times and to however many subscribers.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_PRESERIALIZED_H
+#define FINAL_PROJECT_PRESERIALIZED_H
+
+#include <ros/message_traits.h>
+#include <ros/serialization.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Struct holding the serialized form of a message of type M.
+ *
+ * A publisher advertised with M publishes it as an M, roscpp only copies the bytes. The buffer is kept from one
+ * message to the next, so serializing a message no larger than the previous ones never allocates.
+ *
+ * @tparam M Type of the message.
+ */
+template <typename M>
+struct Preserialized {
+  /**
+   * @brief Method to replace the bytes by the serialized form of a message.
+   */
+  void assign(const M &message) {
+    bytes.resize(ros::serialization::serializationLength(message));
+    ros::serialization::OStream stream(bytes.data(), static_cast<std::uint32_t>(bytes.size()));
+    ros::serialization::serialize(stream, message);
+  }
+
+  // Member 'bytes' contains the serialized message, without the length roscpp prefixes it with.
+  std::vector<std::uint8_t> bytes;
+};
+
+}  // namespace final_project
+
+namespace ros {
+namespace message_traits {
+
+template <typename M>
+struct MD5Sum<final_project::Preserialized<M>> {
+  static const char *value() { return MD5Sum<M>::value(); }
+  static const char *value(const final_project::Preserialized<M> &) { return value(); }
+};
+
+template <typename M>
+struct DataType<final_project::Preserialized<M>> {
+  static const char *value() { return DataType<M>::value(); }
+  static const char *value(const final_project::Preserialized<M> &) { return value(); }
+};
+
+template <typename M>
+struct Definition<final_project::Preserialized<M>> {
+  static const char *value() { return Definition<M>::value(); }
+  static const char *value(const final_project::Preserialized<M> &) { return value(); }
+};
+
+}  // namespace message_traits
+
+namespace serialization {
+
+template <typename M>
+struct Serializer<final_project::Preserialized<M>> {
+  template <typename Stream>
+  inline static void write(Stream &stream, const final_project::Preserialized<M> &message) {
+    if (!message.bytes.empty()) {
+      std::memcpy(stream.advance(static_cast<std::uint32_t>(message.bytes.size())), message.bytes.data(),
+                  message.bytes.size());
+    }
+  }
+
+  inline static std::uint32_t serializedLength(const final_project::Preserialized<M> &message) {
+    return static_cast<std::uint32_t>(message.bytes.size());
+  }
+};
+
+}  // namespace serialization
+}  // namespace ros
+
+#endif  // FINAL_PROJECT_PRESERIALIZED_H
@@ -0,0 +1,127 @@
+/**
+ * @file rotation_search.h
+ * @brief Rotation strategy used by the explorer to find the marker at a lookup location.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_ROTATION_SEARCH_H
+#define FINAL_PROJECT_ROTATION_SEARCH_H
+
+#include <cstdint>
+
+namespace final_project {
+
+/**
+ * @brief Struct giving read access to a row-major occupancy grid, in the nav_msgs/OccupancyGrid convention.
+ *
+ */
+struct GridView {
+  // Member 'data' points to the cells, 0 is free, 100 is occupied and -1 is unknown.
+  const std::int8_t *data = nullptr;
+  // Members 'width' and 'height' contain the size of the grid in cells.
+  int width = 0;
+  int height = 0;
+  // Member 'resolution' contains the size of a cell in meters.
+  double resolution = 0;
+  // Members 'origin_x' and 'origin_y' contain the map coordinates of the corner of cell (0, 0).
+  double origin_x = 0;
+  double origin_y = 0;
+};
+
+/**
+ * @brief Method to find the direction of the closest wall around a point, where a marker is likely hung.
+ *
+ * @param grid Occupancy grid of the map.
+ * @param x x-coordinate of the point in the map frame.
+ * @param y y-coordinate of the point in the map frame.
+ * @param max_range Longest ray cast, in meters.
+ * @param bearing Receives the map heading of the closest occupied cell.
+ * @param rays Number of rays cast over a full turn.
+ * @return true if an occupied cell was found within range.
+ * @return false otherwise.
+ */
+bool nearest_obstacle_bearing(const GridView &grid, double x, double y, double max_range, double &bearing,
+                              int rays = 90);
+
+/**
+ * @brief Class choosing the angular velocity of the explorer while it looks for a marker.
+ *
+ * The explorer turns the shorter way towards the expected bearing at a fast rate. It slows down when it
+ * gets close to that bearing or as soon as markers are being detected, and after a full turn without
+ * any detection it keeps turning at the slow rate only.
+ */
+class RotationSearch {
+ public:
+  /**
+   * @brief Struct holding the tuning of the search.
+   *
+   */
+  struct Params {
+    // Member 'fast_rate' is the angular velocity far from the expected bearing, in rad/s.
+    double fast_rate = 0.6;
+    // Member 'slow_rate' is the angular velocity near the bearing or while markers are seen, in rad/s.
+    double slow_rate = 0.1;
+    // Member 'slow_zone' is the half-width of the window around the expected bearing turned slowly, in radians.
+    double slow_zone = 0.6;
+    // Member 'detection_hold' is how long the slow rate is kept after the last detection, in seconds.
+    double detection_hold = 1.0;
+    // Member 'bearing_range' is how far from the lookup location a wall is looked for, in meters.
+    double bearing_range = 1.5;
+  };
+
+  RotationSearch();
+  explicit RotationSearch(const Params &params);
+
+  /**
+   * @brief Method to start a new search.
+   *
+   * @param now Current time, in seconds.
+   * @param robot_yaw Heading of the explorer in the map frame.
+   * @param has_bearing Whether an expected bearing of the marker is known.
+   * @param expected_bearing Expected map heading of the marker, ignored without 'has_bearing'.
+   */
+  void start(double now, double robot_yaw, bool has_bearing, double expected_bearing);
+
+  /**
+   * @brief Method to get the angular velocity to command now.
+   *
+   * @param now Current time, in seconds.
+   * @param last_detection Time of the last marker detection, in seconds.
+   * @return double Angular velocity, positive is counter-clockwise.
+   */
+  double angular_velocity(double now, double last_detection);
+
+  /**
+   * @brief Method to get the tuning of the search.
+   */
+  const Params &params() const { return params_; }
+
+  /**
+   * @brief Method to change the tuning, for the next start().
+   */
+  void set_params(const Params &params) { params_ = params; }
+
+  /**
+   * @brief Method to get the total angle turned since start(), in radians.
+   */
+  double turned() const { return turned_; }
+
+ private:
+  Params params_;
+  // Member 'direction' is +1 to turn counter-clockwise and -1 to turn clockwise.
+  double direction_ = 1;
+  bool has_bearing_ = false;
+  double expected_bearing_ = 0;
+  // Member 'yaw_' is the heading of the explorer integrated from the commanded velocities.
+  double yaw_ = 0;
+  double turned_ = 0;
+  double last_time_ = 0;
+  double last_rate_ = 0;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_ROTATION_SEARCH_H
@@ -0,0 +1,45 @@
+/**
+ * @file route_planner.h
+ * @brief Orders the goals of a robot to minimize its total travel cost.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_ROUTE_PLANNER_H
+#define FINAL_PROJECT_ROUTE_PLANNER_H
+
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Method to order the nodes of a route so that its total cost is minimal.
+ *
+ * The order is exact (Held-Karp) when at most 'exact_limit' nodes are visited, and found with
+ * nearest neighbour plus 2-opt above that.
+ *
+ * @param cost Row-major n x n matrix of travel costs, cost[i * n + j] is the cost from node i to node j.
+ * @param n Number of nodes.
+ * @param start Node the route starts from.
+ * @param end Node the route must finish at, may be 'start' for a round trip, -1 for an open route.
+ * @param exact_limit Largest number of visited nodes solved exactly.
+ * @return std::vector<int> Every node but 'start' in visiting order, 'end' last when it is given.
+ */
+std::vector<int> plan_route(const std::vector<double> &cost, int n, int start, int end, int exact_limit = 12);
+
+/**
+ * @brief Method to get the total cost of a route.
+ *
+ * @param cost Row-major n x n matrix of travel costs.
+ * @param n Number of nodes.
+ * @param start Node the route starts from.
+ * @param route Nodes in visiting order, as returned by plan_route().
+ * @return double Sum of the costs of every leg.
+ */
+double route_cost(const std::vector<double> &cost, int n, int start, const std::vector<int> &route);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_ROUTE_PLANNER_H
@@ -0,0 +1,81 @@
+/**
+ * @file snapshot_buffer.h
+ * @brief Double-buffered hand-over of the latest snapshot of a state from the thread that owns it to a reader.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_SNAPSHOT_BUFFER_H
+#define FINAL_PROJECT_SNAPSHOT_BUFFER_H
+
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace final_project {
+
+/**
+ * @brief Class handing the latest snapshot of a state from its writer to its reader, neither waiting on the other.
+ *
+ * The writer fills its own frame and the reader reads its own, the two sides of the double buffer. A third
+ * frame sits between them: publish() swaps the written frame with it and latest() swaps it with the read one,
+ * under a mutex held for the swap of two pointers only. A frame is never copied, so once its containers grew to
+ * the size of the state, nothing allocates. Snapshots published faster than they are read are dropped, the
+ * reader only ever sees the latest. There is one writer and one reader at a time, callers serialize the others.
+ *
+ * @tparam T Type of the snapshot, must be default constructible.
+ */
+template <typename T>
+class SnapshotBuffer {
+ public:
+  SnapshotBuffer() = default;
+  SnapshotBuffer(const SnapshotBuffer &) = delete;
+  SnapshotBuffer &operator=(const SnapshotBuffer &) = delete;
+
+  /**
+   * @brief Method to get the frame of the writer, to fill before publish(). It holds an older snapshot.
+   */
+  T &back() { return *back_; }
+
+  /**
+   * @brief Method to make the frame of the writer the latest snapshot, from the writer thread.
+   */
+  void publish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(back_, middle_);
+    version_++;
+  }
+
+  /**
+   * @brief Method to get the latest snapshot, from the reader thread. It stays valid until the next call.
+   *
+   * @param version Receives the number of snapshots published so far, 0 if none was, the snapshot is then a
+   * default constructed one.
+   */
+  const T &latest(std::uint64_t &version) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version_ != front_version_) {
+      std::swap(front_, middle_);
+      front_version_ = version_;
+    }
+    version = front_version_;
+    return *front_;
+  }
+
+ private:
+  T frames_[3];
+  T *back_ = &frames_[0];
+  T *middle_ = &frames_[1];
+  T *front_ = &frames_[2];
+  // Member 'mutex_' guards the three pointers and the versions, never the frames.
+  std::mutex mutex_;
+  // Members 'version_' and 'front_version_' number the snapshots published and the one in 'front_'.
+  std::uint64_t version_ = 0;
+  std::uint64_t front_version_ = 0;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_SNAPSHOT_BUFFER_H
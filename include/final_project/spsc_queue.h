@@ -0,0 +1,105 @@
+/**
+ * @file spsc_queue.h
+ * @brief Single-producer/single-consumer lock-free ring buffer.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_SPSC_QUEUE_H
+#define FINAL_PROJECT_SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace final_project {
+
+/**
+ * @brief Bounded ring buffer handing items from exactly one producer thread to exactly one consumer thread.
+ *
+ * Neither side ever blocks or takes a lock. A full queue rejects the new item instead of overwriting an
+ * old one, and the rejections are counted so they can be reported.
+ *
+ * @tparam T Type of the items, must be default constructible and copy assignable.
+ * @tparam Capacity Number of slots, must be a power of two.
+ */
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  /**
+   * @brief Method to add an item, called from the producer thread only.
+   *
+   * @param item Item to add.
+   * @return true if the item was added.
+   * @return false if the queue was full, the item is dropped.
+   */
+  bool try_push(const T &item) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_cache_ == Capacity) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head - tail_cache_ == Capacity) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    slots_[head & (Capacity - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Method to take the oldest item, called from the consumer thread only.
+   *
+   * @param item Receives the oldest item.
+   * @return true if an item was taken.
+   * @return false if the queue was empty.
+   */
+  bool try_pop(T &item) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_cache_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail == head_cache_) {
+        return false;
+      }
+    }
+    item = slots_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Method to check if the queue holds no items, exact only from the consumer thread.
+   */
+  bool empty() const {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Method to get the number of items rejected because the queue was full.
+   */
+  std::size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Method to get the number of slots.
+   */
+  static constexpr std::size_t capacity() { return Capacity; }
+
+ private:
+  // Head and tail live on their own cache lines so the two threads do not share one.
+  alignas(64) std::atomic<std::size_t> head_{0};
+  // Member 'tail_cache_' is the producer's last seen tail.
+  std::size_t tail_cache_ = 0;
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  // Member 'head_cache_' is the consumer's last seen head.
+  std::size_t head_cache_ = 0;
+  alignas(64) std::atomic<std::size_t> dropped_{0};
+  std::array<T, Capacity> slots_{};
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_SPSC_QUEUE_H
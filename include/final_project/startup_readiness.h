@@ -0,0 +1,84 @@
+/**
+ * @file startup_readiness.h
+ * @brief Tracks the dependencies the mission waits for at startup, all at the same time.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_STARTUP_READINESS_H
+#define FINAL_PROJECT_STARTUP_READINESS_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Set of named readiness checks polled together, so startup takes as long as the slowest one.
+ *
+ * Each check is a probe returning true once its dependency is up. A check that passed is not probed again.
+ * Required checks gate the mission, the others are only reported.
+ */
+class StartupReadiness {
+ public:
+  // Returns true once the dependency is up, called from the polling thread only.
+  using Probe = std::function<bool()>;
+
+  /**
+   * @brief Method to add a check.
+   *
+   * @param name Name of the dependency in the report.
+   * @param probe Check of the dependency.
+   * @param required The mission cannot start without the dependency.
+   */
+  void add(const std::string &name, Probe probe, bool required);
+
+  /**
+   * @brief Method to run the probes of the checks that have not passed yet.
+   *
+   * @param elapsed Time since the startup began, in seconds, recorded for the checks that pass.
+   * @return true if every check has passed.
+   * @return false otherwise.
+   */
+  bool poll(double elapsed);
+
+  /**
+   * @brief Method to check if every required check has passed.
+   */
+  bool required_ready() const;
+
+  /**
+   * @brief Method to check if every check has passed.
+   */
+  bool all_ready() const;
+
+  /**
+   * @brief Method to get one line per check, with the time it passed at, or whether it is required if it did not.
+   */
+  std::string report() const;
+
+  /**
+   * @brief Method to get the number of checks.
+   */
+  std::size_t size() const { return checks_.size(); }
+
+ private:
+  struct Check {
+    std::string name;
+    Probe probe;
+    bool required = false;
+    bool ready = false;
+    double ready_after = 0;
+  };
+
+  // Member 'checks_' holds the checks in the order they were added.
+  std::vector<Check> checks_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_STARTUP_READINESS_H
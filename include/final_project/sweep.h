@@ -0,0 +1,152 @@
+/**
+ * @file sweep.h
+ * @brief Parallel sweep of missions, each in a ROS graph of its own, with the results of every mission gathered.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_SWEEP_H
+#define FINAL_PROJECT_SWEEP_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "final_project/bench_report.h"
+
+namespace final_project {
+
+// Arguments of a launch file, as name:=value on the roslaunch command line.
+using LaunchArgs = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief Struct holding one mission of a sweep, e.g. a world, a marker layout and a fleet.
+ *
+ */
+struct SweepJob {
+  // Member 'name' names the job, it is the directory of the job under the report directory.
+  std::string name;
+  // Member 'args' contains the arguments of the launch file, they override the common ones of the sweep.
+  LaunchArgs args;
+};
+
+/**
+ * @brief Struct holding the outcome of one job of a sweep.
+ *
+ */
+struct SweepResult {
+  // Member 'job' contains the name of the job.
+  std::string job;
+  // Member 'exit_status' contains the exit status of roslaunch, -1 if it did not start or was stopped.
+  int exit_status = -1;
+  // Member 'timed_out' is raised if the job ran out of time, or the sweep was cancelled while it ran.
+  bool timed_out = false;
+  // Member 'wall_time' contains the time from the start of roslaunch to its exit, in seconds.
+  double wall_time = 0;
+  // Member 'report' contains the CSV report of the trials of the job.
+  std::string report;
+  // Member 'trials' contains the trials read back from 'report', none if it was not written.
+  std::vector<BenchTrial> trials;
+};
+
+/**
+ * @brief Class running the jobs of a sweep on a pool of worker threads, one roslaunch of the bench per job.
+ *
+ * ROS1 allows one node and one clock per process, and each job runs a simulator publishing its own /clock, so each
+ * job is a process tree of its own: roslaunch starts a master on a port of the job and the nodes of the launch file
+ * talk to it only. The Gazebo server of a job, when it does not run the kinematic simulator, listens on a port of
+ * the job too. A job also gets its own ROS_HOME, the distance field and marker caches, the logs and the report
+ * land in its directory and never collide with those of the other jobs. A worker only waits for its roslaunch.
+ */
+class SweepExecutor {
+ public:
+  /**
+   * @brief Struct holding the parameters of the sweep.
+   *
+   */
+  struct Params {
+    // Member 'workers' contains the jobs run at once, 0 for one per two hardware threads, the simulator and the
+    // mission of a job each keep one busy.
+    int workers = 0;
+    // Member 'base_port' contains the port of the master of the first job, job i uses base_port + i.
+    int base_port = 11411;
+    // Member 'gazebo_base_port' contains the port of the Gazebo server of the first job, job i uses
+    // gazebo_base_port + i. The ports of the masters and of the Gazebo servers must not overlap.
+    int gazebo_base_port = 12345;
+    // Member 'timeout' contains the time a job may run before it is stopped, in seconds.
+    double timeout = 3600;
+    // Member 'grace' contains the time a stopped roslaunch has to shut its nodes down before it is killed.
+    double grace = 30;
+    // Members 'package' and 'launch' name the launch file of the jobs.
+    std::string package = "final_project";
+    std::string launch = "bench.launch";
+    // Member 'args' contains the arguments of the launch file common to all the jobs.
+    LaunchArgs args;
+    // Member 'report_dir' contains the directory the jobs get their directories in, created if needed.
+    std::string report_dir;
+  };
+
+  explicit SweepExecutor(const Params &params);
+
+  /**
+   * @brief Method to run the jobs, blocks until they all exited.
+   *
+   * @param jobs Jobs of the sweep, their names must be distinct valid directory names.
+   * @return std::vector<SweepResult> Outcome of each job, in the order of 'jobs'.
+   */
+  std::vector<SweepResult> run(const std::vector<SweepJob> &jobs);
+
+  /**
+   * @brief Method to stop the running jobs and skip the others, safe to call from a signal handler.
+   */
+  void cancel() { cancelled_ = true; }
+
+  /**
+   * @brief Method to get the number of jobs run at once.
+   */
+  int workers() const { return workers_; }
+
+ private:
+  /**
+   * @brief Method to run one job and wait for it, stopping it once it ran out of time.
+   *
+   * @param index Index of the job, it picks the port of its master.
+   * @param job Job to run.
+   */
+  SweepResult run_job(std::size_t index, const SweepJob &job);
+
+  // Member 'params_' contains the parameters of the sweep.
+  Params params_;
+  // Member 'workers_' contains the jobs run at once, that of the parameters resolved.
+  int workers_ = 1;
+  // Member 'cancelled_' is raised by cancel().
+  std::atomic<bool> cancelled_{false};
+};
+
+/**
+ * @brief Method to write one CSV row per job, its status and a summary of its trials.
+ *
+ * @param path File to write, replaced if it exists.
+ * @param results Outcome of the jobs.
+ * @return true if the file was written.
+ * @return false otherwise.
+ */
+bool write_sweep_csv(const std::string &path, const std::vector<SweepResult> &results);
+
+/**
+ * @brief Method to write the jobs as a JSON array of objects, with the same fields as the CSV.
+ *
+ * @param path File to write, replaced if it exists.
+ * @param results Outcome of the jobs.
+ * @return true if the file was written.
+ * @return false otherwise.
+ */
+bool write_sweep_json(const std::string &path, const std::vector<SweepResult> &results);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_SWEEP_H
@@ -0,0 +1,149 @@
+/**
+ * @file target_registry.h
+ * @brief Lookup targets of the explorers and markers localized so far, sized at runtime.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_TARGET_REGISTRY_H
+#define FINAL_PROJECT_TARGET_REGISTRY_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "final_project/flat_index_map.h"
+
+namespace final_project {
+
+/**
+ * @brief Struct holding one lookup location the explorer drives to and looks for a marker from.
+ *
+ */
+struct LookupTarget {
+  // Member 'x' contains x-coordinate of the lookup location in map frame.
+  double x = 0;
+  // Member 'y' contains y-coordinate of the lookup location in map frame.
+  double y = 0;
+  // Member 'fiducial_id' contains the fiducial_id of the marker found from this location, -1 until one is found.
+  int fiducial_id = -1;
+};
+
+/**
+ * @brief Struct holding the follower location of one localized marker.
+ *
+ */
+struct MarkerLocation {
+  // Member 'fiducial_id' contains the fiducial_id of the explorer-detected aruco tag.
+  int fiducial_id = -1;
+  // Member 'x' contains x-coordinate of follower target location in map frame.
+  double x = 0;
+  // Member 'y' contains y-coordinate of follower target location in map frame.
+  double y = 0;
+  // Member 'yaw' contains the heading that looks at the marker from the follower target location.
+  double yaw = 0;
+};
+
+/**
+ * @brief Registry of the lookup targets and of the markers, with no bound on either count.
+ *
+ * Targets and markers live in dense arrays in the order they are added, so the route planners and the summary
+ * walk contiguous memory. Markers are found from their fiducial_id through a flat hash map, so ids of any size
+ * are accepted and a lookup stays O(1).
+ */
+class TargetRegistry {
+ public:
+  /**
+   * @brief Method to add a lookup target.
+   *
+   * @return int Index of the new target.
+   */
+  int add_target(double x, double y);
+
+  /**
+   * @brief Method to get the number of lookup targets.
+   */
+  std::size_t target_count() const { return targets_.size(); }
+
+  /**
+   * @brief Method to get a lookup target.
+   *
+   * @param index Index of the target, below target_count().
+   */
+  const LookupTarget &target(int index) const { return targets_[index]; }
+
+  /**
+   * @brief Method to get the location of every lookup target, in index order.
+   */
+  std::vector<std::array<double, 2>> target_points() const;
+
+  /**
+   * @brief Method to record the marker found from a lookup target.
+   *
+   * @param index Index of the target.
+   * @param fiducial_id fiducial_id of the marker.
+   */
+  void set_target_fiducial(int index, int fiducial_id) { targets_[index].fiducial_id = fiducial_id; }
+
+  /**
+   * @brief Method to check if the marker of a lookup target was found.
+   *
+   * @param index Index of the target.
+   */
+  bool target_done(int index) const { return targets_[index].fiducial_id >= 0; }
+
+  /**
+   * @brief Method to get the index of a marker.
+   *
+   * @param fiducial_id fiducial_id of the marker.
+   * @return int Index of the marker, -1 if it was never added.
+   */
+  int find_marker(int fiducial_id) const { return marker_of_id_.find(fiducial_id); }
+
+  /**
+   * @brief Method to set the follower location of a marker, adding the marker on its first call.
+   *
+   * @param fiducial_id fiducial_id of the marker.
+   * @param x x-coordinate of the follower location in map frame.
+   * @param y y-coordinate of the follower location in map frame.
+   * @param yaw Heading that looks at the marker from the follower location.
+   * @return int Index of the marker.
+   */
+  int update_marker(int fiducial_id, double x, double y, double yaw);
+
+  /**
+   * @brief Method to get the number of markers.
+   */
+  std::size_t marker_count() const { return markers_.size(); }
+
+  /**
+   * @brief Method to get a marker.
+   *
+   * @param index Index of the marker, below marker_count().
+   */
+  const MarkerLocation &marker(int index) const { return markers_[index]; }
+
+  /**
+   * @brief Method to make room for a number of markers, so adding up to that many never allocates.
+   */
+  void reserve_markers(std::size_t markers);
+
+  /**
+   * @brief Method to remove every target and marker, the room made for them is kept.
+   */
+  void clear();
+
+ private:
+  // Member 'targets_' holds the lookup targets in the order they were added.
+  std::vector<LookupTarget> targets_;
+  // Member 'markers_' holds the markers in the order they were first localized.
+  std::vector<MarkerLocation> markers_;
+  // Member 'marker_of_id_' maps a fiducial_id to its index in 'markers_'.
+  FlatIndexMap marker_of_id_;
+};
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_TARGET_REGISTRY_H
@@ -0,0 +1,52 @@
+/**
+ * @file xmlrpc_params.h
+ * @brief Parsing of the structured parameters the mission and the simulator share.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef FINAL_PROJECT_XMLRPC_PARAMS_H
+#define FINAL_PROJECT_XMLRPC_PARAMS_H
+
+#include <ros/ros.h>
+
+#include <array>
+#include <vector>
+
+namespace final_project {
+
+/**
+ * @brief Method to read a number from a parameter, which YAML may have typed as an int.
+ *
+ * @param value Parameter to read.
+ * @param number Receives the number.
+ * @return true if the parameter is a number.
+ * @return false otherwise.
+ */
+bool xmlrpc_number(XmlRpc::XmlRpcValue &value, double &number);
+
+/**
+ * @brief Method to read a point from a parameter holding a list [x, y].
+ *
+ * @param value Parameter to read.
+ * @param point Receives the point.
+ * @return true if the parameter is a list of two numbers.
+ * @return false otherwise.
+ */
+bool xmlrpc_point(XmlRpc::XmlRpcValue &value, std::array<double, 2> &point);
+
+/**
+ * @brief Method to read the lookup targets of the explorer, aruco_lookup_locations as loaded from
+ * param/aruco_lookup.yaml.
+ *
+ * @param nh Nodehandle the parameter is looked up in.
+ * @return std::vector<std::array<double, 2>> Targets in the order of the number ending their names, target_1,
+ * target_2, ..., those that are not a list [x, y] are dropped with a warning.
+ */
+std::vector<std::array<double, 2>> read_lookup_locations(ros::NodeHandle &nh);
+
+}  // namespace final_project
+
+#endif  // FINAL_PROJECT_XMLRPC_PARAMS_H
@@ -0,0 +1,64 @@
+/**
+ * @file allocation_counter.cpp
+ * @brief Per-thread count of the heap allocations, to check that the hot path of the mission allocates nothing.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/allocation_counter.h"
+
+#ifdef FINAL_PROJECT_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Allocations of each thread, zero-initialized so it is usable before any constructor ran.
+thread_local std::uint64_t allocations = 0;
+
+void *counted_malloc(std::size_t size) {
+  allocations++;
+  // malloc(0) may return a null pointer, operator new may not.
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *counted_new(std::size_t size) {
+  void *pointer = counted_malloc(size);
+  while (pointer == nullptr) {
+    const std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+    pointer = std::malloc(size == 0 ? 1 : size);
+  }
+  return pointer;
+}
+
+}  // namespace
+
+void *operator new(std::size_t size) { return counted_new(size); }
+void *operator new[](std::size_t size) { return counted_new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return counted_malloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return counted_malloc(size); }
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+
+bool final_project::allocations_counted() { return true; }
+
+std::uint64_t final_project::thread_allocations() { return allocations; }
+
+#else
+
+bool final_project::allocations_counted() { return false; }
+
+std::uint64_t final_project::thread_allocations() { return 0; }
+
+#endif
@@ -0,0 +1,292 @@
+/**
+ * @file bench.cpp
+ * @brief Benchmark running the mission for several seeded trials with the markers moved between trials.
+ * @version 0.1
+ * @date 2021-12-15
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+#include <actionlib_msgs/GoalID.h>
+#include <gazebo_msgs/GetModelState.h>
+#include <gazebo_msgs/SetModelState.h>
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include <geometry_msgs/Twist.h>
+#include <nav_msgs/Odometry.h>
+#include <ros/ros.h>
+#include <std_srvs/Empty.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2/utils.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "final_project/bench_report.h"
+#include "final_project/fleet.h"
+#include "final_project/mission.h"
+
+/**
+ * @brief Struct holding a robot of the benchmark and the distance it drove in the current trial.
+ * 
+ */
+struct bench_robot {
+  // Member 'spec' contains the names and home of the robot.
+  final_project::RobotSpec spec;
+  // Member 'odom' integrates the distance driven from the odometry of the robot.
+  ros::Subscriber odom;
+  // Member 'distance' contains the distance driven in the current trial, in meters.
+  std::atomic<double> distance{0};
+  // Member 'last' contains the last odometry position, 'has_last' is raised once there is one.
+  double last_x = 0;
+  double last_y = 0;
+  bool has_last = false;
+};
+
+/**
+ * @brief Struct holding the pose of a marker model in the world.
+ * 
+ */
+struct marker_pose {
+  std::string model;
+  geometry_msgs::Pose pose;
+};
+
+// Raised while a trial runs, the odometry of the robots only counts then.
+std::atomic<bool> trial_running{false};
+
+/**
+ * @brief Method to move a model of the world, with zero velocity.
+ * 
+ * @param set_state Client of /gazebo/set_model_state.
+ * @param model Name of the model.
+ * @param pose New pose of the model in the world frame.
+ * @return true if Gazebo moved the model.
+ * @return false otherwise, the reason is logged.
+ */
+bool set_model_pose(ros::ServiceClient &set_state, const std::string &model, const geometry_msgs::Pose &pose)
+{
+  gazebo_msgs::SetModelState srv;
+  srv.request.model_state.model_name = model;
+  srv.request.model_state.pose = pose;
+  srv.request.model_state.reference_frame = "world";
+  if (!set_state.call(srv) || !srv.response.success) {
+    ROS_WARN_STREAM("Could not move " << model << ": " << srv.response.status_message);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Method to get a pose with a position and a heading.
+ */
+geometry_msgs::Pose make_pose(double x, double y, double z, double yaw)
+{
+  geometry_msgs::Pose pose;
+  pose.position.x = x;
+  pose.position.y = y;
+  pose.position.z = z;
+  tf2::Quaternion rotation;
+  rotation.setRPY(0, 0, yaw);
+  pose.orientation = tf2::toMsg(rotation);
+  return pose;
+}
+
+/**
+ * @brief Method to slide every marker along its wall and turn it a little, from the seed of the trial.
+ * 
+ * The markers face along their x-axis, so the slide is along their y-axis and keeps them on their wall.
+ * 
+ * @param set_state Client of /gazebo/set_model_state.
+ * @param markers Poses of the markers in the world file.
+ * @param seed Seed of the trial.
+ * @param jitter Largest slide, in meters.
+ * @param yaw_jitter Largest turn, in radians.
+ */
+void place_markers(ros::ServiceClient &set_state, const std::vector<marker_pose> &markers, std::uint32_t seed,
+                   double jitter, double yaw_jitter)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> slide(-jitter, jitter);
+  std::uniform_real_distribution<double> turn(-yaw_jitter, yaw_jitter);
+  for (const marker_pose &marker : markers) {
+    const double yaw = tf2::getYaw(marker.pose.orientation);
+    const double offset = slide(rng);
+    set_model_pose(set_state, marker.model,
+                   make_pose(marker.pose.position.x - std::sin(yaw) * offset,
+                             marker.pose.position.y + std::cos(yaw) * offset, marker.pose.position.z,
+                             yaw + turn(rng)));
+  }
+}
+
+/**
+ * @brief Method to stop a robot, put it back home and tell its localization and costmaps about it.
+ * 
+ * @param nh Nodehandle for a ROS node
+ * @param set_state Client of /gazebo/set_model_state.
+ * @param robot Robot to reset, its Gazebo model has the name of the robot.
+ */
+void reset_robot(ros::NodeHandle &nh, ros::ServiceClient &set_state, const final_project::RobotSpec &robot)
+{
+  // A trial that timed out leaves its goal active.
+  ros::Publisher cancel = nh.advertise<actionlib_msgs::GoalID>(robot.move_base_action + "/cancel", 1);
+  ros::Publisher cmd_vel = nh.advertise<geometry_msgs::Twist>(robot.cmd_vel, 1);
+  ros::Publisher initial_pose = nh.advertise<geometry_msgs::PoseWithCovarianceStamped>(
+      "/" + robot.name + "/initialpose", 1);
+  // Give the new publishers time to connect.
+  ros::WallDuration(0.5).sleep();
+  cancel.publish(actionlib_msgs::GoalID());
+  cmd_vel.publish(geometry_msgs::Twist());
+
+  set_model_pose(set_state, robot.name, make_pose(robot.home_x, robot.home_y, 0, 0));
+
+  geometry_msgs::PoseWithCovarianceStamped pose;
+  pose.header.frame_id = "map";
+  pose.header.stamp = ros::Time::now();
+  pose.pose.pose = make_pose(robot.home_x, robot.home_y, 0, 0);
+  pose.pose.covariance[0] = 0.01;
+  pose.pose.covariance[7] = 0.01;
+  pose.pose.covariance[35] = 0.01;
+  initial_pose.publish(pose);
+
+  // The planner service lives on the move_base node, next to clear_costmaps.
+  const std::string planner_suffix = "make_plan";
+  if (robot.planner.size() > planner_suffix.size()) {
+    const std::string clear = robot.planner.substr(0, robot.planner.size() - planner_suffix.size()) + "clear_costmaps";
+    std_srvs::Empty srv;
+    if (!ros::service::call(clear, srv)) {
+      ROS_WARN_STREAM("Could not call " << clear);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "final_project_bench");
+  ros::NodeHandle nh;
+  // The mission reads its tuning from the private namespace of the benchmark, e.g. ~mission_mode.
+  ros::NodeHandle pnh("~");
+
+  int trials = 5;
+  pnh.param("bench/trials", trials, trials);
+  int seed = 1;
+  pnh.param("bench/seed", seed, seed);
+  double jitter = 0.3;
+  pnh.param("bench/marker_jitter", jitter, jitter);
+  double yaw_jitter = 0.15;
+  pnh.param("bench/yaw_jitter", yaw_jitter, yaw_jitter);
+  // Simulated time a trial may take before it is stopped and counted as not completed.
+  double trial_timeout = 900.0;
+  pnh.param("bench/trial_timeout", trial_timeout, trial_timeout);
+  double settle_time = 3.0;
+  pnh.param("bench/settle_time", settle_time, settle_time);
+  std::vector<std::string> marker_models{"aruco_marker_0", "aruco_marker_1", "aruco_marker_2", "aruco_marker_3"};
+  pnh.param("bench/markers", marker_models, marker_models);
+  std::string csv_path;
+  pnh.param<std::string>("bench/csv", csv_path, "final_project_bench.csv");
+  std::string json_path;
+  pnh.param<std::string>("bench/json", json_path, "final_project_bench.json");
+  std::string mode;
+  pnh.param<std::string>("mission_mode", mode, "polling");
+
+  // One spinner thread serves the mission too, which keeps its fiducial callbacks the only producer of its queue.
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  ros::ServiceClient get_state = nh.serviceClient<gazebo_msgs::GetModelState>("/gazebo/get_model_state");
+  ros::ServiceClient set_state = nh.serviceClient<gazebo_msgs::SetModelState>("/gazebo/set_model_state");
+  if (!get_state.waitForExistence(ros::Duration(120.0)) || !set_state.waitForExistence(ros::Duration(10.0))) {
+    ROS_FATAL("Gazebo is not running");
+    return 1;
+  }
+  std::vector<marker_pose> markers;
+  for (const std::string &model : marker_models) {
+    gazebo_msgs::GetModelState srv;
+    srv.request.model_name = model;
+    if (!get_state.call(srv) || !srv.response.success) {
+      ROS_WARN_STREAM("No model " << model << " in the world, it is not moved");
+      continue;
+    }
+    markers.push_back({model, srv.response.pose});
+  }
+
+  std::deque<bench_robot> robots;
+  for (const final_project::RobotSpec &spec : final_project::read_fleet(pnh)) {
+    robots.emplace_back();
+    bench_robot &robot = robots.back();
+    robot.spec = spec;
+    robot.odom = nh.subscribe<nav_msgs::Odometry>("/" + spec.name + "/odom", 10,
+        [&robot](const nav_msgs::Odometry::ConstPtr &msg) {
+          const double x = msg->pose.pose.position.x;
+          const double y = msg->pose.pose.position.y;
+          if (trial_running.load() && robot.has_last) {
+            // Only the spinner thread writes the distance.
+            robot.distance.store(robot.distance.load() + std::hypot(x - robot.last_x, y - robot.last_y));
+          }
+          robot.last_x = x;
+          robot.last_y = y;
+          robot.has_last = true;
+        });
+  }
+
+  std::vector<final_project::BenchTrial> results;
+  for (int trial = 0; trial < trials && ros::ok(); trial++) {
+    const std::uint32_t trial_seed = static_cast<std::uint32_t>(seed + trial);
+    ROS_INFO_STREAM("Trial " << trial + 1 << "/" << trials << ", seed " << trial_seed << ", mode " << mode);
+    place_markers(set_state, markers, trial_seed, jitter, yaw_jitter);
+    for (bench_robot &robot : robots) {
+      reset_robot(nh, set_state, robot.spec);
+      robot.distance.store(0);
+    }
+    ros::Duration(settle_time).sleep();
+
+    final_project::MissionHost host;
+    host.spin = false;
+    final_project::Mission trial_mission(host);
+    ros::Timer timeout = nh.createTimer(ros::Duration(trial_timeout), [&trial_mission](const ros::TimerEvent &) {
+      ROS_WARN("Trial timed out");
+      trial_mission.stop();
+    }, true);
+    trial_running.store(true);
+    const int status = trial_mission.run(nh, pnh);
+    trial_running.store(false);
+    timeout.stop();
+
+    const final_project::MissionResult mission = trial_mission.last_result();
+    final_project::BenchTrial result;
+    result.trial = trial;
+    result.seed = trial_seed;
+    result.mode = mode;
+    result.completed = status == 0 && mission.completed;
+    result.mission_time = mission.duration;
+    result.target_times = mission.target_times;
+    result.markers = mission.markers;
+    for (const bench_robot &robot : robots) {
+      (robot.spec.role == final_project::RobotRole::Explorer ? result.explorer_distance : result.follower_distance) +=
+          robot.distance.load();
+    }
+    for (const auto &stage : mission.stages) {
+      if (stage.first == "tf_failure") {
+        result.tf_failures = stage.second.count;
+        result.tf_time_lost = stage.second.sum;
+      } else if (stage.first == "rotation") {
+        result.rotation_time = stage.second.sum;
+      }
+    }
+    results.push_back(result);
+    ROS_INFO_STREAM("Trial " << trial + 1 << (result.completed ? " completed" : " did not complete") << " in "
+                    << result.mission_time << " s, " << result.markers << " markers");
+
+    // Written after every trial, so an interrupted run keeps the trials done so far.
+    if (!final_project::write_bench_csv(csv_path, results) || !final_project::write_bench_json(json_path, results)) {
+      ROS_ERROR_STREAM("Could not write the report to " << csv_path << " and " << json_path);
+    }
+  }
+  ROS_INFO_STREAM("Benchmark report written to " << csv_path << " and " << json_path);
+  ros::shutdown();
+  return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file bench_report.cpp
+ * @brief Results of the benchmark trials, written as CSV and JSON.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/bench_report.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace final_project {
+
+namespace {
+
+// Escapes the characters a mode name could break the JSON string with.
+std::string json_string(const std::string &text) {
+  std::string escaped = "\"";
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+// Splits a line at every 'separator', an empty line gives one empty field.
+std::vector<std::string> split(const std::string &line, char separator) {
+  std::vector<std::string> fields;
+  std::istringstream stream(line);
+  std::string field;
+  while (std::getline(stream, field, separator)) {
+    fields.push_back(field);
+  }
+  if (fields.empty() || line.back() == separator) {
+    fields.emplace_back();
+  }
+  return fields;
+}
+
+}  // namespace
+
+bool write_bench_csv(const std::string &path, const std::vector<BenchTrial> &trials) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << std::fixed << std::setprecision(4);
+  out << "trial,seed,mode,completed,mission_time,markers,explorer_distance,follower_distance,tf_failures,"
+         "tf_time_lost,rotation_time,target_times\n";
+  for (const BenchTrial &trial : trials) {
+    out << trial.trial << "," << trial.seed << "," << trial.mode << "," << (trial.completed ? 1 : 0) << ","
+        << trial.mission_time << "," << trial.markers << "," << trial.explorer_distance << ","
+        << trial.follower_distance << "," << trial.tf_failures << "," << trial.tf_time_lost << ","
+        << trial.rotation_time << ",";
+    for (std::size_t i = 0; i < trial.target_times.size(); i++) {
+      out << (i > 0 ? ";" : "") << trial.target_times[i];
+    }
+    out << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+bool write_bench_json(const std::string &path, const std::vector<BenchTrial> &trials) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << std::fixed << std::setprecision(4);
+  out << "[";
+  for (std::size_t t = 0; t < trials.size(); t++) {
+    const BenchTrial &trial = trials[t];
+    out << (t > 0 ? "," : "") << "\n  {\"trial\": " << trial.trial << ", \"seed\": " << trial.seed
+        << ", \"mode\": " << json_string(trial.mode) << ", \"completed\": " << (trial.completed ? "true" : "false")
+        << ", \"mission_time\": " << trial.mission_time << ", \"markers\": " << trial.markers
+        << ", \"explorer_distance\": " << trial.explorer_distance
+        << ", \"follower_distance\": " << trial.follower_distance << ", \"tf_failures\": " << trial.tf_failures
+        << ", \"tf_time_lost\": " << trial.tf_time_lost << ", \"rotation_time\": " << trial.rotation_time
+        << ", \"target_times\": [";
+    for (std::size_t i = 0; i < trial.target_times.size(); i++) {
+      out << (i > 0 ? ", " : "") << trial.target_times[i];
+    }
+    out << "]}";
+  }
+  out << "\n]\n";
+  return static_cast<bool>(out);
+}
+
+bool read_bench_csv(const std::string &path, std::vector<BenchTrial> &trials) {
+  trials.clear();
+  std::ifstream in(path);
+  std::string line;
+  if (!in || !std::getline(in, line)) {
+    return false;
+  }
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    const std::vector<std::string> fields = split(line, ',');
+    if (fields.size() != 12) {
+      return false;
+    }
+    BenchTrial trial;
+    try {
+      trial.trial = std::stoi(fields[0]);
+      trial.seed = static_cast<std::uint32_t>(std::stoul(fields[1]));
+      trial.mode = fields[2];
+      trial.completed = fields[3] == "1";
+      trial.mission_time = std::stod(fields[4]);
+      trial.markers = std::stoul(fields[5]);
+      trial.explorer_distance = std::stod(fields[6]);
+      trial.follower_distance = std::stod(fields[7]);
+      trial.tf_failures = std::stoull(fields[8]);
+      trial.tf_time_lost = std::stod(fields[9]);
+      trial.rotation_time = std::stod(fields[10]);
+      if (!fields[11].empty()) {
+        for (const std::string &time : split(fields[11], ';')) {
+          trial.target_times.push_back(std::stod(time));
+        }
+      }
+    } catch (const std::exception &) {
+      return false;
+    }
+    trials.push_back(trial);
+  }
+  return true;
+}
+
+}  // namespace final_project
@@ -0,0 +1,103 @@
+/**
+ * @file detector_gate.cpp
+ * @brief Turns the marker detector of an explorer on and off, and hides the markers already localized from it.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/detector_gate.h"
+
+#include <std_msgs/String.h>
+#include <std_srvs/SetBool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace final_project {
+
+DetectorGate::DetectorGate(ros::NodeHandle &nh, const std::string &detector)
+    : detector_(detector),
+      enable_client_(nh.serviceClient<std_srvs::SetBool>(detector + "/enable_detections")),
+      ignore_pub_(nh.advertise<std_msgs::String>(detector + "/ignore_fiducials", 1, true)),
+      worker_(&DetectorGate::run, this) {}
+
+DetectorGate::~DetectorGate() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  worker_.join();
+}
+
+void DetectorGate::set_enabled(bool enabled) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    desired_ = enabled;
+  }
+  wake_.notify_one();
+}
+
+void DetectorGate::ignore(int fiducial_id) {
+  std_msgs::String msg;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::find(ignored_.begin(), ignored_.end(), fiducial_id) != ignored_.end()) {
+      return;
+    }
+    ignored_.push_back(fiducial_id);
+    msg.data = ignore_list(ignored_);
+  }
+  ignore_pub_.publish(msg);
+}
+
+std::string DetectorGate::ignore_list(std::vector<int> ids) {
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  std::ostringstream out;
+  for (std::size_t i = 0; i < ids.size();) {
+    std::size_t last = i;
+    while (last + 1 < ids.size() && ids[last + 1] == ids[last] + 1) {
+      ++last;
+    }
+    out << (i > 0 ? "," : "") << ids[i];
+    if (last > i) {
+      out << "-" << ids[last];
+    }
+    i = last + 1;
+  }
+  return out.str();
+}
+
+void DetectorGate::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this]() { return stop_ || desired_ != applied_; });
+    if (desired_ == applied_) {
+      return;
+    }
+    const bool enabled = desired_;
+    lock.unlock();
+    std_srvs::SetBool srv;
+    srv.request.data = enabled;
+    const bool applied = enable_client_.call(srv) && srv.response.success;
+    lock.lock();
+    if (applied) {
+      applied_ = enabled;
+      ROS_DEBUG_STREAM(detector_ << (enabled ? " enabled" : " disabled"));
+      continue;
+    }
+    ROS_WARN_STREAM_THROTTLE(10.0, "Could not " << (enabled ? "enable " : "disable ") << detector_
+                             << ", it keeps its current state");
+    if (stop_) {
+      return;
+    }
+    // The detector may not be up yet, try again later unless the request changes.
+    wake_.wait_for(lock, std::chrono::seconds(1), [this, enabled]() { return stop_ || desired_ != enabled; });
+  }
+}
+
+}  // namespace final_project
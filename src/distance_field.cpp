@@ -0,0 +1,573 @@
+/**
+ * @file distance_field.cpp
+ * @brief Path lengths over the static map, precomputed from the known targets and cached on disk.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/distance_field.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <sstream>
+#include <utility>
+
+namespace final_project {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'P', 'D', 'F', 'C', 'A', 'C', 'H'};
+constexpr std::uint32_t kVersion = 1;
+constexpr float kUnreachable = std::numeric_limits<float>::infinity();
+
+/**
+ * @brief Struct at the start of the cache file, followed by the source cells and the fields.
+ */
+struct CacheHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t source_count;
+  // Member 'key' hashes the map and the source cells, a mismatch means the cache is stale.
+  std::uint64_t key;
+};
+
+void set_error(std::string *error, const std::string &message) {
+  if (error != nullptr) {
+    *error = message;
+  }
+}
+
+std::uint64_t fnv1a(std::uint64_t hash, const void *data, std::size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string trim(const std::string &text) {
+  const auto first = text.find_first_not_of(" \t\r\"'");
+  if (first == std::string::npos) {
+    return "";
+  }
+  const auto last = text.find_last_not_of(" \t\r\"'");
+  return text.substr(first, last - first + 1);
+}
+
+// Parses a finite real number, false if 'text' holds anything else.
+bool parse_double(const std::string &text, double &value) {
+  char *end = nullptr;
+  errno = 0;
+  value = std::strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0' && errno == 0 && std::isfinite(value);
+}
+
+// Parses a whole integer, false if 'text' holds anything else or it does not fit an int.
+bool parse_int(const std::string &text, int &value) {
+  char *end = nullptr;
+  errno = 0;
+  const long parsed = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || errno != 0 || parsed < std::numeric_limits<int>::min() ||
+      parsed > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  value = static_cast<int>(parsed);
+  return true;
+}
+
+/**
+ * @brief Method to read the next header token of a PGM file, skipping comments.
+ */
+bool pgm_token(std::istream &in, std::string &token) {
+  token.clear();
+  char c;
+  while (in.get(c)) {
+    if (c == '#') {
+      std::string comment;
+      std::getline(in, comment);
+    } else if (!std::isspace(static_cast<unsigned char>(c))) {
+      token.push_back(c);
+      break;
+    }
+  }
+  while (in.get(c) && !std::isspace(static_cast<unsigned char>(c))) {
+    token.push_back(c);
+  }
+  return !token.empty();
+}
+
+}  // namespace
+
+bool OccupancyBitmap::load(const std::string &yaml_path, OccupancyBitmap &bitmap, std::string *error) {
+  std::ifstream yaml(yaml_path);
+  if (!yaml) {
+    set_error(error, "cannot open " + yaml_path);
+    return false;
+  }
+  std::string image;
+  double resolution = 0;
+  double origin[3] = {0, 0, 0};
+  int negate = 0;
+  double occupied_thresh = 0.65;
+  double free_thresh = 0.196;
+  std::string line;
+  while (std::getline(yaml, line)) {
+    const auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    const std::string key = trim(line.substr(0, colon));
+    const std::string value = trim(line.substr(colon + 1));
+    bool parsed = true;
+    if (key == "image") {
+      image = value;
+    } else if (key == "resolution") {
+      parsed = parse_double(value, resolution);
+    } else if (key == "negate") {
+      parsed = parse_int(value, negate);
+    } else if (key == "occupied_thresh") {
+      parsed = parse_double(value, occupied_thresh);
+    } else if (key == "free_thresh") {
+      parsed = parse_double(value, free_thresh);
+    } else if (key == "origin") {
+      std::string list = value;
+      for (char &c : list) {
+        if (c == '[' || c == ']' || c == ',') {
+          c = ' ';
+        }
+      }
+      std::istringstream values(list);
+      parsed = static_cast<bool>(values >> origin[0] >> origin[1] >> origin[2]);
+    }
+    if (!parsed) {
+      set_error(error, yaml_path + " has a bad " + key + ": " + value);
+      return false;
+    }
+  }
+  if (image.empty() || resolution <= 0) {
+    set_error(error, yaml_path + " has no image or resolution");
+    return false;
+  }
+  if (image[0] != '/') {
+    const auto slash = yaml_path.find_last_of('/');
+    if (slash != std::string::npos) {
+      image = yaml_path.substr(0, slash + 1) + image;
+    }
+  }
+
+  std::ifstream pgm(image, std::ios::binary);
+  std::string magic, width_token, height_token, maxval_token;
+  if (!pgm || !pgm_token(pgm, magic) || magic != "P5" || !pgm_token(pgm, width_token) ||
+      !pgm_token(pgm, height_token) || !pgm_token(pgm, maxval_token)) {
+    set_error(error, "cannot read 8-bit binary PGM " + image);
+    return false;
+  }
+  int width = 0;
+  int height = 0;
+  int maxval = 0;
+  if (!parse_int(width_token, width) || !parse_int(height_token, height) || width <= 0 || height <= 0) {
+    set_error(error, image + " has a bad size: " + width_token + " x " + height_token);
+    return false;
+  }
+  if (!parse_int(maxval_token, maxval) || maxval < 1 || maxval > 255) {
+    set_error(error, image + " has a bad maxval for an 8-bit PGM: " + maxval_token);
+    return false;
+  }
+  bitmap.width_ = width;
+  bitmap.height_ = height;
+  bitmap.resolution_ = resolution;
+  bitmap.origin_x_ = origin[0];
+  bitmap.origin_y_ = origin[1];
+  const std::size_t cells = static_cast<std::size_t>(bitmap.width_) * bitmap.height_;
+  bitmap.bits_.assign((cells + 63) / 64, 0);
+  std::vector<unsigned char> pixels(cells);
+  if (!pgm.read(reinterpret_cast<char *>(pixels.data()), static_cast<std::streamsize>(cells))) {
+    set_error(error, image + " is truncated");
+    return false;
+  }
+  for (int image_row = 0; image_row < bitmap.height_; ++image_row) {
+    // The first image row is the top of the map.
+    const int row = bitmap.height_ - 1 - image_row;
+    for (int col = 0; col < bitmap.width_; ++col) {
+      const double value = pixels[static_cast<std::size_t>(image_row) * bitmap.width_ + col] / 255.0;
+      const double occupancy = negate ? value : 1.0 - value;
+      // Occupied and unknown cells are both blocked, only free cells can be driven through.
+      if (occupancy >= free_thresh || occupancy > occupied_thresh) {
+        bitmap.set_blocked(col, row, true);
+      }
+    }
+  }
+  return true;
+}
+
+void OccupancyBitmap::set_blocked(int col, int row, bool blocked) {
+  const std::size_t index = static_cast<std::size_t>(row) * width_ + col;
+  if (blocked) {
+    bits_[index >> 6] |= std::uint64_t(1) << (index & 63);
+  } else {
+    bits_[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+  }
+}
+
+void OccupancyBitmap::inflate(double radius) {
+  const int reach = static_cast<int>(std::ceil(radius / resolution_));
+  if (reach <= 0) {
+    return;
+  }
+  const OccupancyBitmap original = *this;
+  for (int row = 0; row < height_; ++row) {
+    for (int col = 0; col < width_; ++col) {
+      if (!original.blocked(col, row)) {
+        continue;
+      }
+      for (int dr = -reach; dr <= reach; ++dr) {
+        for (int dc = -reach; dc <= reach; ++dc) {
+          const int c = col + dc;
+          const int r = row + dr;
+          if (c >= 0 && r >= 0 && c < width_ && r < height_ && dc * dc + dr * dr <= reach * reach) {
+            set_blocked(c, r, true);
+          }
+        }
+      }
+    }
+  }
+}
+
+void OccupancyBitmap::cell(double x, double y, int &col, int &row) const {
+  col = static_cast<int>(std::floor((x - origin_x_) / resolution_));
+  row = static_cast<int>(std::floor((y - origin_y_) / resolution_));
+}
+
+std::uint64_t OccupancyBitmap::checksum() const {
+  std::uint64_t hash = 14695981039346656037ull;
+  hash = fnv1a(hash, &width_, sizeof(width_));
+  hash = fnv1a(hash, &height_, sizeof(height_));
+  hash = fnv1a(hash, &resolution_, sizeof(resolution_));
+  hash = fnv1a(hash, &origin_x_, sizeof(origin_x_));
+  hash = fnv1a(hash, &origin_y_, sizeof(origin_y_));
+  return fnv1a(hash, bits_.data(), bits_.size() * sizeof(std::uint64_t));
+}
+
+DistanceFieldCache::DistanceFieldCache(std::size_t transient_fields)
+    : transient_capacity_(std::max<std::size_t>(transient_fields, 1)) {}
+
+DistanceFieldCache::~DistanceFieldCache() { close(); }
+
+void DistanceFieldCache::close() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+  }
+  fields_ = nullptr;
+  owned_.clear();
+  transient_.clear();
+}
+
+void DistanceFieldCache::compute_field(int col, int row, std::vector<float> &field) const {
+  const int width = bitmap_->width();
+  const int height = bitmap_->height();
+  field.assign(cells_, kUnreachable);
+  if (col < 0 || row < 0 || col >= width || row >= height) {
+    return;
+  }
+  const float straight = static_cast<float>(bitmap_->resolution());
+  const float diagonal = straight * static_cast<float>(std::sqrt(2.0));
+  using Entry = std::pair<float, std::uint32_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+  const std::uint32_t start = static_cast<std::uint32_t>(row) * width + col;
+  // The source itself may sit in inflated space, it is still a valid start.
+  field[start] = 0;
+  open.push({0.0f, start});
+  while (!open.empty()) {
+    const Entry top = open.top();
+    open.pop();
+    if (top.first > field[top.second]) {
+      continue;
+    }
+    const int c = static_cast<int>(top.second % width);
+    const int r = static_cast<int>(top.second / width);
+    for (int dr = -1; dr <= 1; ++dr) {
+      for (int dc = -1; dc <= 1; ++dc) {
+        if ((dr == 0 && dc == 0) || bitmap_->blocked(c + dc, r + dr)) {
+          continue;
+        }
+        // Diagonal moves may not cut the corner of a blocked cell.
+        if (dr != 0 && dc != 0 && (bitmap_->blocked(c + dc, r) || bitmap_->blocked(c, r + dr))) {
+          continue;
+        }
+        const std::uint32_t next = static_cast<std::uint32_t>(r + dr) * width + (c + dc);
+        const float length = top.first + ((dr != 0 && dc != 0) ? diagonal : straight);
+        if (length < field[next]) {
+          field[next] = length;
+          open.push({length, next});
+        }
+      }
+    }
+  }
+}
+
+bool DistanceFieldCache::open(const std::string &cache_path, const OccupancyBitmap &bitmap,
+                              const std::vector<std::array<double, 2>> &sources, std::string *error) {
+  close();
+  bitmap_ = &bitmap;
+  cells_ = static_cast<std::size_t>(bitmap.width()) * bitmap.height();
+  source_count_ = sources.size();
+  sources_ = sources;
+  source_cells_.clear();
+  for (const auto &source : sources) {
+    int col, row;
+    bitmap.cell(source[0], source[1], col, row);
+    source_cells_.push_back({{col, row}});
+  }
+  std::uint64_t key = bitmap.checksum();
+  key = fnv1a(key, source_cells_.data(), source_cells_.size() * sizeof(source_cells_[0]));
+
+  CacheHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.width = static_cast<std::uint32_t>(bitmap.width());
+  header.height = static_cast<std::uint32_t>(bitmap.height());
+  header.source_count = static_cast<std::uint32_t>(source_count_);
+  header.key = key;
+  const std::size_t size = sizeof(CacheHeader) + source_count_ * cells_ * sizeof(float);
+
+  // Map an existing cache when it was built from the same map and sources.
+  const int fd = ::open(cache_path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat info;
+    if (fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) == size) {
+      void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapping != MAP_FAILED) {
+        if (std::memcmp(mapping, &header, sizeof(CacheHeader)) == 0) {
+          mapping_ = mapping;
+          mapping_size_ = size;
+          fields_ = reinterpret_cast<const float *>(static_cast<const char *>(mapping) + sizeof(CacheHeader));
+          loaded_from_cache_ = true;
+          ::close(fd);
+          return true;
+        }
+        munmap(mapping, size);
+      }
+    }
+    ::close(fd);
+  }
+
+  loaded_from_cache_ = false;
+  owned_.reserve(source_count_ * cells_);
+  std::vector<float> field;
+  for (const auto &cell : source_cells_) {
+    compute_field(cell[0], cell[1], field);
+    owned_.insert(owned_.end(), field.begin(), field.end());
+  }
+  fields_ = owned_.data();
+
+  // Write to a temporary file and rename it, so a concurrent launch never maps a partial cache.
+  const std::string temporary = cache_path + ".tmp";
+  std::FILE *file = std::fopen(temporary.c_str(), "wb");
+  bool written = file != nullptr && std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 std::fwrite(owned_.data(), sizeof(float), owned_.size(), file) == owned_.size();
+  if (file != nullptr) {
+    written = (std::fclose(file) == 0) && written;
+  }
+  if (!written || std::rename(temporary.c_str(), cache_path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    set_error(error, "cannot write distance field cache " + cache_path);
+  }
+  return true;
+}
+
+float DistanceFieldCache::lookup(const float *field, double x, double y) const {
+  int col, row;
+  bitmap_->cell(x, y, col, row);
+  if (col < 0 || row < 0 || col >= bitmap_->width() || row >= bitmap_->height()) {
+    return kUnreachable;
+  }
+  const float value = field[static_cast<std::size_t>(row) * bitmap_->width() + col];
+  if (value != kUnreachable) {
+    return value;
+  }
+  // The point may sit in inflated space next to the wall, use the closest reachable neighbour.
+  float best = kUnreachable;
+  for (int dr = -3; dr <= 3; ++dr) {
+    for (int dc = -3; dc <= 3; ++dc) {
+      const int c = col + dc;
+      const int r = row + dr;
+      if (c < 0 || r < 0 || c >= bitmap_->width() || r >= bitmap_->height()) {
+        continue;
+      }
+      const float neighbour = field[static_cast<std::size_t>(r) * bitmap_->width() + c];
+      if (neighbour != kUnreachable) {
+        best = std::min(best, neighbour + static_cast<float>(std::hypot(dr, dc) * bitmap_->resolution()));
+      }
+    }
+  }
+  return best;
+}
+
+double DistanceFieldCache::distance(std::size_t source, double x, double y) const {
+  if (fields_ == nullptr || source >= source_count_) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return lookup(fields_ + source * cells_, x, y);
+}
+
+std::size_t DistanceFieldCache::nearest_source(double x, double y) const {
+  std::size_t nearest = source_count_;
+  double best = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < sources_.size(); ++i) {
+    const double d = std::hypot(sources_[i][0] - x, sources_[i][1] - y);
+    if (d < best) {
+      best = d;
+      nearest = i;
+    }
+  }
+  return nearest;
+}
+
+const float *DistanceFieldCache::source_field(double x, double y) const {
+  int col, row;
+  bitmap_->cell(x, y, col, row);
+  for (std::size_t i = 0; i < source_count_; ++i) {
+    if (source_cells_[i][0] == col && source_cells_[i][1] == row) {
+      return fields_ + i * cells_;
+    }
+  }
+  return nullptr;
+}
+
+const float *DistanceFieldCache::field_from(double x, double y) {
+  const float *source = source_field(x, y);
+  if (source != nullptr) {
+    return source;
+  }
+  int col, row;
+  bitmap_->cell(x, y, col, row);
+  if (col < 0 || row < 0 || col >= bitmap_->width() || row >= bitmap_->height()) {
+    return nullptr;
+  }
+  const std::size_t index = static_cast<std::size_t>(row) * bitmap_->width() + col;
+  ++transient_clock_;
+  TransientField *oldest = nullptr;
+  for (TransientField &transient : transient_) {
+    if (transient.cell == index) {
+      transient.used = transient_clock_;
+      return transient.field.data();
+    }
+    if (oldest == nullptr || transient.used < oldest->used) {
+      oldest = &transient;
+    }
+  }
+  if (transient_.size() < transient_capacity_) {
+    transient_.emplace_back();
+    oldest = &transient_.back();
+  }
+  // The evicted field keeps its storage, it is computed over.
+  oldest->cell = index;
+  oldest->used = transient_clock_;
+  compute_field(col, row, oldest->field);
+  return oldest->field.data();
+}
+
+double DistanceFieldCache::path_length(double ax, double ay, double bx, double by) {
+  if (fields_ == nullptr) {
+    return std::numeric_limits<double>::infinity();
+  }
+  // Paths are symmetric, a source at 'b' saves computing the field of 'a'.
+  const float *to = source_field(bx, by);
+  if (to != nullptr && source_field(ax, ay) == nullptr) {
+    return lookup(to, ax, ay);
+  }
+  const float *field = field_from(ax, ay);
+  if (field == nullptr) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return lookup(field, bx, by);
+}
+
+bool DistanceFieldCache::path(double ax, double ay, double bx, double by,
+                              std::vector<std::array<double, 2>> &waypoints) {
+  waypoints.clear();
+  const float *field = fields_ == nullptr ? nullptr : field_from(bx, by);
+  if (field == nullptr) {
+    return false;
+  }
+  const int width = bitmap_->width();
+  const int height = bitmap_->height();
+  const auto value = [&](int c, int r) {
+    return (c < 0 || r < 0 || c >= width || r >= height) ? kUnreachable
+                                                          : field[static_cast<std::size_t>(r) * width + c];
+  };
+  int col, row;
+  bitmap_->cell(ax, ay, col, row);
+  if (value(col, row) == kUnreachable) {
+    // Start from the closest reachable neighbour, as lookup() does.
+    float best = kUnreachable;
+    int best_col = col;
+    int best_row = row;
+    for (int dr = -3; dr <= 3; ++dr) {
+      for (int dc = -3; dc <= 3; ++dc) {
+        const float neighbour = value(col + dc, row + dr);
+        if (neighbour != kUnreachable && neighbour + std::hypot(dr, dc) * bitmap_->resolution() < best) {
+          best = neighbour + static_cast<float>(std::hypot(dr, dc) * bitmap_->resolution());
+          best_col = col + dc;
+          best_row = row + dr;
+        }
+      }
+    }
+    if (best == kUnreachable) {
+      return false;
+    }
+    col = best_col;
+    row = best_row;
+  }
+  const double resolution = bitmap_->resolution();
+  // Every step goes to a neighbour with a strictly smaller value, so the descent ends at the source.
+  while (value(col, row) > 0) {
+    float best = value(col, row);
+    int next_col = col;
+    int next_row = row;
+    for (int dr = -1; dr <= 1; ++dr) {
+      for (int dc = -1; dc <= 1; ++dc) {
+        // The same moves as compute_field(), a diagonal may not cut the corner of a blocked cell.
+        if (dr != 0 && dc != 0 && (bitmap_->blocked(col + dc, row) || bitmap_->blocked(col, row + dr))) {
+          continue;
+        }
+        if (value(col + dc, row + dr) < best) {
+          best = value(col + dc, row + dr);
+          next_col = col + dc;
+          next_row = row + dr;
+        }
+      }
+    }
+    if (next_col == col && next_row == row) {
+      break;
+    }
+    col = next_col;
+    row = next_row;
+    waypoints.push_back({{bitmap_->origin_x() + (col + 0.5) * resolution,
+                          bitmap_->origin_y() + (row + 0.5) * resolution}});
+  }
+  return true;
+}
+
+}  // namespace final_project
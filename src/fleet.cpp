@@ -0,0 +1,50 @@
+/**
+ * @file fleet.cpp
+ * @brief Description of the robots taking part in the mission.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/fleet.h"
+
+namespace final_project {
+
+RobotSpec make_robot_spec(const std::string &name, RobotRole role, double home_x, double home_y) {
+  RobotSpec robot;
+  robot.name = name;
+  robot.role = role;
+  robot.move_base_action = "/" + name + "/move_base";
+  // The move_base nodes are not namespaced, only their action topics are remapped.
+  robot.planner = "/" + name + "_move_base/make_plan";
+  robot.cmd_vel = name + "/cmd_vel";
+  robot.base_frame = name + "_tf/base_footprint";
+  robot.camera_frame = name + "_tf/camera_rgb_optical_frame";
+  robot.fiducial_topic = "/" + name + "/fiducial_transforms";
+  robot.detector = "/" + name + "/aruco_detect";
+  robot.home_x = home_x;
+  robot.home_y = home_y;
+  return robot;
+}
+
+std::vector<RobotSpec> default_fleet() {
+  std::vector<RobotSpec> fleet{make_robot_spec("explorer", RobotRole::Explorer, -4, 2.5),
+                               make_robot_spec("follower", RobotRole::Follower, -4, 3.5)};
+  // The single aruco_detect node of the launch file is not namespaced.
+  fleet[0].fiducial_topic = "/fiducial_transforms";
+  fleet[0].detector = "/aruco_detect";
+  return fleet;
+}
+
+std::vector<int> robots_with_role(const std::vector<RobotSpec> &fleet, RobotRole role) {
+  std::vector<int> robots;
+  for (std::size_t i = 0; i < fleet.size(); i++) {
+    if (fleet[i].role == role) {
+      robots.push_back(static_cast<int>(i));
+    }
+  }
+  return robots;
+}
+
+}  // namespace final_project
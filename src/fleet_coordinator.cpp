@@ -0,0 +1,191 @@
+/**
+ * @file fleet_coordinator.cpp
+ * @brief Per-robot task deques with work stealing between the robots of one role.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/fleet_coordinator.h"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace final_project {
+
+FleetCoordinator::FleetCoordinator(std::size_t robots)
+    : queues_(robots), positions_(robots, std::array<double, 2>{{0, 0}}) {}
+
+void FleetCoordinator::set_cost(CostFunction cost) { cost_ = std::move(cost); }
+
+void FleetCoordinator::set_position(int robot, const std::array<double, 2> &position) { positions_[robot] = position; }
+
+int FleetCoordinator::add_task(const std::array<double, 2> &location) {
+  locations_.push_back(location);
+  queued_.push_back(false);
+  taken_.push_back(false);
+  completed_.push_back(false);
+  return static_cast<int>(locations_.size()) - 1;
+}
+
+double FleetCoordinator::cost(const std::array<double, 2> &from, const std::array<double, 2> &to) const {
+  if (cost_) {
+    return cost_(from, to);
+  }
+  return std::hypot(to[0] - from[0], to[1] - from[1]);
+}
+
+double FleetCoordinator::queued_cost(int robot) const {
+  double total = 0;
+  const std::array<double, 2> *from = &positions_[robot];
+  for (int task : queues_[robot]) {
+    if (completed_[task]) {
+      continue;
+    }
+    total += cost(*from, locations_[task]);
+    from = &locations_[task];
+  }
+  return total;
+}
+
+const std::array<double, 2> &FleetCoordinator::tail(int robot) const {
+  for (auto it = queues_[robot].rbegin(); it != queues_[robot].rend(); ++it) {
+    if (!completed_[*it]) {
+      return locations_[*it];
+    }
+  }
+  return positions_[robot];
+}
+
+void FleetCoordinator::distribute() {
+  if (queues_.empty()) {
+    return;
+  }
+  std::vector<int> unqueued;
+  for (std::size_t task = 0; task < locations_.size(); task++) {
+    if (!queued_[task] && !taken_[task] && !completed_[task]) {
+      unqueued.push_back(static_cast<int>(task));
+    }
+  }
+  std::vector<double> load(queues_.size());
+  for (std::size_t robot = 0; robot < queues_.size(); robot++) {
+    load[robot] = queued_cost(static_cast<int>(robot));
+  }
+  while (!unqueued.empty()) {
+    int robot = 0;
+    for (std::size_t r = 1; r < load.size(); r++) {
+      if (load[r] < load[robot]) {
+        robot = static_cast<int>(r);
+      }
+    }
+    const std::array<double, 2> &from = tail(robot);
+    std::size_t best = 0;
+    double best_cost = std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i < unqueued.size(); i++) {
+      const double c = cost(from, locations_[unqueued[i]]);
+      if (c < best_cost) {
+        best = i;
+        best_cost = c;
+      }
+    }
+    const int task = unqueued[best];
+    unqueued[best] = unqueued.back();
+    unqueued.pop_back();
+    queues_[robot].push_back(task);
+    queued_[task] = true;
+    // An unreachable task still counts, so it does not pile every later task on the same robot.
+    load[robot] += std::isfinite(best_cost) ? best_cost : 1e6;
+  }
+}
+
+int FleetCoordinator::assign(int task) {
+  if (queues_.empty()) {
+    return -1;
+  }
+  int best = 0;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (std::size_t robot = 0; robot < queues_.size(); robot++) {
+    const int r = static_cast<int>(robot);
+    const double c = queued_cost(r) + cost(tail(r), locations_[task]);
+    if (c < best_cost) {
+      best = r;
+      best_cost = c;
+    }
+  }
+  queues_[best].push_back(task);
+  queued_[task] = true;
+  return best;
+}
+
+int FleetCoordinator::next(int robot, bool *stolen) {
+  if (stolen) {
+    *stolen = false;
+  }
+  std::deque<int> &own = queues_[robot];
+  while (!own.empty()) {
+    const int task = own.front();
+    own.pop_front();
+    queued_[task] = false;
+    if (!completed_[task]) {
+      taken_[task] = true;
+      positions_[robot] = locations_[task];
+      return task;
+    }
+  }
+  // Steal the pending task of another robot that is cheapest to reach from here.
+  int victim = -1;
+  std::size_t victim_slot = 0;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (std::size_t other = 0; other < queues_.size(); other++) {
+    if (static_cast<int>(other) == robot) {
+      continue;
+    }
+    for (std::size_t slot = 0; slot < queues_[other].size(); slot++) {
+      const int task = queues_[other][slot];
+      if (completed_[task]) {
+        continue;
+      }
+      const double c = cost(positions_[robot], locations_[task]);
+      if (victim < 0 || c < best_cost) {
+        victim = static_cast<int>(other);
+        victim_slot = slot;
+        best_cost = c;
+      }
+    }
+  }
+  if (victim < 0) {
+    return -1;
+  }
+  const int task = queues_[victim][victim_slot];
+  queues_[victim].erase(queues_[victim].begin() + static_cast<std::ptrdiff_t>(victim_slot));
+  queued_[task] = false;
+  taken_[task] = true;
+  positions_[robot] = locations_[task];
+  steals_++;
+  if (stolen) {
+    *stolen = true;
+  }
+  return task;
+}
+
+void FleetCoordinator::defer(int robot, int task) {
+  taken_[task] = false;
+  queues_[robot].push_back(task);
+  queued_[task] = true;
+}
+
+void FleetCoordinator::complete(int task) { completed_[task] = true; }
+
+std::size_t FleetCoordinator::pending() const {
+  std::size_t count = 0;
+  for (std::size_t task = 0; task < locations_.size(); task++) {
+    if (!completed_[task] && !taken_[task]) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace final_project
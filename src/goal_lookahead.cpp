@@ -0,0 +1,30 @@
+/**
+ * @file goal_lookahead.cpp
+ * @brief Decides when a robot is close enough to its goal to be sent the next one without stopping.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/goal_lookahead.h"
+
+#include <cmath>
+
+namespace final_project {
+
+void GoalLookahead::arm(double x, double y, bool hold) {
+  x_ = x;
+  y_ = y;
+  hold_ = hold;
+  armed_ = true;
+}
+
+bool GoalLookahead::passed(double x, double y) const {
+  if (!armed_ || hold_ || !(radius_ > 0)) {
+    return false;
+  }
+  return std::hypot(x - x_, y - y_) <= radius_;
+}
+
+}  // namespace final_project
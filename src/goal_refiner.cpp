@@ -0,0 +1,202 @@
+/**
+ * @file goal_refiner.cpp
+ * @brief Moves a follower goal to a free, reachable spot of the costmap near it, facing its marker.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/goal_refiner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace final_project {
+
+namespace {
+
+// Cost of a cell holding an obstacle in a published costmap, the only cost that hides the marker.
+constexpr int kObstacleCost = 100;
+// Distance short of the marker the line of sight is checked to, in cells, the marker hangs on an obstacle.
+constexpr double kSightMargin = 2.0;
+
+}  // namespace
+
+void GoalRefiner::set_costmap(int width, int height, double resolution, double origin_x, double origin_y,
+                              const std::vector<std::int8_t> &data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (width <= 0 || height <= 0 || !(resolution > 0) ||
+      data.size() != static_cast<std::size_t>(width) * static_cast<std::size_t>(height)) {
+    costs_.clear();
+    width_ = 0;
+    height_ = 0;
+    return;
+  }
+  width_ = width;
+  height_ = height;
+  resolution_ = resolution;
+  origin_x_ = origin_x;
+  origin_y_ = origin_y;
+  costs_ = data;
+}
+
+bool GoalRefiner::update_costmap(int x, int y, int width, int height, const std::vector<std::int8_t> &data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (costs_.empty() || x < 0 || y < 0 || width < 0 || height < 0 || x + width > width_ || y + height > height_ ||
+      data.size() != static_cast<std::size_t>(width) * static_cast<std::size_t>(height)) {
+    return false;
+  }
+  for (int row = 0; row < height; ++row) {
+    std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(row) * width, width,
+                costs_.begin() + static_cast<std::ptrdiff_t>(y + row) * width_ + x);
+  }
+  return true;
+}
+
+bool GoalRefiner::has_costmap() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !costs_.empty();
+}
+
+int GoalRefiner::cost(int col, int row) const {
+  if (col < 0 || row < 0 || col >= width_ || row >= height_) {
+    return -1;
+  }
+  const int value = costs_[static_cast<std::size_t>(row) * width_ + col];
+  return value < 0 ? -1 : std::min(value, kObstacleCost);
+}
+
+bool GoalRefiner::sees(int col, int row, double marker_x, double marker_y) const {
+  const double x = origin_x_ + (col + 0.5) * resolution_;
+  const double y = origin_y_ + (row + 0.5) * resolution_;
+  const double cells = std::hypot(marker_x - x, marker_y - y) / resolution_;
+  const double length = cells - kSightMargin;
+  if (length <= 0) {
+    return true;
+  }
+  // Half-cell steps, no obstacle cell is stepped over.
+  const int steps = static_cast<int>(std::ceil(length * 2.0));
+  const double scale = length / (cells * steps);
+  for (int i = 1; i <= steps; ++i) {
+    const double px = x + (marker_x - x) * scale * i;
+    const double py = y + (marker_y - y) * scale * i;
+    if (cost(static_cast<int>(std::floor((px - origin_x_) / resolution_)),
+             static_cast<int>(std::floor((py - origin_y_) / resolution_))) == kObstacleCost) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GoalRefiner::refine(double x, double y, double marker_x, double marker_y, RefinedGoal &goal) const {
+  goal.x = x;
+  goal.y = y;
+  goal.yaw = std::atan2(marker_y - y, marker_x - x);
+  goal.cost = -1;
+  goal.moved = false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (costs_.empty()) {
+    return false;
+  }
+  const auto passable = [this](int col, int row) {
+    const int value = cost(col, row);
+    return value >= 0 && value < params_.lethal_cost;
+  };
+  const int col0 = static_cast<int>(std::floor((x - origin_x_) / resolution_));
+  const int row0 = static_cast<int>(std::floor((y - origin_y_) / resolution_));
+  const int reach = std::max(0, static_cast<int>(std::floor(params_.search_radius / resolution_)));
+  const int side = 2 * reach + 1;
+
+  // The nominal goal often sits in the inflation of the wall behind the marker, the search then starts from the
+  // first cell the robot may stand on, stepping straight back from the marker.
+  int seed_col = col0;
+  int seed_row = row0;
+  if (!passable(col0, row0)) {
+    const double away = std::hypot(x - marker_x, y - marker_y);
+    if (!(away > 0)) {
+      return false;
+    }
+    const double dx = (x - marker_x) / away * resolution_;
+    const double dy = (y - marker_y) / away * resolution_;
+    bool found = false;
+    for (int step = 1; step <= reach && !found; ++step) {
+      seed_col = static_cast<int>(std::floor((x + dx * step - origin_x_) / resolution_));
+      seed_row = static_cast<int>(std::floor((y + dy * step - origin_y_) / resolution_));
+      const int dc = seed_col - col0;
+      const int dr = seed_row - row0;
+      found = dc * dc + dr * dr <= reach * reach && passable(seed_col, seed_row);
+    }
+    if (!found) {
+      return false;
+    }
+  }
+
+  const std::size_t window = static_cast<std::size_t>(side) * static_cast<std::size_t>(side);
+  if (visited_.size() < window) {
+    visited_.assign(window, 0);
+    generation_ = 0;
+  }
+  if (++generation_ == 0) {
+    std::fill(visited_.begin(), visited_.end(), 0);
+    generation_ = 1;
+  }
+  const auto local = [reach, side, col0, row0](int col, int row) {
+    return static_cast<std::size_t>(row - row0 + reach) * side + static_cast<std::size_t>(col - col0 + reach);
+  };
+  frontier_.clear();
+  visited_[local(seed_col, seed_row)] = generation_;
+  frontier_.push_back(local(seed_col, seed_row));
+
+  double best_score = std::numeric_limits<double>::infinity();
+  int best_col = 0;
+  int best_row = 0;
+  int best_cost = -1;
+  static const int kSteps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  for (std::size_t head = 0; head < frontier_.size(); ++head) {
+    const int col = static_cast<int>(frontier_[head] % side) - reach + col0;
+    const int row = static_cast<int>(frontier_[head] / side) - reach + row0;
+    const int value = cost(col, row);
+    const double cx = origin_x_ + (col + 0.5) * resolution_;
+    const double cy = origin_y_ + (row + 0.5) * resolution_;
+    const double range = std::hypot(marker_x - cx, marker_y - cy);
+    if (value <= params_.max_cost && range >= params_.min_marker_distance && range <= params_.max_marker_distance) {
+      // The nominal goal itself is not offset to its cell center.
+      const double offset = col == col0 && row == row0 ? 0.0 : std::hypot(cx - x, cy - y);
+      const double score = offset + params_.cost_weight * value;
+      if (score < best_score && sees(col, row, marker_x, marker_y)) {
+        best_score = score;
+        best_col = col;
+        best_row = row;
+        best_cost = value;
+      }
+    }
+    for (const auto &step : kSteps) {
+      const int next_col = col + step[0];
+      const int next_row = row + step[1];
+      const int dc = next_col - col0;
+      const int dr = next_row - row0;
+      if (dc * dc + dr * dr > reach * reach || visited_[local(next_col, next_row)] == generation_ ||
+          !passable(next_col, next_row)) {
+        continue;
+      }
+      visited_[local(next_col, next_row)] = generation_;
+      frontier_.push_back(local(next_col, next_row));
+    }
+  }
+  if (best_cost < 0) {
+    return false;
+  }
+  goal.cost = best_cost;
+  if (best_col != col0 || best_row != row0) {
+    goal.x = origin_x_ + (best_col + 0.5) * resolution_;
+    goal.y = origin_y_ + (best_row + 0.5) * resolution_;
+    goal.yaw = std::atan2(marker_y - goal.y, marker_x - goal.x);
+    goal.moved = true;
+  }
+  return true;
+}
+
+}  // namespace final_project
@@ -0,0 +1,76 @@
+/**
+ * @file goal_retry.cpp
+ * @brief Decides what becomes of the goals move_base fails, and how long each goal may take.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/goal_retry.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace final_project {
+
+namespace {
+
+// Angle between two successive retries of a goal, in radians.
+constexpr double kGoldenAngle = 2.399963229728653;
+
+}  // namespace
+
+GoalRetryPolicy::Decision GoalRetryPolicy::failed(int goal, bool deferrable) {
+  failures_++;
+  Attempts &attempts = attempts_[goal];
+  if (attempts.retries < params_.max_retries) {
+    attempts.retries++;
+    return Decision::Retry;
+  }
+  if (deferrable && attempts.deferrals < params_.max_deferrals) {
+    attempts.deferrals++;
+    attempts.retries = 0;
+    return Decision::Defer;
+  }
+  attempts_.erase(goal);
+  given_up_++;
+  return Decision::GiveUp;
+}
+
+int GoalRetryPolicy::retries(int goal) const {
+  const auto it = attempts_.find(goal);
+  return it == attempts_.end() ? 0 : it->second.retries;
+}
+
+std::array<double, 2> GoalRetryPolicy::perturb(int goal, const std::array<double, 2> &location) const {
+  const int retry = retries(goal);
+  if (retry == 0 || !(params_.perturbation > 0)) {
+    return location;
+  }
+  const double angle = kGoldenAngle * retry;
+  const double radius = params_.perturbation * retry;
+  return {{location[0] + radius * std::cos(angle), location[1] + radius * std::sin(angle)}};
+}
+
+double GoalRetryPolicy::deadline(double path_length) const {
+  if (!(params_.deadline_factor > 0) || !(params_.speed > 0)) {
+    return 0.0;
+  }
+  const double eta = std::isfinite(path_length) ? std::max(path_length, 0.0) / params_.speed : 0.0;
+  return std::max(params_.deadline_factor * eta, params_.min_deadline);
+}
+
+const char *to_string(GoalRetryPolicy::Decision decision) {
+  switch (decision) {
+    case GoalRetryPolicy::Decision::Retry:
+      return "retried";
+    case GoalRetryPolicy::Decision::Defer:
+      return "deferred";
+    case GoalRetryPolicy::Decision::GiveUp:
+      return "given up";
+  }
+  return "unknown";
+}
+
+}  // namespace final_project
@@ -0,0 +1,138 @@
+/**
+ * @file kernel_bench.cpp
+ * @brief Microbenchmark of the marker localization, the tf2 composition against the kernels of pose_kernels.h.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <geometry_msgs/Transform.h>
+#include <ros/ros.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2_ros/buffer.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "final_project/marker_localizer.h"
+#include "final_project/pose_kernels.h"
+
+// Most markers of one image, as in the mission.
+const std::size_t max_markers = 8;
+
+/**
+ * @brief Struct holding one image of the benchmark, the camera pose and the markers it saw.
+ *
+ */
+struct bench_image {
+  geometry_msgs::Transform map_to_camera;
+  std::vector<geometry_msgs::Transform> markers;
+};
+
+/**
+ * @brief Method to draw a random pose, a position in a box and a uniform rotation.
+ *
+ * @param rng Random generator.
+ * @param extent Half size of the box, in meters.
+ * @param z Height of the box center, in meters.
+ */
+geometry_msgs::Transform random_transform(std::mt19937 &rng, double extent, double z)
+{
+  std::uniform_real_distribution<double> position(-extent, extent);
+  std::normal_distribution<double> component(0.0, 1.0);
+  tf2::Quaternion rotation(component(rng), component(rng), component(rng), component(rng));
+  rotation.normalize();
+  geometry_msgs::Transform transform;
+  transform.translation.x = position(rng);
+  transform.translation.y = position(rng);
+  transform.translation.z = z + position(rng);
+  transform.rotation.x = rotation.x();
+  transform.rotation.y = rotation.y();
+  transform.rotation.z = rotation.z();
+  transform.rotation.w = rotation.w();
+  return transform;
+}
+
+/**
+ * @brief Method to get the difference of two headings, in [0, pi].
+ */
+double yaw_difference(double a, double b)
+{
+  return std::fabs(std::remainder(a - b, 2 * M_PI));
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "final_project_kernel_bench", ros::init_options::NoRosout);
+  // Number of images and seed, from the command line.
+  const std::size_t images = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+  const unsigned seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+  const double offset = 0.4;
+
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<std::size_t> marker_count(1, max_markers);
+  std::vector<bench_image> bench(images);
+  std::size_t markers = 0;
+  for (bench_image &image : bench) {
+    image.map_to_camera = random_transform(rng, 5.0, 0.3);
+    image.markers.resize(marker_count(rng));
+    for (geometry_msgs::Transform &marker : image.markers) {
+      marker = random_transform(rng, 1.0, 2.0);
+    }
+    markers += image.markers.size();
+  }
+
+  // The tf2 path of MarkerLocalizer::compose(), the buffer is never looked up.
+  const tf2_ros::Buffer buffer;
+  const final_project::MarkerLocalizer localizer(buffer, "map", "camera", offset);
+  std::vector<final_project::PlanarPose> reference(markers);
+  auto start = std::chrono::steady_clock::now();
+  std::size_t k = 0;
+  for (const bench_image &image : bench) {
+    for (const geometry_msgs::Transform &marker : image.markers) {
+      const geometry_msgs::Transform map_to_goal = localizer.compose(image.map_to_camera, marker);
+      reference[k++] = {map_to_goal.translation.x, map_to_goal.translation.y,
+                        final_project::MarkerLocalizer::facing_yaw(map_to_goal)};
+    }
+  }
+  const double tf2_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // The batch path of the mission, the messages are converted once when the detection is queued.
+  std::vector<final_project::Pose3> cameras(images);
+  std::vector<final_project::MarkerBatch<max_markers>> batches(images);
+  for (std::size_t i = 0; i < images; i++) {
+    cameras[i] = final_project::to_pose3(bench[i].map_to_camera);
+    for (const geometry_msgs::Transform &marker : bench[i].markers) {
+      batches[i].push(final_project::to_pose3(marker));
+    }
+  }
+  std::vector<final_project::PlanarPose> batched(markers);
+  start = std::chrono::steady_clock::now();
+  k = 0;
+  for (std::size_t i = 0; i < images; i++) {
+    final_project::PlanarPose goals[max_markers];
+    const std::size_t localized = final_project::localize_markers(cameras[i], batches[i], offset, goals);
+    std::copy(goals, goals + localized, batched.begin() + k);
+    k += localized;
+  }
+  const double kernel_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  double position_error = 0;
+  double yaw_error = 0;
+  for (std::size_t i = 0; i < markers; i++) {
+    position_error = std::max(position_error, std::hypot(batched[i].x - reference[i].x, batched[i].y - reference[i].y));
+    yaw_error = std::max(yaw_error, yaw_difference(batched[i].yaw, reference[i].yaw));
+  }
+
+  ROS_INFO_STREAM(markers << " markers in " << images << " images, seed " << seed);
+  ROS_INFO_STREAM("  tf2:    " << 1e9 * tf2_time / markers << " ns per marker");
+  ROS_INFO_STREAM("  kernel: " << 1e9 * kernel_time / markers << " ns per marker ("
+                  << (kernel_time > 0 ? tf2_time / kernel_time : 0.0) << "x)");
+  ROS_INFO_STREAM("  largest difference: " << position_error << " m, " << yaw_error << " rad");
+  return 0;
+}
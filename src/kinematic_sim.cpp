@@ -0,0 +1,306 @@
+/**
+ * @file kinematic_sim.cpp
+ * @brief Lightweight simulation of the robots and their marker detector, for runs much faster than realtime.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/kinematic_sim.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace final_project {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+double wrap_angle(double angle) { return std::atan2(std::sin(angle), std::cos(angle)); }
+
+double clamp(double value, double limit) { return std::max(-limit, std::min(limit, value)); }
+
+// Direction of the map frame expressed in the optical frame of a camera with heading 'yaw':
+// x to the right, y down and z forward.
+std::array<double, 3> to_optical(double yaw, double wx, double wy, double wz) {
+  const double forward = wx * std::cos(yaw) + wy * std::sin(yaw);
+  const double left = -wx * std::sin(yaw) + wy * std::cos(yaw);
+  return {{-left, -wz, forward}};
+}
+
+// Quaternion x, y, z, w of the rotation matrix with columns 'x', 'y' and 'z'.
+std::array<double, 4> quaternion(const std::array<double, 3> &x, const std::array<double, 3> &y,
+                                 const std::array<double, 3> &z) {
+  const double trace = x[0] + y[1] + z[2];
+  if (trace > 0) {
+    const double s = 0.5 / std::sqrt(trace + 1.0);
+    return {{(y[2] - z[1]) * s, (z[0] - x[2]) * s, (x[1] - y[0]) * s, 0.25 / s}};
+  }
+  if (x[0] > y[1] && x[0] > z[2]) {
+    const double s = 2.0 * std::sqrt(1.0 + x[0] - y[1] - z[2]);
+    return {{0.25 * s, (y[0] + x[1]) / s, (z[0] + x[2]) / s, (y[2] - z[1]) / s}};
+  }
+  if (y[1] > z[2]) {
+    const double s = 2.0 * std::sqrt(1.0 + y[1] - x[0] - z[2]);
+    return {{(y[0] + x[1]) / s, 0.25 * s, (z[1] + y[2]) / s, (z[0] - x[2]) / s}};
+  }
+  const double s = 2.0 * std::sqrt(1.0 + z[2] - x[0] - y[1]);
+  return {{(z[0] + x[2]) / s, (z[1] + y[2]) / s, 0.25 * s, (x[1] - y[0]) / s}};
+}
+
+}  // namespace
+
+KinematicSim::KinematicSim(const OccupancyBitmap &map, DistanceFieldCache &fields, const Params &params)
+    : map_(map), fields_(fields), params_(params) {}
+
+int KinematicSim::add_robot(const UnicyclePose &start) {
+  Robot robot;
+  robot.pose = start;
+  robots_.push_back(robot);
+  return static_cast<int>(robots_.size()) - 1;
+}
+
+bool KinematicSim::set_goal(int index, const UnicyclePose &goal) {
+  Robot &robot = robots_[index];
+  robot.goal = goal;
+  robot.next = 0;
+  if (!fields_.path(robot.pose.x, robot.pose.y, goal.x, goal.y, robot.path)) {
+    robot.state = GoalState::Aborted;
+    return false;
+  }
+  robot.state = GoalState::Active;
+  return true;
+}
+
+void KinematicSim::cancel_goal(int index) {
+  Robot &robot = robots_[index];
+  if (robot.state == GoalState::Active) {
+    robot.state = GoalState::Idle;
+  }
+  robot.path.clear();
+}
+
+void KinematicSim::set_pose(int index, const UnicyclePose &pose) {
+  cancel_goal(index);
+  Robot &robot = robots_[index];
+  robot.pose = pose;
+  robot.command_time = -1;
+  robot.linear = 0;
+  robot.angular = 0;
+}
+
+void KinematicSim::set_velocity(int index, double linear, double angular) {
+  Robot &robot = robots_[index];
+  robot.command_linear = linear;
+  robot.command_angular = angular;
+  robot.command_time = time_;
+}
+
+void KinematicSim::follow_goal(Robot &robot, double &linear, double &angular) {
+  const double to_goal = std::hypot(robot.goal.x - robot.pose.x, robot.goal.y - robot.pose.y);
+  if (to_goal <= params_.xy_tolerance) {
+    // In place, turn to the goal heading like move_base does.
+    const double error = wrap_angle(robot.goal.yaw - robot.pose.yaw);
+    linear = 0;
+    angular = clamp(params_.heading_gain * error, params_.max_angular);
+    if (std::fabs(error) <= params_.yaw_tolerance) {
+      angular = 0;
+      robot.state = GoalState::Succeeded;
+      robot.path.clear();
+    }
+    return;
+  }
+  // Aim at the first path point beyond the lookahead, the goal itself at the end of the path.
+  while (robot.next < robot.path.size() &&
+         std::hypot(robot.path[robot.next][0] - robot.pose.x, robot.path[robot.next][1] - robot.pose.y) <
+             params_.lookahead) {
+    ++robot.next;
+  }
+  const double aim_x = robot.next < robot.path.size() ? robot.path[robot.next][0] : robot.goal.x;
+  const double aim_y = robot.next < robot.path.size() ? robot.path[robot.next][1] : robot.goal.y;
+  const double error = wrap_angle(std::atan2(aim_y - robot.pose.y, aim_x - robot.pose.x) - robot.pose.yaw);
+  angular = clamp(params_.heading_gain * error, params_.max_angular);
+  // Slow down while the heading is off, turn in place when it is more than 90 degrees off.
+  const double alignment = std::max(0.0, std::cos(error));
+  linear = std::min(params_.max_linear * alignment * alignment, to_goal);
+}
+
+void KinematicSim::step(double dt) {
+  for (Robot &robot : robots_) {
+    double linear = 0;
+    double angular = 0;
+    if (robot.state == GoalState::Active) {
+      follow_goal(robot, linear, angular);
+    } else if (robot.command_time >= 0 && time_ - robot.command_time <= params_.command_timeout) {
+      linear = clamp(robot.command_linear, params_.max_linear);
+      angular = clamp(robot.command_angular, params_.max_angular);
+    }
+    // Exact unicycle motion for a constant command over the step.
+    double x = robot.pose.x;
+    double y = robot.pose.y;
+    const double yaw = robot.pose.yaw + angular * dt;
+    if (std::fabs(angular) > 1e-9) {
+      x += linear / angular * (std::sin(yaw) - std::sin(robot.pose.yaw));
+      y -= linear / angular * (std::cos(yaw) - std::cos(robot.pose.yaw));
+    } else {
+      x += linear * dt * std::cos(robot.pose.yaw);
+      y += linear * dt * std::sin(robot.pose.yaw);
+    }
+    int col, row;
+    map_.cell(x, y, col, row);
+    // Velocity commands may drive into a wall, the robot then only turns.
+    if (robot.state == GoalState::Active || !map_.blocked(col, row)) {
+      robot.pose.x = x;
+      robot.pose.y = y;
+    } else {
+      linear = 0;
+    }
+    robot.pose.yaw = wrap_angle(yaw);
+    robot.linear = linear;
+    robot.angular = angular;
+  }
+  time_ += dt;
+}
+
+bool KinematicSim::line_of_sight(double x0, double y0, double x1, double y1) const {
+  const double length = std::hypot(x1 - x0, y1 - y0);
+  const int steps = static_cast<int>(std::ceil(length / (0.5 * map_.resolution())));
+  for (int i = 0; i <= steps; i++) {
+    const double t = steps > 0 ? static_cast<double>(i) / steps : 0.0;
+    int col, row;
+    map_.cell(x0 + t * (x1 - x0), y0 + t * (y1 - y0), col, row);
+    if (map_.blocked(col, row)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<SimDetection> KinematicSim::detect(int index, const SimCamera &camera,
+                                               const std::vector<SimMarker> &markers, std::mt19937 &rng) const {
+  std::vector<SimDetection> detections;
+  const UnicyclePose &pose = robots_[index].pose;
+  const double cx = pose.x + camera.forward * std::cos(pose.yaw);
+  const double cy = pose.y + camera.forward * std::sin(pose.yaw);
+  std::normal_distribution<double> unit(0.0, 1.0);
+  for (const SimMarker &marker : markers) {
+    const double dx = marker.x - cx;
+    const double dy = marker.y - cy;
+    const double range = std::hypot(dx, dy);
+    if (range < camera.min_range || range > camera.max_range) {
+      continue;
+    }
+    const double bearing = wrap_angle(std::atan2(dy, dx) - pose.yaw);
+    if (std::fabs(bearing) > 0.5 * camera.fov) {
+      continue;
+    }
+    // The camera has to be in front of the marker face.
+    const double incidence = std::acos(std::max(-1.0, std::min(1.0, -(dx * std::cos(marker.yaw) +
+                                                                        dy * std::sin(marker.yaw)) / range)));
+    if (incidence > camera.max_incidence) {
+      continue;
+    }
+    // The marker may sit inside the wall cells, the line of sight ends at the first free cell in front of it.
+    double front = 0;
+    int col, row;
+    map_.cell(marker.x, marker.y, col, row);
+    while (front < 0.3 && map_.blocked(col, row)) {
+      front += 0.5 * map_.resolution();
+      map_.cell(marker.x + front * std::cos(marker.yaw), marker.y + front * std::sin(marker.yaw), col, row);
+    }
+    if (!line_of_sight(cx, cy, marker.x + front * std::cos(marker.yaw), marker.y + front * std::sin(marker.yaw))) {
+      continue;
+    }
+    const double noisy_range = range * (1.0 + camera.range_noise * unit(rng));
+    const double noisy_bearing = bearing + camera.bearing_noise * unit(rng);
+    const double noisy_yaw = marker.yaw + camera.yaw_noise * unit(rng);
+
+    SimDetection detection;
+    detection.fiducial_id = marker.fiducial_id;
+    detection.translation = {{-noisy_range * std::sin(noisy_bearing), -(marker.z - camera.height),
+                              noisy_range * std::cos(noisy_bearing)}};
+    // The marker z-axis is its normal, its y-axis points up and its x-axis completes the frame.
+    const std::array<double, 3> z = to_optical(pose.yaw, std::cos(noisy_yaw), std::sin(noisy_yaw), 0);
+    const std::array<double, 3> y = to_optical(pose.yaw, 0, 0, 1);
+    const std::array<double, 3> x = {{y[1] * z[2] - y[2] * z[1], y[2] * z[0] - y[0] * z[2],
+                                      y[0] * z[1] - y[1] * z[0]}};
+    detection.rotation = quaternion(x, y, z);
+    // Far and oblique markers are seen with fewer pixels, so their corners are less accurate.
+    const double obliquity = 1.0 / std::max(std::cos(incidence), 0.1);
+    detection.image_error = camera.image_error_per_meter * range * obliquity;
+    detection.object_error = camera.range_noise * range * obliquity;
+    detections.push_back(detection);
+  }
+  return detections;
+}
+
+double KinematicSim::marker_facing(const OccupancyBitmap &map, double x, double y) {
+  // The wall the marker hangs on is the edge between blocked and free cells around it.
+  int col, row;
+  map.cell(x, y, col, row);
+  const int radius = std::max(1, static_cast<int>(std::lround(0.35 / map.resolution())));
+  double sum_c = 0;
+  double sum_r = 0;
+  double sum_cc = 0;
+  double sum_cr = 0;
+  double sum_rr = 0;
+  int edges = 0;
+  for (int dr = -radius; dr <= radius; ++dr) {
+    for (int dc = -radius; dc <= radius; ++dc) {
+      const int c = col + dc;
+      const int r = row + dr;
+      if (!map.blocked(c, r) ||
+          (map.blocked(c + 1, r) && map.blocked(c - 1, r) && map.blocked(c, r + 1) && map.blocked(c, r - 1))) {
+        continue;
+      }
+      sum_c += dc;
+      sum_r += dr;
+      sum_cc += dc * dc;
+      sum_cr += dc * dr;
+      sum_rr += dr * dr;
+      ++edges;
+    }
+  }
+  // Free space in front of the marker along a heading, up to a meter past the wall.
+  const auto free_along = [&map, x, y](double yaw) {
+    const double step = 0.5 * map.resolution();
+    double free = 0;
+    for (double distance = 0; distance <= 1.25; distance += step) {
+      int c, r;
+      map.cell(x + distance * std::cos(yaw), y + distance * std::sin(yaw), c, r);
+      if (!map.blocked(c, r)) {
+        free += step;
+      } else if (free > 0) {
+        break;
+      }
+    }
+    return free;
+  };
+  if (edges >= 3) {
+    const double mean_c = sum_c / edges;
+    const double mean_r = sum_r / edges;
+    const double cov_cc = sum_cc / edges - mean_c * mean_c;
+    const double cov_cr = sum_cr / edges - mean_c * mean_r;
+    const double cov_rr = sum_rr / edges - mean_r * mean_r;
+    // The normal is across the principal direction of the edge, on its free side.
+    const double tangent = 0.5 * std::atan2(2 * cov_cr, cov_cc - cov_rr);
+    const double normal = tangent + 0.5 * kPi;
+    return wrap_angle(free_along(normal) >= free_along(normal + kPi) ? normal : normal + kPi);
+  }
+  // No wall nearby, face the direction with the most free space.
+  double best_yaw = 0;
+  double best_free = -1;
+  for (int i = 0; i < 72; i++) {
+    const double yaw = 2 * kPi * i / 72;
+    const double free = free_along(yaw);
+    if (free > best_free) {
+      best_free = free;
+      best_yaw = yaw;
+    }
+  }
+  return wrap_angle(best_yaw);
+}
+
+}  // namespace final_project
@@ -0,0 +1,112 @@
+/**
+ * @file latency_histogram.cpp
+ * @brief Lock-free fixed-bucket histograms of the durations of the mission stages.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace final_project {
+
+constexpr std::size_t HistogramSnapshot::kBuckets;
+constexpr double LatencyHistogram::kResolution;
+constexpr std::size_t MissionMetrics::kStages;
+
+double HistogramSnapshot::quantile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  const double rank = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count);
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; i++) {
+    if (buckets[i] == 0 || static_cast<double>(seen + buckets[i]) < rank) {
+      seen += buckets[i];
+      continue;
+    }
+    // Interpolate linearly inside the bucket.
+    const double lower = i == 0 ? 0.0 : std::ldexp(LatencyHistogram::kResolution, static_cast<int>(i) - 1);
+    const double upper = std::ldexp(LatencyHistogram::kResolution, static_cast<int>(i));
+    const double fraction = (rank - static_cast<double>(seen)) / static_cast<double>(buckets[i]);
+    return std::min(lower + fraction * (upper - lower), max);
+  }
+  return max;
+}
+
+void LatencyHistogram::record(double seconds) {
+  const double scaled = std::max(seconds, 0.0) / kResolution;
+  // Saturate instead of overflowing, the last bucket holds everything beyond its lower bound.
+  const std::uint64_t ticks = scaled < 1e18 ? static_cast<std::uint64_t>(scaled) : static_cast<std::uint64_t>(1e18);
+  std::size_t bucket = 0;
+  for (std::uint64_t rest = ticks; rest > 0 && bucket + 1 < HistogramSnapshot::kBuckets; rest >>= 1) {
+    ++bucket;
+  }
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  sum_ticks_.fetch_add(ticks, std::memory_order_relaxed);
+  std::uint64_t max = max_ticks_.load(std::memory_order_relaxed);
+  while (ticks > max && !max_ticks_.compare_exchange_weak(max, ticks, std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+  HistogramSnapshot snapshot;
+  for (std::size_t i = 0; i < HistogramSnapshot::kBuckets; i++) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.sum = static_cast<double>(sum_ticks_.load(std::memory_order_relaxed)) * kResolution;
+  snapshot.max = static_cast<double>(max_ticks_.load(std::memory_order_relaxed)) * kResolution;
+  return snapshot;
+}
+
+void LatencyHistogram::reset() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  sum_ticks_.store(0, std::memory_order_relaxed);
+  max_ticks_.store(0, std::memory_order_relaxed);
+}
+
+const LatencyHistogram &MissionMetrics::stage(std::size_t index, std::string &name) const {
+  switch (index) {
+    case 0: name = "detection_latency"; return detection_latency;
+    case 1: name = "localization_latency"; return localization_latency;
+    case 2: name = "tf_lookup"; return tf_lookup;
+    case 3: name = "tf_failure"; return tf_failure;
+    case 4: name = "explorer_goal"; return explorer_goal;
+    case 5: name = "follower_goal"; return follower_goal;
+    default: name = "rotation"; return rotation;
+  }
+}
+
+void MissionMetrics::reset() {
+  detection_latency.reset();
+  localization_latency.reset();
+  tf_lookup.reset();
+  tf_failure.reset();
+  explorer_goal.reset();
+  follower_goal.reset();
+  rotation.reset();
+}
+
+std::string MissionMetrics::report() const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(4);
+  for (std::size_t i = 0; i < kStages; i++) {
+    std::string name;
+    const HistogramSnapshot snapshot = stage(i, name).snapshot();
+    out << "  " << std::left << std::setw(22) << name << std::right << " n=" << std::setw(6) << snapshot.count
+        << "  mean " << snapshot.mean() << "  p50 " << snapshot.quantile(0.5) << "  p90 " << snapshot.quantile(0.9)
+        << "  p99 " << snapshot.quantile(0.99) << "  max " << snapshot.max << "  total " << snapshot.sum << " s\n";
+  }
+  return out.str();
+}
+
+}  // namespace final_project
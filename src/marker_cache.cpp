@@ -0,0 +1,163 @@
+/**
+ * @file marker_cache.cpp
+ * @brief Fused marker poses kept on disk between launches, tied to the map they were localized in.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/marker_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace final_project {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'P', 'M', 'K', 'C', 'A', 'C', 'H'};
+constexpr std::uint32_t kVersion = 1;
+
+/**
+ * @brief Struct at the start of the cache file, followed by 'count' CachedMarker records.
+ */
+struct CacheHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t count;
+  // Member 'map_checksum' identifies the map, markers localized in another map are not used.
+  std::uint64_t map_checksum;
+  // Member 'records_checksum' hashes the records, a mismatch means the file is corrupt.
+  std::uint64_t records_checksum;
+};
+
+// The records are mapped in place, so their layout is fixed and 8-byte aligned.
+static_assert(sizeof(CacheHeader) == 32, "CacheHeader layout changed, bump kVersion");
+static_assert(sizeof(CachedMarker) == 80, "CachedMarker layout changed, bump kVersion");
+
+void set_error(std::string *error, const std::string &message) {
+  if (error != nullptr) {
+    *error = message;
+  }
+}
+
+std::uint64_t fnv1a(const void *data, std::size_t size) {
+  std::uint64_t hash = 14695981039346656037ull;
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+CachedMarker to_cached_marker(const Se2Estimate &estimate, double localized_at) {
+  CachedMarker marker;
+  marker.fiducial_id = estimate.fiducial_id;
+  marker.samples = estimate.samples;
+  marker.x = estimate.x;
+  marker.y = estimate.y;
+  marker.yaw = estimate.yaw;
+  marker.cov_xx = estimate.cov_xx;
+  marker.cov_xy = estimate.cov_xy;
+  marker.cov_yy = estimate.cov_yy;
+  marker.yaw_std = estimate.yaw_std;
+  marker.effective_samples = estimate.effective_samples;
+  marker.localized_at = localized_at;
+  return marker;
+}
+
+Se2Estimate to_estimate(const CachedMarker &marker) {
+  Se2Estimate estimate;
+  estimate.fiducial_id = marker.fiducial_id;
+  estimate.x = marker.x;
+  estimate.y = marker.y;
+  estimate.yaw = marker.yaw;
+  estimate.cov_xx = marker.cov_xx;
+  estimate.cov_xy = marker.cov_xy;
+  estimate.cov_yy = marker.cov_yy;
+  estimate.yaw_std = marker.yaw_std;
+  estimate.samples = marker.samples;
+  estimate.effective_samples = marker.effective_samples;
+  return estimate;
+}
+
+bool marker_cache_trusted(const CachedMarker &marker, double now, const MarkerCacheFreshness &freshness) {
+  if (freshness.max_age > 0 && !(now - marker.localized_at <= freshness.max_age)) {
+    return false;
+  }
+  if (!(marker.effective_samples > 0)) {
+    return false;
+  }
+  const double std_error = std::sqrt((marker.cov_xx + marker.cov_yy) / marker.effective_samples);
+  return std_error <= freshness.max_std_error;
+}
+
+bool read_marker_cache(const std::string &path, std::uint64_t map_checksum, std::vector<CachedMarker> &markers,
+                       std::string *error) {
+  markers.clear();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    set_error(error, "no marker cache " + path);
+    return false;
+  }
+  struct stat info;
+  const std::size_t size = fstat(fd, &info) == 0 ? static_cast<std::size_t>(info.st_size) : 0;
+  void *mapping = size >= sizeof(CacheHeader) ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    set_error(error, "cannot read marker cache " + path);
+    return false;
+  }
+  const CacheHeader *header = static_cast<const CacheHeader *>(mapping);
+  const CachedMarker *records =
+      reinterpret_cast<const CachedMarker *>(static_cast<const char *>(mapping) + sizeof(CacheHeader));
+  bool valid = false;
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+      size != sizeof(CacheHeader) + header->count * sizeof(CachedMarker) ||
+      header->records_checksum != fnv1a(records, header->count * sizeof(CachedMarker))) {
+    set_error(error, "marker cache " + path + " is corrupt or from another version");
+  } else if (header->map_checksum != map_checksum) {
+    set_error(error, "marker cache " + path + " was written for another map");
+  } else {
+    markers.assign(records, records + header->count);
+    valid = true;
+  }
+  munmap(mapping, size);
+  return valid;
+}
+
+bool write_marker_cache(const std::string &path, std::uint64_t map_checksum, const std::vector<CachedMarker> &markers,
+                        std::string *error) {
+  CacheHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.count = static_cast<std::uint32_t>(markers.size());
+  header.map_checksum = map_checksum;
+  header.records_checksum = fnv1a(markers.data(), markers.size() * sizeof(CachedMarker));
+
+  const std::string temporary = path + ".tmp";
+  std::FILE *file = std::fopen(temporary.c_str(), "wb");
+  bool written = file != nullptr && std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 std::fwrite(markers.data(), sizeof(CachedMarker), markers.size(), file) == markers.size();
+  if (file != nullptr) {
+    written = (std::fclose(file) == 0) && written;
+  }
+  if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    set_error(error, "cannot write marker cache " + path);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace final_project
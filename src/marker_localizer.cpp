@@ -0,0 +1,81 @@
+/**
+ * @file marker_localizer.cpp
+ * @brief Localizes detected aruco markers in the map without going through /tf.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/marker_localizer.h"
+
+#include <tf2/LinearMath/Transform.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace final_project {
+
+double DetectionWeighting::weight(double image_error, double object_error) const {
+  // Also false for NaN, which aruco_detect reports when the pose could not be refined.
+  if (!(image_error >= 0) || !(object_error >= 0)) {
+    return min_weight;
+  }
+  const double error = image_error / image_error_scale + object_error / object_error_scale;
+  return std::max(min_weight, 1 / (1 + error));
+}
+
+Pose3 to_pose3(const geometry_msgs::Transform &transform) {
+  Pose3 pose;
+  pose.translation = {transform.translation.x, transform.translation.y, transform.translation.z};
+  pose.rotation = {transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w};
+  return pose;
+}
+
+MarkerLocalizer::MarkerLocalizer(const tf2_ros::Buffer &buffer, std::string map_frame, std::string camera_frame,
+                                 double offset)
+    : buffer_(buffer), map_frame_(std::move(map_frame)), camera_frame_(std::move(camera_frame)), offset_(offset) {}
+
+bool MarkerLocalizer::localize(const ros::Time &stamp, const geometry_msgs::Transform &camera_to_marker,
+                               const ros::Duration &timeout, geometry_msgs::Transform &map_to_goal) const {
+  geometry_msgs::Transform map_to_camera;
+  if (!lookup_camera(stamp, timeout, map_to_camera)) {
+    return false;
+  }
+  map_to_goal = compose(map_to_camera, camera_to_marker);
+  return true;
+}
+
+bool MarkerLocalizer::lookup_camera(const ros::Time &stamp, const ros::Duration &timeout,
+                                    geometry_msgs::Transform &map_to_camera) const {
+  try {
+    map_to_camera = buffer_.lookupTransform(map_frame_, camera_frame_, stamp, timeout).transform;
+  } catch (tf2::TransformException &ex) {
+    ROS_WARN("%s", ex.what());
+    return false;
+  }
+  return true;
+}
+
+geometry_msgs::Transform MarkerLocalizer::compose(const geometry_msgs::Transform &map_to_camera,
+                                                  const geometry_msgs::Transform &camera_to_marker) const {
+  tf2::Transform map_camera;
+  tf2::Transform camera_marker;
+  tf2::fromMsg(map_to_camera, map_camera);
+  tf2::fromMsg(camera_to_marker, camera_marker);
+  // The follower location sits 'offset_' along the marker z-axis, which points out of the marker face.
+  const tf2::Transform marker_goal(tf2::Quaternion::getIdentity(), tf2::Vector3(0, 0, offset_));
+  return tf2::toMsg(map_camera * camera_marker * marker_goal);
+}
+
+double MarkerLocalizer::facing_yaw(const geometry_msgs::Transform &map_to_goal) {
+  tf2::Quaternion rotation;
+  tf2::fromMsg(map_to_goal.rotation, rotation);
+  // The marker z-axis points from the marker towards the follower location.
+  const tf2::Vector3 normal = tf2::quatRotate(rotation, tf2::Vector3(0, 0, 1));
+  return std::atan2(-normal.y(), -normal.x());
+}
+
+}  // namespace final_project
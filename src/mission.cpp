@@ -0,0 +1,4205 @@
+/**
+ * @file mission.cpp
+ * @author Anirudh Krishnan Komaralingam (UID: 117446432)
+ * @author Pulkit Mehta (UID: 117551693)
+ * @author Shubham Takbhate (UID: 118359502)
+ * @brief Mission of the explorer and the follower, run by final_project_node and by the mission nodelet.
+ * @version 0.1
+ * @date 2021-12-15
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+#include <actionlib/client/simple_action_client.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <dynamic_reconfigure/server.h>
+#include <fiducial_msgs/FiducialTransformArray.h>
+#include <geometry_msgs/Twist.h>
+#include <map_msgs/OccupancyGridUpdate.h>
+#include <move_base_msgs/MoveBaseAction.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <nav_msgs/GetPlan.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <tf2/utils.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_msgs/TFMessage.h>
+#include <tf2_ros/message_filter.h>
+#include <tf2_ros/transform_listener.h>
+#include <ros/callback_queue.h>
+#include <ros/package.h>
+#include <ros/ros.h>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <nav_msgs/Odometry.h>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "final_project/MissionConfig.h"
+#include "final_project/config_snapshot.h"
+#include "final_project/detector_gate.h"
+#include "final_project/distance_field.h"
+#include "final_project/allocation_counter.h"
+#include "final_project/flat_index_map.h"
+#include "final_project/fleet.h"
+#include "final_project/fleet_coordinator.h"
+#include "final_project/GetTelemetry.h"
+#include "final_project/goal_lookahead.h"
+#include "final_project/goal_refiner.h"
+#include "final_project/goal_retry.h"
+#include "final_project/latency_histogram.h"
+#include "final_project/marker_cache.h"
+#include "final_project/marker_localizer.h"
+#include "final_project/mission.h"
+#include "final_project/mission_state.h"
+#include "final_project/MissionTelemetry.h"
+#include "final_project/pose_fusion.h"
+#include "final_project/preserialized.h"
+#include "final_project/rotation_search.h"
+#include "final_project/route_planner.h"
+#include "final_project/snapshot_buffer.h"
+#include "final_project/spsc_queue.h"
+#include "final_project/startup_readiness.h"
+#include "final_project/target_registry.h"
+#include "final_project/xmlrpc_params.h"
+
+
+typedef actionlib::SimpleActionClient<move_base_msgs::MoveBaseAction> MoveBaseClient;
+
+/*                                      DATA STRUCTURES                                     */
+
+// Follower location standing for the home position of the follower, the other locations index the markers.
+const int follower_home_location = -1;
+
+// Indices of the explorer and the follower in 'mission_state' when the polling and event-driven missions run it.
+const int explorer_id = 0;
+const int follower_id = 1;
+
+// Most markers localized from one image, the others in the image are dropped.
+const std::size_t max_markers_per_image = 8;
+
+/**
+ * @brief Struct holding one aruco marker seen in an image.
+ * 
+ */
+struct marker_observation {
+  // Member 'fiducial_id' contains the fiducial_id of the detected aruco tag.
+  int fiducial_id = -1;
+  // Member 'camera_to_marker' contains the pose of the marker in the explorer camera frame.
+  final_project::Pose3 camera_to_marker;
+  // Member 'weight' contains the weight of the observation in the fusion, from its error fields.
+  double weight = 1.0;
+};
+
+/**
+ * @brief Struct holding the aruco markers of one image, handed from the fiducial callback to the localization stage.
+ * 
+ */
+struct marker_detection {
+  // Member 'robot' contains the index of the explorer whose camera saw the markers, in fleet mode.
+  int robot = 0;
+  // Member 'stamp' contains the stamp of the image the markers were detected in.
+  ros::Time stamp;
+  // Member 'queued' contains the time the fiducial callback queued the detection.
+  ros::WallTime queued;
+  // Member 'count' contains the number of markers in 'markers'.
+  std::size_t count = 0;
+  // Member 'markers' contains the markers of the image, fixed size so the queue never allocates.
+  std::array<marker_observation, max_markers_per_image> markers;
+};
+
+// Ids of the markers whose estimate became stable from one image.
+typedef std::array<int, max_markers_per_image> stable_markers;
+
+/**
+ * @brief Struct holding the tuning of the mission that may change while it runs, see cfg/Mission.cfg.
+ * 
+ */
+struct mission_tuning {
+  // Member 'rotation' contains the tuning of the rotation search, applied at the start of every lookup.
+  final_project::RotationSearch::Params rotation;
+  // Member 'loop_rate' contains the rate the polling mission checks the goals at, in Hz.
+  double loop_rate = 10.0;
+  // Member 'association_radius' is the largest distance between a target and a marker localized in transit.
+  double association_radius = 1.5;
+  // Member 'lookahead_radius' is the distance to its goal a follower is sent the next one at, applied to every goal.
+  double lookahead_radius = 0.3;
+  // Members 'fusion' and 'weighting' contain the tuning of the marker fusion and the weighting of the detections.
+  final_project::PoseFusion::Params fusion;
+  final_project::DetectionWeighting weighting;
+  // Member 'retry' contains the tuning of what becomes of the goals move_base fails, and of their deadlines.
+  final_project::GoalRetryPolicy::Params retry;
+};
+
+/**
+ * @brief Struct holding the current goal of one robot, for the telemetry.
+ * 
+ */
+struct robot_progress {
+  // Member 'name' contains the name of the robot in the fleet.
+  std::string name;
+  // Member 'target' contains the index of the current goal, -1 before the first one.
+  int target = -1;
+  // Members 'goal_x' and 'goal_y' contain the current goal in the map frame.
+  double goal_x = 0;
+  double goal_y = 0;
+  // Member 'eta' contains the time the current goal was expected to take when it was sent, -1 if unknown.
+  double eta = -1;
+  // Member 'sent' contains the time the current goal was sent.
+  ros::Time sent;
+  // Members 'role' and 'state' contain the role and the state of the robot, filled in the snapshots only.
+  final_project::RobotRole role = final_project::RobotRole::Explorer;
+  final_project::RobotState state = final_project::RobotState::Idle;
+};
+
+/**
+ * @brief Struct holding the robots of the mission at one time, for the telemetry.
+ * 
+ */
+struct robots_snapshot {
+  // Member 'start' contains the time the startup ended at, zero before.
+  ros::Time start;
+  std::vector<robot_progress> robots;
+};
+
+/**
+ * @brief Struct holding information about the current status/progress.
+ * 
+ */
+struct program_status_indicator{
+// Member 'current_explorer_target' contains the target number to be visited by explorer.
+int current_explorer_target = -1;
+// Member 'current_follower_target' contains the target number to be visited by follower.
+int current_follower_target = -1;
+// Member 'explorer_route_step' contains the position of the current explorer target in 'explorer_route'.
+int explorer_route_step = -1;
+// Member 'follower_route_step' contains the position of the current follower target in 'follower_route'.
+int follower_route_step = -1;
+};
+
+/**
+ * @brief Struct holding the handles and flags shared by the action client callbacks when the mission is event-driven.
+ * 
+ */
+struct event_mission_context {
+  // Member 'explorer_client' points to the action client of the explorer.
+  MoveBaseClient* explorer_client = nullptr;
+  // Member 'follower_client' points to the action client of the follower.
+  MoveBaseClient* follower_client = nullptr;
+  // Member 'localizer' points to the localizer of the detected markers.
+  const final_project::MarkerLocalizer* localizer = nullptr;
+  // Member 'tf_buffer' points to the buffer holding the pose of the explorer.
+  tf2_ros::Buffer* tf_buffer = nullptr;
+  // Member 'map' contains the static map, used to guess where the marker is. May be null.
+  nav_msgs::OccupancyGrid::ConstPtr map;
+  // Member 'explorer_pub' publishes velocity commands to rotate the explorer.
+  ros::Publisher explorer_pub;
+  // Member 'rotate_timer' keeps the explorer rotating while it looks for a marker.
+  ros::Timer rotate_timer;
+  // Member 'detection_ready' wakes the localization stage when fiducial_callback() queues a detection.
+  std::condition_variable detection_ready;
+  // Member 'detection_mutex' is only used to wait on 'detection_ready', the producer never takes it.
+  std::mutex detection_mutex;
+  // Member 'mutex' guards 'mission_state' and the members below, which are touched from the action client threads
+  // and the localizer.
+  std::mutex mutex;
+  // Member 'looking_since' contains the time the explorer started looking, older detections are ignored.
+  ros::Time looking_since;
+  // Member 'rotation_search' chooses how the explorer turns while it looks for the marker.
+  final_project::RotationSearch rotation_search;
+  // Member 'scan_while_driving' fuses the detections made in transit and skips targets already localized.
+  bool scan_while_driving = false;
+  // Member 'optimize_routes' orders the follower goals by travel cost once exploring is over.
+  bool optimize_routes = false;
+  // Member 'follower_planner' points to the make_plan client of the follower, null to use straight distances.
+  ros::ServiceClient* follower_planner = nullptr;
+  // Member 'pipelined' sends each localized marker to the follower straight away instead of after exploring.
+  bool pipelined = false;
+  // Member 'follower_queue' holds the markers the follower has not been sent to yet, by index in the registry.
+  std::deque<int> follower_queue;
+  // Member 'follower_lookahead' sends the follower its next goal as it passes the current one.
+  final_project::GoalLookahead follower_lookahead;
+  // Member 'follower_refiner' points to the costmap of the follower its goals are refined in, may be null.
+  const final_project::GoalRefiner* follower_refiner = nullptr;
+  // Members 'explorer_retry' and 'follower_retry' decide what becomes of the goals move_base fails.
+  final_project::GoalRetryPolicy explorer_retry;
+  final_project::GoalRetryPolicy follower_retry;
+  // Members 'explorer_goals' and 'follower_goals' count the goals sent, the callbacks of a replaced goal are
+  // ignored.
+  unsigned explorer_goals = 0;
+  unsigned follower_goals = 0;
+  // Members 'explorer_deadline' and 'follower_deadline' contain the time the current goals are given up at, zero
+  // when there is none.
+  ros::Time explorer_deadline;
+  ros::Time follower_deadline;
+};
+
+// Defined next to the stages that use them.
+struct fiducial_input;
+struct costmap_input;
+struct tuning_server;
+struct telemetry_server;
+struct fleet_robot;
+struct fleet_mission_context;
+
+/*                                      FUNCTION PROTOTYPES                                     */
+
+/**
+ * @brief Method to get the explorer targets locations, every entry of 'aruco_lookup_locations' in the order
+ * of its number.
+ * 
+ * @param nh Nodehandle for a ROS node
+ * @param registry Receives the lookup targets.
+ */
+void get_explorer_targets(ros::NodeHandle &nh, final_project::TargetRegistry& registry);
+/**
+ * @brief Method to get the robots of the mission from the '~fleet' list, the default fleet when it is unset.
+ * 
+ * @param pnh Private nodehandle of the ROS node
+ * @param robots Receives the robots.
+ */
+void get_fleet(ros::NodeHandle &pnh, std::vector<final_project::RobotSpec>& robots);
+/**
+ * @brief Method to get the tuning of the marker pose fusion.
+ * 
+ * @param pnh Private nodehandle of the ROS node
+ * @param params Receives the tuning, fields without a parameter keep their default.
+ */
+void get_fusion_params(ros::NodeHandle &pnh, final_project::PoseFusion::Params& params);
+/**
+ * @brief Method to get how the detections are weighted in the marker pose fusion.
+ * 
+ * @param pnh Private nodehandle of the ROS node
+ * @param weighting Receives the tuning, fields without a parameter keep their default.
+ */
+void get_detection_weighting(ros::NodeHandle &pnh, final_project::DetectionWeighting& weighting);
+/**
+ * @brief Method to get the tuning of the rotation search.
+ * 
+ * @param pnh Private nodehandle of the ROS node
+ * @param params Receives the tuning, fields without a parameter keep their default.
+ */
+void get_rotation_params(ros::NodeHandle &pnh, final_project::RotationSearch::Params& params);
+/**
+ * @brief Method to get the tuning of the search of the follower goals in the costmap.
+ * 
+ * @param pnh Private nodehandle of the ROS node
+ * @param params Receives the tuning, fields without a parameter keep their default.
+ */
+void get_refiner_params(ros::NodeHandle &pnh, final_project::GoalRefiner::Params& params);
+/**
+ * @brief Method to get the tuning of what becomes of the goals move_base fails.
+ * 
+ * @param pnh Private nodehandle of the ROS node
+ * @param params Receives the tuning, fields without a parameter keep their default.
+ */
+void get_retry_params(ros::NodeHandle &pnh, final_project::GoalRetryPolicy::Params& params);
+/**
+ * @brief Method to get the directory ROS keeps its files in, $ROS_HOME or ~/.ros.
+ */
+std::string ros_home_dir();
+/**
+ * @brief Method to get the map_server description of the static map, ~map_yaml or the map of the package.
+ * 
+ * @param pnh Private nodehandle of the ROS node
+ */
+std::string map_yaml_path(ros::NodeHandle &pnh);
+/**
+ * @brief Method to set a follower goal at a given follower location.
+ * 
+ * @param follower_goal variable containing the follower goal.
+ * @param location Follower location to go to, in map frame.
+ */
+void set_follower_goal(move_base_msgs::MoveBaseGoal& follower_goal, const std::array<double, 2>& location);
+/**
+ * @brief Method to lock the mutex guarding the registry of the mission, if the registry is shared between threads.
+ * 
+ * @param mutex Mutex of the threads sharing the registry, null if the caller is its only user.
+ */
+std::unique_lock<std::mutex> lock_registry(std::mutex* mutex);
+
+/*                                      MISSION STATE                                     */
+
+/**
+ * @brief Class holding the state of one mission, and the stages that read and write it.
+ * 
+ * Every Mission has its own, none of it is global, but only one mission runs per process, see Mission. The stages
+ * declared without documentation are documented where they are defined.
+ */
+class final_project::Mission::Impl {
+ public:
+  /**
+   * @brief Construct the state of a mission, ready to run.
+   * 
+   * @param host How the calling process serves the callbacks and ends the mission.
+   */
+  explicit Impl(const final_project::MissionHost &host) : mission_host(host) {}
+
+  // The detection queue keeps its indices on cache lines of their own, aligned beyond what new guarantees before
+  // C++17.
+  static void* operator new(std::size_t size)
+  {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(Impl), size) != 0) {
+      throw std::bad_alloc();
+    }
+    return memory;
+  }
+  static void operator delete(void* memory)
+  {
+    std::free(memory);
+  }
+
+  // Entry points of final_project::Mission, see mission.h.
+  int run_mission(ros::NodeHandle &nh, ros::NodeHandle &pnh);
+  void stop_mission();
+  final_project::MissionResult last_mission_result() const;
+  final_project::ReplayResult replay_bag(ros::NodeHandle &pnh, const std::string &path);
+  std::vector<std::pair<std::string, final_project::HistogramSnapshot>> stage_snapshots() const;
+
+  /**
+   * @brief Method to get the location of a target of the explorer route.
+   * 
+   * @param target Index of a lookup target, or explorer_home_target() for the home position.
+   * @return std::array<double, 2> Location in map frame.
+   */
+  std::array<double, 2> explorer_waypoint(int target);
+  /**
+   * @brief Method to get the target of the explorer route standing for its home position.
+   */
+  int explorer_home_target();
+  /**
+   * @brief Method to get the location of a follower location.
+   * 
+   * @param location Index of a marker, or follower_home_location.
+   * @return std::array<double, 2> Location in map frame.
+   */
+  std::array<double, 2> follower_waypoint(int location);
+  /**
+   * @brief Method to make room for the markers of the mission in the fusion and the registry, so that the first
+   * detection of a marker allocates nothing either.
+   * 
+   * @param pnh Private nodehandle of the ROS node
+   */
+  void reserve_markers(ros::NodeHandle &pnh);
+  /**
+   * @brief Method to start the rotation search of the explorer at its current target.
+   * 
+   * @param search Rotation search to start, given the current tuning.
+   * @param tfBuffer Contains the pose of the explorer in the map.
+   * @param map Static map used to guess the bearing of the marker, may be null.
+   * @param target Lookup location the explorer is at.
+   * @param base_frame Base frame of the explorer.
+   */
+  void start_rotation_search(final_project::RotationSearch& search, const tf2_ros::Buffer& tfBuffer,
+                             const nav_msgs::OccupancyGrid::ConstPtr& map, const std::array<double, 2>& target,
+                             const std::string& base_frame);
+  /**
+   * @brief Method to set the next goal location for the explorer.
+   * 
+   * @param explorer_goal variable containing the explorer goal.
+   */
+  void next_explorer_goal(move_base_msgs::MoveBaseGoal& explorer_goal);
+  /**
+   * @brief Method to set an explorer goal at a target of the explorer route.
+   * 
+   * @param explorer_goal variable containing the explorer goal.
+   * @param target Index of a lookup target, or explorer_home_target() for the home position.
+   */
+  void set_explorer_goal(move_base_msgs::MoveBaseGoal& explorer_goal, int target);
+  /**
+   * @brief Method to move the current explorer target to the end of the explorer route, before home, so that
+   * next_explorer_goal() goes on with the target after it.
+   */
+  void defer_explorer_target();
+  /**
+   * @brief Method to display the resulting locations found by the explorer.
+   * 
+   */
+  void explorer_summary();
+  /**
+   * @brief variable containing the follower goal.
+   * 
+   * @param follower_goal 
+   * @param refiner Costmap of the follower, may be null.
+   */
+  void next_follower_goal(move_base_msgs::MoveBaseGoal& follower_goal, const final_project::GoalRefiner* refiner);
+  /**
+   * @brief Method to move on to the next follower location of the follower route.
+   * 
+   * @return int Index of the marker in 'target_registry', or follower_home_location.
+   */
+  int next_follower_location();
+  /**
+   * @brief Method to move the current follower location to the end of the follower route, before home, so that
+   * next_follower_location() goes on with the location after it.
+   */
+  void defer_follower_location();
+  /**
+   * @brief Method to compute the travel cost between every pair of points.
+   * 
+   * @param planner Client of a move_base make_plan service. When it is null the distance fields are used instead,
+   * and the straight distance when neither gives a path.
+   * @param points Points in the map frame.
+   * @return std::vector<double> Row-major matrix of the costs, the entry i * n + j is the cost from point i to point j.
+   */
+  std::vector<double> travel_costs(ros::ServiceClient* planner, const std::vector<std::array<double, 2>>& points);
+  /**
+   * @brief Method to load the static map and map or build the distance fields from the known targets and homes.
+   * 
+   * @param pnh Private nodehandle of the ROS node
+   */
+  void load_distance_fields(ros::NodeHandle &pnh);
+  /**
+   * @brief Method to read the markers localized by the previous launches and take the trusted ones as localized,
+   * so their targets need no lookup. Stale or imprecise markers are left to the explorer.
+   * 
+   * @param pnh Private nodehandle of the ROS node
+   * @param radius Largest distance between a target and a cached marker that saves its lookup.
+   */
+  void load_marker_cache(ros::NodeHandle &pnh, double radius);
+  /**
+   * @brief Method to write every stable marker to the cache, called once exploring is over.
+   */
+  void save_marker_cache();
+  /**
+   * @brief Method to make the detectors skip the markers taken from the cache.
+   */
+  void ignore_cached_markers();
+  /**
+   * @brief Method to set the order of the explorer targets, home last.
+   * 
+   * @param planner Client of the explorer make_plan service, may be null.
+   * @param optimize Order the targets so that the explorer drives the shortest way, otherwise keep their order.
+   */
+  void plan_explorer_route(ros::ServiceClient* planner, bool optimize);
+  /**
+   * @brief Method to set the order of the localized follower locations, home last.
+   * 
+   * @param planner Client of the follower make_plan service, may be null.
+   * @param optimize Order the locations so that the follower drives the shortest way, otherwise keep the order
+   * the markers were localized in.
+   */
+  void plan_follower_route(ros::ServiceClient* planner, bool optimize);
+  /**
+   * @brief Method to set a follower goal in front of a marker, facing it, moved by the search of the costmap when
+   * the nominal location is too close to an obstacle.
+   * 
+   * @param follower_goal variable containing the follower goal.
+   * @param marker Index of the marker in 'target_registry'.
+   * @param refiner Costmap of the follower, null to keep the nominal location.
+   * @param registry_mutex Guards 'target_registry' while the localization stage updates it, null if the caller is
+   * its only user or already holds it.
+   */
+  void set_marker_goal(move_base_msgs::MoveBaseGoal& follower_goal, int marker,
+                       const final_project::GoalRefiner* refiner, std::mutex* registry_mutex);
+  /**
+   * @brief Method to set the goal of the follower running the mission at one of its follower locations.
+   * 
+   * @param follower_goal variable containing the follower goal.
+   * @param location Index of the marker in 'target_registry', or follower_home_location.
+   * @param refiner Costmap of the follower, may be null.
+   * @param registry_mutex Guards 'target_registry', see set_marker_goal.
+   */
+  void set_follower_goal_at(move_base_msgs::MoveBaseGoal& follower_goal, int location,
+                            const final_project::GoalRefiner* refiner, std::mutex* registry_mutex);
+  /**
+   * @brief Method to wait for the move_base servers, the TF tree from the map to each robot, the marker detectors
+   * and the static map all at the same time, then report when each came up.
+   * 
+   * @param nh Nodehandle for a ROS node
+   * @param timeout Overall deadline in seconds, 0 to wait as long as it takes for the move_base servers only.
+   * @param robots Robots of the mission.
+   * @param clients move_base action client of each robot, in the order of 'robots'.
+   * @param tfBuffer Buffer of the TF listener.
+   * @param map Receives the static map, null if it did not arrive in time.
+   * @return true if every move_base server is up, the other dependencies are not required.
+   * @return false otherwise.
+   */
+  bool wait_for_startup(ros::NodeHandle &nh, double timeout, const std::vector<final_project::RobotSpec>& robots,
+                        const std::vector<MoveBaseClient*>& clients, const tf2_ros::Buffer& tfBuffer,
+                        nav_msgs::OccupancyGrid::ConstPtr& map);
+  /**
+   * @brief Method to send the next explorer goal with the event-driven callbacks attached.
+   * 
+   * @param ctx Context of the event-driven mission.
+   */
+  void send_explorer_goal(event_mission_context &ctx);
+  /**
+   * @brief Method to send the explorer a goal at its current target with the event-driven callbacks attached, moved
+   * if the goal is retried.
+   * 
+   * @param ctx Context of the event-driven mission.
+   * @param explorer_goal Goal at the nominal location of the target.
+   */
+  void send_current_explorer_goal(event_mission_context &ctx, move_base_msgs::MoveBaseGoal &explorer_goal);
+  /**
+   * @brief Method to send the next follower goal with the event-driven callbacks attached.
+   * 
+   * @param ctx Context of the event-driven mission.
+   */
+  void send_follower_goal(event_mission_context &ctx);
+  /**
+   * @brief Method to send a follower goal at a given location with the event-driven callbacks attached.
+   * 
+   * @param ctx Context of the event-driven mission.
+   * @param location Index of the marker to go to, or follower_home_location.
+   */
+  void send_follower_goal_to(event_mission_context &ctx, int location);
+  /**
+   * @brief Method to move the mission on once the explorer reached its goal, to look for the marker or, at home,
+   * to hand over to the follower.
+   * 
+   * @param ctx Context of the event-driven mission.
+   */
+  void explorer_arrived(event_mission_context &ctx);
+
+  // Stages shared by every mode.
+  bool mission_running();
+  void finish_mission(bool completed = true);
+  void wait_for_mission_end();
+  void spin_mission_callbacks();
+  void add_observations(const fiducial_msgs::FiducialTransformArray &msg, marker_detection &detection);
+  void check_hot_path(std::uint64_t since, const char *stage);
+  void queue_detection(const fiducial_msgs::FiducialTransformArray::ConstPtr &msg, int robot);
+  void fiducial_callback(const fiducial_msgs::FiducialTransformArray::ConstPtr &msg);
+  void subscribe_fiducials(ros::NodeHandle &nh, tf2_ros::Buffer &buffer, const final_project::RobotSpec &spec,
+                           std::atomic<double> &last_detection,
+                           const std::function<void(const fiducial_msgs::FiducialTransformArray::ConstPtr &)> &on_ready,
+                           fiducial_input &input);
+  void subscribe_costmap(ros::NodeHandle &nh, const final_project::RobotSpec &spec, costmap_input &input);
+  void serve_tuning(ros::NodeHandle &pnh, tuning_server &server);
+  void update_telemetry(telemetry_server &server);
+  void serve_telemetry(ros::NodeHandle &pnh, telemetry_server &server);
+  void snapshot_robots();
+  void snapshot_markers(bool force);
+  int add_robot(const final_project::RobotSpec &spec);
+  double field_path_length(const std::array<double, 2>& a, const std::array<double, 2>& b);
+  double travel_length(const std::array<double, 2>& a, const std::array<double, 2>& b);
+  double goal_length(const tf2_ros::Buffer& buffer, const std::string& base_frame,
+                     const move_base_msgs::MoveBaseGoal& goal);
+  ros::Time goal_deadline(final_project::GoalRetryPolicy& policy, int robot, int target,
+                          const move_base_msgs::MoveBaseGoal& goal, double length);
+  final_project::GoalRetryPolicy::Decision goal_failed(final_project::GoalRetryPolicy& policy, const std::string& robot,
+                                                       int id, bool deferrable, const std::string& why);
+  void publish_metrics(const ros::Publisher& pub);
+  void gate_detector(int robot, bool enabled);
+  bool robot_event(int robot, final_project::RobotEvent event);
+  std::size_t listen_at(const final_project::MarkerLocalizer &localizer, const marker_detection &detection,
+                        const ros::Duration &timeout, stable_markers& stable, std::mutex* registry_mutex);
+  void localize_target(int target, int fiducial_id);
+  int nearest_free_target(double x, double y, double radius);
+  int assign_marker_to_target(int fiducial_id, double radius);
+  void listen(const final_project::MarkerLocalizer &localizer, double radius, bool& status);
+  bool scan_in_transit(const final_project::MarkerLocalizer &localizer, double radius);
+  // Stages of the event-driven mission.
+  void dispatch_pipelined_follower(event_mission_context &ctx);
+  bool follower_passed(event_mission_context &ctx, double x, double y);
+  void follower_goal_failed(event_mission_context &ctx, unsigned goal, const std::string &why);
+  void follower_done_callback(event_mission_context &ctx, unsigned goal, const actionlib::SimpleClientGoalState &state);
+  void explorer_goal_failed(event_mission_context &ctx, unsigned goal, const std::string &why);
+  void explorer_done_callback(event_mission_context &ctx, unsigned goal, const actionlib::SimpleClientGoalState &state);
+  void handle_detection(event_mission_context &ctx, const marker_detection &detection);
+  void localizer_loop(event_mission_context &ctx);
+  void check_event_deadlines(event_mission_context &ctx);
+  void run_event_mission(ros::NodeHandle &nh, event_mission_context &ctx);
+  // Stages of the fleet mission.
+  void send_fleet_goal(fleet_robot &robot, const move_base_msgs::MoveBaseGoal& goal,
+                       std::function<void(const actionlib::SimpleClientGoalState&)> done,
+                       std::function<bool(double, double)> passed = nullptr);
+  void send_fleet_explorer_goal(fleet_mission_context &ctx, int index);
+  void dispatch_fleet_explorer(fleet_mission_context &ctx, int index);
+  void send_fleet_follower_goal(fleet_mission_context &ctx, int index);
+  void dispatch_fleet_follower(fleet_mission_context &ctx, int index);
+  void fleet_summary(fleet_mission_context &ctx);
+  void fleet_explorer_home(fleet_mission_context &ctx, int index);
+  void fleet_follower_home(fleet_mission_context &ctx, int index);
+  void fleet_explorer_failed(fleet_mission_context &ctx, int index, const std::string &why);
+  void fleet_follower_failed(fleet_mission_context &ctx, int index, const std::string &why);
+  void fleet_explorer_done(fleet_mission_context &ctx, int index, unsigned goal,
+                           const actionlib::SimpleClientGoalState &state);
+  void fleet_follower_done(fleet_mission_context &ctx, int index, unsigned goal,
+                           const actionlib::SimpleClientGoalState &state);
+  void check_fleet_deadlines(fleet_mission_context &ctx);
+  void fleet_marker_localized(fleet_mission_context &ctx, int target, int fiducial_id);
+  void handle_fleet_detection(fleet_mission_context &ctx, const marker_detection &detection);
+  bool run_fleet_mission(ros::NodeHandle &nh, fleet_mission_context &ctx,
+                         const final_project::RotationSearch::Params& rotation_params);
+
+  // Lookup targets of the explorer, and follower locations of the localized markers.
+  final_project::TargetRegistry target_registry;
+
+  // Robots of the mission, and the explorer and follower running it.
+  std::vector<final_project::RobotSpec> fleet;
+  final_project::RobotSpec explorer_robot;
+  final_project::RobotSpec follower_robot;
+
+  // State of every robot of the mission, guarded by the mutex of the event-driven or fleet context. The polling and
+  // event-driven missions add the explorer then the follower, the fleet mission adds its robots in ~fleet order.
+  final_project::MissionStateMachine mission_state;
+
+  // Static map the path lengths are computed over, and the distance fields from the known targets. The mutex guards
+  // the fields, the path lengths from points other than the sources are computed on demand.
+  final_project::OccupancyBitmap static_map;
+  final_project::DistanceFieldCache distance_fields;
+  std::mutex distance_fields_mutex;
+
+  // Fused pose of every marker observed by the explorer, and the version of the tuning it was last given. Both are
+  // only touched by the thread that fuses.
+  final_project::PoseFusion marker_fusion;
+  std::uint64_t marker_fusion_tuning = 0;
+
+  // Markers of the previous launches trusted without a lookup, and the cache file they are read from and written
+  // to, with the checksum of the map they are localized in. The path is empty unless ~cache/enabled is set.
+  std::vector<final_project::CachedMarker> cached_markers;
+  std::string marker_cache_path;
+  std::uint64_t marker_cache_map = 0;
+
+  // Detector of each explorer, indexed like the 'robot' of the detections, empty unless ~detector/gating is set.
+  std::vector<std::unique_ptr<final_project::DetectorGate>> detector_gates;
+  // Switch the detectors off while their detections are not needed.
+  bool detector_gating = true;
+  // Stop localizing the markers whose estimate is stable, and make the detectors skip them.
+  bool ignore_localized_markers = true;
+
+  // Move the follower goals to a free spot of the global costmap of the follower, and the tuning of the search.
+  bool refine_follower_goals = true;
+  final_project::GoalRefiner::Params goal_refiner_params;
+  // Distance in front of a marker its follower location is placed at, given to every MarkerLocalizer. The fused
+  // observations depend on it, so it is only read when the mission starts.
+  double follower_standoff = 0.4;
+  // Depth of the queues of the fiducial subscriptions and of the velocity publishers.
+  int topic_queue_size = 5;
+
+  // Tuning of the mission, replaced as a whole by dynamic_reconfigure and read by every stage without a lock.
+  final_project::ConfigSnapshot<mission_tuning> tuning;
+
+  // Counts of the goals move_base failed and of those given up, of every robot of the mission. Every robot keeps
+  // the failures of its own goals.
+  std::atomic<std::size_t> goal_failures{0};
+  std::atomic<std::size_t> goals_given_up{0};
+
+  // Heap allocations made by the steady-state detection path, counted in the builds that count allocations only.
+  std::atomic<std::uint64_t> hot_path_allocations{0};
+
+  // Goals of the robots of the mission, indexed and guarded like 'mission_state'.
+  std::vector<robot_progress> mission_progress;
+  // Latest robots and markers of the mission, handed from the mission and from the localization stage to the
+  // telemetry thread, which never reads 'mission_state' or 'marker_fusion' itself.
+  final_project::SnapshotBuffer<robots_snapshot> robot_telemetry;
+  final_project::SnapshotBuffer<std::vector<final_project::Se2Estimate>> marker_telemetry;
+  // Period of the telemetry, in seconds, 0 when there is none, and the time the markers were last handed to it.
+  double telemetry_period = 0;
+  ros::WallTime markers_snapshot_time;
+
+  // Detections waiting to be localized, filled by fiducial_callback() and drained by the localization stage.
+  final_project::SpscQueue<marker_detection, 64> detection_queue;
+
+  // Order in which the explorer visits its targets, the home position (one past the last target) last.
+  std::vector<int> explorer_route;
+  // Order in which the follower visits the follower locations, the home position last.
+  std::vector<int> follower_route;
+
+  // Durations of the instrumented stages, recorded from every thread of the mission.
+  final_project::MissionMetrics mission_metrics;
+
+  // Time of the last marker detection, in seconds, read by the rotation search.
+  std::atomic<double> last_detection_time{0};
+
+  // Process running the mission, and the flag raised once the mission is over or asked to stop.
+  final_project::MissionHost mission_host;
+  std::atomic<bool> mission_stopped{false};
+  std::mutex mission_end_mutex;
+  std::condition_variable mission_end;
+  // Outcome of the mission: whether the follower got home, when the startup ended and the mission ended, and when
+  // each lookup target got its marker, in seconds after the startup.
+  std::atomic<bool> mission_completed{false};
+  ros::Time mission_start_time;
+  ros::Time mission_end_time;
+  std::vector<double> target_done_after;
+
+  // Current targets of the explorer and the follower running the mission, and their steps along the routes.
+  program_status_indicator psi;
+};
+
+/**
+ * @brief Method to check if the mission goes on, what every loop of the mission waits on.
+ */
+bool final_project::Mission::Impl::mission_running()
+{
+  return ros::ok() && !mission_stopped.load();
+}
+
+/**
+ * @brief Method to end the mission, the host decides whether the process ends with it.
+ * 
+ * @param completed Every follower got home, lowered if one gave up on its way home.
+ */
+void final_project::Mission::Impl::finish_mission(bool completed)
+{
+  if (mission_stopped.exchange(true)) {
+    return;
+  }
+  mission_completed.store(completed);
+  mission_end_time = ros::Time::now();
+  mission_end.notify_all();
+  if (mission_host.on_finished) {
+    mission_host.on_finished();
+  }
+}
+
+/**
+ * @brief Method to block until the mission is over.
+ */
+void final_project::Mission::Impl::wait_for_mission_end()
+{
+  std::unique_lock<std::mutex> lock(mission_end_mutex);
+  // The timeout covers a ROS shutdown, which does not notify.
+  while (mission_running()) {
+    mission_end.wait_for(lock, std::chrono::milliseconds(100));
+  }
+}
+
+/**
+ * @brief Method to serve the callbacks of a polling loop, unless the host already does.
+ */
+void final_project::Mission::Impl::spin_mission_callbacks()
+{
+  if (mission_host.spin) {
+    ros::spinOnce();
+  }
+}
+
+
+/**
+ * @brief Method to add the markers of one image to a detection, with the weight of each.
+ * 
+ * @param msg Contains the ros message published to fiducial_transforms topic.
+ * @param detection Receives the markers, the first max_markers_per_image only.
+ */
+void final_project::Mission::Impl::add_observations(const fiducial_msgs::FiducialTransformArray &msg,
+                                                    marker_detection &detection)
+{
+  const final_project::DetectionWeighting &weighting = tuning.get().weighting;
+  for (const fiducial_msgs::FiducialTransform &transform : msg.transforms) {
+    if (detection.count == max_markers_per_image) {
+      ROS_WARN_STREAM_THROTTLE(1.0, msg.transforms.size() << " markers in one image, only the first "
+                               << max_markers_per_image << " are localized");
+      break;
+    }
+    marker_observation &marker = detection.markers[detection.count++];
+    marker.fiducial_id = transform.fiducial_id;
+    marker.camera_to_marker = final_project::to_pose3(transform.transform);
+    marker.weight = weighting.weight(transform.image_error, transform.object_error);
+  }
+}
+
+/**
+ * @brief Method to check that the calling thread allocated nothing since 'since', in the builds that count
+ * allocations. The allocations found are added to the count of the hot path and logged.
+ * 
+ * @param since Allocations of the calling thread at the start of the checked code.
+ * @param stage Name of the checked code, for the log.
+ */
+void final_project::Mission::Impl::check_hot_path(std::uint64_t since, const char *stage)
+{
+  if (!final_project::allocations_counted()) {
+    return;
+  }
+  const std::uint64_t allocated = final_project::thread_allocations() - since;
+  if (allocated == 0) {
+    return;
+  }
+  hot_path_allocations += allocated;
+  ROS_WARN_STREAM_THROTTLE(1.0, stage << " allocated " << allocated << " times, "
+                           << hot_path_allocations.load() << " allocations in the detection path so far");
+}
+
+/**
+ * @brief Method to queue the aruco markers detected by one explorer in one image for the localization stage.
+ * Never blocks.
+ * 
+ * @param msg Contains the ros message published to fiducial_transforms topic.
+ * @param robot Index of the explorer whose camera the message comes from.
+ */
+void final_project::Mission::Impl::queue_detection(const fiducial_msgs::FiducialTransformArray::ConstPtr &msg, int robot)
+{
+  //check if the marker is detected
+  if (msg->transforms.empty()) {
+    return;
+  }
+  const std::uint64_t allocations = final_project::thread_allocations();
+  marker_detection detection;
+  detection.robot = robot;
+  // The camera pose is looked up at the time the image was taken.
+  detection.stamp = msg->header.stamp.isZero() ? ros::Time::now() : msg->header.stamp;
+  detection.queued = ros::WallTime::now();
+  if (!msg->header.stamp.isZero()) {
+    mission_metrics.detection_latency.record((ros::Time::now() - msg->header.stamp).toSec());
+  }
+  add_observations(*msg, detection);
+  if (!detection_queue.try_push(detection)) {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Detection queue full, " << detection_queue.dropped() << " detections dropped");
+    return;
+  }
+  check_hot_path(allocations, "Queueing a detection");
+}
+
+/**
+ * @brief Callback function for subscriber which queues the detected aruco marker for the localization stage.
+ * Never blocks.
+ * 
+ * @param msg Contains the ros message published to fiducial_transforms topic.
+ */
+void final_project::Mission::Impl::fiducial_callback(const fiducial_msgs::FiducialTransformArray::ConstPtr &msg)
+{
+  queue_detection(msg, 0);
+}
+
+/**
+ * @brief Struct holding a fiducial message as received, with the camera frame of the explorer it came from.
+ * 
+ * The TF filter waits for the camera pose in that frame whatever the header says, so the message is shared, never
+ * copied to rewrite its frame_id.
+ */
+struct camera_fiducials {
+  typedef boost::shared_ptr<const camera_fiducials> ConstPtr;
+  // Member 'msg' is the message of the detector, untouched.
+  fiducial_msgs::FiducialTransformArray::ConstPtr msg;
+  // Member 'camera_frame' is the frame the localizer looks the camera pose up in.
+  boost::shared_ptr<const std::string> camera_frame;
+};
+
+namespace ros {
+namespace message_traits {
+// The filter looks up the camera frame of the explorer, at the stamp of the image.
+template <> struct FrameId<camera_fiducials> {
+  static std::string value(const camera_fiducials &m) { return *m.camera_frame; }
+};
+template <> struct TimeStamp<camera_fiducials> {
+  static ros::Time value(const camera_fiducials &m) { return m.msg->header.stamp; }
+};
+}  // namespace message_traits
+}  // namespace ros
+
+// Filter holding the fiducial transforms back until the camera pose at their stamp is in the TF buffer.
+typedef tf2_ros::MessageFilter<camera_fiducials> fiducial_filter;
+
+/**
+ * @brief Struct holding the subscription to the fiducial transforms of one explorer.
+ * 
+ */
+struct fiducial_input {
+  // Member 'filter' passes each message on as soon as map->camera at its stamp can be looked up.
+  std::unique_ptr<fiducial_filter> filter;
+  // Member 'subscriber' receives the fiducial transforms and hands those with markers to 'filter', declared last
+  // so that it is shut down first.
+  ros::Subscriber subscriber;
+};
+
+/**
+ * @brief Method to subscribe to the fiducial transforms of an explorer, each message handed on only once the
+ * camera pose at its stamp is in the TF buffer, so the localization stage never waits on a lookup.
+ * 
+ * The filter callbacks go through the callback queue of 'nh', like the subscriber callbacks, so a single
+ * spinner thread keeps them the only producer of the detection queue. The filter waits for the camera frame of
+ * 'spec', the one its MarkerLocalizer looks up, not for the frame of the message header.
+ * 
+ * @param nh Nodehandle the subscriber and the filter are created on.
+ * @param buffer Buffer of the TF listener.
+ * @param spec Explorer whose fiducial transforms are subscribed to.
+ * @param last_detection Receives the time of the last message with a marker, in seconds, without waiting for TF.
+ * @param on_ready Called with each message once map->camera at its stamp is available.
+ * @param input Receives the subscriber and the filter, the subscription lasts as long as it does.
+ */
+void final_project::Mission::Impl::subscribe_fiducials(ros::NodeHandle &nh, tf2_ros::Buffer &buffer,
+    const final_project::RobotSpec &spec, std::atomic<double> &last_detection,
+    const std::function<void(const fiducial_msgs::FiducialTransformArray::ConstPtr &)> &on_ready, fiducial_input &input)
+{
+  // About one second of images at the rate of aruco_detect.
+  input.filter.reset(new fiducial_filter(buffer, "map", 10, nh));
+  input.filter->registerCallback([on_ready](const camera_fiducials::ConstPtr &fiducials) {
+    on_ready(fiducials->msg);
+  });
+  input.filter->registerFailureCallback(
+      [this](const camera_fiducials::ConstPtr &fiducials, tf2_ros::filter_failure_reasons::FilterFailureReason reason) {
+        const ros::Time stamp = fiducials->msg->header.stamp;
+        mission_metrics.tf_failure.record(std::max((ros::Time::now() - stamp).toSec(), 0.0));
+        ROS_WARN_STREAM_THROTTLE(1.0, "Dropped the markers of the image at " << stamp.toSec() << ", "
+                                 << (reason == tf2_ros::filter_failure_reasons::OutTheBack ?
+                                     "it is older than the TF cache" : "its camera pose never came"));
+      });
+  fiducial_filter* filter = input.filter.get();
+  const boost::shared_ptr<const std::string> camera_frame = boost::make_shared<const std::string>(spec.camera_frame);
+  input.subscriber = nh.subscribe<fiducial_msgs::FiducialTransformArray>(spec.fiducial_topic, topic_queue_size,
+      [filter, camera_frame, &last_detection](const fiducial_msgs::FiducialTransformArray::ConstPtr &msg) {
+        if (msg->transforms.empty()) {
+          return;
+        }
+        last_detection.store(ros::Time::now().toSec(), std::memory_order_relaxed);
+        const boost::shared_ptr<camera_fiducials> fiducials = boost::make_shared<camera_fiducials>();
+        fiducials->msg = msg;
+        fiducials->camera_frame = camera_frame;
+        filter->add(fiducials);
+      });
+}
+
+/**
+ * @brief Struct holding the subscription to the global costmap of one follower.
+ * 
+ */
+struct costmap_input {
+  // Member 'refiner' keeps the last costmap and searches it for the follower goals.
+  std::unique_ptr<final_project::GoalRefiner> refiner;
+  // Members 'costmap' and 'updates' receive the whole costmap and the windows of it that changed, declared last
+  // so that they are shut down first.
+  ros::Subscriber costmap;
+  ros::Subscriber updates;
+};
+
+/**
+ * @brief Method to subscribe to the global costmap of a follower, nothing is subscribed to unless
+ * ~refine/enabled is set.
+ * 
+ * The callbacks go through the callback queue of 'nh' and only copy the costs, the search runs when a goal is sent.
+ * 
+ * @param nh Nodehandle the subscribers are created on.
+ * @param spec Follower whose costmap is subscribed to, its move_base node publishes it.
+ * @param input Receives the subscribers and the refiner, the subscription lasts as long as it does.
+ */
+void final_project::Mission::Impl::subscribe_costmap(ros::NodeHandle &nh, const final_project::RobotSpec &spec,
+                                                     costmap_input &input)
+{
+  if (!refine_follower_goals) {
+    return;
+  }
+  input.refiner.reset(new final_project::GoalRefiner(goal_refiner_params));
+  final_project::GoalRefiner* refiner = input.refiner.get();
+  const std::string topic = spec.move_base_action + "/global_costmap/costmap";
+  input.costmap = nh.subscribe<nav_msgs::OccupancyGrid>(topic, 1,
+      [refiner](const nav_msgs::OccupancyGrid::ConstPtr &msg) {
+        refiner->set_costmap(static_cast<int>(msg->info.width), static_cast<int>(msg->info.height),
+                             msg->info.resolution, msg->info.origin.position.x, msg->info.origin.position.y,
+                             msg->data);
+      });
+  input.updates = nh.subscribe<map_msgs::OccupancyGridUpdate>(topic + "_updates", 10,
+      [refiner, topic](const map_msgs::OccupancyGridUpdate::ConstPtr &msg) {
+        if (!refiner->update_costmap(msg->x, msg->y, static_cast<int>(msg->width), static_cast<int>(msg->height),
+                                     msg->data)) {
+          ROS_DEBUG_STREAM_THROTTLE(1.0, "Dropped an update of " << topic << " outside the last costmap");
+        }
+      });
+}
+
+/**
+ * @brief Method to get the dynamic_reconfigure config of a tuning.
+ */
+final_project::MissionConfig tuning_config(const mission_tuning &tuning)
+{
+  final_project::MissionConfig config;
+  config.rotation_fast_rate = tuning.rotation.fast_rate;
+  config.rotation_slow_rate = tuning.rotation.slow_rate;
+  config.rotation_slow_zone = tuning.rotation.slow_zone;
+  config.rotation_detection_hold = tuning.rotation.detection_hold;
+  config.rotation_bearing_range = tuning.rotation.bearing_range;
+  config.loop_rate = tuning.loop_rate;
+  config.scan_association_radius = tuning.association_radius;
+  config.lookahead_radius = tuning.lookahead_radius;
+  config.fusion_min_samples = static_cast<int>(tuning.fusion.min_samples);
+  config.fusion_gate_sigma = tuning.fusion.gate_sigma;
+  config.fusion_min_sigma = tuning.fusion.min_sigma;
+  config.fusion_max_yaw_error = tuning.fusion.max_yaw_error;
+  config.fusion_converged_std_error = tuning.fusion.converged_std_error;
+  config.fusion_converged_yaw_std = tuning.fusion.converged_yaw_std;
+  config.fusion_reset_after_rejects = static_cast<int>(tuning.fusion.reset_after_rejects);
+  config.fusion_image_error_scale = tuning.weighting.image_error_scale;
+  config.fusion_object_error_scale = tuning.weighting.object_error_scale;
+  config.fusion_min_weight = tuning.weighting.min_weight;
+  config.retry_max_retries = tuning.retry.max_retries;
+  config.retry_max_deferrals = tuning.retry.max_deferrals;
+  config.retry_perturbation = tuning.retry.perturbation;
+  config.retry_speed = tuning.retry.speed;
+  config.retry_deadline_factor = tuning.retry.deadline_factor;
+  config.retry_min_deadline = tuning.retry.min_deadline;
+  return config;
+}
+
+/**
+ * @brief Method to get the tuning of a dynamic_reconfigure config, already clamped to the ranges of the .cfg.
+ */
+mission_tuning config_tuning(const final_project::MissionConfig &config)
+{
+  mission_tuning tuning;
+  tuning.rotation.fast_rate = config.rotation_fast_rate;
+  tuning.rotation.slow_rate = config.rotation_slow_rate;
+  tuning.rotation.slow_zone = config.rotation_slow_zone;
+  tuning.rotation.detection_hold = config.rotation_detection_hold;
+  tuning.rotation.bearing_range = config.rotation_bearing_range;
+  tuning.loop_rate = config.loop_rate;
+  tuning.association_radius = config.scan_association_radius;
+  tuning.lookahead_radius = config.lookahead_radius;
+  tuning.fusion.min_samples = static_cast<std::uint32_t>(config.fusion_min_samples);
+  tuning.fusion.gate_sigma = config.fusion_gate_sigma;
+  tuning.fusion.min_sigma = config.fusion_min_sigma;
+  tuning.fusion.max_yaw_error = config.fusion_max_yaw_error;
+  tuning.fusion.converged_std_error = config.fusion_converged_std_error;
+  tuning.fusion.converged_yaw_std = config.fusion_converged_yaw_std;
+  tuning.fusion.reset_after_rejects = static_cast<std::uint32_t>(config.fusion_reset_after_rejects);
+  tuning.weighting.image_error_scale = config.fusion_image_error_scale;
+  tuning.weighting.object_error_scale = config.fusion_object_error_scale;
+  tuning.weighting.min_weight = config.fusion_min_weight;
+  tuning.retry.max_retries = config.retry_max_retries;
+  tuning.retry.max_deferrals = config.retry_max_deferrals;
+  tuning.retry.perturbation = config.retry_perturbation;
+  tuning.retry.speed = config.retry_speed;
+  tuning.retry.deadline_factor = config.retry_deadline_factor;
+  tuning.retry.min_deadline = config.retry_min_deadline;
+  return tuning;
+}
+
+/**
+ * @brief Struct holding the dynamic_reconfigure server of the tuning, with a callback queue and a thread of its own
+ * so that a reconfiguration never runs among the callbacks of the mission.
+ * 
+ */
+struct tuning_server {
+  ros::CallbackQueue queue;
+  std::unique_ptr<dynamic_reconfigure::Server<final_project::MissionConfig>> server;
+  // Member 'spinner' serves 'queue', declared last so that it stops first.
+  std::unique_ptr<ros::AsyncSpinner> spinner;
+};
+
+/**
+ * @brief Method to serve the current tuning on ~set_parameters, every reconfiguration publishes a new snapshot.
+ * 
+ * @param pnh Private nodehandle of the mission, the server advertises next to its parameters.
+ * @param server Receives the server, it serves as long as it lives.
+ */
+void final_project::Mission::Impl::serve_tuning(ros::NodeHandle &pnh, tuning_server &server)
+{
+  ros::NodeHandle nh(pnh);
+  nh.setCallbackQueue(&server.queue);
+  server.server.reset(new dynamic_reconfigure::Server<final_project::MissionConfig>(nh));
+  // The server starts from the tuning read from the private parameters, not from the defaults of the .cfg.
+  final_project::MissionConfig config = tuning_config(tuning.get());
+  server.server->updateConfig(config);
+  server.server->setCallback([this](final_project::MissionConfig &config, std::uint32_t) {
+    const std::uint64_t version = tuning.publish(config_tuning(config));
+    ROS_INFO_STREAM("Mission tuning " << version << " applied");
+  });
+  server.spinner.reset(new ros::AsyncSpinner(1, &server.queue));
+  server.spinner->start();
+}
+
+/**
+ * @brief Struct holding the telemetry of the mission, published and served from a callback queue and a thread of
+ * its own so that it never runs among the callbacks of the mission.
+ * 
+ */
+struct telemetry_server {
+  ros::CallbackQueue queue;
+  ros::Publisher publisher;
+  ros::ServiceServer service;
+  ros::Timer timer;
+  // Member 'message' contains the latest telemetry, 'serialized' the same message serialized once for the topic.
+  final_project::MissionTelemetry message;
+  final_project::Preserialized<final_project::MissionTelemetry> serialized;
+  // Member 'spinner' serves 'queue', declared last so that it stops first.
+  std::unique_ptr<ros::AsyncSpinner> spinner;
+};
+
+/**
+ * @brief Method to rebuild the telemetry from the latest snapshots of the robots and the markers, the stage
+ * histograms and the goal counts, none of which the mission waits on.
+ * 
+ * @param server Telemetry to rebuild, its message and serialized message are replaced.
+ */
+void final_project::Mission::Impl::update_telemetry(telemetry_server &server)
+{
+  final_project::MissionTelemetry &msg = server.message;
+  const ros::Time now = ros::Time::now();
+  msg.header.stamp = now;
+  std::uint64_t version = 0;
+  const robots_snapshot &robots = robot_telemetry.latest(version);
+  msg.elapsed = robots.start.isZero() ? 0.0 : (now - robots.start).toSec();
+  msg.robots.resize(robots.robots.size());
+  for (std::size_t i = 0; i < robots.robots.size(); i++) {
+    const robot_progress &robot = robots.robots[i];
+    final_project::RobotTelemetry &entry = msg.robots[i];
+    entry.name = robot.name;
+    entry.role = robot.role == final_project::RobotRole::Explorer ? final_project::RobotTelemetry::EXPLORER :
+                                                                    final_project::RobotTelemetry::FOLLOWER;
+    // The constants of the message follow the order of RobotState.
+    entry.state = static_cast<std::uint8_t>(robot.state);
+    entry.target = robot.target;
+    entry.goal_x = robot.goal_x;
+    entry.goal_y = robot.goal_y;
+    const bool driving = robot.state == final_project::RobotState::Driving ||
+                         robot.state == final_project::RobotState::HeadingHome;
+    entry.eta = driving && robot.eta >= 0 ? std::max(robot.eta - (now - robot.sent).toSec(), 0.0) : -1.0;
+  }
+  const std::vector<final_project::Se2Estimate> &markers = marker_telemetry.latest(version);
+  msg.markers.resize(markers.size());
+  for (std::size_t i = 0; i < markers.size(); i++) {
+    const final_project::Se2Estimate &estimate = markers[i];
+    final_project::MarkerTelemetry &entry = msg.markers[i];
+    entry.fiducial_id = estimate.fiducial_id;
+    entry.x = estimate.x;
+    entry.y = estimate.y;
+    entry.yaw = estimate.yaw;
+    entry.std_error = estimate.effective_samples > 0 ?
+        std::sqrt((estimate.cov_xx + estimate.cov_yy) / estimate.effective_samples) : 0.0;
+    entry.yaw_std = estimate.yaw_std;
+    entry.samples = estimate.samples;
+    entry.converged = estimate.converged;
+  }
+  msg.stages.resize(final_project::MissionMetrics::kStages);
+  for (std::size_t i = 0; i < final_project::MissionMetrics::kStages; i++) {
+    final_project::StageTelemetry &entry = msg.stages[i];
+    const final_project::HistogramSnapshot snapshot = mission_metrics.stage(i, entry.name).snapshot();
+    entry.count = snapshot.count;
+    entry.mean = snapshot.mean();
+    entry.p50 = snapshot.quantile(0.5);
+    entry.p90 = snapshot.quantile(0.9);
+    entry.p99 = snapshot.quantile(0.99);
+    entry.max = snapshot.max;
+  }
+  msg.goal_failures = static_cast<std::uint32_t>(goal_failures.load());
+  msg.goals_given_up = static_cast<std::uint32_t>(goals_given_up.load());
+  server.serialized.assign(msg);
+}
+
+/**
+ * @brief Method to publish the telemetry on ~telemetry every period and serve the latest on ~get_telemetry.
+ * 
+ * The telemetry is rebuilt and serialized once per period, the topic sends the serialized bytes to every
+ * subscriber and the service answers with the same message, whatever the number of callers.
+ * 
+ * @param pnh Private nodehandle of the mission, the topic and the service are advertised in its namespace.
+ * @param server Receives the publisher, service and timer, they serve as long as it lives.
+ */
+void final_project::Mission::Impl::serve_telemetry(ros::NodeHandle &pnh, telemetry_server &server)
+{
+  ros::NodeHandle nh(pnh);
+  nh.setCallbackQueue(&server.queue);
+  server.publisher = nh.advertise<final_project::MissionTelemetry>("telemetry", 1);
+  server.service = nh.advertiseService<final_project::GetTelemetry::Request, final_project::GetTelemetry::Response>(
+      "get_telemetry", [&server](final_project::GetTelemetry::Request &, final_project::GetTelemetry::Response &res) {
+        res.telemetry = server.message;
+        return true;
+      });
+  update_telemetry(server);
+  server.timer = nh.createTimer(ros::Duration(telemetry_period), [this, &server](const ros::TimerEvent &) {
+    update_telemetry(server);
+    if (server.publisher.getNumSubscribers() > 0) {
+      server.publisher.publish(server.serialized);
+    }
+  });
+  server.spinner.reset(new ros::AsyncSpinner(1, &server.queue));
+  server.spinner->start();
+}
+
+/**
+ * @brief Method to hand the robots of the mission to the telemetry. Called with the mutex of the mission held.
+ */
+void final_project::Mission::Impl::snapshot_robots()
+{
+  if (!(telemetry_period > 0)) {
+    return;
+  }
+  robots_snapshot &snapshot = robot_telemetry.back();
+  snapshot.start = mission_start_time;
+  snapshot.robots.resize(mission_progress.size());
+  for (std::size_t i = 0; i < mission_progress.size(); i++) {
+    snapshot.robots[i] = mission_progress[i];
+    snapshot.robots[i].role = mission_state.role(static_cast<int>(i));
+    snapshot.robots[i].state = mission_state.state(static_cast<int>(i));
+  }
+  robot_telemetry.publish();
+}
+
+/**
+ * @brief Method to hand the fused markers to the telemetry, at most once per period. Called from the thread that
+ * fuses.
+ * 
+ * @param force Hand them over whatever the time since the last time, e.g. when a marker became stable.
+ */
+void final_project::Mission::Impl::snapshot_markers(bool force)
+{
+  if (!(telemetry_period > 0)) {
+    return;
+  }
+  const ros::WallTime now = ros::WallTime::now();
+  if (!force && (now - markers_snapshot_time).toSec() < telemetry_period) {
+    return;
+  }
+  markers_snapshot_time = now;
+  std::vector<final_project::Se2Estimate> &markers = marker_telemetry.back();
+  const std::vector<int> &ids = marker_fusion.fiducial_ids();
+  markers.resize(ids.size());
+  for (std::size_t i = 0; i < ids.size(); i++) {
+    marker_fusion.estimate(ids[i], markers[i]);
+  }
+  marker_telemetry.publish();
+}
+
+/**
+ * @brief Method to add a robot to the mission, Idle and without a goal.
+ * 
+ * @param spec Robot of the fleet.
+ * @return int Index of the robot in 'mission_state'.
+ */
+int final_project::Mission::Impl::add_robot(const final_project::RobotSpec &spec)
+{
+  const int robot = mission_state.add_robot(spec.role);
+  mission_progress.resize(mission_state.robot_count());
+  mission_progress[robot].name = spec.name;
+  return robot;
+}
+
+/**
+ * @brief Method to record the time from sending a goal to its success.
+ * 
+ * @param histogram Histogram of the robot role.
+ * @param sent Time the goal was sent.
+ * @param state Final state of the goal, only successful goals are recorded.
+ */
+void record_goal(final_project::LatencyHistogram& histogram, const ros::Time& sent,
+                 const actionlib::SimpleClientGoalState& state)
+{
+  if (state == actionlib::SimpleClientGoalState::SUCCEEDED) {
+    histogram.record((ros::Time::now() - sent).toSec());
+  }
+}
+
+/**
+ * @brief Method to get the path length between two points over the distance fields, from any thread.
+ * 
+ * @return double Path length in meters, infinity if the fields are not loaded or give no path.
+ */
+double final_project::Mission::Impl::field_path_length(const std::array<double, 2>& a, const std::array<double, 2>& b)
+{
+  std::lock_guard<std::mutex> lock(distance_fields_mutex);
+  return distance_fields.path_length(a[0], a[1], b[0], b[1]);
+}
+
+/**
+ * @brief Method to get the travel length between two points, the straight distance when the distance fields give
+ * none.
+ * 
+ * @return double Length in meters.
+ */
+double final_project::Mission::Impl::travel_length(const std::array<double, 2>& a, const std::array<double, 2>& b)
+{
+  const double length = field_path_length(a, b);
+  return std::isfinite(length) ? length : std::hypot(b[0] - a[0], b[1] - a[1]);
+}
+
+/**
+ * @brief Method to get the travel length of the robot to a goal, from the precomputed field of the source closest
+ * to the goal, its lookup target or a home, so no field is computed for it. Never takes the mutex of the mission,
+ * the fields are read-only once loaded.
+ * 
+ * @param buffer Buffer holding the pose of the robot.
+ * @param base_frame Base frame of the robot.
+ * @param goal Goal about to be sent, a perturbed or refined goal keeps the source of its nominal location.
+ * @return double Path length from the robot to the source plus the straight line to the goal, in meters, 0 without
+ * a pose of the robot.
+ */
+double final_project::Mission::Impl::goal_length(const tf2_ros::Buffer& buffer, const std::string& base_frame,
+                                                 const move_base_msgs::MoveBaseGoal& goal)
+{
+  const std::array<double, 2> to{{goal.target_pose.pose.position.x, goal.target_pose.pose.position.y}};
+  std::array<double, 2> from;
+  try {
+    const geometry_msgs::TransformStamped map_to_base = buffer.lookupTransform("map", base_frame, ros::Time(0));
+    from = {{map_to_base.transform.translation.x, map_to_base.transform.translation.y}};
+  } catch (tf2::TransformException &ex) {
+    // Without a pose the deadline is the shortest one.
+    ROS_WARN_STREAM_THROTTLE(1.0, "No ETA of the goal, " << ex.what());
+    return 0;
+  }
+  const std::size_t source = distance_fields.nearest_source(to[0], to[1]);
+  if (source < distance_fields.source_count()) {
+    const std::array<double, 2>& point = distance_fields.source(source);
+    const double length = distance_fields.distance(source, from[0], from[1]) +
+                          std::hypot(to[0] - point[0], to[1] - point[1]);
+    if (std::isfinite(length)) {
+      return length;
+    }
+  }
+  return std::hypot(to[0] - from[0], to[1] - from[1]);
+}
+
+/**
+ * @brief Method to get the time a goal is given up at, from the ETA of the robot, and record the goal for the
+ * telemetry. Called with the mutex of the mission held.
+ * 
+ * @param policy Retry policy of the robot, given the current tuning.
+ * @param robot Index of the robot in 'mission_state'.
+ * @param target Index of the goal, as in the logs.
+ * @param goal Goal about to be sent.
+ * @param length Travel length of the robot to the goal, from goal_length().
+ * @return ros::Time Deadline of the goal, zero if the goals have no deadline.
+ */
+ros::Time final_project::Mission::Impl::goal_deadline(final_project::GoalRetryPolicy& policy, int robot, int target,
+                                                      const move_base_msgs::MoveBaseGoal& goal, double length)
+{
+  policy.set_params(tuning.get().retry);
+  robot_progress &progress = mission_progress[robot];
+  progress.target = target;
+  progress.goal_x = goal.target_pose.pose.position.x;
+  progress.goal_y = goal.target_pose.pose.position.y;
+  progress.eta = policy.params().speed > 0 ? length / policy.params().speed : -1.0;
+  progress.sent = ros::Time::now();
+  snapshot_robots();
+  const double seconds = policy.deadline(length);
+  return seconds > 0 ? progress.sent + ros::Duration(seconds) : ros::Time();
+}
+
+/**
+ * @brief Method to move a goal that is sent again around its nominal location.
+ * 
+ * @param policy Retry policy of the robot.
+ * @param id Name of the goal in the policy.
+ * @param goal Goal at its nominal location, moved for its current retry.
+ */
+void perturb_goal(const final_project::GoalRetryPolicy& policy, int id, move_base_msgs::MoveBaseGoal& goal)
+{
+  const std::array<double, 2> moved = policy.perturb(id, {{goal.target_pose.pose.position.x,
+                                                           goal.target_pose.pose.position.y}});
+  goal.target_pose.pose.position.x = moved[0];
+  goal.target_pose.pose.position.y = moved[1];
+}
+
+/**
+ * @brief Method to record a failed goal in the retry policy of its robot and log what becomes of it.
+ * 
+ * @param policy Retry policy of the robot, given the current tuning.
+ * @param robot Name of the robot, for the log.
+ * @param id Name of the goal in the policy.
+ * @param deferrable The goal may go to the end of the route.
+ * @param why How the goal failed, for the log.
+ * @return final_project::GoalRetryPolicy::Decision What becomes of the goal.
+ */
+final_project::GoalRetryPolicy::Decision final_project::Mission::Impl::goal_failed(
+    final_project::GoalRetryPolicy& policy, const std::string& robot, int id, bool deferrable, const std::string& why)
+{
+  policy.set_params(tuning.get().retry);
+  const final_project::GoalRetryPolicy::Decision decision = policy.failed(id, deferrable);
+  goal_failures++;
+  if (decision == final_project::GoalRetryPolicy::Decision::GiveUp) {
+    goals_given_up++;
+    ROS_ERROR_STREAM(robot << " goal # " << id << " " << why << ", " << final_project::to_string(decision));
+  } else {
+    ROS_WARN_STREAM(robot << " goal # " << id << " " << why << ", " << final_project::to_string(decision)
+                    << (decision == final_project::GoalRetryPolicy::Decision::Retry ?
+                        " (" + std::to_string(policy.retries(id)) + " of " +
+                        std::to_string(policy.params().max_retries) + ")" : ""));
+  }
+  return decision;
+}
+
+/**
+ * @brief Method to publish the stage histograms as one diagnostic status per stage.
+ * 
+ * @param pub Publisher of diagnostic_msgs/DiagnosticArray.
+ */
+void final_project::Mission::Impl::publish_metrics(const ros::Publisher& pub)
+{
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+  for (std::size_t i = 0; i < final_project::MissionMetrics::kStages; i++) {
+    std::string name;
+    const final_project::HistogramSnapshot snapshot = mission_metrics.stage(i, name).snapshot();
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = ros::this_node::getName() + ": " + name;
+    status.hardware_id = ros::this_node::getName();
+    // Every failed TF lookup is an image whose markers were not localized.
+    const bool failing = name == "tf_failure" && snapshot.count > 0;
+    status.level = failing ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = std::to_string(snapshot.count) + " samples";
+    const std::pair<const char*, double> values[] = {
+        {"mean", snapshot.mean()}, {"p50", snapshot.quantile(0.5)}, {"p90", snapshot.quantile(0.9)},
+        {"p99", snapshot.quantile(0.99)}, {"max", snapshot.max}, {"total", snapshot.sum}};
+    diagnostic_msgs::KeyValue count;
+    count.key = "count";
+    count.value = std::to_string(snapshot.count);
+    status.values.push_back(count);
+    for (const auto& value : values) {
+      diagnostic_msgs::KeyValue entry;
+      entry.key = std::string(value.first) + " [s]";
+      entry.value = std::to_string(value.second);
+      status.values.push_back(entry);
+    }
+    msg.status.push_back(status);
+  }
+  pub.publish(msg);
+}
+
+/**
+ * @brief Method to switch the detector of an explorer on or off. Never blocks.
+ * 
+ * @param robot Index of the explorer, as in the detections.
+ * @param enabled The detector processes images.
+ */
+void final_project::Mission::Impl::gate_detector(int robot, bool enabled)
+{
+  if (robot >= 0 && robot < static_cast<int>(detector_gates.size())) {
+    detector_gates[robot]->set_enabled(enabled);
+  }
+}
+
+/**
+ * @brief Method to move a robot of the mission to its next state. Called with the mutex of the mission held.
+ * 
+ * @param robot Index of the robot in 'mission_state'.
+ * @param event Event to apply.
+ * @return true if the robot accepted the event.
+ * @return false if its state does not, it is left as is.
+ */
+bool final_project::Mission::Impl::robot_event(int robot, final_project::RobotEvent event)
+{
+  const final_project::RobotState from = mission_state.state(robot);
+  if (!mission_state.dispatch(robot, event, ros::Time::now().toSec())) {
+    ROS_DEBUG_STREAM("Robot " << robot << " ignores " << final_project::to_string(event) << " while "
+                     << final_project::to_string(from));
+    return false;
+  }
+  ROS_DEBUG_STREAM("Robot " << robot << " " << final_project::to_string(from) << " -> "
+                   << final_project::to_string(mission_state.state(robot)) << " on "
+                   << final_project::to_string(event));
+  snapshot_robots();
+  return true;
+}
+
+/**
+ * @brief Method for localizing every marker of one detection in the map and fusing each with the previous
+ * observations of the same marker, without sleeping on failure.
+ * 
+ * @param localizer Composes the map->camera transform with the detection, looked up once for all its markers
+ * @param detection Detection to localize, the camera pose is looked up at its stamp
+ * @param timeout Maximum time to wait for the camera pose to become available
+ * @param stable Receives the fiducial_ids of the markers this detection made stable, in image order
+ * @param registry_mutex Guards 'target_registry' while the goal senders read it, null if the caller is its only user
+ * @return std::size_t Number of fiducial_ids written to 'stable'.
+ */
+std::size_t final_project::Mission::Impl::listen_at(const final_project::MarkerLocalizer &localizer,
+                                                    const marker_detection &detection, const ros::Duration &timeout,
+                                                    stable_markers& stable, std::mutex* registry_mutex)
+{
+  geometry_msgs::Transform map_to_camera;
+  const ros::WallTime lookup_start = ros::WallTime::now();
+  const bool found = localizer.lookup_camera(detection.stamp, timeout, map_to_camera);
+  const ros::WallTime lookup_end = ros::WallTime::now();
+  (found ? mission_metrics.tf_lookup : mission_metrics.tf_failure).record((lookup_end - lookup_start).toSec());
+  if (!found) {
+    return 0;
+  }
+  mission_metrics.localization_latency.record((lookup_end - detection.queued).toSec());
+  // tf2 copies the frame ids into the result of the lookup, the allocations are counted from here.
+  const std::uint64_t allocations = final_project::thread_allocations();
+  // The tuning of the fusion changes here only, in the thread that fuses.
+  std::uint64_t version = 0;
+  const mission_tuning &current = tuning.get(version);
+  if (version != marker_fusion_tuning) {
+    marker_fusion.set_params(current.fusion);
+    marker_fusion_tuning = version;
+  }
+  // All the markers of the image are localized in one pass against the camera pose.
+  final_project::MarkerBatch<max_markers_per_image> batch;
+  std::array<std::size_t, max_markers_per_image> observation;
+  for (std::size_t i = 0; i < detection.count; i++) {
+    const marker_observation &marker = detection.markers[i];
+    // Frames already in flight when the detectors were told to skip a marker still carry it.
+    if (ignore_localized_markers && marker_fusion.converged(marker.fiducial_id)) {
+      continue;
+    }
+    observation[batch.push(marker.camera_to_marker)] = i;
+  }
+  final_project::PlanarPose goals[max_markers_per_image];
+  const std::size_t localized = final_project::localize_markers(final_project::to_pose3(map_to_camera), batch,
+                                                                localizer.offset(), goals);
+  std::size_t count = 0;
+  for (std::size_t j = 0; j < localized; j++) {
+    const marker_observation &marker = detection.markers[observation[j]];
+    const final_project::PlanarPose &goal = goals[j];
+    const bool was_converged = marker_fusion.converged(marker.fiducial_id);
+    if (!marker_fusion.add(marker.fiducial_id, goal.x, goal.y, goal.yaw, marker.weight)) {
+      ROS_DEBUG_STREAM("Rejected outlier of marker " << marker.fiducial_id);
+      continue;
+    }
+    final_project::Se2Estimate estimate;
+    marker_fusion.estimate(marker.fiducial_id, estimate);
+    {
+      // The first detection of a marker may grow the registry, the readers copy its locations out under the lock.
+      const std::unique_lock<std::mutex> lock = lock_registry(registry_mutex);
+      target_registry.update_marker(marker.fiducial_id, estimate.x, estimate.y, estimate.yaw);
+    }
+    if (was_converged || !estimate.converged) {
+      continue;
+    }
+    ROS_INFO_STREAM("Position of marker " << marker.fiducial_id << " in map frame: ["
+                    << estimate.x << ","
+                    << estimate.y << "] from " << estimate.samples << " observations");
+    stable[count++] = marker.fiducial_id;
+    if (ignore_localized_markers) {
+      for (const auto &gate : detector_gates) {
+        gate->ignore(marker.fiducial_id);
+      }
+    }
+  }
+  // A detection that made a marker stable goes on to dispatch a follower, which may allocate.
+  if (count == 0) {
+    check_hot_path(allocations, "Localizing a detection");
+  }
+  snapshot_markers(count > 0);
+  return count;
+}
+
+/**
+ * @brief Method to record that a lookup target has its marker.
+ * 
+ * @param target Index of the lookup target.
+ * @param fiducial_id fiducial_id of the marker found at the target.
+ */
+void final_project::Mission::Impl::localize_target(int target, int fiducial_id)
+{
+  target_registry.set_target_fiducial(target, fiducial_id);
+  if (target >= 0 && target < static_cast<int>(target_done_after.size()) && target_done_after[target] < 0) {
+    // Markers taken from the cache are localized before the startup ends.
+    target_done_after[target] = mission_start_time.isZero() ? 0.0 : (ros::Time::now() - mission_start_time).toSec();
+  }
+}
+
+/**
+ * @brief Method to find the closest explorer target without a marker.
+ * 
+ * @param x x-coordinate in map frame.
+ * @param y y-coordinate in map frame.
+ * @param radius Largest distance to the target.
+ * @return int Index of the target, -1 if no target is close enough.
+ */
+int final_project::Mission::Impl::nearest_free_target(double x, double y, double radius)
+{
+  int best = -1;
+  double best_distance = radius;
+  for (int i = 0; i < static_cast<int>(target_registry.target_count()); i++) {
+    if (target_registry.target_done(i)) {
+      continue;
+    }
+    const double distance = std::hypot(target_registry.target(i).x - x, target_registry.target(i).y - y);
+    if (distance <= best_distance) {
+      best = i;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Method to assign a marker localized in transit to the closest explorer target without a marker.
+ * 
+ * @param fiducial_id fiducial_id of the newly stable marker.
+ * @param radius Largest distance between the target and the follower location of the marker.
+ * @return int Index of the assigned target, -1 if no target is close enough.
+ */
+int final_project::Mission::Impl::assign_marker_to_target(int fiducial_id, double radius)
+{
+  const int index = target_registry.find_marker(fiducial_id);
+  if (index < 0) {
+    return -1;
+  }
+  const final_project::MarkerLocation& marker = target_registry.marker(index);
+  const int best = nearest_free_target(marker.x, marker.y, radius);
+  if (best >= 0) {
+    localize_target(best, fiducial_id);
+    ROS_INFO_STREAM("Marker " << fiducial_id << " localized in transit, target " << best << " needs no lookup");
+  }
+  return best;
+}
+
+/**
+ * @brief Method for localizing the marker frame in the map. 
+ * 
+ * @param localizer Composes the map->camera transform with the detection
+ * @param radius Largest distance between a target and another marker that became stable in the same image.
+ * @param status Bool value as a flag to check status
+ */
+void final_project::Mission::Impl::listen(const final_project::MarkerLocalizer &localizer, double radius, bool& status)
+{
+  // Every queued detection is fused, the job is done once a new marker is stable.
+  marker_detection detection;
+  stable_markers stable;
+  while (detection_queue.try_pop(detection)) {
+    const std::size_t count = listen_at(localizer, detection, ros::Duration(0), stable, nullptr);
+    for (std::size_t i = 0; i < count; i++) {
+      // The first new marker belongs to the current target, the others may save later lookups.
+      if (!status) {
+        localize_target(psi.current_explorer_target, stable[i]);
+        status = true;
+      } else {
+        assign_marker_to_target(stable[i], radius);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Method for fusing the detections made while the explorer drives to its current target.
+ * 
+ * @param localizer Composes the map->camera transform with the detection
+ * @param radius Largest distance between a target and a marker localized in transit.
+ * @return true if the marker of the current target is already localized, so the lookup can be skipped.
+ * @return false otherwise.
+ */
+bool final_project::Mission::Impl::scan_in_transit(const final_project::MarkerLocalizer &localizer, double radius)
+{
+  marker_detection detection;
+  stable_markers stable;
+  while (detection_queue.try_pop(detection)) {
+    const std::size_t count = listen_at(localizer, detection, ros::Duration(0), stable, nullptr);
+    for (std::size_t i = 0; i < count; i++) {
+      assign_marker_to_target(stable[i], radius);
+    }
+  }
+  return target_registry.target_done(psi.current_explorer_target);
+}
+
+/*                                      EVENT-DRIVEN MISSION                                     */
+
+/**
+ * @brief Method to send the follower to the next queued marker in pipelined mode, or home once exploring is over.
+ * 
+ * @param ctx Context of the event-driven mission.
+ */
+void final_project::Mission::Impl::dispatch_pipelined_follower(event_mission_context &ctx)
+{
+  int location = -1;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    if (!mission_state.in(follower_id, final_project::RobotState::Idle)) {
+      return;
+    }
+    if (!ctx.follower_queue.empty()) {
+      location = ctx.follower_queue.front();
+      ctx.follower_queue.pop_front();
+      robot_event(follower_id, final_project::RobotEvent::GoalSent);
+    } else if (mission_state.in(explorer_id, final_project::RobotState::Home)) {
+      location = follower_home_location;
+      robot_event(follower_id, final_project::RobotEvent::SentHome);
+    } else {
+      return;
+    }
+  }
+  send_follower_goal_to(ctx, location);
+}
+
+/**
+ * @brief Method to check if the follower may leave its current goal for the next one, from its move_base feedback.
+ * 
+ * @param ctx Context of the event-driven mission.
+ * @param x Position of the follower in the map frame.
+ * @param y Position of the follower in the map frame.
+ * @return true if the follower is within the lookahead radius and its next goal is known, the lookahead is then
+ * disarmed until the next goal is sent.
+ * @return false otherwise.
+ */
+bool final_project::Mission::Impl::follower_passed(event_mission_context &ctx, double x, double y)
+{
+  std::lock_guard<std::mutex> lock(ctx.mutex);
+  if (!ctx.follower_lookahead.passed(x, y)) {
+    return false;
+  }
+  // In pipelined mode the next marker may not be localized yet, the follower then stops at the current one.
+  if (ctx.pipelined && ctx.follower_queue.empty() &&
+      !mission_state.in(explorer_id, final_project::RobotState::Home)) {
+    return false;
+  }
+  ctx.follower_lookahead.disarm();
+  ROS_INFO_STREAM("Follower passes goal # " << psi.current_follower_target << ", sending the next one");
+  return true;
+}
+
+/**
+ * @brief Method to send the failed goal of the follower again, defer it or give it up.
+ * 
+ * @param ctx Context of the event-driven mission.
+ * @param goal Number of the failed goal in 'ctx.follower_goals', nothing is done if a later goal replaced it.
+ * @param why How the goal failed, for the log.
+ */
+void final_project::Mission::Impl::follower_goal_failed(event_mission_context &ctx, unsigned goal,
+                                                        const std::string &why)
+{
+  int location = follower_home_location;
+  bool heading_home = false;
+  final_project::GoalRetryPolicy::Decision decision;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    if (goal != ctx.follower_goals || !mission_running() ||
+        (!mission_state.in(follower_id, final_project::RobotState::Driving) &&
+         !mission_state.in(follower_id, final_project::RobotState::HeadingHome))) {
+      return;
+    }
+    location = psi.current_follower_target;
+    heading_home = location == follower_home_location;
+    ctx.follower_deadline = ros::Time();
+    ctx.follower_lookahead.disarm();
+    decision = goal_failed(ctx.follower_retry, follower_robot.name, location, !heading_home, why);
+    if (heading_home && decision == final_project::GoalRetryPolicy::Decision::GiveUp) {
+      // Counted home, the mission ends without completing.
+      robot_event(follower_id, final_project::RobotEvent::GoalReached);
+    } else {
+      robot_event(follower_id, final_project::RobotEvent::GoalFailed);
+    }
+    if (decision == final_project::GoalRetryPolicy::Decision::Retry) {
+      robot_event(follower_id, heading_home ? final_project::RobotEvent::SentHome :
+                                              final_project::RobotEvent::GoalSent);
+    } else if (decision == final_project::GoalRetryPolicy::Decision::Defer) {
+      if (ctx.pipelined) {
+        ctx.follower_queue.push_back(location);
+      } else {
+        defer_follower_location();
+      }
+    }
+  }
+  switch (decision) {
+    case final_project::GoalRetryPolicy::Decision::Retry:
+      send_follower_goal_to(ctx, location);
+      return;
+    case final_project::GoalRetryPolicy::Decision::Defer:
+      break;
+    case final_project::GoalRetryPolicy::Decision::GiveUp:
+      if (heading_home) {
+        ROS_ERROR_STREAM("The follower never got home");
+        finish_mission(false);
+        return;
+      }
+      break;
+  }
+  if (ctx.pipelined) {
+    dispatch_pipelined_follower(ctx);
+    return;
+  }
+  send_follower_goal(ctx);
+}
+
+/**
+ * @brief Done callback of the follower goals, sends the next follower goal as soon as one succeeds.
+ * 
+ * @param ctx Context of the event-driven mission.
+ * @param goal Number of the goal in 'ctx.follower_goals', the callbacks of a replaced goal are ignored.
+ * @param state Final state of the goal.
+ */
+void final_project::Mission::Impl::follower_done_callback(event_mission_context &ctx, unsigned goal,
+                                                          const actionlib::SimpleClientGoalState &state)
+{
+  if (state != actionlib::SimpleClientGoalState::SUCCEEDED) {
+    follower_goal_failed(ctx, goal, "finished as " + state.toString());
+    return;
+  }
+  bool home = false;
+  int location = follower_home_location;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    if (goal != ctx.follower_goals || !robot_event(follower_id, final_project::RobotEvent::GoalReached)) {
+      return;
+    }
+    ctx.follower_deadline = ros::Time();
+    location = psi.current_follower_target;
+    ctx.follower_retry.succeeded(location);
+    home = mission_state.in(follower_id, final_project::RobotState::Home);
+  }
+  ROS_INFO_STREAM("Follower reached goal # " << location);
+  // Check if all targets locations are reached by follower.
+  if (home) {
+    ROS_INFO_STREAM("PROJECT FINISHED!!!");
+    finish_mission();
+    return;
+  }
+  if (ctx.pipelined) {
+    dispatch_pipelined_follower(ctx);
+    return;
+  }
+  send_follower_goal(ctx);
+}
+
+/**
+ * @brief Method to send the failed goal of the explorer again, defer it or give it up.
+ * 
+ * A target given up is left to a later detection in transit. The explorer is counted home if it cannot get there,
+ * so that the follower still starts.
+ * 
+ * @param ctx Context of the event-driven mission.
+ * @param goal Number of the failed goal in 'ctx.explorer_goals', nothing is done if a later goal replaced it.
+ * @param why How the goal failed, for the log.
+ */
+void final_project::Mission::Impl::explorer_goal_failed(event_mission_context &ctx, unsigned goal,
+                                                        const std::string &why)
+{
+  int target = -1;
+  bool heading_home = false;
+  final_project::GoalRetryPolicy::Decision decision;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    if (goal != ctx.explorer_goals || !mission_running() ||
+        (!mission_state.in(explorer_id, final_project::RobotState::Driving) &&
+         !mission_state.in(explorer_id, final_project::RobotState::HeadingHome))) {
+      return;
+    }
+    target = psi.current_explorer_target;
+    heading_home = target >= explorer_home_target();
+    ctx.explorer_deadline = ros::Time();
+    decision = goal_failed(ctx.explorer_retry, explorer_robot.name, target, !heading_home, why);
+    if (!heading_home || decision != final_project::GoalRetryPolicy::Decision::GiveUp) {
+      robot_event(explorer_id, final_project::RobotEvent::GoalFailed);
+    }
+    if (decision == final_project::GoalRetryPolicy::Decision::Defer) {
+      defer_explorer_target();
+    }
+  }
+  switch (decision) {
+    case final_project::GoalRetryPolicy::Decision::Retry: {
+      move_base_msgs::MoveBaseGoal explorer_goal;
+      set_explorer_goal(explorer_goal, target);
+      send_current_explorer_goal(ctx, explorer_goal);
+      return;
+    }
+    case final_project::GoalRetryPolicy::Decision::Defer:
+      break;
+    case final_project::GoalRetryPolicy::Decision::GiveUp:
+      if (heading_home) {
+        {
+          std::lock_guard<std::mutex> lock(ctx.mutex);
+          robot_event(explorer_id, final_project::RobotEvent::GoalReached);
+        }
+        explorer_arrived(ctx);
+        return;
+      }
+      break;
+  }
+  send_explorer_goal(ctx);
+}
+
+/**
+ * @brief Done callback of the explorer goals, starts looking for the marker or hands over to the follower.
+ * 
+ * @param ctx Context of the event-driven mission.
+ * @param goal Number of the goal in 'ctx.explorer_goals', the callbacks of a replaced goal are ignored.
+ * @param state Final state of the goal.
+ */
+void final_project::Mission::Impl::explorer_done_callback(event_mission_context &ctx, unsigned goal,
+                                                          const actionlib::SimpleClientGoalState &state)
+{
+  if (state != actionlib::SimpleClientGoalState::SUCCEEDED) {
+    explorer_goal_failed(ctx, goal, "finished as " + state.toString());
+    return;
+  }
+  int target = -1;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    if (goal != ctx.explorer_goals || !robot_event(explorer_id, final_project::RobotEvent::GoalReached)) {
+      return;
+    }
+    ctx.explorer_deadline = ros::Time();
+    target = psi.current_explorer_target;
+    ctx.explorer_retry.succeeded(target);
+  }
+  ROS_INFO_STREAM("Hooray, explorer reached goal " << target);
+  explorer_arrived(ctx);
+}
+
+void final_project::Mission::Impl::explorer_arrived(event_mission_context &ctx)
+{
+  bool home = false;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    home = mission_state.in(explorer_id, final_project::RobotState::Home);
+  }
+  // Check if all targets locations are reached by explorer 
+  if (home) {
+    {
+      // Detections already queued may still add markers.
+      std::lock_guard<std::mutex> lock(ctx.mutex);
+      explorer_summary();
+    }
+    save_marker_cache();
+    gate_detector(0, false);
+
+    // Publish a message to stop explorer
+    geometry_msgs::Twist msg;
+    msg.linear.x = 0;
+    msg.angular.z = 0.0;
+    ctx.explorer_pub.publish(msg);
+
+    ROS_INFO_STREAM("EXPLORER JOB DONE!");
+    if (!ctx.pipelined) {
+      std::lock_guard<std::mutex> lock(ctx.mutex);
+      plan_follower_route(ctx.follower_planner, ctx.optimize_routes);
+    }
+    if (ctx.pipelined) {
+      dispatch_pipelined_follower(ctx);
+      return;
+    }
+    send_follower_goal(ctx);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(ctx.mutex);
+  if (!mission_state.in(explorer_id, final_project::RobotState::Looking)) {
+    return;
+  }
+  start_rotation_search(ctx.rotation_search, *ctx.tf_buffer, ctx.map,
+                        explorer_waypoint(psi.current_explorer_target), explorer_robot.base_frame);
+  ctx.looking_since = ros::Time::now();
+  ctx.rotate_timer.start();
+  gate_detector(0, true);
+}
+
+void final_project::Mission::Impl::send_explorer_goal(event_mission_context &ctx)
+{
+  move_base_msgs::MoveBaseGoal explorer_goal;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    next_explorer_goal(explorer_goal);
+  }
+  send_current_explorer_goal(ctx, explorer_goal);
+}
+
+void final_project::Mission::Impl::send_current_explorer_goal(event_mission_context &ctx,
+                                                              move_base_msgs::MoveBaseGoal &explorer_goal)
+{
+  const double length = goal_length(*ctx.tf_buffer, explorer_robot.base_frame, explorer_goal);
+  int target = -1;
+  unsigned goal = 0;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    target = psi.current_explorer_target;
+    perturb_goal(ctx.explorer_retry, target, explorer_goal);
+    robot_event(explorer_id, target >= explorer_home_target() ?
+                final_project::RobotEvent::SentHome : final_project::RobotEvent::GoalSent);
+    ctx.explorer_deadline = goal_deadline(ctx.explorer_retry, explorer_id, target, explorer_goal, length);
+    goal = ++ctx.explorer_goals;
+  }
+  ROS_INFO_STREAM("Sending goal # " << target << " for explorer");
+  const ros::Time sent = ros::Time::now();
+  ctx.explorer_client->sendGoal(explorer_goal,
+      [this, &ctx, sent, goal](const actionlib::SimpleClientGoalState &state,
+                         const move_base_msgs::MoveBaseResultConstPtr &) {
+        record_goal(mission_metrics.explorer_goal, sent, state);
+        explorer_done_callback(ctx, goal, state);
+      },
+      [target]() { ROS_DEBUG_STREAM("Explorer goal # " << target << " is active"); },
+      [](const move_base_msgs::MoveBaseFeedbackConstPtr &feedback) {
+        ROS_DEBUG_STREAM_THROTTLE(1.0, "Explorer at x: " << feedback->base_position.pose.position.x
+                                       << "\ty: " << feedback->base_position.pose.position.y);
+      });
+}
+
+void final_project::Mission::Impl::send_follower_goal(event_mission_context &ctx)
+{
+  int location = follower_home_location;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    location = next_follower_location();
+    robot_event(follower_id, location == follower_home_location ? final_project::RobotEvent::SentHome :
+                                                                  final_project::RobotEvent::GoalSent);
+  }
+  send_follower_goal_to(ctx, location);
+}
+
+void final_project::Mission::Impl::send_follower_goal_to(event_mission_context &ctx, int location)
+{
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    psi.current_follower_target = location;
+  }
+  move_base_msgs::MoveBaseGoal follower_goal;
+  set_follower_goal_at(follower_goal, location, ctx.follower_refiner, &ctx.mutex);
+  const double length = goal_length(*ctx.tf_buffer, follower_robot.base_frame, follower_goal);
+  unsigned goal = 0;
+  {
+    // The follower stops at home, the end of its route.
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    perturb_goal(ctx.follower_retry, location, follower_goal);
+    ctx.follower_lookahead.set_radius(tuning.get().lookahead_radius);
+    ctx.follower_lookahead.arm(follower_goal.target_pose.pose.position.x, follower_goal.target_pose.pose.position.y,
+                               location == follower_home_location);
+    ctx.follower_deadline = goal_deadline(ctx.follower_retry, follower_id, location, follower_goal, length);
+    goal = ++ctx.follower_goals;
+  }
+  ROS_INFO_STREAM("Sending goal # " << location << " to follower");
+  ROS_INFO_STREAM("goal => x: " << follower_goal.target_pose.pose.position.x << 
+                  "\ty: "     << follower_goal.target_pose.pose.position.y );
+  const ros::Time sent = ros::Time::now();
+  ctx.follower_client->sendGoal(follower_goal,
+      [this, &ctx, sent, goal](const actionlib::SimpleClientGoalState &state,
+                         const move_base_msgs::MoveBaseResultConstPtr &) {
+        record_goal(mission_metrics.follower_goal, sent, state);
+        follower_done_callback(ctx, goal, state);
+      },
+      [location]() { ROS_DEBUG_STREAM("Follower goal # " << location << " is active"); },
+      [this, &ctx, sent, goal](const move_base_msgs::MoveBaseFeedbackConstPtr &feedback) {
+        ROS_DEBUG_STREAM_THROTTLE(1.0, "Follower at x: " << feedback->base_position.pose.position.x
+                                       << "\ty: " << feedback->base_position.pose.position.y);
+        if (follower_passed(ctx, feedback->base_position.pose.position.x, feedback->base_position.pose.position.y)) {
+          // Handled as if move_base had reached it, the next goal preempts it.
+          record_goal(mission_metrics.follower_goal, sent, actionlib::SimpleClientGoalState::SUCCEEDED);
+          follower_done_callback(ctx, goal, actionlib::SimpleClientGoalState::SUCCEEDED);
+        }
+      });
+}
+
+/**
+ * @brief Method to localize one queued detection in event-driven mode and move the mission on once it succeeds.
+ * 
+ * @param ctx Context of the event-driven mission.
+ * @param detection Detection taken from the queue.
+ */
+void final_project::Mission::Impl::handle_detection(event_mission_context &ctx, const marker_detection &detection)
+{
+  bool looking = false;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    looking = mission_state.in(explorer_id, final_project::RobotState::Looking) &&
+              detection.stamp >= ctx.looking_since;
+    if (!looking && !ctx.scan_while_driving) {
+      return;
+    }
+  }
+  stable_markers stable;
+  // The fiducial filter only hands on the detections whose camera pose is in the buffer.
+  const std::size_t count = listen_at(*ctx.localizer, detection, ros::Duration(0), stable, &ctx.mutex);
+  if (count == 0) {
+    return;
+  }
+  bool next_goal = false;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    for (std::size_t i = 0; i < count; i++) {
+      if (looking && robot_event(explorer_id, final_project::RobotEvent::MarkerLocalized)) {
+        localize_target(psi.current_explorer_target, stable[i]);
+        ctx.rotate_timer.stop();
+        mission_metrics.rotation.record((ros::Time::now() - ctx.looking_since).toSec());
+        gate_detector(0, ctx.scan_while_driving);
+        next_goal = true;
+      } else if (mission_state.in(explorer_id, final_project::RobotState::Driving) ||
+                 mission_state.in(explorer_id, final_project::RobotState::Looking)) {
+        // The marker was seen on the way, or next to the one of the current target: move on if it belongs to
+        // the target the explorer is heading to or rotating at.
+        const int target = assign_marker_to_target(stable[i], tuning.get().association_radius);
+        if (target == psi.current_explorer_target) {
+          const bool was_looking = mission_state.in(explorer_id, final_project::RobotState::Looking);
+          robot_event(explorer_id, final_project::RobotEvent::MarkerLocalized);
+          if (was_looking) {
+            ctx.rotate_timer.stop();
+            mission_metrics.rotation.record((ros::Time::now() - ctx.looking_since).toSec());
+            gate_detector(0, ctx.scan_while_driving);
+          }
+          next_goal = true;
+        }
+      }
+      if (ctx.pipelined) {
+        ctx.follower_queue.push_back(target_registry.find_marker(stable[i]));
+      }
+    }
+  }
+  if (next_goal) {
+    send_explorer_goal(ctx);
+  }
+  if (ctx.pipelined) {
+    dispatch_pipelined_follower(ctx);
+  }
+}
+
+/**
+ * @brief Localization stage of the event-driven mission, drains the detection queue on its own thread
+ * so the fiducial callback never waits on a TF lookup.
+ * 
+ * @param ctx Context of the event-driven mission.
+ */
+void final_project::Mission::Impl::localizer_loop(event_mission_context &ctx)
+{
+  marker_detection detection;
+  while (mission_running()) {
+    if (!detection_queue.try_pop(detection)) {
+      // The timeout covers a notification sent between the empty check and the wait.
+      std::unique_lock<std::mutex> lock(ctx.detection_mutex);
+      ctx.detection_ready.wait_for(lock, std::chrono::milliseconds(50));
+      continue;
+    }
+    handle_detection(ctx, detection);
+  }
+}
+
+/**
+ * @brief Method to fail the goals that are past their deadline, move_base may keep trying them forever.
+ * 
+ * @param ctx Context of the event-driven mission.
+ */
+void final_project::Mission::Impl::check_event_deadlines(event_mission_context &ctx)
+{
+  const ros::Time now = ros::Time::now();
+  unsigned explorer_goal = 0;
+  unsigned follower_goal = 0;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    if (!ctx.explorer_deadline.isZero() && now > ctx.explorer_deadline) {
+      explorer_goal = ctx.explorer_goals;
+    }
+    if (!ctx.follower_deadline.isZero() && now > ctx.follower_deadline) {
+      follower_goal = ctx.follower_goals;
+    }
+  }
+  // The goals sent again replace the cancelled ones, whose callbacks are then ignored.
+  if (explorer_goal != 0) {
+    ctx.explorer_client->cancelGoal();
+    explorer_goal_failed(ctx, explorer_goal, "missed its deadline");
+  }
+  if (follower_goal != 0) {
+    ctx.follower_client->cancelGoal();
+    follower_goal_failed(ctx, follower_goal, "missed its deadline");
+  }
+}
+
+/**
+ * @brief Method to run the whole mission from action client callbacks, with no polling loop.
+ * 
+ * @param nh Nodehandle for a ROS node
+ * @param ctx Context of the event-driven mission, with clients, targets and buffer already set.
+ */
+void final_project::Mission::Impl::run_event_mission(ros::NodeHandle &nh, event_mission_context &ctx)
+{
+  ctx.rotate_timer = nh.createTimer(ros::Duration(0.1), [this, &ctx](const ros::TimerEvent &) {
+    // Publish a message to rotate explorer
+    geometry_msgs::Twist msg;
+    msg.linear.x = 0;
+    {
+      // Timer::stop() waits for a running callback, so never block on a mutex its caller may hold.
+      std::unique_lock<std::mutex> lock(ctx.mutex, std::try_to_lock);
+      if (!lock.owns_lock()) {
+        return;
+      }
+      msg.angular.z = ctx.rotation_search.angular_velocity(ros::Time::now().toSec(),
+                                                           last_detection_time.load(std::memory_order_relaxed));
+    }
+    ctx.explorer_pub.publish(msg);
+  }, false, false);
+  // A single spinner thread keeps fiducial_callback() the only producer of the detection queue.
+  fiducial_input fiducials;
+  subscribe_fiducials(nh, *ctx.tf_buffer, explorer_robot, last_detection_time,
+      [this, &ctx](const fiducial_msgs::FiducialTransformArray::ConstPtr &msg) {
+        fiducial_callback(msg);
+        ctx.detection_ready.notify_one();
+      }, fiducials);
+  ros::Timer deadlines = nh.createTimer(ros::Duration(1.0), [this, &ctx](const ros::TimerEvent &) {
+    check_event_deadlines(ctx);
+  });
+
+  // Under a nodelet manager the callbacks of the nodelet are already served one at a time.
+  std::unique_ptr<ros::AsyncSpinner> spinner;
+  if (mission_host.spin) {
+    spinner.reset(new ros::AsyncSpinner(1));
+    spinner->start();
+  }
+  std::thread localizer(&final_project::Mission::Impl::localizer_loop, this, std::ref(ctx));
+  gate_detector(0, ctx.scan_while_driving);
+  if (ctx.pipelined) {
+    // The follower starts with the markers of the cache while the explorer looks for the others.
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    for (const final_project::CachedMarker& marker : cached_markers) {
+      ctx.follower_queue.push_back(target_registry.find_marker(marker.fiducial_id));
+    }
+  }
+  send_explorer_goal(ctx);
+  if (ctx.pipelined) {
+    dispatch_pipelined_follower(ctx);
+  }
+  wait_for_mission_end();
+  ctx.detection_ready.notify_one();
+  localizer.join();
+}
+
+
+/*                                      FLEET MISSION                                     */
+
+/**
+ * @brief Struct holding the handles and progress of one robot of the fleet.
+ * 
+ */
+struct fleet_robot {
+  // Member 'spec' contains the names and home of the robot.
+  final_project::RobotSpec spec;
+  // Member 'client' is the move_base action client of the robot.
+  std::unique_ptr<MoveBaseClient> client;
+  // Member 'cmd_vel' publishes velocity commands to rotate an explorer.
+  ros::Publisher cmd_vel;
+  // Member 'fiducials' receives the markers detected by the camera of an explorer.
+  fiducial_input fiducials;
+  // Member 'localizer' localizes the markers detected by the camera of an explorer.
+  std::unique_ptr<final_project::MarkerLocalizer> localizer;
+  // Member 'rotation_search' chooses how an explorer turns while it looks for a marker.
+  final_project::RotationSearch rotation_search;
+  // Member 'rotate_timer' keeps an explorer rotating while it looks for a marker.
+  ros::Timer rotate_timer;
+  // Member 'last_detection_time' contains the time of the last marker detection of an explorer, in seconds.
+  std::atomic<double> last_detection_time{0};
+  // Member 'id' contains the index of the robot in 'mission_state'.
+  int id = -1;
+  // Member 'task' contains the task the robot drives to or looks from, -1 when it has none.
+  int task = -1;
+  // Member 'looking_since' contains the time an explorer started looking, older detections are ignored.
+  ros::Time looking_since;
+  // Member 'lookahead' sends a follower its next goal as it passes the current one.
+  final_project::GoalLookahead lookahead;
+  // Member 'costmap' holds the global costmap of a follower, its marker goals are refined in.
+  costmap_input costmap;
+  // Member 'retry' decides what becomes of the goals move_base fails, by task, -1 for home.
+  final_project::GoalRetryPolicy retry;
+  // Member 'goals' counts the goals sent, the callbacks of a replaced goal are ignored.
+  unsigned goals = 0;
+  // Member 'deadline' contains the time the current goal is given up at, zero when there is none.
+  ros::Time deadline;
+};
+
+/**
+ * @brief Struct holding the robots and task queues of a mission run by a whole fleet.
+ * 
+ */
+struct fleet_mission_context {
+  // Member 'explorers' holds the explorers, a deque so that the robots never move.
+  std::deque<fleet_robot> explorers;
+  // Member 'followers' holds the followers.
+  std::deque<fleet_robot> followers;
+  // Member 'explorer_tasks' hands the lookup targets to the explorers, task i is target i.
+  final_project::FleetCoordinator explorer_tasks;
+  // Member 'follower_tasks' hands the localized markers to the followers.
+  final_project::FleetCoordinator follower_tasks;
+  // Member 'follower_task_markers' contains the marker of each follower task, by index in the registry.
+  std::vector<int> follower_task_markers;
+  // Member 'tf_buffer' points to the buffer holding the pose of the explorers.
+  tf2_ros::Buffer* tf_buffer = nullptr;
+  // Member 'map' contains the static map, used to guess where the marker is. May be null.
+  nav_msgs::OccupancyGrid::ConstPtr map;
+  // Member 'detection_ready' wakes the localization stage when a detection is queued.
+  std::condition_variable detection_ready;
+  // Member 'detection_mutex' is only used to wait on 'detection_ready', the producer never takes it.
+  std::mutex detection_mutex;
+  // Member 'mutex' guards 'mission_state', the robots' progress and the task queues.
+  std::mutex mutex;
+  // Member 'scan_while_driving' fuses the detections made in transit and skips targets already localized.
+  bool scan_while_driving = false;
+  // Member 'startup_timeout' is the deadline for the robots to come up, in seconds, see wait_for_startup().
+  double startup_timeout = 60.0;
+  // Member 'lookahead_radius' is the distance to its goal a follower is sent the next one at when it starts.
+  double lookahead_radius = 0.3;
+  // Member 'explorers_home' counts the explorers back home, exploring is over once all are.
+  std::size_t explorers_home = 0;
+  // Member 'followers_home' counts the followers back home, the mission is over once all are.
+  std::size_t followers_home = 0;
+  // Member 'followers_stranded' counts the followers counted home that never got there.
+  std::size_t followers_stranded = 0;
+  // Member 'start' contains the time the first goals were sent.
+  ros::Time start;
+};
+
+/**
+ * @brief Method to send a robot of the fleet a goal, with the done callback attached.
+ * 
+ * @param robot Robot to send.
+ * @param goal Goal in map frame.
+ * @param done Called with the final state of the goal.
+ * @param passed Called with the position of the robot on every move_base feedback, returns true once the robot
+ * passed the goal, which then counts as reached. May be empty.
+ */
+void final_project::Mission::Impl::send_fleet_goal(fleet_robot &robot, const move_base_msgs::MoveBaseGoal& goal,
+                                                   std::function<void(const actionlib::SimpleClientGoalState&)> done,
+                                                   std::function<bool(double, double)> passed)
+{
+  final_project::LatencyHistogram* histogram = robot.spec.role == final_project::RobotRole::Explorer ?
+      &mission_metrics.explorer_goal : &mission_metrics.follower_goal;
+  const ros::Time sent = ros::Time::now();
+  robot.client->sendGoal(goal,
+      [done, histogram, sent](const actionlib::SimpleClientGoalState &state,
+                              const move_base_msgs::MoveBaseResultConstPtr &) {
+        record_goal(*histogram, sent, state);
+        done(state);
+      },
+      MoveBaseClient::SimpleActiveCallback(),
+      [done, passed, histogram, sent](const move_base_msgs::MoveBaseFeedbackConstPtr &feedback) {
+        if (passed && passed(feedback->base_position.pose.position.x, feedback->base_position.pose.position.y)) {
+          // Handled as if move_base had reached it, the next goal preempts it.
+          record_goal(*histogram, sent, actionlib::SimpleClientGoalState::SUCCEEDED);
+          done(actionlib::SimpleClientGoalState::SUCCEEDED);
+        }
+      });
+}
+
+/**
+ * @brief Method to check if a follower may leave its current goal for the next one, from its move_base feedback.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the follower.
+ * @param x Position of the follower in the map frame.
+ * @param y Position of the follower in the map frame.
+ * @return true if the follower is within the lookahead radius and a next goal is left, the lookahead is then
+ * disarmed until the next goal is sent.
+ * @return false otherwise.
+ */
+bool fleet_follower_passed(fleet_mission_context &ctx, int index, double x, double y)
+{
+  std::lock_guard<std::mutex> lock(ctx.mutex);
+  fleet_robot &robot = ctx.followers[index];
+  if (!robot.lookahead.passed(x, y)) {
+    return false;
+  }
+  // With no marker left to visit yet, the follower stops at the current one.
+  if (ctx.follower_tasks.pending() == 0 && ctx.explorers_home < ctx.explorers.size()) {
+    return false;
+  }
+  robot.lookahead.disarm();
+  ROS_INFO_STREAM(robot.spec.name << " passes its goal, sending the next one");
+  return true;
+}
+
+/**
+ * @brief Method to send an explorer to the location of its task, or home, moved for the current retry of the goal.
+ * Called with 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the explorer.
+ */
+void final_project::Mission::Impl::send_fleet_explorer_goal(fleet_mission_context &ctx, int index)
+{
+  fleet_robot &robot = ctx.explorers[index];
+  std::array<double, 2> location{{robot.spec.home_x, robot.spec.home_y}};
+  if (robot.task >= 0) {
+    location = ctx.explorer_tasks.location(robot.task);
+  }
+  move_base_msgs::MoveBaseGoal goal;
+  set_follower_goal(goal, robot.retry.perturb(robot.task, location));
+  robot.deadline = goal_deadline(robot.retry, robot.id, robot.task, goal,
+                                 goal_length(*ctx.tf_buffer, robot.spec.base_frame, goal));
+  const unsigned sequence = ++robot.goals;
+  send_fleet_goal(robot, goal, [this, &ctx, index, sequence](const actionlib::SimpleClientGoalState &state) {
+    fleet_explorer_done(ctx, index, sequence, state);
+  });
+}
+
+/**
+ * @brief Method to send an explorer to its next lookup target, stealing one if its own are done, or home.
+ * Called with 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the explorer.
+ */
+void final_project::Mission::Impl::dispatch_fleet_explorer(fleet_mission_context &ctx, int index)
+{
+  fleet_robot &robot = ctx.explorers[index];
+  bool stolen = false;
+  robot.task = ctx.explorer_tasks.next(index, &stolen);
+  if (robot.task >= 0) {
+    ROS_INFO_STREAM("Sending goal # " << robot.task << " to " << robot.spec.name << (stolen ? " (stolen)" : ""));
+    robot_event(robot.id, final_project::RobotEvent::GoalSent);
+  } else {
+    ROS_INFO_STREAM("Sending " << robot.spec.name << " home");
+    robot_event(robot.id, final_project::RobotEvent::SentHome);
+  }
+  gate_detector(index, ctx.scan_while_driving && robot.task >= 0);
+  send_fleet_explorer_goal(ctx, index);
+}
+
+/**
+ * @brief Method to send a follower to the marker of its task, or home, moved for the current retry of the goal.
+ * Called with 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the follower.
+ */
+void final_project::Mission::Impl::send_fleet_follower_goal(fleet_mission_context &ctx, int index)
+{
+  fleet_robot &robot = ctx.followers[index];
+  move_base_msgs::MoveBaseGoal goal;
+  if (robot.task >= 0) {
+    // The marker estimate may have improved since the task was queued.
+    set_marker_goal(goal, ctx.follower_task_markers[robot.task], robot.costmap.refiner.get(), nullptr);
+  } else {
+    set_follower_goal(goal, {{robot.spec.home_x, robot.spec.home_y}});
+  }
+  perturb_goal(robot.retry, robot.task, goal);
+  // The follower stops at home, the end of its route.
+  robot.lookahead.set_radius(tuning.get().lookahead_radius);
+  robot.lookahead.arm(goal.target_pose.pose.position.x, goal.target_pose.pose.position.y, robot.task < 0);
+  robot.deadline = goal_deadline(robot.retry, robot.id, robot.task, goal,
+                                 goal_length(*ctx.tf_buffer, robot.spec.base_frame, goal));
+  const unsigned sequence = ++robot.goals;
+  send_fleet_goal(robot, goal,
+      [this, &ctx, index, sequence](const actionlib::SimpleClientGoalState &state) {
+        fleet_follower_done(ctx, index, sequence, state);
+      },
+      [&ctx, index](double x, double y) { return fleet_follower_passed(ctx, index, x, y); });
+}
+
+/**
+ * @brief Method to send a follower to its next marker, stealing one if its own are done, or home once
+ * exploring is over. Called with 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the follower.
+ */
+void final_project::Mission::Impl::dispatch_fleet_follower(fleet_mission_context &ctx, int index)
+{
+  fleet_robot &robot = ctx.followers[index];
+  if (!mission_state.in(robot.id, final_project::RobotState::Idle)) {
+    return;
+  }
+  bool stolen = false;
+  robot.task = ctx.follower_tasks.next(index, &stolen);
+  if (robot.task >= 0) {
+    ROS_INFO_STREAM("Sending " << robot.spec.name << " to marker "
+                    << target_registry.marker(ctx.follower_task_markers[robot.task]).fiducial_id
+                    << (stolen ? " (stolen)" : ""));
+    robot_event(robot.id, final_project::RobotEvent::GoalSent);
+  } else if (ctx.explorers_home == ctx.explorers.size()) {
+    ROS_INFO_STREAM("Sending " << robot.spec.name << " home");
+    robot_event(robot.id, final_project::RobotEvent::SentHome);
+  } else {
+    return;
+  }
+  send_fleet_follower_goal(ctx, index);
+}
+
+/**
+ * @brief Method to log how fast the fleet localized the markers. Called with 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ */
+void final_project::Mission::Impl::fleet_summary(fleet_mission_context &ctx)
+{
+  const double minutes = (ros::Time::now() - ctx.start).toSec() / 60.0;
+  const std::size_t markers = target_registry.marker_count();
+  ROS_INFO_STREAM(ctx.explorers.size() << " explorers localized " << markers << " markers in " << minutes * 60.0
+                  << " s (" << (minutes > 0 ? markers / minutes : 0.0) << " per minute), "
+                  << ctx.explorer_tasks.steals() << " targets stolen");
+}
+
+/**
+ * @brief Method to count an explorer home and start the followers once every explorer is. Called with
+ * 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the explorer.
+ */
+void final_project::Mission::Impl::fleet_explorer_home(fleet_mission_context &ctx, int index)
+{
+  fleet_robot &robot = ctx.explorers[index];
+  robot.cmd_vel.publish(geometry_msgs::Twist());
+  ROS_INFO_STREAM(robot.spec.name << " JOB DONE!");
+  if (++ctx.explorers_home == ctx.explorers.size()) {
+    explorer_summary();
+    save_marker_cache();
+    fleet_summary(ctx);
+    ROS_INFO_STREAM("EXPLORER JOB DONE!");
+    for (std::size_t i = 0; i < ctx.followers.size(); i++) {
+      dispatch_fleet_follower(ctx, static_cast<int>(i));
+    }
+  }
+}
+
+/**
+ * @brief Method to count a follower home and end the mission once every follower is. Called with 'ctx.mutex'
+ * held.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the follower.
+ */
+void final_project::Mission::Impl::fleet_follower_home(fleet_mission_context &ctx, int index)
+{
+  ROS_INFO_STREAM(ctx.followers[index].spec.name << " is home");
+  if (++ctx.followers_home == ctx.followers.size()) {
+    if (ctx.followers_stranded == 0) {
+      ROS_INFO_STREAM("PROJECT FINISHED!!!");
+    } else {
+      ROS_ERROR_STREAM(ctx.followers_stranded << " followers never got home");
+    }
+    finish_mission(ctx.followers_stranded == 0);
+  }
+}
+
+/**
+ * @brief Method to send the failed goal of an explorer again, defer its target to the end of its deque or give
+ * it up. Called with 'ctx.mutex' held.
+ * 
+ * A target given up is left to the others, a later detection in transit may still localize its marker. An
+ * explorer that cannot get home is counted home, so that the followers still start.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the explorer.
+ * @param why How the goal failed, for the log.
+ */
+void final_project::Mission::Impl::fleet_explorer_failed(fleet_mission_context &ctx, int index, const std::string &why)
+{
+  fleet_robot &robot = ctx.explorers[index];
+  const bool heading_home = mission_state.in(robot.id, final_project::RobotState::HeadingHome);
+  if (!heading_home && !mission_state.in(robot.id, final_project::RobotState::Driving)) {
+    return;
+  }
+  robot.deadline = ros::Time();
+  const final_project::GoalRetryPolicy::Decision decision = goal_failed(robot.retry, robot.spec.name, robot.task,
+                                                                        !heading_home, why);
+  if (heading_home && decision == final_project::GoalRetryPolicy::Decision::GiveUp) {
+    robot_event(robot.id, final_project::RobotEvent::GoalReached);
+    fleet_explorer_home(ctx, index);
+    return;
+  }
+  robot_event(robot.id, final_project::RobotEvent::GoalFailed);
+  switch (decision) {
+    case final_project::GoalRetryPolicy::Decision::Retry:
+      robot_event(robot.id, heading_home ? final_project::RobotEvent::SentHome : final_project::RobotEvent::GoalSent);
+      send_fleet_explorer_goal(ctx, index);
+      return;
+    case final_project::GoalRetryPolicy::Decision::Defer:
+      ctx.explorer_tasks.defer(index, robot.task);
+      robot.task = -1;
+      break;
+    case final_project::GoalRetryPolicy::Decision::GiveUp:
+      break;
+  }
+  dispatch_fleet_explorer(ctx, index);
+}
+
+/**
+ * @brief Method to send the failed goal of a follower again, defer its marker to the end of its deque or give
+ * it up. Called with 'ctx.mutex' held.
+ * 
+ * A follower that cannot get home is counted home and stranded, the mission then ends without completing.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param index Index of the follower.
+ * @param why How the goal failed, for the log.
+ */
+void final_project::Mission::Impl::fleet_follower_failed(fleet_mission_context &ctx, int index, const std::string &why)
+{
+  fleet_robot &robot = ctx.followers[index];
+  const bool heading_home = mission_state.in(robot.id, final_project::RobotState::HeadingHome);
+  if (!heading_home && !mission_state.in(robot.id, final_project::RobotState::Driving)) {
+    return;
+  }
+  robot.deadline = ros::Time();
+  robot.lookahead.disarm();
+  const final_project::GoalRetryPolicy::Decision decision = goal_failed(robot.retry, robot.spec.name, robot.task,
+                                                                        !heading_home, why);
+  if (heading_home && decision == final_project::GoalRetryPolicy::Decision::GiveUp) {
+    robot_event(robot.id, final_project::RobotEvent::GoalReached);
+    ctx.followers_stranded++;
+    fleet_follower_home(ctx, index);
+    return;
+  }
+  robot_event(robot.id, final_project::RobotEvent::GoalFailed);
+  switch (decision) {
+    case final_project::GoalRetryPolicy::Decision::Retry:
+      robot_event(robot.id, heading_home ? final_project::RobotEvent::SentHome : final_project::RobotEvent::GoalSent);
+      send_fleet_follower_goal(ctx, index);
+      return;
+    case final_project::GoalRetryPolicy::Decision::Defer:
+      ctx.follower_tasks.defer(index, robot.task);
+      break;
+    case final_project::GoalRetryPolicy::Decision::GiveUp:
+      ctx.follower_tasks.complete(robot.task);
+      break;
+  }
+  robot.task = -1;
+  dispatch_fleet_follower(ctx, index);
+}
+
+void final_project::Mission::Impl::fleet_explorer_done(fleet_mission_context &ctx, int index, unsigned goal,
+                                                       const actionlib::SimpleClientGoalState &state)
+{
+  std::lock_guard<std::mutex> lock(ctx.mutex);
+  fleet_robot &robot = ctx.explorers[index];
+  if (goal != robot.goals) {
+    return;
+  }
+  if (state != actionlib::SimpleClientGoalState::SUCCEEDED) {
+    fleet_explorer_failed(ctx, index, "finished as " + state.toString());
+    return;
+  }
+  if (!mission_state.in(robot.id, final_project::RobotState::Driving) &&
+      !mission_state.in(robot.id, final_project::RobotState::HeadingHome)) {
+    return;
+  }
+  robot.deadline = ros::Time();
+  robot.retry.succeeded(robot.task);
+  if (robot.task >= 0 && target_registry.target_done(robot.task)) {
+    // Another explorer localized the marker while this one was on its way.
+    dispatch_fleet_explorer(ctx, index);
+    return;
+  }
+  robot_event(robot.id, final_project::RobotEvent::GoalReached);
+  if (mission_state.in(robot.id, final_project::RobotState::Home)) {
+    fleet_explorer_home(ctx, index);
+    return;
+  }
+  ROS_INFO_STREAM(robot.spec.name << " reached goal " << robot.task);
+  start_rotation_search(robot.rotation_search, *ctx.tf_buffer, ctx.map, ctx.explorer_tasks.location(robot.task),
+                        robot.spec.base_frame);
+  robot.looking_since = ros::Time::now();
+  robot.rotate_timer.start();
+  gate_detector(index, true);
+}
+
+void final_project::Mission::Impl::fleet_follower_done(fleet_mission_context &ctx, int index, unsigned goal,
+                                                       const actionlib::SimpleClientGoalState &state)
+{
+  std::lock_guard<std::mutex> lock(ctx.mutex);
+  fleet_robot &robot = ctx.followers[index];
+  if (goal != robot.goals) {
+    return;
+  }
+  if (state != actionlib::SimpleClientGoalState::SUCCEEDED) {
+    fleet_follower_failed(ctx, index, "finished as " + state.toString());
+    return;
+  }
+  if (!robot_event(robot.id, final_project::RobotEvent::GoalReached)) {
+    return;
+  }
+  robot.deadline = ros::Time();
+  robot.retry.succeeded(robot.task);
+  if (mission_state.in(robot.id, final_project::RobotState::Home)) {
+    fleet_follower_home(ctx, index);
+    return;
+  }
+  ROS_INFO_STREAM(robot.spec.name << " reached marker "
+                  << target_registry.marker(ctx.follower_task_markers[robot.task]).fiducial_id);
+  ctx.follower_tasks.complete(robot.task);
+  robot.task = -1;
+  dispatch_fleet_follower(ctx, index);
+}
+
+/**
+ * @brief Method to give up the goals of the fleet that missed their deadline. Called with 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ */
+void final_project::Mission::Impl::check_fleet_deadlines(fleet_mission_context &ctx)
+{
+  const ros::Time now = ros::Time::now();
+  for (std::size_t i = 0; i < ctx.explorers.size(); i++) {
+    fleet_robot &robot = ctx.explorers[i];
+    if (!robot.deadline.isZero() && now > robot.deadline) {
+      // The goal sent again replaces the cancelled one, whose callback is then ignored.
+      robot.client->cancelGoal();
+      fleet_explorer_failed(ctx, static_cast<int>(i), "missed its deadline");
+    }
+  }
+  for (std::size_t i = 0; i < ctx.followers.size(); i++) {
+    fleet_robot &robot = ctx.followers[i];
+    if (!robot.deadline.isZero() && now > robot.deadline) {
+      robot.client->cancelGoal();
+      fleet_follower_failed(ctx, static_cast<int>(i), "missed its deadline");
+    }
+  }
+}
+
+/**
+ * @brief Method to record a newly stable marker, free the explorers heading to its target and queue it for
+ * the followers. Called with 'ctx.mutex' held.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param target Lookup target the marker belongs to, -1 if it belongs to none.
+ * @param fiducial_id fiducial_id of the marker.
+ */
+void final_project::Mission::Impl::fleet_marker_localized(fleet_mission_context &ctx, int target, int fiducial_id)
+{
+  if (target >= 0) {
+    localize_target(target, fiducial_id);
+    ctx.explorer_tasks.complete(target);
+    for (std::size_t i = 0; i < ctx.explorers.size(); i++) {
+      fleet_robot &explorer = ctx.explorers[i];
+      const bool looking = mission_state.in(explorer.id, final_project::RobotState::Looking);
+      if (explorer.task != target || !robot_event(explorer.id, final_project::RobotEvent::MarkerLocalized)) {
+        continue;
+      }
+      if (looking) {
+        mission_metrics.rotation.record((ros::Time::now() - explorer.looking_since).toSec());
+      }
+      explorer.rotate_timer.stop();
+      // Sending the next goal preempts the current one.
+      dispatch_fleet_explorer(ctx, static_cast<int>(i));
+    }
+  }
+  const int marker = target_registry.find_marker(fiducial_id);
+  const int task = ctx.follower_tasks.add_task(follower_waypoint(marker));
+  ctx.follower_task_markers.push_back(marker);
+  ctx.follower_tasks.assign(task);
+  for (std::size_t i = 0; i < ctx.followers.size(); i++) {
+    dispatch_fleet_follower(ctx, static_cast<int>(i));
+  }
+}
+
+/**
+ * @brief Method to localize one queued detection of the fleet and move the mission on once a marker is stable.
+ * 
+ * @param ctx Context of the fleet mission.
+ * @param detection Detection taken from the queue.
+ */
+void final_project::Mission::Impl::handle_fleet_detection(fleet_mission_context &ctx, const marker_detection &detection)
+{
+  bool looking = false;
+  const final_project::MarkerLocalizer* localizer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    const fleet_robot &robot = ctx.explorers[detection.robot];
+    looking = mission_state.in(robot.id, final_project::RobotState::Looking) && detection.stamp >= robot.looking_since;
+    if ((!looking && !ctx.scan_while_driving) || mission_state.in(robot.id, final_project::RobotState::Home)) {
+      return;
+    }
+    localizer = robot.localizer.get();
+  }
+  stable_markers stable;
+  // The fiducial filter only hands on the detections whose camera pose is in the buffer.
+  const std::size_t count = listen_at(*localizer, detection, ros::Duration(0), stable, &ctx.mutex);
+  if (count == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(ctx.mutex);
+  for (std::size_t i = 0; i < count; i++) {
+    const fleet_robot &robot = ctx.explorers[detection.robot];
+    int target = -1;
+    // The first new marker of a looking explorer belongs to its task, the others to the nearest free target.
+    if (looking && mission_state.in(robot.id, final_project::RobotState::Looking)) {
+      target = robot.task;
+    } else {
+      target = assign_marker_to_target(stable[i], tuning.get().association_radius);
+    }
+    fleet_marker_localized(ctx, target, stable[i]);
+  }
+}
+
+/**
+ * @brief Method to run the whole mission with every robot of the fleet, from action client callbacks.
+ * 
+ * @param nh Nodehandle for a ROS node
+ * @param ctx Context of the fleet mission, with the buffer and flags already set.
+ * @param rotation_params Tuning of the rotation search of every explorer.
+ * @return true if the mission ran.
+ * @return false if some move_base server did not come up in time.
+ */
+bool final_project::Mission::Impl::run_fleet_mission(ros::NodeHandle &nh, fleet_mission_context &ctx,
+                                                     const final_project::RotationSearch::Params& rotation_params)
+{
+  for (const final_project::RobotSpec& spec : fleet) {
+    std::deque<fleet_robot>& robots = (spec.role == final_project::RobotRole::Explorer) ? ctx.explorers : ctx.followers;
+    robots.emplace_back();
+    fleet_robot& robot = robots.back();
+    robot.spec = spec;
+    robot.id = add_robot(spec);
+    robot.client.reset(new MoveBaseClient(spec.move_base_action, true));
+    robot.lookahead = final_project::GoalLookahead(ctx.lookahead_radius);
+    robot.retry = final_project::GoalRetryPolicy(tuning.get().retry);
+  }
+  std::vector<final_project::RobotSpec> robots;
+  std::vector<MoveBaseClient*> clients;
+  for (std::deque<fleet_robot>* group : {&ctx.explorers, &ctx.followers}) {
+    for (fleet_robot& robot : *group) {
+      robots.push_back(robot.spec);
+      clients.push_back(robot.client.get());
+    }
+  }
+  if (!wait_for_startup(nh, ctx.startup_timeout, robots, clients, *ctx.tf_buffer, ctx.map)) {
+    return false;
+  }
+
+  // Travel costs come from the distance fields when they are loaded.
+  const final_project::FleetCoordinator::CostFunction cost = [this](const std::array<double, 2> &a,
+                                                                   const std::array<double, 2> &b) {
+    return travel_length(a, b);
+  };
+  ctx.explorer_tasks = final_project::FleetCoordinator(ctx.explorers.size());
+  ctx.follower_tasks = final_project::FleetCoordinator(ctx.followers.size());
+  ctx.explorer_tasks.set_cost(cost);
+  ctx.follower_tasks.set_cost(cost);
+  for (std::size_t i = 0; i < target_registry.target_count(); i++) {
+    ctx.explorer_tasks.add_task({{target_registry.target(static_cast<int>(i)).x,
+                                  target_registry.target(static_cast<int>(i)).y}});
+  }
+  for (std::size_t i = 0; i < ctx.explorers.size(); i++) {
+    fleet_robot& robot = ctx.explorers[i];
+    ctx.explorer_tasks.set_position(static_cast<int>(i), {{robot.spec.home_x, robot.spec.home_y}});
+    robot.cmd_vel = nh.advertise<geometry_msgs::Twist>(robot.spec.cmd_vel, topic_queue_size);
+    robot.localizer.reset(new final_project::MarkerLocalizer(*ctx.tf_buffer, "map", robot.spec.camera_frame,
+                                                                 follower_standoff));
+    if (detector_gating) {
+      detector_gates.emplace_back(new final_project::DetectorGate(nh, robot.spec.detector));
+    }
+    robot.rotation_search = final_project::RotationSearch(rotation_params);
+    robot.rotate_timer = nh.createTimer(ros::Duration(0.1), [&robot, &ctx](const ros::TimerEvent &) {
+      geometry_msgs::Twist msg;
+      {
+        // Timer::stop() waits for a running callback, so never block on a mutex its caller may hold.
+        std::unique_lock<std::mutex> lock(ctx.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+          return;
+        }
+        msg.angular.z = robot.rotation_search.angular_velocity(ros::Time::now().toSec(),
+                                                               robot.last_detection_time.load(std::memory_order_relaxed));
+      }
+      robot.cmd_vel.publish(msg);
+    }, false, false);
+    // The one spinner thread keeps the callbacks the only producer of the detection queue.
+    const int index = static_cast<int>(i);
+    subscribe_fiducials(nh, *ctx.tf_buffer, robot.spec, robot.last_detection_time,
+        [this, &ctx, index](const fiducial_msgs::FiducialTransformArray::ConstPtr &msg) {
+          queue_detection(msg, index);
+          ctx.detection_ready.notify_one();
+        }, robot.fiducials);
+  }
+  for (std::size_t i = 0; i < ctx.followers.size(); i++) {
+    ctx.follower_tasks.set_position(static_cast<int>(i), {{ctx.followers[i].spec.home_x, ctx.followers[i].spec.home_y}});
+    subscribe_costmap(nh, ctx.followers[i].spec, ctx.followers[i].costmap);
+  }
+  // The targets of the cached markers need no explorer.
+  for (std::size_t i = 0; i < target_registry.target_count(); i++) {
+    if (target_registry.target_done(static_cast<int>(i))) {
+      ctx.explorer_tasks.complete(static_cast<int>(i));
+    }
+  }
+  ctx.explorer_tasks.distribute();
+  ignore_cached_markers();
+  ROS_INFO_STREAM("Fleet of " << ctx.explorers.size() << " explorers and " << ctx.followers.size()
+                  << " followers, " << target_registry.target_count() << " lookup targets");
+
+  std::unique_ptr<ros::AsyncSpinner> spinner;
+  if (mission_host.spin) {
+    spinner.reset(new ros::AsyncSpinner(1));
+    spinner->start();
+  }
+  std::thread localizer([this, &ctx]() {
+    marker_detection detection;
+    while (mission_running()) {
+      if (!detection_queue.try_pop(detection)) {
+        std::unique_lock<std::mutex> lock(ctx.detection_mutex);
+        ctx.detection_ready.wait_for(lock, std::chrono::milliseconds(50));
+        continue;
+      }
+      handle_fleet_detection(ctx, detection);
+    }
+  });
+  {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    ctx.start = ros::Time::now();
+    for (std::size_t i = 0; i < ctx.explorers.size(); i++) {
+      dispatch_fleet_explorer(ctx, static_cast<int>(i));
+    }
+    // The followers start with the markers of the cache.
+    for (const final_project::CachedMarker& marker : cached_markers) {
+      fleet_marker_localized(ctx, -1, marker.fiducial_id);
+    }
+  }
+  ros::Timer deadlines = nh.createTimer(ros::Duration(1.0), [this, &ctx](const ros::TimerEvent &) {
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    check_fleet_deadlines(ctx);
+  });
+  wait_for_mission_end();
+  ctx.detection_ready.notify_one();
+  localizer.join();
+  return true;
+}
+
+
+/*                                      MISSION                                              */
+
+final_project::Mission::Mission(const final_project::MissionHost &host) : impl_(new Impl(host))
+{
+}
+
+final_project::Mission::~Mission() = default;
+
+int final_project::Mission::run(ros::NodeHandle &nh, ros::NodeHandle &pnh)
+{
+  return impl_->run_mission(nh, pnh);
+}
+
+void final_project::Mission::stop()
+{
+  impl_->stop_mission();
+}
+
+final_project::MissionResult final_project::Mission::last_result() const
+{
+  return impl_->last_mission_result();
+}
+
+final_project::ReplayResult final_project::Mission::replay_bag(ros::NodeHandle &pnh, const std::string &path)
+{
+  return impl_->replay_bag(pnh, path);
+}
+
+void final_project::Mission::Impl::stop_mission()
+{
+  if (!mission_stopped.exchange(true)) {
+    mission_end_time = ros::Time::now();
+  }
+  mission_end.notify_all();
+}
+
+std::vector<final_project::RobotSpec> final_project::read_fleet(ros::NodeHandle &pnh)
+{
+  std::vector<final_project::RobotSpec> robots;
+  get_fleet(pnh, robots);
+  return robots;
+}
+
+/**
+ * @brief Method to get the histogram of every instrumented stage, by name.
+ */
+std::vector<std::pair<std::string, final_project::HistogramSnapshot>>
+final_project::Mission::Impl::stage_snapshots() const
+{
+  std::vector<std::pair<std::string, final_project::HistogramSnapshot>> stages;
+  for (std::size_t i = 0; i < final_project::MissionMetrics::kStages; i++) {
+    std::string name;
+    const final_project::HistogramSnapshot snapshot = mission_metrics.stage(i, name).snapshot();
+    stages.emplace_back(name, snapshot);
+  }
+  return stages;
+}
+
+final_project::MissionResult final_project::Mission::Impl::last_mission_result() const
+{
+  final_project::MissionResult result;
+  result.completed = mission_completed.load();
+  if (!mission_start_time.isZero()) {
+    // A mission ended by a ROS shutdown has no end time.
+    const ros::Time end = mission_end_time.isZero() ? ros::Time::now() : mission_end_time;
+    result.duration = (end - mission_start_time).toSec();
+  }
+  result.target_times = target_done_after;
+  result.markers = target_registry.marker_count();
+  result.stages = stage_snapshots();
+  result.transitions = mission_state.transitions();
+  result.goal_failures = goal_failures.load();
+  result.goals_given_up = goals_given_up.load();
+  result.hot_path_allocations = hot_path_allocations.load();
+  return result;
+}
+
+int final_project::Mission::Impl::run_mission(ros::NodeHandle &nh, ros::NodeHandle &pnh)
+{
+  // Start from a clean state, the mission may run again once it returned.
+  mission_stopped.store(false);
+  mission_completed.store(false);
+  mission_start_time = ros::Time();
+  mission_end_time = ros::Time();
+  psi = program_status_indicator();
+  mission_state.clear();
+  mission_progress.clear();
+  target_registry.clear();
+  explorer_route.clear();
+  follower_route.clear();
+  marker_detection stale;
+  while (detection_queue.try_pop(stale)) {
+  }
+  mission_metrics.reset();
+
+  // Times the current goals were sent and the explorer started looking, for the stage histograms.
+  ros::Time explorer_goal_sent_at;
+  ros::Time follower_goal_sent_at;
+  ros::Time looking_since;
+
+  // Mission mode, "polling" checks the goal states at a fixed rate, "event" reacts to the action client callbacks,
+  // "pipelined" also sends the follower to each marker as soon as it is localized, "fleet" runs the pipelined
+  // mission with every robot of ~fleet.
+  std::string mission_mode;
+  pnh.param<std::string>("mission_mode", mission_mode, "polling");
+  // Fuse the detections made in transit and skip the targets whose marker is already localized.
+  bool scan_while_driving = false;
+  pnh.param("scan_while_driving", scan_while_driving, false);
+  // The tuning below may change while the mission runs, see cfg/Mission.cfg, the private parameters start it.
+  mission_tuning initial_tuning;
+  pnh.param("scan/association_radius", initial_tuning.association_radius, initial_tuning.association_radius);
+  const double association_radius = initial_tuning.association_radius;
+  // Deadline for the robots to come up, the TF tree, detectors and map are only waited for until then.
+  double startup_timeout = 60.0;
+  pnh.param("startup/timeout", startup_timeout, startup_timeout);
+  // Send a follower its next goal once it is this close to the current one, in meters, 0 to stop at every goal.
+  pnh.param("lookahead/radius", initial_tuning.lookahead_radius, initial_tuning.lookahead_radius);
+  const double lookahead_radius = initial_tuning.lookahead_radius;
+  // Rate the polling mission checks the goals at, in Hz.
+  pnh.param("loop_rate", initial_tuning.loop_rate, initial_tuning.loop_rate);
+  // Distance in front of a marker its follower location is placed at, and the depth of the topic queues.
+  pnh.param("marker/offset", follower_standoff, 0.4);
+  pnh.param("queue_size", topic_queue_size, 5);
+  topic_queue_size = std::max(topic_queue_size, 1);
+  // Move the follower goals that are too close to an obstacle of the global costmap of the follower.
+  pnh.param("refine/enabled", refine_follower_goals, true);
+  goal_refiner_params = final_project::GoalRefiner::Params();
+  get_refiner_params(pnh, goal_refiner_params);
+  // Send the failed goals again, then last, then give them up, and fail the goals that take far longer than
+  // their ETA.
+  get_retry_params(pnh, initial_tuning.retry);
+  goal_failures.store(0);
+  goals_given_up.store(0);
+  hot_path_allocations.store(0);
+  // Run the marker detectors only while the mission uses their detections.
+  pnh.param("detector/gating", detector_gating, true);
+  pnh.param("detector/ignore_localized", ignore_localized_markers, true);
+  // The detectors are handed back switched on, whichever way the mission returns.
+  struct detector_gates_reset {
+    std::vector<std::unique_ptr<final_project::DetectorGate>> &gates;
+    ~detector_gates_reset() {
+      for (const auto &gate : gates) {
+        gate->set_enabled(true);
+      }
+      gates.clear();
+    }
+  } gates_reset{detector_gates};
+
+  // The first explorer and the first follower of the fleet run the mission, unless the whole fleet does.
+  get_fleet(pnh, fleet);
+  const std::vector<int> explorers = final_project::robots_with_role(fleet, final_project::RobotRole::Explorer);
+  const std::vector<int> followers = final_project::robots_with_role(fleet, final_project::RobotRole::Follower);
+  if (explorers.empty() || followers.empty()) {
+    ROS_FATAL("The fleet needs at least one explorer and one follower");
+    return 1;
+  }
+  explorer_robot = fleet[explorers.front()];
+  follower_robot = fleet[followers.front()];
+
+  get_explorer_targets(nh, target_registry);
+  target_done_after.assign(target_registry.target_count(), -1.0);
+  if (target_registry.target_count() == 0) {
+    ROS_WARN("No aruco_lookup_locations, the explorer only drives home");
+  }
+
+  // Order the goals by travel cost, "distance_field" uses the precomputed path lengths over the static map,
+  // "make_plan" asks move_base for path lengths, "euclidean" uses straight lines.
+  bool optimize_routes = true;
+  pnh.param("optimize_routes", optimize_routes, true);
+  std::string route_cost_source;
+  pnh.param<std::string>("route/cost_source", route_cost_source, "distance_field");
+  if (route_cost_source == "distance_field") {
+    load_distance_fields(pnh);
+  }
+
+  get_fusion_params(pnh, initial_tuning.fusion);
+  get_detection_weighting(pnh, initial_tuning.weighting);
+  get_rotation_params(pnh, initial_tuning.rotation);
+  const final_project::RotationSearch::Params rotation_params = initial_tuning.rotation;
+  // The readers of the last mission are gone with its threads and timers, its tunings can be freed.
+  tuning.publish(initial_tuning);
+  tuning.reclaim();
+  tuning_server reconfigure;
+  serve_tuning(pnh, reconfigure);
+  marker_fusion = final_project::PoseFusion(initial_tuning.fusion);
+  reserve_markers(pnh);
+  load_marker_cache(pnh, association_radius);
+  // Publish the progress of the mission on ~telemetry at this rate, in Hz, and serve it on ~get_telemetry, 0 for
+  // neither.
+  double telemetry_rate = 2.0;
+  pnh.param("telemetry/rate", telemetry_rate, telemetry_rate);
+  telemetry_period = telemetry_rate > 0 ? 1.0 / telemetry_rate : 0.0;
+  snapshot_robots();
+  snapshot_markers(true);
+  telemetry_server telemetry;
+  if (telemetry_period > 0) {
+    serve_telemetry(pnh, telemetry);
+  }
+  final_project::RotationSearch rotation_search(rotation_params);
+  // The static map is latched by map_server, it is only used to guess where the markers are.
+  nav_msgs::OccupancyGrid::ConstPtr map;
+
+  tf2_ros::Buffer tfBuffer;
+  tf2_ros::TransformListener tfListener(tfBuffer);
+
+  // Publish the stage histograms on /diagnostics every period, 0 to only log them with the explorer summary.
+  double diagnostics_period = 1.0;
+  pnh.param("diagnostics/period", diagnostics_period, diagnostics_period);
+  ros::Publisher diagnostics_pub;
+  ros::Timer diagnostics_timer;
+  if (diagnostics_period > 0) {
+    diagnostics_pub = nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 5);
+    diagnostics_timer = nh.createTimer(ros::Duration(diagnostics_period),
+        [this, &diagnostics_pub](const ros::TimerEvent &) { publish_metrics(diagnostics_pub); });
+  }
+
+  if (mission_mode == "fleet") {
+    fleet_mission_context ctx;
+    ctx.tf_buffer = &tfBuffer;
+    ctx.scan_while_driving = scan_while_driving;
+    ctx.startup_timeout = startup_timeout;
+    ctx.lookahead_radius = lookahead_radius;
+    return run_fleet_mission(nh, ctx, rotation_params) ? 0 : 1;
+  }
+  if (explorers.size() > 1 || followers.size() > 1) {
+    ROS_WARN_STREAM("Only " << explorer_robot.name << " and " << follower_robot.name
+                    << " take part, set ~mission_mode to fleet to use the whole fleet");
+  }
+  if (detector_gating) {
+    detector_gates.emplace_back(new final_project::DetectorGate(nh, explorer_robot.detector));
+  }
+  ignore_cached_markers();
+  add_robot(explorer_robot);
+  add_robot(follower_robot);
+
+  // Tell the action client that we want to spin a thread by default
+  MoveBaseClient explorer_client(explorer_robot.move_base_action, true);
+  // Tell the action client that we want to spin a thread by default
+  MoveBaseClient follower_client(follower_robot.move_base_action, true);
+
+  // Wait for the action servers, the TF tree, the marker detector and the map to come up
+  if (!wait_for_startup(nh, startup_timeout, {explorer_robot, follower_robot}, {&explorer_client, &follower_client},
+                        tfBuffer, map)) {
+    return 1;
+  }
+
+  move_base_msgs::MoveBaseGoal explorer_goal;
+  move_base_msgs::MoveBaseGoal follower_goal;
+
+  // Publisher to make the explorer rotate when it reaches a target location so as to start detection of the aruco marker.  
+  ros::Publisher explorer_pub = nh.advertise<geometry_msgs::Twist>(explorer_robot.cmd_vel, topic_queue_size);
+
+  std::string explorer_planner_name;
+  std::string follower_planner_name;
+  pnh.param<std::string>("route/explorer_planner", explorer_planner_name, explorer_robot.planner);
+  pnh.param<std::string>("route/follower_planner", follower_planner_name, follower_robot.planner);
+  ros::ServiceClient explorer_planner = nh.serviceClient<nav_msgs::GetPlan>(explorer_planner_name);
+  ros::ServiceClient follower_planner = nh.serviceClient<nav_msgs::GetPlan>(follower_planner_name);
+  const bool use_planner = (route_cost_source == "make_plan");
+  plan_explorer_route(use_planner ? &explorer_planner : nullptr, optimize_routes);
+
+  final_project::MarkerLocalizer localizer(tfBuffer, "map", explorer_robot.camera_frame, follower_standoff);
+  costmap_input follower_costmap;
+  subscribe_costmap(nh, follower_robot, follower_costmap);
+
+  if (mission_mode == "event" || mission_mode == "pipelined") {
+    event_mission_context ctx;
+    ctx.pipelined = (mission_mode == "pipelined");
+    ctx.explorer_client = &explorer_client;
+    ctx.follower_client = &follower_client;
+    ctx.localizer = &localizer;
+    ctx.tf_buffer = &tfBuffer;
+    ctx.map = map;
+    ctx.rotation_search = rotation_search;
+    ctx.scan_while_driving = scan_while_driving;
+    ctx.optimize_routes = optimize_routes;
+    ctx.follower_planner = use_planner ? &follower_planner : nullptr;
+    ctx.explorer_pub = explorer_pub;
+    ctx.follower_lookahead = final_project::GoalLookahead(lookahead_radius);
+    ctx.follower_refiner = follower_costmap.refiner.get();
+    ctx.explorer_retry = final_project::GoalRetryPolicy(tuning.get().retry);
+    ctx.follower_retry = final_project::GoalRetryPolicy(tuning.get().retry);
+    run_event_mission(nh, ctx);
+    return 0;
+  }
+
+  // Subscriber for retrieving information about aruco tag.
+  fiducial_input fiducials;
+  subscribe_fiducials(nh, tfBuffer, explorer_robot, last_detection_time,
+      [this](const fiducial_msgs::FiducialTransformArray::ConstPtr &msg) { fiducial_callback(msg); }, fiducials);
+  // The rate follows the tuning, the loop picks a new one up at its next iteration.
+  double loop_hz = tuning.get().loop_rate;
+  ros::Rate loop_rate(loop_hz);
+  // Last position of the follower from its move_base feedback, written by the action client thread.
+  final_project::GoalLookahead follower_lookahead(lookahead_radius);
+  std::mutex follower_feedback_mutex;
+  std::array<double, 2> follower_position{{0, 0}};
+  bool has_follower_position = false;
+  // What becomes of the failed goals, and the time the current goals are given up at, zero when there is none.
+  final_project::GoalRetryPolicy explorer_retry(tuning.get().retry);
+  final_project::GoalRetryPolicy follower_retry(tuning.get().retry);
+  ros::Time explorer_deadline;
+  ros::Time follower_deadline;
+  // Raised to send the current goal again rather than the next one.
+  bool resend_explorer_goal = false;
+  bool resend_follower_goal = false;
+  // Hands over to the follower once the explorer is home, or counted home.
+  const auto explorer_done = [&]() {
+    // Stop explorer from exploring new targets.
+    gate_detector(0, false);
+
+    explorer_summary();
+    save_marker_cache();
+    plan_follower_route(use_planner ? &follower_planner : nullptr, optimize_routes);
+
+    // Publish a message to rotate explorer
+    geometry_msgs::Twist msg;
+    msg.linear.x = 0;
+    msg.angular.z = 0.0;
+    explorer_pub.publish(msg);
+
+    ROS_INFO_STREAM("EXPLORER JOB DONE!");
+  };
+
+  while (mission_running())
+  {
+    // The action results, the detections and the timers of this iteration are served once, up front.
+    spin_mission_callbacks();
+    // Check if explorer needs to move to a target location.
+    if (!mission_state.in(explorer_id, final_project::RobotState::Home)){
+      // Check if a goal is sent to explorer.
+      if (mission_state.in(explorer_id, final_project::RobotState::Idle)){
+        if (resend_explorer_goal) {
+          set_explorer_goal(explorer_goal, psi.current_explorer_target);
+          resend_explorer_goal = false;
+        } else {
+          next_explorer_goal(explorer_goal);
+        }
+        perturb_goal(explorer_retry, psi.current_explorer_target, explorer_goal);
+        ROS_INFO_STREAM("Sending goal # " << psi.current_explorer_target << " for explorer");
+        explorer_client.sendGoal(explorer_goal); 
+        explorer_goal_sent_at = ros::Time::now();
+        explorer_deadline = goal_deadline(explorer_retry, explorer_id, psi.current_explorer_target, explorer_goal,
+                                          goal_length(tfBuffer, explorer_robot.base_frame, explorer_goal));
+        const bool heading_home = psi.current_explorer_target >= explorer_home_target();
+        robot_event(explorer_id, heading_home ? final_project::RobotEvent::SentHome :
+                                                final_project::RobotEvent::GoalSent);
+        gate_detector(0, scan_while_driving && !heading_home);
+      }
+      // Check if the explorer goal failed or missed its deadline, the goal is then sent again, deferred or given up.
+      else if (mission_state.in(explorer_id, final_project::RobotState::Driving) ||
+               mission_state.in(explorer_id, final_project::RobotState::HeadingHome)){
+        const actionlib::SimpleClientGoalState state = explorer_client.getState();
+        const bool late = !explorer_deadline.isZero() && ros::Time::now() > explorer_deadline;
+        if ((state.isDone() && state != actionlib::SimpleClientGoalState::SUCCEEDED) || late){
+          if (late) {
+            explorer_client.cancelGoal();
+          }
+          explorer_deadline = ros::Time();
+          const int target = psi.current_explorer_target;
+          const bool heading_home = target >= explorer_home_target();
+          const final_project::GoalRetryPolicy::Decision decision = goal_failed(
+              explorer_retry, explorer_robot.name, target, !heading_home,
+              late ? "missed its deadline" : "finished as " + state.toString());
+          if (heading_home && decision == final_project::GoalRetryPolicy::Decision::GiveUp) {
+            // Counted home, so that the follower still starts.
+            robot_event(explorer_id, final_project::RobotEvent::GoalReached);
+            explorer_done();
+            continue;
+          }
+          robot_event(explorer_id, final_project::RobotEvent::GoalFailed);
+          resend_explorer_goal = decision == final_project::GoalRetryPolicy::Decision::Retry;
+          if (decision == final_project::GoalRetryPolicy::Decision::Defer) {
+            defer_explorer_target();
+          }
+          continue;
+        }
+      }
+      // Check if explorer reached a goal.
+      if (explorer_client.getState() == actionlib::SimpleClientGoalState::SUCCEEDED){
+        const bool arrived = !mission_state.in(explorer_id, final_project::RobotState::Looking);
+        if (arrived) {
+          mission_metrics.explorer_goal.record((ros::Time::now() - explorer_goal_sent_at).toSec());
+          ROS_INFO_STREAM("Hooray, explorer reached goal " << psi.current_explorer_target);
+          robot_event(explorer_id, final_project::RobotEvent::GoalReached);
+          explorer_retry.succeeded(psi.current_explorer_target);
+          explorer_deadline = ros::Time();
+        }
+        // Check if all targets locations are reached by explorer 
+        if(mission_state.in(explorer_id, final_project::RobotState::Home)){
+          explorer_done();
+          continue;
+        }
+        
+        if (arrived) {
+          start_rotation_search(rotation_search, tfBuffer, map, explorer_waypoint(psi.current_explorer_target),
+                                explorer_robot.base_frame);
+          gate_detector(0, true);
+          looking_since = ros::Time::now();
+        }
+        // Publish a message to rotate explorer
+        geometry_msgs::Twist msg;
+        msg.linear.x = 0;
+        msg.angular.z = rotation_search.angular_velocity(ros::Time::now().toSec(),
+                                                         last_detection_time.load(std::memory_order_relaxed));
+        explorer_pub.publish(msg);
+      }
+    }
+
+    // Check if follower needs to move to a target location.
+    if (mission_state.in(explorer_id, final_project::RobotState::Home)){
+      // Check if a goal is sent to follower.
+      if (mission_state.in(follower_id, final_project::RobotState::Idle)) {
+        if (resend_follower_goal) {
+          set_follower_goal_at(follower_goal, psi.current_follower_target, follower_costmap.refiner.get(), nullptr);
+          resend_follower_goal = false;
+        } else {
+          next_follower_goal(follower_goal, follower_costmap.refiner.get());
+        }
+        perturb_goal(follower_retry, psi.current_follower_target, follower_goal);
+        ROS_INFO_STREAM("Sending goal # " << psi.current_follower_target << " to follower");
+        ROS_INFO_STREAM("goal => x: " << follower_goal.target_pose.pose.position.x << 
+                        "\ty: "     << follower_goal.target_pose.pose.position.y );
+        {
+          std::lock_guard<std::mutex> lock(follower_feedback_mutex);
+          has_follower_position = false;
+        }
+        // The follower stops at home, the end of its route.
+        follower_lookahead.set_radius(tuning.get().lookahead_radius);
+        follower_lookahead.arm(follower_goal.target_pose.pose.position.x, follower_goal.target_pose.pose.position.y,
+                               psi.current_follower_target == follower_home_location);
+        follower_client.sendGoal(follower_goal, MoveBaseClient::SimpleDoneCallback(),
+            MoveBaseClient::SimpleActiveCallback(),
+            [&](const move_base_msgs::MoveBaseFeedbackConstPtr &feedback) {
+              std::lock_guard<std::mutex> lock(follower_feedback_mutex);
+              follower_position = {{feedback->base_position.pose.position.x, feedback->base_position.pose.position.y}};
+              has_follower_position = true;
+            });
+        follower_goal_sent_at = ros::Time::now();
+        follower_deadline = goal_deadline(follower_retry, follower_id, psi.current_follower_target, follower_goal,
+                                          goal_length(tfBuffer, follower_robot.base_frame, follower_goal));
+        robot_event(follower_id, psi.current_follower_target == follower_home_location ?
+                    final_project::RobotEvent::SentHome : final_project::RobotEvent::GoalSent);
+      }
+      // Check if the follower goal failed or missed its deadline, the goal is then sent again, deferred or given up.
+      else if (mission_state.in(follower_id, final_project::RobotState::Driving) ||
+               mission_state.in(follower_id, final_project::RobotState::HeadingHome)) {
+        const actionlib::SimpleClientGoalState state = follower_client.getState();
+        const bool late = !follower_deadline.isZero() && ros::Time::now() > follower_deadline;
+        if ((state.isDone() && state != actionlib::SimpleClientGoalState::SUCCEEDED) || late) {
+          if (late) {
+            follower_client.cancelGoal();
+          }
+          follower_deadline = ros::Time();
+          follower_lookahead.disarm();
+          const int location = psi.current_follower_target;
+          const bool heading_home = location == follower_home_location;
+          const final_project::GoalRetryPolicy::Decision decision = goal_failed(
+              follower_retry, follower_robot.name, location, !heading_home,
+              late ? "missed its deadline" : "finished as " + state.toString());
+          if (heading_home && decision == final_project::GoalRetryPolicy::Decision::GiveUp) {
+            robot_event(follower_id, final_project::RobotEvent::GoalReached);
+            ROS_ERROR_STREAM("The follower never got home");
+            finish_mission(false);
+            continue;
+          }
+          robot_event(follower_id, final_project::RobotEvent::GoalFailed);
+          resend_follower_goal = decision == final_project::GoalRetryPolicy::Decision::Retry;
+          if (decision == final_project::GoalRetryPolicy::Decision::Defer) {
+            defer_follower_location();
+          }
+          continue;
+        }
+      }
+      // Check if the follower passes its goal, the next one then preempts it.
+      bool passed = false;
+      {
+        std::lock_guard<std::mutex> lock(follower_feedback_mutex);
+        passed = has_follower_position && follower_lookahead.passed(follower_position[0], follower_position[1]);
+      }
+      // Check if follower reached a goal.
+      if ((passed || follower_client.getState() == actionlib::SimpleClientGoalState::SUCCEEDED) &&
+          robot_event(follower_id, final_project::RobotEvent::GoalReached)) {
+        follower_lookahead.disarm();
+        follower_retry.succeeded(psi.current_follower_target);
+        follower_deadline = ros::Time();
+        mission_metrics.follower_goal.record((ros::Time::now() - follower_goal_sent_at).toSec());
+        ROS_INFO_STREAM("Follower " << (passed ? "passes" : "reached") << " goal # " << psi.current_follower_target);
+        // Check if all targets locations are reached by follower.
+        if (mission_state.in(follower_id, final_project::RobotState::Home)){
+          ROS_INFO_STREAM("PROJECT FINISHED!!!");
+          finish_mission();
+        }
+      }
+    }
+    // Check if aruco marker needs to be detected.
+    if (mission_state.in(explorer_id, final_project::RobotState::Looking)){
+      bool localized = false;
+      listen(localizer, tuning.get().association_radius, localized);
+      // Check if marker is found and localized, the next goal is sent on the next iteration.
+      if (localized){
+        mission_metrics.rotation.record((ros::Time::now() - looking_since).toSec());
+        robot_event(explorer_id, final_project::RobotEvent::MarkerLocalized);
+      }
+    }
+    // Check if the markers seen on the way make the current lookup unnecessary.
+    else if (scan_while_driving && mission_state.in(explorer_id, final_project::RobotState::Driving)){
+      if (scan_in_transit(localizer, tuning.get().association_radius)){
+        // The next goal preempts the current one.
+        robot_event(explorer_id, final_project::RobotEvent::MarkerLocalized);
+      }
+    }
+    if (tuning.get().loop_rate != loop_hz) {
+      loop_hz = tuning.get().loop_rate;
+      loop_rate = ros::Rate(loop_hz);
+    }
+    loop_rate.sleep();
+  }
+  return 0;
+}
+
+/*                                      REPLAY                                              */
+
+/**
+ * @brief Struct holding the topics and localizer of one explorer of a replayed bag.
+ * 
+ */
+struct replay_explorer {
+  // Members 'fiducial_topic' and 'odom_topic' contain the topics of the explorer recorded in the bag.
+  std::string fiducial_topic;
+  std::string odom_topic;
+  // Member 'localizer' localizes the markers detected by the camera of the explorer.
+  std::unique_ptr<final_project::MarkerLocalizer> localizer;
+  // Member 'last' contains the last odometry position, 'has_last' is raised once there is one.
+  double last_x = 0;
+  double last_y = 0;
+  bool has_last = false;
+};
+
+final_project::ReplayResult final_project::Mission::Impl::replay_bag(ros::NodeHandle &pnh, const std::string &path)
+{
+  final_project::ReplayResult result;
+  rosbag::Bag bag;
+  try {
+    bag.open(path, rosbag::bagmode::Read);
+  } catch (const rosbag::BagException &e) {
+    ROS_ERROR_STREAM("Could not open " << path << ": " << e.what());
+    return result;
+  }
+  result.opened = true;
+
+  // Start from a clean state, with the tuning of the mission.
+  psi = program_status_indicator();
+  target_registry.clear();
+  detector_gates.clear();
+  mission_metrics.reset();
+  hot_path_allocations.store(0);
+  telemetry_period = 0;
+  pnh.param("detector/ignore_localized", ignore_localized_markers, true);
+  mission_tuning replay_tuning;
+  get_fusion_params(pnh, replay_tuning.fusion);
+  get_detection_weighting(pnh, replay_tuning.weighting);
+  tuning.publish(replay_tuning);
+  tuning.reclaim();
+  marker_fusion = final_project::PoseFusion(replay_tuning.fusion);
+  reserve_markers(pnh);
+  pnh.param("marker/offset", follower_standoff, 0.4);
+  // A detection is localized once the bag has played this far past its stamp, so that the transforms recorded
+  // just after the image are in the buffer, as they would be after the live TF lookup timeout.
+  double tf_delay = 0.2;
+  pnh.param("replay/tf_delay", tf_delay, tf_delay);
+
+  // The buffer is filled from the bag only, no listener thread waits on it, so lookups never block.
+  tf2_ros::Buffer buffer;
+  buffer.setUsingDedicatedThread(true);
+  std::vector<std::string> topics{"/tf", "/tf_static"};
+  std::deque<replay_explorer> explorers;
+  get_fleet(pnh, fleet);
+  for (const final_project::RobotSpec& spec : fleet) {
+    if (spec.role != final_project::RobotRole::Explorer) {
+      continue;
+    }
+    explorers.emplace_back();
+    replay_explorer& explorer = explorers.back();
+    explorer.fiducial_topic = spec.fiducial_topic;
+    explorer.odom_topic = "/" + spec.name + "/odom";
+    explorer.localizer.reset(new final_project::MarkerLocalizer(buffer, "map", spec.camera_frame, follower_standoff));
+    topics.push_back(explorer.fiducial_topic);
+    topics.push_back(explorer.odom_topic);
+  }
+
+  // Detections waiting for the bag to play past their stamp, in the order they were recorded.
+  std::deque<marker_detection> pending;
+  // Time from the first detection to the convergence of each marker, indexed through 'converged_index'.
+  final_project::FlatIndexMap converged_index;
+  std::vector<double> converged_after;
+  ros::Time first;
+  const auto localize_pending = [&](const ros::Time &until) {
+    stable_markers stable;
+    while (!pending.empty() && (until.isZero() || pending.front().stamp + ros::Duration(tf_delay) <= until)) {
+      const marker_detection& detection = pending.front();
+      const std::size_t count = listen_at(*explorers[detection.robot].localizer, detection, ros::Duration(0), stable,
+                                          nullptr);
+      for (std::size_t i = 0; i < count; i++) {
+        int index = converged_index.find(stable[i]);
+        if (index < 0) {
+          index = static_cast<int>(converged_after.size());
+          converged_index.insert(stable[i], index);
+          converged_after.push_back(0.0);
+        }
+        converged_after[index] = (detection.stamp - first).toSec();
+      }
+      pending.pop_front();
+    }
+  };
+
+  const ros::WallTime start = ros::WallTime::now();
+  rosbag::View view(bag, rosbag::TopicQuery(topics));
+  ros::Time last;
+  for (const rosbag::MessageInstance& message : view) {
+    const ros::Time time = message.getTime();
+    if (first.isZero()) {
+      first = time;
+    }
+    last = time;
+    result.messages++;
+    const std::string& topic = message.getTopic();
+    if (topic == "/tf" || topic == "/tf_static") {
+      const tf2_msgs::TFMessage::ConstPtr tf = message.instantiate<tf2_msgs::TFMessage>();
+      if (tf) {
+        for (const geometry_msgs::TransformStamped& transform : tf->transforms) {
+          buffer.setTransform(transform, "bag", topic == "/tf_static");
+        }
+      }
+    }
+    for (std::size_t i = 0; i < explorers.size(); i++) {
+      replay_explorer& explorer = explorers[i];
+      if (topic == explorer.fiducial_topic) {
+        const fiducial_msgs::FiducialTransformArray::ConstPtr msg =
+            message.instantiate<fiducial_msgs::FiducialTransformArray>();
+        if (!msg || msg->transforms.empty()) {
+          continue;
+        }
+        marker_detection detection;
+        detection.robot = static_cast<int>(i);
+        detection.stamp = msg->header.stamp.isZero() ? time : msg->header.stamp;
+        detection.queued = ros::WallTime::now();
+        add_observations(*msg, detection);
+        pending.push_back(detection);
+        result.detections++;
+      } else if (topic == explorer.odom_topic) {
+        const nav_msgs::Odometry::ConstPtr odom = message.instantiate<nav_msgs::Odometry>();
+        if (!odom) {
+          continue;
+        }
+        const double x = odom->pose.pose.position.x;
+        const double y = odom->pose.pose.position.y;
+        if (explorer.has_last) {
+          result.explorer_distance += std::hypot(x - explorer.last_x, y - explorer.last_y);
+        }
+        explorer.last_x = x;
+        explorer.last_y = y;
+        explorer.has_last = true;
+      }
+    }
+    localize_pending(time);
+  }
+  // The detections at the end of the bag get every transform there is.
+  localize_pending(ros::Time());
+  result.wall_time = (ros::WallTime::now() - start).toSec();
+  result.bag_duration = first.isZero() ? 0.0 : (last - first).toSec();
+  bag.close();
+
+  for (const int fiducial_id : marker_fusion.fiducial_ids()) {
+    final_project::Se2Estimate estimate;
+    if (!marker_fusion.estimate(fiducial_id, estimate) || estimate.samples == 0) {
+      continue;
+    }
+    final_project::ReplayMarker marker;
+    marker.fiducial_id = fiducial_id;
+    marker.x = estimate.x;
+    marker.y = estimate.y;
+    marker.yaw = estimate.yaw;
+    marker.std_error = estimate.effective_samples > 0 ?
+        std::sqrt((estimate.cov_xx + estimate.cov_yy) / estimate.effective_samples) : 0.0;
+    marker.yaw_std = estimate.yaw_std;
+    marker.samples = estimate.samples;
+    marker.rejected = estimate.rejected;
+    const int converged = converged_index.find(fiducial_id);
+    if (converged >= 0) {
+      marker.converged_after = converged_after[converged];
+    }
+    result.markers.push_back(marker);
+  }
+  std::sort(result.markers.begin(), result.markers.end(),
+            [](const final_project::ReplayMarker& a, const final_project::ReplayMarker& b) {
+              return a.fiducial_id < b.fiducial_id;
+            });
+  result.localized = static_cast<std::size_t>(mission_metrics.tf_lookup.snapshot().count);
+  result.stages = stage_snapshots();
+  return result;
+}
+
+/*                                      FUNCTION DEFINITIONS                                     */
+
+void get_explorer_targets(ros::NodeHandle &nh, final_project::TargetRegistry& registry){
+  registry.clear();
+  for (const std::array<double, 2>& target : final_project::read_lookup_locations(nh)){
+    registry.add_target(target[0], target[1]);
+  }
+}
+
+void get_fleet(ros::NodeHandle &pnh, std::vector<final_project::RobotSpec>& robots){
+  XmlRpc::XmlRpcValue list;
+  if (!pnh.getParam("fleet", list)){
+    robots = final_project::default_fleet();
+    return;
+  }
+  robots.clear();
+  if (list.getType() != XmlRpc::XmlRpcValue::TypeArray){
+    ROS_WARN("Ignoring ~fleet, it is not a list");
+    robots = final_project::default_fleet();
+    return;
+  }
+  for (int i = 0; i < list.size(); i++){
+    XmlRpc::XmlRpcValue& entry = list[i];
+    std::array<double, 2> home{{0, 0}};
+    if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("name") || !entry.hasMember("role") ||
+        entry["name"].getType() != XmlRpc::XmlRpcValue::TypeString ||
+        entry["role"].getType() != XmlRpc::XmlRpcValue::TypeString ||
+        !entry.hasMember("home") || !final_project::xmlrpc_point(entry["home"], home)){
+      ROS_WARN_STREAM("Ignoring ~fleet entry " << i << ", it needs a name, a role and a home [x, y]");
+      continue;
+    }
+    const std::string role = entry["role"];
+    if (role != "explorer" && role != "follower"){
+      ROS_WARN_STREAM("Ignoring ~fleet entry " << i << ", its role is neither explorer nor follower");
+      continue;
+    }
+    final_project::RobotSpec robot = final_project::make_robot_spec(
+        entry["name"], role == "explorer" ? final_project::RobotRole::Explorer : final_project::RobotRole::Follower,
+        home[0], home[1]);
+    // Robots spawned some other way can override every name.
+    const std::pair<const char*, std::string*> names[] = {
+        {"move_base_action", &robot.move_base_action}, {"planner", &robot.planner}, {"cmd_vel", &robot.cmd_vel},
+        {"base_frame", &robot.base_frame}, {"camera_frame", &robot.camera_frame},
+        {"fiducial_topic", &robot.fiducial_topic}, {"detector", &robot.detector}};
+    for (const auto& name : names){
+      if (entry.hasMember(name.first) && entry[name.first].getType() == XmlRpc::XmlRpcValue::TypeString){
+        *name.second = static_cast<std::string>(entry[name.first]);
+      }
+    }
+    robots.push_back(robot);
+  }
+}
+
+std::array<double, 2> final_project::Mission::Impl::explorer_waypoint(int target){
+  if (target >= explorer_home_target()){
+    return {{explorer_robot.home_x, explorer_robot.home_y}};
+  }
+  return {{target_registry.target(target).x, target_registry.target(target).y}};
+}
+
+int final_project::Mission::Impl::explorer_home_target(){
+  return static_cast<int>(target_registry.target_count());
+}
+
+std::array<double, 2> final_project::Mission::Impl::follower_waypoint(int location){
+  if (location == follower_home_location){
+    return {{follower_robot.home_x, follower_robot.home_y}};
+  }
+  return {{target_registry.marker(location).x, target_registry.marker(location).y}};
+}
+
+void get_fusion_params(ros::NodeHandle &pnh, final_project::PoseFusion::Params& params){
+  int min_samples = static_cast<int>(params.min_samples);
+  pnh.param("fusion/min_samples", min_samples, min_samples);
+  params.min_samples = static_cast<std::uint32_t>(std::max(min_samples, 1));
+  pnh.param("fusion/gate_sigma", params.gate_sigma, params.gate_sigma);
+  pnh.param("fusion/min_sigma", params.min_sigma, params.min_sigma);
+  pnh.param("fusion/max_yaw_error", params.max_yaw_error, params.max_yaw_error);
+  pnh.param("fusion/converged_std_error", params.converged_std_error, params.converged_std_error);
+  pnh.param("fusion/converged_yaw_std", params.converged_yaw_std, params.converged_yaw_std);
+  int reset_after_rejects = static_cast<int>(params.reset_after_rejects);
+  pnh.param("fusion/reset_after_rejects", reset_after_rejects, reset_after_rejects);
+  params.reset_after_rejects = static_cast<std::uint32_t>(std::max(reset_after_rejects, 1));
+}
+
+void final_project::Mission::Impl::reserve_markers(ros::NodeHandle &pnh){
+  // Markers beyond this many still fuse, their first detection allocates.
+  int max_markers = 64;
+  pnh.param("fusion/max_markers", max_markers, max_markers);
+  const std::size_t markers = static_cast<std::size_t>(std::max(max_markers, 1));
+  marker_fusion.reserve(markers);
+  target_registry.reserve_markers(markers);
+}
+
+void get_detection_weighting(ros::NodeHandle &pnh, final_project::DetectionWeighting& weighting){
+  pnh.param("fusion/image_error_scale", weighting.image_error_scale, weighting.image_error_scale);
+  pnh.param("fusion/object_error_scale", weighting.object_error_scale, weighting.object_error_scale);
+  pnh.param("fusion/min_weight", weighting.min_weight, weighting.min_weight);
+  // Non-positive scales would make every weight 0 or negative.
+  weighting.image_error_scale = std::max(weighting.image_error_scale, 1e-6);
+  weighting.object_error_scale = std::max(weighting.object_error_scale, 1e-6);
+  weighting.min_weight = std::min(std::max(weighting.min_weight, 1e-6), 1.0);
+}
+
+void get_rotation_params(ros::NodeHandle &pnh, final_project::RotationSearch::Params& params){
+  pnh.param("rotation/fast_rate", params.fast_rate, params.fast_rate);
+  pnh.param("rotation/slow_rate", params.slow_rate, params.slow_rate);
+  pnh.param("rotation/slow_zone", params.slow_zone, params.slow_zone);
+  pnh.param("rotation/detection_hold", params.detection_hold, params.detection_hold);
+  pnh.param("rotation/bearing_range", params.bearing_range, params.bearing_range);
+}
+
+void get_refiner_params(ros::NodeHandle &pnh, final_project::GoalRefiner::Params& params){
+  pnh.param("refine/search_radius", params.search_radius, params.search_radius);
+  pnh.param("refine/max_cost", params.max_cost, params.max_cost);
+  pnh.param("refine/lethal_cost", params.lethal_cost, params.lethal_cost);
+  pnh.param("refine/cost_weight", params.cost_weight, params.cost_weight);
+  pnh.param("refine/min_marker_distance", params.min_marker_distance, params.min_marker_distance);
+  pnh.param("refine/max_marker_distance", params.max_marker_distance, params.max_marker_distance);
+}
+
+void get_retry_params(ros::NodeHandle &pnh, final_project::GoalRetryPolicy::Params& params){
+  pnh.param("retry/max_retries", params.max_retries, params.max_retries);
+  pnh.param("retry/max_deferrals", params.max_deferrals, params.max_deferrals);
+  pnh.param("retry/perturbation", params.perturbation, params.perturbation);
+  pnh.param("retry/speed", params.speed, params.speed);
+  pnh.param("retry/deadline_factor", params.deadline_factor, params.deadline_factor);
+  pnh.param("retry/min_deadline", params.min_deadline, params.min_deadline);
+}
+
+void final_project::Mission::Impl::start_rotation_search(final_project::RotationSearch& search,
+                                                         const tf2_ros::Buffer& tfBuffer,
+                                                         const nav_msgs::OccupancyGrid::ConstPtr& map,
+                                                         const std::array<double, 2>& target,
+                                                         const std::string& base_frame){
+  search.set_params(tuning.get().rotation);
+  double robot_yaw = 0;
+  bool has_yaw = false;
+  try {
+    auto map_to_base = tfBuffer.lookupTransform("map", base_frame, ros::Time(0));
+    robot_yaw = tf2::getYaw(map_to_base.transform.rotation);
+    has_yaw = true;
+  } catch (tf2::TransformException &ex) {
+    ROS_WARN("%s", ex.what());
+  }
+  double bearing = 0;
+  bool has_bearing = false;
+  if (map && has_yaw) {
+    final_project::GridView grid;
+    grid.data = map->data.data();
+    grid.width = static_cast<int>(map->info.width);
+    grid.height = static_cast<int>(map->info.height);
+    grid.resolution = map->info.resolution;
+    grid.origin_x = map->info.origin.position.x;
+    grid.origin_y = map->info.origin.position.y;
+    has_bearing = final_project::nearest_obstacle_bearing(grid, target[0], target[1], search.params().bearing_range, bearing);
+  }
+  if (has_bearing) {
+    ROS_INFO_STREAM("Looking for the marker around bearing " << bearing << " rad, explorer at " << robot_yaw << " rad");
+  }
+  search.start(ros::Time::now().toSec(), robot_yaw, has_bearing, bearing);
+}
+
+void final_project::Mission::Impl::next_explorer_goal(move_base_msgs::MoveBaseGoal& explorer_goal){
+  psi.explorer_route_step += 1;
+  psi.current_explorer_target = explorer_route[psi.explorer_route_step];
+  // Skip the targets whose marker was already localized in transit.
+  while (psi.current_explorer_target < explorer_home_target() && target_registry.target_done(psi.current_explorer_target)) {
+    ROS_INFO_STREAM("Skipping goal # " << psi.current_explorer_target << ", its marker is already localized");
+    psi.explorer_route_step += 1;
+    psi.current_explorer_target = explorer_route[psi.explorer_route_step];
+  }
+  set_explorer_goal(explorer_goal, psi.current_explorer_target);
+}
+
+void final_project::Mission::Impl::set_explorer_goal(move_base_msgs::MoveBaseGoal& explorer_goal, int target){
+  explorer_goal.target_pose.header.frame_id = "map";
+  explorer_goal.target_pose.header.stamp = ros::Time::now();
+  const std::array<double, 2> location = explorer_waypoint(target);
+  explorer_goal.target_pose.pose.position.x = location[0];
+  explorer_goal.target_pose.pose.position.y = location[1];
+  explorer_goal.target_pose.pose.orientation.w = 1.0;
+}
+
+void final_project::Mission::Impl::defer_explorer_target(){
+  // The route ends with home, which is never deferred.
+  explorer_route.erase(explorer_route.begin() + psi.explorer_route_step);
+  explorer_route.insert(explorer_route.end() - 1, psi.current_explorer_target);
+  psi.explorer_route_step -= 1;
+}
+
+void final_project::Mission::Impl::next_follower_goal(move_base_msgs::MoveBaseGoal& follower_goal,
+                                                      const final_project::GoalRefiner* refiner){
+  set_follower_goal_at(follower_goal, next_follower_location(), refiner, nullptr);
+}
+
+int final_project::Mission::Impl::next_follower_location(){
+  psi.follower_route_step += 1;
+  psi.current_follower_target = follower_route[psi.follower_route_step];
+  return psi.current_follower_target;
+}
+
+void final_project::Mission::Impl::defer_follower_location(){
+  // The route ends with home, which is never deferred.
+  follower_route.erase(follower_route.begin() + psi.follower_route_step);
+  follower_route.insert(follower_route.end() - 1, psi.current_follower_target);
+  psi.follower_route_step -= 1;
+}
+
+std::vector<double> final_project::Mission::Impl::travel_costs(ros::ServiceClient* planner,
+                                                               const std::vector<std::array<double, 2>>& points){
+  const std::size_t n = points.size();
+  std::vector<double> cost(n * n, 0.0);
+  for (std::size_t i = 0; i < n; i++){
+    for (std::size_t j = i + 1; j < n; j++){
+      double length = std::hypot(points[j][0] - points[i][0], points[j][1] - points[i][1]);
+      nav_msgs::GetPlan plan;
+      plan.request.start.header.frame_id = "map";
+      plan.request.start.pose.position.x = points[i][0];
+      plan.request.start.pose.position.y = points[i][1];
+      plan.request.start.pose.orientation.w = 1.0;
+      plan.request.goal = plan.request.start;
+      plan.request.goal.pose.position.x = points[j][0];
+      plan.request.goal.pose.position.y = points[j][1];
+      plan.request.tolerance = 0.2;
+      if (planner && planner->call(plan) && plan.response.plan.poses.size() > 1){
+        const auto& poses = plan.response.plan.poses;
+        length = 0;
+        for (std::size_t k = 1; k < poses.size(); k++){
+          length += std::hypot(poses[k].pose.position.x - poses[k - 1].pose.position.x,
+                               poses[k].pose.position.y - poses[k - 1].pose.position.y);
+        }
+      }
+      else if (!planner){
+        const double field_length = field_path_length(points[i], points[j]);
+        if (std::isfinite(field_length)){
+          length = field_length;
+        }
+      }
+      // Paths are assumed symmetric, which holds for the static map.
+      cost[i * n + j] = length;
+      cost[j * n + i] = length;
+    }
+  }
+  return cost;
+}
+
+std::string ros_home_dir(){
+  const char* ros_home = std::getenv("ROS_HOME");
+  const char* home = std::getenv("HOME");
+  return ros_home ? std::string(ros_home) : std::string(home ? home : "/tmp") + "/.ros";
+}
+
+std::string map_yaml_path(ros::NodeHandle &pnh){
+  std::string map_yaml;
+  pnh.param<std::string>("map_yaml", map_yaml, ros::package::getPath("final_project") + "/maps/final_world.yaml");
+  return map_yaml;
+}
+
+void final_project::Mission::Impl::load_distance_fields(ros::NodeHandle &pnh){
+  const std::string map_yaml = map_yaml_path(pnh);
+  std::string cache_path;
+  pnh.param<std::string>("distance_field/cache", cache_path, ros_home_dir() + "/final_project_distance_fields.bin");
+  double inflation = 0.2;
+  pnh.param("distance_field/inflation", inflation, inflation);
+
+  std::string error;
+  if (!final_project::OccupancyBitmap::load(map_yaml, static_map, &error)){
+    ROS_WARN_STREAM("No distance fields, " << error);
+    return;
+  }
+  static_map.inflate(inflation);
+  // Sources are the explorer targets, then the homes of the fleet.
+  std::vector<std::array<double, 2>> sources = target_registry.target_points();
+  for (const final_project::RobotSpec& robot : fleet){
+    sources.push_back({{robot.home_x, robot.home_y}});
+  }
+  const ros::WallTime start = ros::WallTime::now();
+  if (!distance_fields.open(cache_path, static_map, sources, &error)){
+    ROS_WARN_STREAM("No distance fields, " << error);
+    return;
+  }
+  if (!error.empty()){
+    ROS_WARN_STREAM(error);
+  }
+  ROS_INFO_STREAM((distance_fields.loaded_from_cache() ? "Mapped " : "Computed ") << sources.size()
+                  << " distance fields in " << (ros::WallTime::now() - start).toSec() * 1000 << " ms");
+}
+
+void final_project::Mission::Impl::load_marker_cache(ros::NodeHandle &pnh, double radius){
+  cached_markers.clear();
+  marker_cache_path.clear();
+  bool enabled = true;
+  pnh.param("cache/enabled", enabled, true);
+  if (!enabled){
+    return;
+  }
+  std::string path;
+  pnh.param<std::string>("cache/path", path, ros_home_dir() + "/final_project_markers.bin");
+  final_project::MarkerCacheFreshness freshness;
+  pnh.param("cache/max_age", freshness.max_age, freshness.max_age);
+  pnh.param("cache/max_std_error", freshness.max_std_error, freshness.max_std_error);
+
+  // Markers localized in another map are not trusted, the map file identifies it.
+  final_project::OccupancyBitmap map;
+  std::string error;
+  if (!final_project::OccupancyBitmap::load(map_yaml_path(pnh), map, &error)){
+    ROS_WARN_STREAM("No marker cache, " << error);
+    return;
+  }
+  marker_cache_path = path;
+  marker_cache_map = map.checksum();
+  std::vector<final_project::CachedMarker> markers;
+  if (!final_project::read_marker_cache(marker_cache_path, marker_cache_map, markers, &error)){
+    ROS_INFO_STREAM("Exploring every target, " << error);
+    return;
+  }
+  const double now = ros::WallTime::now().toSec();
+  for (const final_project::CachedMarker& marker : markers){
+    if (!final_project::marker_cache_trusted(marker, now, freshness)){
+      ROS_INFO_STREAM("Cached marker " << marker.fiducial_id << " is stale or imprecise, it is localized again");
+      continue;
+    }
+    marker_fusion.restore(final_project::to_estimate(marker));
+    // The fusion may have been tuned stricter since the marker was cached.
+    if (!marker_fusion.converged(marker.fiducial_id)){
+      marker_fusion.reset(marker.fiducial_id);
+      ROS_INFO_STREAM("Cached marker " << marker.fiducial_id << " is not stable enough, it is localized again");
+      continue;
+    }
+    target_registry.update_marker(marker.fiducial_id, marker.x, marker.y, marker.yaw);
+    const int target = nearest_free_target(marker.x, marker.y, radius);
+    if (target >= 0){
+      localize_target(target, marker.fiducial_id);
+    }
+    cached_markers.push_back(marker);
+    ROS_INFO_STREAM("Marker " << marker.fiducial_id << " at [" << marker.x << "," << marker.y << "] from the cache, "
+                    << (target >= 0 ? "target " + std::to_string(target) + " needs no lookup" : "at no target"));
+  }
+}
+
+void final_project::Mission::Impl::save_marker_cache(){
+  if (marker_cache_path.empty()){
+    return;
+  }
+  const double now = ros::WallTime::now().toSec();
+  std::vector<final_project::CachedMarker> markers;
+  for (int fiducial_id : marker_fusion.fiducial_ids()){
+    final_project::Se2Estimate estimate;
+    if (!marker_fusion.estimate(fiducial_id, estimate) || !estimate.converged){
+      continue;
+    }
+    // Markers taken from the cache keep the time they were last looked at, so they age.
+    double localized_at = now;
+    for (const final_project::CachedMarker& cached : cached_markers){
+      if (cached.fiducial_id == fiducial_id){
+        localized_at = cached.localized_at;
+      }
+    }
+    markers.push_back(final_project::to_cached_marker(estimate, localized_at));
+  }
+  std::string error;
+  if (!final_project::write_marker_cache(marker_cache_path, marker_cache_map, markers, &error)){
+    ROS_WARN_STREAM(error);
+    return;
+  }
+  ROS_INFO_STREAM("Cached " << markers.size() << " markers in " << marker_cache_path);
+}
+
+void final_project::Mission::Impl::ignore_cached_markers(){
+  if (!ignore_localized_markers){
+    return;
+  }
+  for (const auto &gate : detector_gates){
+    for (const final_project::CachedMarker& marker : cached_markers){
+      gate->ignore(marker.fiducial_id);
+    }
+  }
+}
+
+void final_project::Mission::Impl::plan_explorer_route(ros::ServiceClient* planner, bool optimize){
+  // The explorer starts and finishes at its home position, one past the last target.
+  const int home = explorer_home_target();
+  explorer_route.clear();
+  for (int i = 0; i <= home; i++){
+    explorer_route.push_back(i);
+  }
+  if (!optimize){
+    return;
+  }
+  std::vector<std::array<double, 2>> points = target_registry.target_points();
+  points.push_back(explorer_waypoint(home));
+  const std::vector<double> cost = travel_costs(planner, points);
+  explorer_route = final_project::plan_route(cost, static_cast<int>(points.size()), home, home);
+  std::ostringstream order;
+  for (int target : explorer_route){
+    order << " " << target;
+  }
+  ROS_INFO_STREAM("Explorer route:" << order.str() << " ("
+                  << final_project::route_cost(cost, static_cast<int>(points.size()), home, explorer_route) << " m)");
+}
+
+void final_project::Mission::Impl::plan_follower_route(ros::ServiceClient* planner, bool optimize){
+  // Nodes are the follower locations of the localized markers, then the home position of the follower.
+  std::vector<int> locations;
+  final_project::Se2Estimate estimate;
+  for (int i = 0; i < static_cast<int>(target_registry.marker_count()); i++){
+    if (marker_fusion.estimate(target_registry.marker(i).fiducial_id, estimate)){
+      locations.push_back(i);
+    }
+  }
+  locations.push_back(follower_home_location);
+  if (!optimize){
+    follower_route = locations;
+    return;
+  }
+  std::vector<std::array<double, 2>> points;
+  for (int location : locations){
+    points.push_back(follower_waypoint(location));
+  }
+  const std::vector<double> cost = travel_costs(planner, points);
+  const int home = static_cast<int>(locations.size()) - 1;
+  const std::vector<int> nodes = final_project::plan_route(cost, static_cast<int>(points.size()), home, home);
+  follower_route.clear();
+  std::ostringstream order;
+  for (int node : nodes){
+    follower_route.push_back(locations[node]);
+    order << " " << locations[node];
+  }
+  ROS_INFO_STREAM("Follower route:" << order.str() << " ("
+                  << final_project::route_cost(cost, static_cast<int>(points.size()), home, nodes) << " m)");
+}
+
+void set_follower_goal(move_base_msgs::MoveBaseGoal& follower_goal, const std::array<double, 2>& location){
+  follower_goal.target_pose.header.frame_id = "map";
+  follower_goal.target_pose.header.stamp = ros::Time::now();
+  follower_goal.target_pose.pose.position.x = location[0];
+  follower_goal.target_pose.pose.position.y = location[1];
+  follower_goal.target_pose.pose.orientation.w = 1.0;
+}
+
+std::unique_lock<std::mutex> lock_registry(std::mutex* mutex){
+  return mutex ? std::unique_lock<std::mutex>(*mutex) : std::unique_lock<std::mutex>();
+}
+
+void final_project::Mission::Impl::set_marker_goal(move_base_msgs::MoveBaseGoal& follower_goal, int marker,
+                                                   const final_project::GoalRefiner* refiner,
+                                                   std::mutex* registry_mutex){
+  // A copy, the costmap search runs without the lock.
+  final_project::MarkerLocation location;
+  {
+    const std::unique_lock<std::mutex> lock = lock_registry(registry_mutex);
+    location = target_registry.marker(marker);
+  }
+  final_project::RefinedGoal goal;
+  goal.x = location.x;
+  goal.y = location.y;
+  goal.yaw = location.yaw;
+  if (refine_follower_goals && refiner){
+    // The marker is straight ahead of its follower location.
+    const double marker_x = location.x + follower_standoff * std::cos(location.yaw);
+    const double marker_y = location.y + follower_standoff * std::sin(location.yaw);
+    if (!refiner->refine(location.x, location.y, marker_x, marker_y, goal)){
+      goal.yaw = location.yaw;
+      ROS_WARN_STREAM("No free spot in the costmap near marker " << location.fiducial_id
+                      << ", the follower goes to its nominal location");
+    } else if (goal.moved){
+      ROS_INFO_STREAM("Follower goal of marker " << location.fiducial_id << " moved by "
+                      << std::hypot(goal.x - location.x, goal.y - location.y) << " m to a cell of cost " << goal.cost);
+    }
+  }
+  set_follower_goal(follower_goal, {{goal.x, goal.y}});
+  tf2::Quaternion orientation;
+  orientation.setRPY(0, 0, goal.yaw);
+  follower_goal.target_pose.pose.orientation = tf2::toMsg(orientation);
+}
+
+void final_project::Mission::Impl::set_follower_goal_at(move_base_msgs::MoveBaseGoal& follower_goal, int location,
+                                                        const final_project::GoalRefiner* refiner,
+                                                        std::mutex* registry_mutex){
+  if (location == follower_home_location){
+    set_follower_goal(follower_goal, follower_waypoint(location));
+    return;
+  }
+  set_marker_goal(follower_goal, location, refiner, registry_mutex);
+}
+
+void final_project::Mission::Impl::explorer_summary(){
+  ROS_INFO_STREAM("=============");
+  for (std::size_t i = 0; i < target_registry.marker_count(); i++){
+    const final_project::MarkerLocation& marker = target_registry.marker(static_cast<int>(i));
+    ROS_INFO_STREAM("follower goals: " << marker.fiducial_id << "  " 
+                                       << marker.x << "  "
+                                       << marker.y << "  ");
+  }
+  ROS_INFO_STREAM("=============");
+  ROS_INFO_STREAM("Stage durations:\n" << mission_metrics.report());
+  if (final_project::allocations_counted()) {
+    ROS_INFO_STREAM(hot_path_allocations.load() << " allocations in the detection path");
+  }
+}
+
+bool final_project::Mission::Impl::wait_for_startup(ros::NodeHandle &nh, double timeout,
+                                                    const std::vector<final_project::RobotSpec>& robots,
+                                                    const std::vector<MoveBaseClient*>& clients,
+                                                    const tf2_ros::Buffer& tfBuffer,
+                                                    nav_msgs::OccupancyGrid::ConstPtr& map){
+  final_project::StartupReadiness readiness;
+  // The subscriptions below are served by the polling loop, or by the nodelet manager on its own threads.
+  std::vector<ros::Subscriber> subscribers;
+  std::deque<std::atomic<bool>> detected;
+  for (std::size_t i = 0; i < robots.size(); i++){
+    MoveBaseClient* client = clients[i];
+    readiness.add("move_base " + robots[i].move_base_action, [client]() { return client->isServerConnected(); }, true);
+    const std::string base_frame = robots[i].base_frame;
+    readiness.add("tf map -> " + base_frame, [&tfBuffer, base_frame]() {
+      return tfBuffer.canTransform("map", base_frame, ros::Time(0));
+    }, false);
+    if (robots[i].role == final_project::RobotRole::Explorer){
+      detected.emplace_back(false);
+      std::atomic<bool>* seen = &detected.back();
+      subscribers.push_back(nh.subscribe<fiducial_msgs::FiducialTransformArray>(robots[i].fiducial_topic, 1,
+          [seen](const fiducial_msgs::FiducialTransformArray::ConstPtr &) { seen->store(true); }));
+      readiness.add("detector " + robots[i].fiducial_topic, [seen]() { return seen->load(); }, false);
+    }
+  }
+  std::mutex received_mutex;
+  nav_msgs::OccupancyGrid::ConstPtr received;
+  subscribers.push_back(nh.subscribe<nav_msgs::OccupancyGrid>("/map", 1,
+      [&received, &received_mutex](const nav_msgs::OccupancyGrid::ConstPtr &msg) {
+        std::lock_guard<std::mutex> lock(received_mutex);
+        received = msg;
+      }));
+  readiness.add("static map /map", [&received, &received_mutex]() {
+    std::lock_guard<std::mutex> lock(received_mutex);
+    return static_cast<bool>(received);
+  }, false);
+
+  // Wall time, the simulated clock may not run yet.
+  const ros::WallTime start = ros::WallTime::now();
+  double elapsed = 0;
+  double next_progress = 5.0;
+  ros::WallRate rate(20);
+  while (mission_running()){
+    spin_mission_callbacks();
+    elapsed = (ros::WallTime::now() - start).toSec();
+    if (readiness.poll(elapsed)){
+      break;
+    }
+    // Without a deadline the optional dependencies are not waited for.
+    if (timeout > 0 ? elapsed >= timeout : readiness.required_ready()){
+      break;
+    }
+    if (elapsed >= next_progress){
+      ROS_INFO_STREAM("Waiting for the robots to come up:\n" << readiness.report());
+      next_progress += 5.0;
+    }
+    rate.sleep();
+  }
+  subscribers.clear();
+  {
+    std::lock_guard<std::mutex> lock(received_mutex);
+    map = received;
+  }
+  if (readiness.all_ready()){
+    ROS_INFO_STREAM("Startup readiness after " << elapsed << " s:\n" << readiness.report());
+  } else {
+    ROS_WARN_STREAM("Startup readiness after " << elapsed << " s:\n" << readiness.report());
+  }
+  if (!map){
+    ROS_WARN("No map received, the explorer will look for markers without an expected bearing");
+  }
+  if (!readiness.required_ready()){
+    ROS_FATAL("Some move_base server did not come up in time");
+    return false;
+  }
+  mission_start_time = ros::Time::now();
+  return true;
+}
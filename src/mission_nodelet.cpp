@@ -0,0 +1,58 @@
+/**
+ * @file mission_nodelet.cpp
+ * @brief Nodelet running the mission, so that it can share a manager with the marker detector.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+#include <thread>
+
+#include "final_project/mission.h"
+
+namespace final_project {
+
+/**
+ * @brief Nodelet running the mission on its own thread.
+ *
+ * Messages published by nodelets of the same manager, e.g. a marker detector, reach the mission as shared
+ * pointers without being serialized or copied. The callbacks of the mission are served by the manager.
+ */
+class MissionNodelet : public nodelet::Nodelet {
+ public:
+  ~MissionNodelet() override {
+    if (mission_) {
+      mission_->stop();
+    }
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+ private:
+  void onInit() override {
+    // onInit() must return promptly, the mission waits for the robots and then runs until it is over.
+    MissionHost host;
+    host.spin = false;
+    host.on_finished = [this]() { NODELET_INFO("Mission over, the nodelet stays loaded"); };
+    mission_.reset(new Mission(host));
+    thread_ = std::thread([this]() {
+      if (mission_->run(getNodeHandle(), getPrivateNodeHandle()) != 0) {
+        NODELET_ERROR("Mission could not start");
+      }
+    });
+  }
+
+  // Member 'mission_' is the mission of the nodelet, 'thread_' runs it.
+  std::unique_ptr<Mission> mission_;
+  std::thread thread_;
+};
+
+}  // namespace final_project
+
+PLUGINLIB_EXPORT_CLASS(final_project::MissionNodelet, nodelet::Nodelet)
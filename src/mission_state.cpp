@@ -0,0 +1,132 @@
+/**
+ * @file mission_state.cpp
+ * @brief States of the robots of a mission and the table of the transitions between them.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/mission_state.h"
+
+#include <algorithm>
+
+namespace final_project {
+
+namespace {
+
+// Marks the events a state does not accept.
+constexpr std::uint8_t kRejected = 0xff;
+
+constexpr std::uint8_t to_index(RobotState state) { return static_cast<std::uint8_t>(state); }
+
+constexpr std::uint8_t I = to_index(RobotState::Idle);
+constexpr std::uint8_t D = to_index(RobotState::Driving);
+constexpr std::uint8_t L = to_index(RobotState::Looking);
+constexpr std::uint8_t H = to_index(RobotState::HeadingHome);
+constexpr std::uint8_t X = kRejected;
+
+/**
+ * @brief Next state of each state for each event, one row per state and one column per event, in enum order:
+ * GoalSent, GoalReached, GoalFailed, MarkerLocalized, SentHome.
+ */
+typedef std::uint8_t TransitionTable[kRobotStates][kRobotEvents];
+
+// An explorer looks for the marker where it arrives. A marker localized on the way ends its goal, and so does a
+// failed goal, the target is left to a later detection in transit.
+constexpr TransitionTable kExplorerTable = {
+    /* Idle        */ {D, X, X, X, H},
+    /* Driving     */ {D, L, I, I, H},
+    /* Looking     */ {D, X, X, I, H},
+    /* HeadingHome */ {X, to_index(RobotState::Home), I, X, X},
+    /* Home        */ {X, X, X, X, X},
+};
+
+// A follower only drives to the localized markers, then home.
+constexpr TransitionTable kFollowerTable = {
+    /* Idle        */ {D, X, X, X, H},
+    /* Driving     */ {D, I, I, X, H},
+    /* Looking     */ {X, X, X, X, X},
+    /* HeadingHome */ {X, to_index(RobotState::Home), I, X, X},
+    /* Home        */ {X, X, X, X, X},
+};
+
+static_assert(kExplorerTable[to_index(RobotState::Driving)][static_cast<std::size_t>(RobotEvent::GoalReached)] == L,
+              "an explorer looks for the marker where it arrives");
+static_assert(kFollowerTable[to_index(RobotState::Driving)][static_cast<std::size_t>(RobotEvent::GoalReached)] == I,
+              "a follower waits for its next marker where it arrives");
+
+}  // namespace
+
+bool MissionStateMachine::next(RobotRole role, RobotState state, RobotEvent event, RobotState &next) {
+  const TransitionTable &table = role == RobotRole::Explorer ? kExplorerTable : kFollowerTable;
+  const std::uint8_t entry = table[to_index(state)][static_cast<std::size_t>(event)];
+  next = entry == kRejected ? state : static_cast<RobotState>(entry);
+  return entry != kRejected;
+}
+
+int MissionStateMachine::add_robot(RobotRole role) {
+  roles_.push_back(role);
+  states_.push_back(RobotState::Idle);
+  return static_cast<int>(states_.size()) - 1;
+}
+
+bool MissionStateMachine::dispatch(int robot, RobotEvent event, double time) {
+  RobotState to;
+  if (!next(roles_[robot], states_[robot], event, to)) {
+    return false;
+  }
+  if (log_.size() < kMaxLoggedTransitions) {
+    StateTransition transition;
+    transition.time = time;
+    transition.robot = robot;
+    transition.from = states_[robot];
+    transition.event = event;
+    transition.to = to;
+    log_.push_back(transition);
+  } else {
+    unlogged_++;
+  }
+  states_[robot] = to;
+  return true;
+}
+
+bool MissionStateMachine::busy(int robot) const {
+  const RobotState state = states_[robot];
+  return state == RobotState::Driving || state == RobotState::Looking || state == RobotState::HeadingHome;
+}
+
+std::size_t MissionStateMachine::count(RobotState state) const {
+  return static_cast<std::size_t>(std::count(states_.begin(), states_.end(), state));
+}
+
+bool MissionStateMachine::replay(const std::vector<StateTransition> &transitions) {
+  for (const StateTransition &transition : transitions) {
+    if (transition.robot < 0 || transition.robot >= static_cast<int>(states_.size()) ||
+        states_[transition.robot] != transition.from ||
+        !dispatch(transition.robot, transition.event, transition.time) || states_[transition.robot] != transition.to) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MissionStateMachine::clear() {
+  roles_.clear();
+  states_.clear();
+  log_.clear();
+  unlogged_ = 0;
+}
+
+const char *to_string(RobotState state) {
+  static const char *const names[kRobotStates] = {"Idle", "Driving", "Looking", "HeadingHome", "Home"};
+  return names[to_index(state)];
+}
+
+const char *to_string(RobotEvent event) {
+  static const char *const names[kRobotEvents] = {"GoalSent", "GoalReached", "GoalFailed", "MarkerLocalized",
+                                                   "SentHome"};
+  return names[static_cast<std::size_t>(event)];
+}
+
+}  // namespace final_project
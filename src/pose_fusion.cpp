@@ -0,0 +1,202 @@
+/**
+ * @file pose_fusion.cpp
+ * @brief Incremental per-fiducial fusion of marker pose observations in SE(2).
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/pose_fusion.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace final_project {
+
+namespace {
+
+double wrap_angle(double angle) { return std::atan2(std::sin(angle), std::cos(angle)); }
+
+}  // namespace
+
+PoseFusion::PoseFusion() : PoseFusion(Params{}) {}
+
+PoseFusion::PoseFusion(const Params &params) : params_(params) {}
+
+int PoseFusion::slot(int fiducial_id) const {
+  return slot_of_id_.find(fiducial_id);
+}
+
+int PoseFusion::add_slot(int fiducial_id) {
+  const int index = static_cast<int>(ids_.size());
+  slot_of_id_.insert(fiducial_id, index);
+  ids_.push_back(fiducial_id);
+  samples_.push_back(0);
+  rejected_.push_back(0);
+  consecutive_rejects_.push_back(0);
+  weight_sum_.push_back(0);
+  weight_sq_sum_.push_back(0);
+  mean_x_.push_back(0);
+  mean_y_.push_back(0);
+  m2_xx_.push_back(0);
+  m2_xy_.push_back(0);
+  m2_yy_.push_back(0);
+  yaw_cos_.push_back(0);
+  yaw_sin_.push_back(0);
+  return index;
+}
+
+void PoseFusion::reserve(std::size_t markers) {
+  slot_of_id_.reserve(markers);
+  ids_.reserve(markers);
+  samples_.reserve(markers);
+  rejected_.reserve(markers);
+  consecutive_rejects_.reserve(markers);
+  weight_sum_.reserve(markers);
+  weight_sq_sum_.reserve(markers);
+  mean_x_.reserve(markers);
+  mean_y_.reserve(markers);
+  m2_xx_.reserve(markers);
+  m2_xy_.reserve(markers);
+  m2_yy_.reserve(markers);
+  yaw_cos_.reserve(markers);
+  yaw_sin_.reserve(markers);
+}
+
+void PoseFusion::clear_slot(int i) {
+  samples_[i] = 0;
+  consecutive_rejects_[i] = 0;
+  weight_sum_[i] = 0;
+  weight_sq_sum_[i] = 0;
+  mean_x_[i] = 0;
+  mean_y_[i] = 0;
+  m2_xx_[i] = 0;
+  m2_xy_[i] = 0;
+  m2_yy_[i] = 0;
+  yaw_cos_[i] = 0;
+  yaw_sin_[i] = 0;
+}
+
+bool PoseFusion::add(int fiducial_id, double x, double y, double yaw, double weight) {
+  if (fiducial_id < 0 || !(weight > 0)) {
+    return false;
+  }
+  int i = slot(fiducial_id);
+  if (i < 0) {
+    i = add_slot(fiducial_id);
+  }
+
+  if (samples_[i] >= params_.min_samples) {
+    // Gate on the Mahalanobis distance to the mean, with a floor on the covariance so that a
+    // tight cluster does not reject every new observation.
+    const double floor = params_.min_sigma * params_.min_sigma;
+    const double sxx = m2_xx_[i] / weight_sum_[i] + floor;
+    const double syy = m2_yy_[i] / weight_sum_[i] + floor;
+    const double sxy = m2_xy_[i] / weight_sum_[i];
+    const double det = sxx * syy - sxy * sxy;
+    const double dx = x - mean_x_[i];
+    const double dy = y - mean_y_[i];
+    const double d2 = (syy * dx * dx - 2 * sxy * dx * dy + sxx * dy * dy) / det;
+    const double dyaw = wrap_angle(yaw - std::atan2(yaw_sin_[i], yaw_cos_[i]));
+    if (d2 > params_.gate_sigma * params_.gate_sigma || std::fabs(dyaw) > params_.max_yaw_error) {
+      ++rejected_[i];
+      if (++consecutive_rejects_[i] < params_.reset_after_rejects) {
+        return false;
+      }
+      // The estimate kept rejecting a consistent cluster, so it latched onto bad first samples.
+      clear_slot(i);
+    }
+  }
+
+  // Weighted incremental mean and covariance (West, 1979).
+  const double new_weight_sum = weight_sum_[i] + weight;
+  const double dx = x - mean_x_[i];
+  const double dy = y - mean_y_[i];
+  const double ratio = weight / new_weight_sum;
+  mean_x_[i] += ratio * dx;
+  mean_y_[i] += ratio * dy;
+  m2_xx_[i] += weight * dx * (x - mean_x_[i]);
+  m2_xy_[i] += weight * dx * (y - mean_y_[i]);
+  m2_yy_[i] += weight * dy * (y - mean_y_[i]);
+  weight_sum_[i] = new_weight_sum;
+  weight_sq_sum_[i] += weight * weight;
+  yaw_cos_[i] += weight * std::cos(yaw);
+  yaw_sin_[i] += weight * std::sin(yaw);
+  ++samples_[i];
+  consecutive_rejects_[i] = 0;
+  return true;
+}
+
+bool PoseFusion::is_converged(int i) const {
+  if (samples_[i] < params_.min_samples) {
+    return false;
+  }
+  // Standard error of the weighted mean, using the effective number of samples.
+  const double effective_samples = weight_sum_[i] * weight_sum_[i] / weight_sq_sum_[i];
+  const double variance = (m2_xx_[i] + m2_yy_[i]) / weight_sum_[i];
+  const double std_error = std::sqrt(variance / effective_samples);
+  const double resultant = std::hypot(yaw_cos_[i], yaw_sin_[i]) / weight_sum_[i];
+  const double yaw_std = std::sqrt(-2 * std::log(std::max(resultant, 1e-12)));
+  return std_error <= params_.converged_std_error && yaw_std <= params_.converged_yaw_std;
+}
+
+bool PoseFusion::estimate(int fiducial_id, Se2Estimate &estimate) const {
+  const int i = slot(fiducial_id);
+  if (i < 0 || samples_[i] == 0) {
+    return false;
+  }
+  estimate.fiducial_id = fiducial_id;
+  estimate.x = mean_x_[i];
+  estimate.y = mean_y_[i];
+  estimate.yaw = std::atan2(yaw_sin_[i], yaw_cos_[i]);
+  estimate.cov_xx = m2_xx_[i] / weight_sum_[i];
+  estimate.cov_xy = m2_xy_[i] / weight_sum_[i];
+  estimate.cov_yy = m2_yy_[i] / weight_sum_[i];
+  const double resultant = std::hypot(yaw_cos_[i], yaw_sin_[i]) / weight_sum_[i];
+  estimate.yaw_std = std::sqrt(-2 * std::log(std::max(resultant, 1e-12)));
+  estimate.samples = samples_[i];
+  estimate.effective_samples = weight_sum_[i] * weight_sum_[i] / weight_sq_sum_[i];
+  estimate.rejected = rejected_[i];
+  estimate.converged = is_converged(i);
+  return true;
+}
+
+bool PoseFusion::converged(int fiducial_id) const {
+  const int i = slot(fiducial_id);
+  return i >= 0 && is_converged(i);
+}
+
+void PoseFusion::restore(const Se2Estimate &estimate) {
+  if (estimate.fiducial_id < 0) {
+    return;
+  }
+  int i = slot(estimate.fiducial_id);
+  if (i < 0) {
+    i = add_slot(estimate.fiducial_id);
+  }
+  clear_slot(i);
+  const double weight = std::max(estimate.effective_samples, 1.0);
+  samples_[i] = std::max<std::uint32_t>(estimate.samples, 1);
+  weight_sum_[i] = weight;
+  weight_sq_sum_[i] = weight;
+  mean_x_[i] = estimate.x;
+  mean_y_[i] = estimate.y;
+  m2_xx_[i] = estimate.cov_xx * weight;
+  m2_xy_[i] = estimate.cov_xy * weight;
+  m2_yy_[i] = estimate.cov_yy * weight;
+  // The mean resultant length the circular standard deviation came from.
+  const double resultant = std::exp(-0.5 * estimate.yaw_std * estimate.yaw_std);
+  yaw_cos_[i] = weight * resultant * std::cos(estimate.yaw);
+  yaw_sin_[i] = weight * resultant * std::sin(estimate.yaw);
+}
+
+void PoseFusion::reset(int fiducial_id) {
+  const int i = slot(fiducial_id);
+  if (i >= 0) {
+    clear_slot(i);
+    rejected_[i] = 0;
+  }
+}
+
+}  // namespace final_project
@@ -0,0 +1,98 @@
+/**
+ * @file replay.cpp
+ * @brief Replays recorded bags through the marker localization and fusion of the mission, as fast as they are read.
+ * @version 0.1
+ * @date 2021-12-15
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+#include <ros/ros.h>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "final_project/mission.h"
+
+/**
+ * @brief Method to write one CSV row per marker of every bag, the timings of the bag repeated on each.
+ * 
+ * @param path File to write, replaced if it exists.
+ * @param results Bags and their replay.
+ * @return true if the file was written.
+ * @return false otherwise.
+ */
+bool write_replay_csv(const std::string &path,
+                      const std::vector<std::pair<std::string, final_project::ReplayResult>> &results)
+{
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << "bag,messages,detections,localized,bag_duration,wall_time,explorer_distance,"
+         "fiducial_id,x,y,yaw,std_error,yaw_std,samples,rejected,converged_after\n";
+  for (const auto &entry : results) {
+    const final_project::ReplayResult &result = entry.second;
+    for (const final_project::ReplayMarker &marker : result.markers) {
+      out << entry.first << ',' << result.messages << ',' << result.detections << ',' << result.localized << ','
+          << result.bag_duration << ',' << result.wall_time << ',' << result.explorer_distance << ','
+          << marker.fiducial_id << ',' << marker.x << ',' << marker.y << ',' << marker.yaw << ','
+          << marker.std_error << ',' << marker.yaw_std << ',' << marker.samples << ',' << marker.rejected << ','
+          << marker.converged_after << '\n';
+    }
+  }
+  return static_cast<bool>(out);
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "final_project_replay");
+  // The localization reads its tuning from the private namespace of the replay, e.g. ~fusion/gate_sigma.
+  ros::NodeHandle pnh("~");
+
+  // Bags to replay, from ~replay/bags then the command line.
+  std::vector<std::string> bags;
+  pnh.param("replay/bags", bags, bags);
+  for (int i = 1; i < argc; i++) {
+    bags.emplace_back(argv[i]);
+  }
+  std::string csv_path;
+  pnh.param<std::string>("replay/csv", csv_path, "final_project_replay.csv");
+  if (bags.empty()) {
+    ROS_FATAL("No bag to replay, pass them on the command line or in ~replay/bags");
+    return 1;
+  }
+
+  std::vector<std::pair<std::string, final_project::ReplayResult>> results;
+  double wall_time = 0;
+  double bag_time = 0;
+  for (std::size_t i = 0; i < bags.size() && ros::ok(); i++) {
+    // Every bag is fused from scratch.
+    final_project::Mission mission;
+    const final_project::ReplayResult result = mission.replay_bag(pnh, bags[i]);
+    if (!result.opened) {
+      continue;
+    }
+    wall_time += result.wall_time;
+    bag_time += result.bag_duration;
+    const double speedup = result.wall_time > 0 ? result.bag_duration / result.wall_time : 0.0;
+    ROS_INFO_STREAM("Bag " << i + 1 << "/" << bags.size() << " " << bags[i] << ": " << result.markers.size()
+                    << " markers from " << result.localized << "/" << result.detections << " detections in "
+                    << result.wall_time << " s (" << speedup << "x realtime)");
+    for (const final_project::ReplayMarker &marker : result.markers) {
+      ROS_INFO_STREAM("  marker " << marker.fiducial_id << ": [" << marker.x << ", " << marker.y << ", "
+                      << marker.yaw << "] +/- " << marker.std_error << " m from " << marker.samples
+                      << " observations, " << (marker.converged_after < 0 ? std::string("never stable") :
+                          "stable after " + std::to_string(marker.converged_after) + " s"));
+    }
+    results.emplace_back(bags[i], result);
+  }
+  if (!write_replay_csv(csv_path, results)) {
+    ROS_ERROR_STREAM("Could not write the report to " << csv_path);
+    return 1;
+  }
+  ROS_INFO_STREAM(results.size() << " bags, " << bag_time << " s of recording replayed in " << wall_time
+                  << " s, report written to " << csv_path);
+  return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file rotation_search.cpp
+ * @brief Rotation strategy used by the explorer to find the marker at a lookup location.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/rotation_search.h"
+
+#include <cmath>
+
+namespace final_project {
+
+namespace {
+
+constexpr double kTwoPi = 2 * M_PI;
+
+double wrap_angle(double angle) { return std::atan2(std::sin(angle), std::cos(angle)); }
+
+}  // namespace
+
+bool nearest_obstacle_bearing(const GridView &grid, double x, double y, double max_range, double &bearing,
+                              int rays) {
+  if (grid.data == nullptr || grid.resolution <= 0 || rays <= 0) {
+    return false;
+  }
+  const double step = grid.resolution / 2;
+  double best = max_range;
+  bool found = false;
+  for (int r = 0; r < rays; ++r) {
+    const double angle = kTwoPi * r / rays;
+    const double dx = std::cos(angle);
+    const double dy = std::sin(angle);
+    for (double d = step; d < best; d += step) {
+      const int col = static_cast<int>(std::floor((x + d * dx - grid.origin_x) / grid.resolution));
+      const int row = static_cast<int>(std::floor((y + d * dy - grid.origin_y) / grid.resolution));
+      if (col < 0 || row < 0 || col >= grid.width || row >= grid.height) {
+        break;
+      }
+      if (grid.data[row * grid.width + col] >= 65) {
+        best = d;
+        bearing = wrap_angle(angle);
+        found = true;
+        break;
+      }
+    }
+  }
+  return found;
+}
+
+RotationSearch::RotationSearch() : RotationSearch(Params{}) {}
+
+RotationSearch::RotationSearch(const Params &params) : params_(params) {}
+
+void RotationSearch::start(double now, double robot_yaw, bool has_bearing, double expected_bearing) {
+  has_bearing_ = has_bearing;
+  expected_bearing_ = expected_bearing;
+  yaw_ = robot_yaw;
+  // Turn the shorter way towards the expected bearing.
+  direction_ = (has_bearing && wrap_angle(expected_bearing - robot_yaw) < 0) ? -1 : 1;
+  turned_ = 0;
+  last_time_ = now;
+  last_rate_ = 0;
+}
+
+double RotationSearch::angular_velocity(double now, double last_detection) {
+  const double dt = now - last_time_;
+  if (dt > 0) {
+    yaw_ = wrap_angle(yaw_ + last_rate_ * dt);
+    turned_ += std::fabs(last_rate_) * dt;
+  }
+  last_time_ = now;
+
+  double rate = params_.fast_rate;
+  if (now - last_detection <= params_.detection_hold) {
+    // Markers are in view, give the detector and the fusion time to settle.
+    rate = params_.slow_rate;
+  } else if (has_bearing_ && std::fabs(wrap_angle(expected_bearing_ - yaw_)) <= params_.slow_zone) {
+    rate = params_.slow_rate;
+  } else if (turned_ >= kTwoPi) {
+    // A full turn fast found nothing, the detector may have missed the marker through motion blur.
+    rate = params_.slow_rate;
+  }
+  last_rate_ = direction_ * rate;
+  return last_rate_;
+}
+
+}  // namespace final_project
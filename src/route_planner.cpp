@@ -0,0 +1,148 @@
+/**
+ * @file route_planner.cpp
+ * @brief Orders the goals of a robot to minimize its total travel cost.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/route_planner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace final_project {
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+/**
+ * @brief Exact open path from 'start' through every node of 'visit', then to 'end' if it is given.
+ */
+std::vector<int> held_karp(const std::vector<double> &cost, int n, int start, int end, const std::vector<int> &visit) {
+  const int m = static_cast<int>(visit.size());
+  const std::size_t states = std::size_t(1) << m;
+  // dp[mask * m + j] is the cheapest path from start through 'mask' finishing at visit[j].
+  std::vector<double> dp(states * m, kInfinity);
+  std::vector<std::int8_t> parent(states * m, -1);
+  for (int j = 0; j < m; ++j) {
+    dp[(std::size_t(1) << j) * m + j] = cost[start * n + visit[j]];
+  }
+  for (std::size_t mask = 1; mask < states; ++mask) {
+    for (int j = 0; j < m; ++j) {
+      const double here = dp[mask * m + j];
+      if (!(mask & (std::size_t(1) << j)) || here == kInfinity) {
+        continue;
+      }
+      for (int k = 0; k < m; ++k) {
+        if (mask & (std::size_t(1) << k)) {
+          continue;
+        }
+        const std::size_t next = mask | (std::size_t(1) << k);
+        const double candidate = here + cost[visit[j] * n + visit[k]];
+        if (candidate < dp[next * m + k]) {
+          dp[next * m + k] = candidate;
+          parent[next * m + k] = static_cast<std::int8_t>(j);
+        }
+      }
+    }
+  }
+  const std::size_t full = states - 1;
+  int last = 0;
+  double best = kInfinity;
+  for (int j = 0; j < m; ++j) {
+    const double total = dp[full * m + j] + (end >= 0 ? cost[visit[j] * n + end] : 0.0);
+    if (total < best) {
+      best = total;
+      last = j;
+    }
+  }
+  std::vector<int> order;
+  std::size_t mask = full;
+  for (int j = last; j >= 0;) {
+    order.push_back(visit[j]);
+    const int previous = parent[mask * m + j];
+    mask &= ~(std::size_t(1) << j);
+    j = previous;
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+/**
+ * @brief Heuristic open path, nearest neighbour improved by 2-opt with both ends fixed.
+ */
+std::vector<int> nearest_neighbour_2opt(const std::vector<double> &cost, int n, int start, int end,
+                                        std::vector<int> visit) {
+  std::vector<int> order;
+  int current = start;
+  while (!visit.empty()) {
+    auto next = std::min_element(visit.begin(), visit.end(),
+                                 [&](int a, int b) { return cost[current * n + a] < cost[current * n + b]; });
+    current = *next;
+    order.push_back(current);
+    visit.erase(next);
+  }
+  // path[0] is the start and path.back() the end, neither moves.
+  std::vector<int> path;
+  path.push_back(start);
+  path.insert(path.end(), order.begin(), order.end());
+  if (end >= 0) {
+    path.push_back(end);
+  }
+  const int last = static_cast<int>(path.size()) - (end >= 0 ? 1 : 0);
+  auto leg = [&](int a, int b) { return cost[path[a] * n + path[b]]; };
+  bool improved = true;
+  while (improved) {
+    improved = false;
+    for (int i = 1; i + 1 < last; ++i) {
+      for (int k = i + 1; k < last; ++k) {
+        // Reverse path[i..k], which changes the legs (i-1, i) and (k, k+1).
+        const bool has_next = k + 1 < static_cast<int>(path.size());
+        const double before = leg(i - 1, i) + (has_next ? leg(k, k + 1) : 0.0);
+        const double after = cost[path[i - 1] * n + path[k]] + (has_next ? cost[path[i] * n + path[k + 1]] : 0.0);
+        if (after + 1e-9 < before) {
+          std::reverse(path.begin() + i, path.begin() + k + 1);
+          improved = true;
+        }
+      }
+    }
+  }
+  return std::vector<int>(path.begin() + 1, path.begin() + last);
+}
+
+}  // namespace
+
+std::vector<int> plan_route(const std::vector<double> &cost, int n, int start, int end, int exact_limit) {
+  std::vector<int> visit;
+  for (int i = 0; i < n; ++i) {
+    if (i != start && i != end) {
+      visit.push_back(i);
+    }
+  }
+  std::vector<int> route;
+  if (!visit.empty()) {
+    route = static_cast<int>(visit.size()) <= std::min(exact_limit, 20)
+                ? held_karp(cost, n, start, end, visit)
+                : nearest_neighbour_2opt(cost, n, start, end, visit);
+  }
+  if (end >= 0) {
+    route.push_back(end);
+  }
+  return route;
+}
+
+double route_cost(const std::vector<double> &cost, int n, int start, const std::vector<int> &route) {
+  double total = 0;
+  int current = start;
+  for (int node : route) {
+    total += cost[current * n + node];
+    current = node;
+  }
+  return total;
+}
+
+}  // namespace final_project
@@ -0,0 +1,510 @@
+/**
+ * @file sim_node.cpp
+ * @brief Lightweight simulator serving the topics, services and actions the mission uses, much faster than realtime.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <actionlib/server/simple_action_server.h>
+#include <fiducial_msgs/FiducialTransformArray.h>
+#include <gazebo_msgs/GetModelState.h>
+#include <gazebo_msgs/SetModelState.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <geometry_msgs/Twist.h>
+#include <move_base_msgs/MoveBaseAction.h>
+#include <nav_msgs/GetPlan.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <nav_msgs/Odometry.h>
+#include <ros/package.h>
+#include <ros/ros.h>
+#include <rosgraph_msgs/Clock.h>
+#include <std_msgs/String.h>
+#include <std_srvs/Empty.h>
+#include <std_srvs/SetBool.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2/utils.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/static_transform_broadcaster.h>
+#include <tf2_ros/transform_broadcaster.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "final_project/distance_field.h"
+#include "final_project/fleet.h"
+#include "final_project/kinematic_sim.h"
+#include "final_project/mission.h"
+#include "final_project/xmlrpc_params.h"
+
+typedef actionlib::SimpleActionServer<move_base_msgs::MoveBaseAction> MoveBaseServer;
+
+/**
+ * @brief Struct holding a simulated robot and the ROS interfaces it serves.
+ *
+ */
+struct sim_robot {
+  // Member 'spec' contains the names and home of the robot.
+  final_project::RobotSpec spec;
+  // Member 'index' is the index of the robot in the simulation.
+  int index = 0;
+  std::unique_ptr<MoveBaseServer> move_base;
+  ros::Subscriber cmd_vel;
+  ros::Publisher odom;
+  ros::ServiceServer planner;
+  ros::ServiceServer clear_costmaps;
+  // Members 'fiducials', 'enable_detections' and 'ignore_fiducials' stand in for the aruco_detect node of an explorer.
+  ros::Publisher fiducials;
+  ros::ServiceServer enable_detections;
+  ros::Subscriber ignore_fiducials;
+  bool detections_enabled = true;
+  std::set<int> ignored;
+  int image_seq = 0;
+};
+
+/**
+ * @brief Method to read the markers of the world, ~markers as loaded from param/real_aruco_poses.yaml.
+ *
+ * Each entry is a list [x, y, z], or [x, y, z, yaw] with the heading of the marker normal. Without a heading
+ * the marker faces away from the wall it is on. The entries are taken in name order and get the fiducial ids
+ * of ~marker_ids, or 0, 1, 2, ... without it.
+ *
+ * @param pnh Private nodehandle of the simulator.
+ * @param map Map the markers hang on the walls of.
+ * @return std::vector<final_project::SimMarker> Markers of the world.
+ */
+std::vector<final_project::SimMarker> read_markers(ros::NodeHandle &pnh, const final_project::OccupancyBitmap &map)
+{
+  std::vector<final_project::SimMarker> markers;
+  XmlRpc::XmlRpcValue entries;
+  if (!pnh.getParam("markers", entries) || entries.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+    ROS_WARN("No ~markers, the explorer detects nothing");
+    return markers;
+  }
+  std::vector<int> ids;
+  pnh.param("marker_ids", ids, ids);
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    XmlRpc::XmlRpcValue &value = it->second;
+    final_project::SimMarker marker;
+    if (value.getType() != XmlRpc::XmlRpcValue::TypeArray || value.size() < 3 || value.size() > 4 ||
+        !final_project::xmlrpc_number(value[0], marker.x) || !final_project::xmlrpc_number(value[1], marker.y) ||
+        !final_project::xmlrpc_number(value[2], marker.z) ||
+        (value.size() == 4 && !final_project::xmlrpc_number(value[3], marker.yaw))) {
+      ROS_WARN_STREAM("Ignoring ~markers/" << it->first << ", it is not a list [x, y, z] or [x, y, z, yaw]");
+      continue;
+    }
+    if (value.size() == 3) {
+      marker.yaw = final_project::KinematicSim::marker_facing(map, marker.x, marker.y);
+    }
+    const std::size_t n = markers.size();
+    marker.fiducial_id = n < ids.size() ? ids[n] : static_cast<int>(n);
+    ROS_INFO_STREAM("Marker " << marker.fiducial_id << " (" << it->first << ") at " << marker.x << ", " << marker.y
+                    << " facing " << marker.yaw);
+    markers.push_back(marker);
+  }
+  return markers;
+}
+
+/**
+ * @brief Method to parse the ignore list of aruco_detect, e.g. "1,3-5".
+ */
+std::set<int> parse_ignore_list(const std::string &list)
+{
+  std::set<int> ids;
+  std::istringstream in(list);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    const std::size_t dash = item.find('-', 1);
+    char *end = nullptr;
+    const long first = std::strtol(item.c_str(), &end, 10);
+    if (end == item.c_str()) {
+      continue;
+    }
+    const long last = dash == std::string::npos ? first : std::strtol(item.c_str() + dash + 1, nullptr, 10);
+    for (long id = first; id <= last; id++) {
+      ids.insert(static_cast<int>(id));
+    }
+  }
+  return ids;
+}
+
+/**
+ * @brief Method to get a pose of the map frame as a message.
+ */
+geometry_msgs::Pose to_pose(const final_project::UnicyclePose &pose)
+{
+  geometry_msgs::Pose msg;
+  msg.position.x = pose.x;
+  msg.position.y = pose.y;
+  tf2::Quaternion rotation;
+  rotation.setRPY(0, 0, pose.yaw);
+  msg.orientation = tf2::toMsg(rotation);
+  return msg;
+}
+
+/**
+ * @brief Method to get a message pose as a pose of the map frame, the robots and markers stay upright.
+ */
+final_project::UnicyclePose from_pose(const geometry_msgs::Pose &msg)
+{
+  final_project::UnicyclePose pose;
+  pose.x = msg.position.x;
+  pose.y = msg.position.y;
+  pose.yaw = tf2::getYaw(msg.orientation);
+  return pose;
+}
+
+/**
+ * @brief Method to get the map the markers are seen through as an occupancy grid, blocked cells are occupied.
+ */
+nav_msgs::OccupancyGrid to_grid(const final_project::OccupancyBitmap &map)
+{
+  nav_msgs::OccupancyGrid grid;
+  grid.header.frame_id = "map";
+  grid.info.resolution = static_cast<float>(map.resolution());
+  grid.info.width = static_cast<std::uint32_t>(map.width());
+  grid.info.height = static_cast<std::uint32_t>(map.height());
+  grid.info.origin.position.x = map.origin_x();
+  grid.info.origin.position.y = map.origin_y();
+  grid.info.origin.orientation.w = 1.0;
+  grid.data.resize(static_cast<std::size_t>(map.width()) * map.height());
+  for (int row = 0; row < map.height(); row++) {
+    for (int col = 0; col < map.width(); col++) {
+      grid.data[static_cast<std::size_t>(row) * map.width() + col] = map.blocked(col, row) ? 100 : 0;
+    }
+  }
+  return grid;
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "final_project_sim");
+  ros::NodeHandle nh;
+  ros::NodeHandle pnh("~");
+
+  // Simulated seconds per wall second, 0 steps as fast as possible.
+  double realtime_factor = 100.0;
+  pnh.param("rate", realtime_factor, realtime_factor);
+  double step_rate = 50.0;
+  pnh.param("step_rate", step_rate, step_rate);
+  double camera_rate = 10.0;
+  pnh.param("camera_rate", camera_rate, camera_rate);
+  double odom_rate = 10.0;
+  pnh.param("odom_rate", odom_rate, odom_rate);
+  int seed = 1;
+  pnh.param("seed", seed, seed);
+
+  std::string map_yaml;
+  pnh.param<std::string>("map_yaml", map_yaml, ros::package::getPath("final_project") + "/maps/final_world.yaml");
+  final_project::OccupancyBitmap map;
+  std::string error;
+  if (!final_project::OccupancyBitmap::load(map_yaml, map, &error)) {
+    ROS_FATAL_STREAM("Could not load the map: " << error);
+    return 1;
+  }
+  // The robots plan over the map inflated by their radius, like the global costmap of move_base.
+  double inflation = 0.2;
+  pnh.param("inflation", inflation, inflation);
+  final_project::OccupancyBitmap inflated = map;
+  inflated.inflate(inflation);
+
+  const std::vector<final_project::RobotSpec> fleet = final_project::read_fleet(pnh);
+  // The goals of the mission are mostly the lookup targets and the homes, their fields are precomputed so a
+  // goal sent there never computes one, the other goals share the few fields the cache keeps.
+  std::vector<std::array<double, 2>> sources = final_project::read_lookup_locations(nh);
+  for (const final_project::RobotSpec &spec : fleet) {
+    sources.push_back({{spec.home_x, spec.home_y}});
+  }
+  const char *ros_home = std::getenv("ROS_HOME");
+  const char *home = std::getenv("HOME");
+  const std::string cache_dir = ros_home ? std::string(ros_home) : std::string(home ? home : "/tmp") + "/.ros";
+  std::string cache_path;
+  pnh.param<std::string>("distance_field_cache", cache_path, cache_dir + "/final_project_sim_fields.bin");
+  final_project::DistanceFieldCache fields;
+  if (!fields.open(cache_path, inflated, sources, &error)) {
+    ROS_FATAL_STREAM("Could not compute the distance fields: " << error);
+    return 1;
+  }
+  if (!error.empty()) {
+    ROS_WARN_STREAM(error);
+  }
+
+  std::vector<final_project::SimMarker> markers = read_markers(pnh, map);
+
+  final_project::KinematicSim::Params params;
+  pnh.param("robot/max_linear", params.max_linear, params.max_linear);
+  pnh.param("robot/max_angular", params.max_angular, params.max_angular);
+  pnh.param("robot/xy_tolerance", params.xy_tolerance, params.xy_tolerance);
+  pnh.param("robot/yaw_tolerance", params.yaw_tolerance, params.yaw_tolerance);
+  final_project::SimCamera camera;
+  pnh.param("camera/fov", camera.fov, camera.fov);
+  pnh.param("camera/min_range", camera.min_range, camera.min_range);
+  pnh.param("camera/max_range", camera.max_range, camera.max_range);
+  pnh.param("camera/max_incidence", camera.max_incidence, camera.max_incidence);
+  pnh.param("camera/range_noise", camera.range_noise, camera.range_noise);
+  pnh.param("camera/bearing_noise", camera.bearing_noise, camera.bearing_noise);
+  pnh.param("camera/yaw_noise", camera.yaw_noise, camera.yaw_noise);
+  final_project::KinematicSim sim(map, fields, params);
+  std::mt19937 rng(static_cast<std::uint32_t>(seed));
+
+  ros::Publisher clock_pub = nh.advertise<rosgraph_msgs::Clock>("/clock", 1);
+  ros::Publisher map_pub = nh.advertise<nav_msgs::OccupancyGrid>("/map", 1, true);
+  map_pub.publish(to_grid(map));
+  tf2_ros::TransformBroadcaster tf_broadcaster;
+  tf2_ros::StaticTransformBroadcaster static_broadcaster;
+
+  // The simulated clock starts past zero, a zero stamp means the latest transform to TF.
+  const double start_time = 1.0;
+  const auto now = [&sim, start_time]() { return ros::Time(start_time + sim.time()); };
+
+  std::deque<sim_robot> robots;
+  std::vector<geometry_msgs::TransformStamped> cameras;
+  for (const final_project::RobotSpec &spec : fleet) {
+    robots.emplace_back();
+    sim_robot &robot = robots.back();
+    robot.spec = spec;
+    final_project::UnicyclePose start;
+    start.x = spec.home_x;
+    start.y = spec.home_y;
+    robot.index = sim.add_robot(start);
+
+    robot.move_base.reset(new MoveBaseServer(nh, spec.move_base_action, false));
+    robot.move_base->registerGoalCallback([&sim, &robot]() {
+      const final_project::UnicyclePose goal = from_pose(robot.move_base->acceptNewGoal()->target_pose.pose);
+      if (!sim.set_goal(robot.index, goal)) {
+        robot.move_base->setAborted(move_base_msgs::MoveBaseResult(), "No path to the goal");
+      }
+    });
+    robot.move_base->registerPreemptCallback([&sim, &robot]() {
+      sim.cancel_goal(robot.index);
+      robot.move_base->setPreempted();
+    });
+    robot.move_base->start();
+    robot.cmd_vel = nh.subscribe<geometry_msgs::Twist>(spec.cmd_vel, 5,
+        [&sim, &robot](const geometry_msgs::Twist::ConstPtr &msg) {
+          sim.set_velocity(robot.index, msg->linear.x, msg->angular.z);
+        });
+    robot.odom = nh.advertise<nav_msgs::Odometry>("/" + spec.name + "/odom", 10);
+    robot.planner = nh.advertiseService<nav_msgs::GetPlan::Request, nav_msgs::GetPlan::Response>(spec.planner,
+        [&fields](nav_msgs::GetPlan::Request &req, nav_msgs::GetPlan::Response &res) {
+          std::vector<std::array<double, 2>> waypoints;
+          fields.path(req.start.pose.position.x, req.start.pose.position.y, req.goal.pose.position.x,
+                      req.goal.pose.position.y, waypoints);
+          res.plan.header.frame_id = "map";
+          res.plan.poses.push_back(req.start);
+          for (const std::array<double, 2> &waypoint : waypoints) {
+            geometry_msgs::PoseStamped pose;
+            pose.header.frame_id = "map";
+            pose.pose.position.x = waypoint[0];
+            pose.pose.position.y = waypoint[1];
+            pose.pose.orientation.w = 1.0;
+            res.plan.poses.push_back(pose);
+          }
+          // An empty plan tells the caller there is no path.
+          if (waypoints.empty()) {
+            res.plan.poses.clear();
+          }
+          return true;
+        });
+    // The planner service lives on the move_base node, next to clear_costmaps, which has nothing to clear here.
+    const std::string planner_suffix = "make_plan";
+    if (spec.planner.size() > planner_suffix.size()) {
+      robot.clear_costmaps = nh.advertiseService<std_srvs::Empty::Request, std_srvs::Empty::Response>(
+          spec.planner.substr(0, spec.planner.size() - planner_suffix.size()) + "clear_costmaps",
+          [](std_srvs::Empty::Request &, std_srvs::Empty::Response &) { return true; });
+    }
+
+    geometry_msgs::TransformStamped base_to_camera;
+    base_to_camera.header.frame_id = spec.base_frame;
+    base_to_camera.header.stamp = now();
+    base_to_camera.child_frame_id = spec.camera_frame;
+    base_to_camera.transform.translation.x = camera.forward;
+    base_to_camera.transform.translation.z = camera.height;
+    // The optical frame has z forward, x right and y down.
+    tf2::Quaternion optical;
+    optical.setRPY(-M_PI / 2, 0, -M_PI / 2);
+    base_to_camera.transform.rotation = tf2::toMsg(optical);
+    cameras.push_back(base_to_camera);
+
+    if (spec.role == final_project::RobotRole::Explorer) {
+      robot.fiducials = nh.advertise<fiducial_msgs::FiducialTransformArray>(spec.fiducial_topic, 5);
+      robot.enable_detections = nh.advertiseService<std_srvs::SetBool::Request, std_srvs::SetBool::Response>(
+          spec.detector + "/enable_detections",
+          [&robot](std_srvs::SetBool::Request &req, std_srvs::SetBool::Response &res) {
+            robot.detections_enabled = req.data;
+            res.success = true;
+            res.message = req.data ? "Enabled aruco detections." : "Disabled aruco detections.";
+            return true;
+          });
+      robot.ignore_fiducials = nh.subscribe<std_msgs::String>(spec.detector + "/ignore_fiducials", 1,
+          [&robot](const std_msgs::String::ConstPtr &msg) { robot.ignored = parse_ignore_list(msg->data); });
+    }
+  }
+  static_broadcaster.sendTransform(cameras);
+
+  // The Gazebo model services, so final_project_bench can move the robots and the markers between trials.
+  const auto find_robot = [&robots](const std::string &model) -> sim_robot * {
+    for (sim_robot &robot : robots) {
+      if (robot.spec.name == model) {
+        return &robot;
+      }
+    }
+    return nullptr;
+  };
+  const auto find_marker = [&markers](const std::string &model) -> final_project::SimMarker * {
+    for (final_project::SimMarker &marker : markers) {
+      if (model == "aruco_marker_" + std::to_string(marker.fiducial_id)) {
+        return &marker;
+      }
+    }
+    return nullptr;
+  };
+  ros::ServiceServer get_model_state =
+      nh.advertiseService<gazebo_msgs::GetModelState::Request, gazebo_msgs::GetModelState::Response>(
+          "/gazebo/get_model_state",
+          [&sim, &find_robot, &find_marker](gazebo_msgs::GetModelState::Request &req,
+                                            gazebo_msgs::GetModelState::Response &res) {
+            res.success = true;
+            if (sim_robot *robot = find_robot(req.model_name)) {
+              res.pose = to_pose(sim.pose(robot->index));
+            } else if (final_project::SimMarker *marker = find_marker(req.model_name)) {
+              final_project::UnicyclePose pose;
+              pose.x = marker->x;
+              pose.y = marker->y;
+              pose.yaw = marker->yaw;
+              res.pose = to_pose(pose);
+              res.pose.position.z = marker->z;
+            } else {
+              res.success = false;
+              res.status_message = "No model " + req.model_name;
+            }
+            return true;
+          });
+  ros::ServiceServer set_model_state =
+      nh.advertiseService<gazebo_msgs::SetModelState::Request, gazebo_msgs::SetModelState::Response>(
+          "/gazebo/set_model_state",
+          [&sim, &robots, &find_robot, &find_marker](gazebo_msgs::SetModelState::Request &req,
+                                                     gazebo_msgs::SetModelState::Response &res) {
+            const gazebo_msgs::ModelState &state = req.model_state;
+            const final_project::UnicyclePose pose = from_pose(state.pose);
+            res.success = true;
+            if (sim_robot *robot = find_robot(state.model_name)) {
+              sim.set_pose(robot->index, pose);
+              if (robot->move_base->isActive()) {
+                robot->move_base->setAborted(move_base_msgs::MoveBaseResult(), "The robot was moved");
+              }
+            } else if (final_project::SimMarker *marker = find_marker(state.model_name)) {
+              marker->x = pose.x;
+              marker->y = pose.y;
+              marker->z = state.pose.position.z;
+              marker->yaw = pose.yaw;
+            } else {
+              res.success = false;
+              res.status_message = "No model " + state.model_name;
+            }
+            return true;
+          });
+
+  ROS_INFO_STREAM("Simulating " << robots.size() << " robots and " << markers.size() << " markers at "
+                  << (realtime_factor > 0 ? std::to_string(realtime_factor) + "x realtime" : "full speed"));
+  const double dt = 1.0 / step_rate;
+  const int camera_every = std::max(1, static_cast<int>(std::lround(step_rate / camera_rate)));
+  const int odom_every = std::max(1, static_cast<int>(std::lround(step_rate / odom_rate)));
+  std::unique_ptr<ros::WallRate> pace;
+  if (realtime_factor > 0) {
+    pace.reset(new ros::WallRate(step_rate * realtime_factor));
+  }
+  std::vector<geometry_msgs::TransformStamped> bases(robots.size());
+  for (long step = 0; ros::ok(); step++) {
+    ros::spinOnce();
+    sim.step(dt);
+    const ros::Time stamp = now();
+    rosgraph_msgs::Clock clock;
+    clock.clock = stamp;
+    clock_pub.publish(clock);
+
+    for (std::size_t i = 0; i < robots.size(); i++) {
+      sim_robot &robot = robots[i];
+      const final_project::UnicyclePose &pose = sim.pose(robot.index);
+      if (robot.move_base->isActive()) {
+        const final_project::KinematicSim::GoalState state = sim.goal_state(robot.index);
+        if (state == final_project::KinematicSim::GoalState::Succeeded) {
+          robot.move_base->setSucceeded();
+        } else if (state == final_project::KinematicSim::GoalState::Aborted) {
+          robot.move_base->setAborted(move_base_msgs::MoveBaseResult(), "No path to the goal");
+        }
+      }
+      // The robots are localized perfectly, map is their odometry frame.
+      geometry_msgs::TransformStamped &base = bases[i];
+      base.header.stamp = stamp;
+      base.header.frame_id = "map";
+      base.child_frame_id = robot.spec.base_frame;
+      base.transform.translation.x = pose.x;
+      base.transform.translation.y = pose.y;
+      base.transform.rotation = to_pose(pose).orientation;
+
+      if (step % odom_every == 0) {
+        nav_msgs::Odometry odom;
+        odom.header.stamp = stamp;
+        odom.header.frame_id = "map";
+        odom.child_frame_id = robot.spec.base_frame;
+        odom.pose.pose = to_pose(pose);
+        odom.twist.twist.linear.x = sim.velocity(robot.index)[0];
+        odom.twist.twist.angular.z = sim.velocity(robot.index)[1];
+        robot.odom.publish(odom);
+        if (robot.move_base->isActive()) {
+          move_base_msgs::MoveBaseFeedback feedback;
+          feedback.base_position.header = odom.header;
+          feedback.base_position.pose = odom.pose.pose;
+          robot.move_base->publishFeedback(feedback);
+        }
+      }
+    }
+    // The transforms go out before the detections they localize.
+    tf_broadcaster.sendTransform(bases);
+
+    if (step % camera_every == 0) {
+      for (sim_robot &robot : robots) {
+        if (robot.spec.role != final_project::RobotRole::Explorer || !robot.detections_enabled) {
+          continue;
+        }
+        fiducial_msgs::FiducialTransformArray msg;
+        msg.header.stamp = stamp;
+        msg.header.frame_id = robot.spec.camera_frame;
+        msg.image_seq = robot.image_seq++;
+        for (const final_project::SimDetection &detection : sim.detect(robot.index, camera, markers, rng)) {
+          if (robot.ignored.count(detection.fiducial_id)) {
+            continue;
+          }
+          fiducial_msgs::FiducialTransform fiducial;
+          fiducial.fiducial_id = detection.fiducial_id;
+          fiducial.transform.translation.x = detection.translation[0];
+          fiducial.transform.translation.y = detection.translation[1];
+          fiducial.transform.translation.z = detection.translation[2];
+          fiducial.transform.rotation.x = detection.rotation[0];
+          fiducial.transform.rotation.y = detection.rotation[1];
+          fiducial.transform.rotation.z = detection.rotation[2];
+          fiducial.transform.rotation.w = detection.rotation[3];
+          fiducial.image_error = detection.image_error;
+          fiducial.object_error = detection.object_error;
+          msg.transforms.push_back(fiducial);
+        }
+        robot.fiducials.publish(msg);
+      }
+    }
+    if (pace) {
+      pace->sleep();
+    }
+  }
+  return 0;
+}
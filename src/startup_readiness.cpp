@@ -0,0 +1,69 @@
+/**
+ * @file startup_readiness.cpp
+ * @brief Tracks the dependencies the mission waits for at startup, all at the same time.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/startup_readiness.h"
+
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace final_project {
+
+void StartupReadiness::add(const std::string &name, Probe probe, bool required) {
+  Check check;
+  check.name = name;
+  check.probe = std::move(probe);
+  check.required = required;
+  checks_.push_back(std::move(check));
+}
+
+bool StartupReadiness::poll(double elapsed) {
+  bool all = true;
+  for (Check &check : checks_) {
+    if (!check.ready && check.probe()) {
+      check.ready = true;
+      check.ready_after = elapsed;
+    }
+    all = all && check.ready;
+  }
+  return all;
+}
+
+bool StartupReadiness::required_ready() const {
+  for (const Check &check : checks_) {
+    if (check.required && !check.ready) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool StartupReadiness::all_ready() const {
+  for (const Check &check : checks_) {
+    if (!check.ready) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string StartupReadiness::report() const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  for (const Check &check : checks_) {
+    if (check.ready) {
+      out << "  ready after " << std::setw(6) << check.ready_after << " s  " << check.name << "\n";
+    } else {
+      out << "  " << (check.required ? "MISSING (required) " : "missing (optional) ") << check.name << "\n";
+    }
+  }
+  return out.str();
+}
+
+}  // namespace final_project
@@ -0,0 +1,282 @@
+/**
+ * @file sweep.cpp
+ * @brief Parallel sweep of missions, each in a ROS graph of its own, with the results of every mission gathered.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/sweep.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+extern char **environ;
+
+namespace final_project {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Escapes the characters a job name could break the JSON string with.
+std::string json_string(const std::string &text) {
+  std::string escaped = "\"";
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+// Creates a directory and its missing parents, like mkdir -p.
+bool make_directories(const std::string &path) {
+  for (std::size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+    const std::string prefix = path.substr(0, slash);
+    if (!prefix.empty() && mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (slash == std::string::npos) {
+      return true;
+    }
+  }
+}
+
+// Environment of the jobs, that of the sweep with its own ROS master, Gazebo master and ROS_HOME.
+std::vector<std::string> job_environment(int port, int gazebo_port, const std::string &ros_home) {
+  std::vector<std::string> environment;
+  for (char **variable = environ; *variable != nullptr; variable++) {
+    if (std::strncmp(*variable, "ROS_MASTER_URI=", 15) != 0 && std::strncmp(*variable, "ROS_HOME=", 9) != 0 &&
+        std::strncmp(*variable, "GAZEBO_MASTER_URI=", 18) != 0) {
+      environment.emplace_back(*variable);
+    }
+  }
+  environment.push_back("ROS_MASTER_URI=http://localhost:" + std::to_string(port));
+  // gzserver listens on 11345 unless told otherwise, two jobs in Gazebo would share one server.
+  environment.push_back("GAZEBO_MASTER_URI=http://localhost:" + std::to_string(gazebo_port));
+  environment.push_back("ROS_HOME=" + ros_home);
+  return environment;
+}
+
+// Array of pointers to the strings, null terminated, for posix_spawn.
+std::vector<char *> c_strings(std::vector<std::string> &strings) {
+  std::vector<char *> pointers;
+  for (std::string &text : strings) {
+    pointers.push_back(&text[0]);
+  }
+  pointers.push_back(nullptr);
+  return pointers;
+}
+
+// Adds or replaces the argument 'name' of a launch file.
+void set_arg(LaunchArgs &args, const std::string &name, const std::string &value) {
+  auto arg = std::find_if(args.begin(), args.end(),
+                          [&name](const std::pair<std::string, std::string> &a) { return a.first == name; });
+  if (arg != args.end()) {
+    arg->second = value;
+  } else {
+    args.emplace_back(name, value);
+  }
+}
+
+/**
+ * @brief Struct holding the figures of a job the reports give.
+ *
+ */
+struct job_summary {
+  std::size_t completed = 0;
+  // Mean over the completed trials, 0 without any.
+  double mission_time = 0;
+  double markers = 0;
+};
+
+job_summary summarize(const SweepResult &result) {
+  job_summary summary;
+  for (const BenchTrial &trial : result.trials) {
+    if (trial.completed) {
+      summary.completed++;
+      summary.mission_time += trial.mission_time;
+    }
+    summary.markers += static_cast<double>(trial.markers);
+  }
+  if (summary.completed > 0) {
+    summary.mission_time /= static_cast<double>(summary.completed);
+  }
+  if (!result.trials.empty()) {
+    summary.markers /= static_cast<double>(result.trials.size());
+  }
+  return summary;
+}
+
+}  // namespace
+
+SweepExecutor::SweepExecutor(const Params &params) : params_(params) {
+  workers_ = params_.workers;
+  if (workers_ <= 0) {
+    workers_ = std::max(1, static_cast<int>(std::thread::hardware_concurrency() / 2));
+  }
+}
+
+std::vector<SweepResult> SweepExecutor::run(const std::vector<SweepJob> &jobs) {
+  std::vector<SweepResult> results(jobs.size());
+  std::atomic<std::size_t> next{0};
+  auto work = [&]() {
+    for (std::size_t i = next++; i < jobs.size(); i = next++) {
+      if (cancelled_) {
+        results[i].job = jobs[i].name;
+        continue;
+      }
+      results[i] = run_job(i, jobs[i]);
+    }
+  };
+  std::vector<std::thread> pool;
+  const std::size_t threads = std::min(jobs.size(), static_cast<std::size_t>(workers_));
+  for (std::size_t t = 0; t < threads; t++) {
+    pool.emplace_back(work);
+  }
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+  return results;
+}
+
+SweepResult SweepExecutor::run_job(std::size_t index, const SweepJob &job) {
+  SweepResult result;
+  result.job = job.name;
+  const std::string directory = params_.report_dir + "/" + job.name;
+  result.report = directory + "/bench.csv";
+  if (!make_directories(directory)) {
+    return result;
+  }
+  // A report left by an earlier sweep would pass for that of a job that failed to write one.
+  std::remove(result.report.c_str());
+
+  LaunchArgs args = params_.args;
+  for (const std::pair<std::string, std::string> &arg : job.args) {
+    set_arg(args, arg.first, arg.second);
+  }
+  set_arg(args, "csv", result.report);
+  set_arg(args, "json", directory + "/bench.json");
+  const int port = params_.base_port + static_cast<int>(index);
+  std::vector<std::string> command{"roslaunch", "-p", std::to_string(port), params_.package, params_.launch};
+  for (const std::pair<std::string, std::string> &arg : args) {
+    command.push_back(arg.first + ":=" + arg.second);
+  }
+  const int gazebo_port = params_.gazebo_base_port + static_cast<int>(index);
+  std::vector<std::string> environment = job_environment(port, gazebo_port, directory);
+  std::vector<char *> argv = c_strings(command);
+  std::vector<char *> envp = c_strings(environment);
+  const std::string log = directory + "/roslaunch.log";
+
+  // ROS1 allows one node and one clock per process, the mission and the simulator of the job run in processes of
+  // their own. The job is a process group of its own, the signals of the terminal reach the sweep only, which
+  // stops the jobs itself. posix_spawn, unlike fork, is safe from a process running other threads.
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, 1, log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, 1, 2);
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  sigset_t default_signals;
+  sigemptyset(&default_signals);
+  sigaddset(&default_signals, SIGINT);
+  sigaddset(&default_signals, SIGTERM);
+  sigset_t no_signals;
+  sigemptyset(&no_signals);
+  posix_spawnattr_setsigdefault(&attributes, &default_signals);
+  posix_spawnattr_setsigmask(&attributes, &no_signals);
+  posix_spawnattr_setpgroup(&attributes, 0);
+  posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+  const Clock::time_point start = Clock::now();
+  pid_t pid = 0;
+  const int spawned = posix_spawnp(&pid, "roslaunch", &actions, &attributes, argv.data(), envp.data());
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attributes);
+  if (spawned != 0) {
+    return result;
+  }
+
+  // roslaunch stops its nodes on SIGINT, they run in sessions of their own and would outlive a SIGKILL of it, so
+  // it only gets one once the grace time is over.
+  bool stopping = false;
+  bool killed = false;
+  Clock::time_point stopped;
+  int status = 0;
+  while (true) {
+    const pid_t waited = waitpid(pid, &status, WNOHANG);
+    if (waited == pid || (waited < 0 && errno != EINTR)) {
+      break;
+    }
+    const Clock::time_point now = Clock::now();
+    if (!stopping && (cancelled_ || std::chrono::duration<double>(now - start).count() > params_.timeout)) {
+      kill(-pid, SIGINT);
+      stopping = true;
+      stopped = now;
+    } else if (stopping && !killed && std::chrono::duration<double>(now - stopped).count() > params_.grace) {
+      kill(-pid, SIGKILL);
+      killed = true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  result.wall_time = std::chrono::duration<double>(Clock::now() - start).count();
+  result.timed_out = stopping;
+  if (!stopping && WIFEXITED(status)) {
+    result.exit_status = WEXITSTATUS(status);
+  }
+  read_bench_csv(result.report, result.trials);
+  return result;
+}
+
+bool write_sweep_csv(const std::string &path, const std::vector<SweepResult> &results) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << std::fixed << std::setprecision(4);
+  out << "job,exit_status,timed_out,wall_time,trials,completed,mission_time,markers,report\n";
+  for (const SweepResult &result : results) {
+    const job_summary summary = summarize(result);
+    out << result.job << "," << result.exit_status << "," << (result.timed_out ? 1 : 0) << "," << result.wall_time
+        << "," << result.trials.size() << "," << summary.completed << "," << summary.mission_time << ","
+        << summary.markers << "," << result.report << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+bool write_sweep_json(const std::string &path, const std::vector<SweepResult> &results) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << std::fixed << std::setprecision(4);
+  out << "[";
+  for (std::size_t j = 0; j < results.size(); j++) {
+    const SweepResult &result = results[j];
+    const job_summary summary = summarize(result);
+    out << (j > 0 ? "," : "") << "\n  {\"job\": " << json_string(result.job)
+        << ", \"exit_status\": " << result.exit_status << ", \"timed_out\": " << (result.timed_out ? "true" : "false")
+        << ", \"wall_time\": " << result.wall_time << ", \"trials\": " << result.trials.size()
+        << ", \"completed\": " << summary.completed << ", \"mission_time\": " << summary.mission_time
+        << ", \"markers\": " << summary.markers << ", \"report\": " << json_string(result.report) << "}";
+  }
+  out << "\n]\n";
+  return static_cast<bool>(out);
+}
+
+}  // namespace final_project
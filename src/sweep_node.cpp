@@ -0,0 +1,197 @@
+/**
+ * @file sweep_node.cpp
+ * @brief Sweep running many benchmark missions at once, each in a ROS graph of its own, see launch/sweep.launch.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <ros/ros.h>
+#include <signal.h>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "final_project/sweep.h"
+
+// Sweep the interrupt handler cancels, set while it runs.
+final_project::SweepExecutor *running_sweep = nullptr;
+
+/**
+ * @brief Method to stop the sweep on SIGINT, the jobs get the time to shut down and the results are still written.
+ */
+void interrupt(int)
+{
+  if (running_sweep != nullptr) {
+    running_sweep->cancel();
+  }
+}
+
+/**
+ * @brief Method to write a parameter value as a launch argument, strings as is and the other scalars as in yaml.
+ *
+ * @param value Value of the parameter.
+ * @param text Receives the argument.
+ * @return true if the value is a scalar.
+ * @return false otherwise.
+ */
+bool launch_value(XmlRpc::XmlRpcValue &value, std::string &text)
+{
+  std::ostringstream out;
+  switch (value.getType()) {
+    case XmlRpc::XmlRpcValue::TypeString:
+      text = static_cast<std::string>(value);
+      return true;
+    case XmlRpc::XmlRpcValue::TypeBoolean:
+      text = static_cast<bool>(value) ? "true" : "false";
+      return true;
+    case XmlRpc::XmlRpcValue::TypeInt:
+      out << static_cast<int>(value);
+      break;
+    case XmlRpc::XmlRpcValue::TypeDouble:
+      out << static_cast<double>(value);
+      break;
+    default:
+      return false;
+  }
+  text = out.str();
+  return true;
+}
+
+/**
+ * @brief Method to read launch arguments from a map of parameters.
+ *
+ * @param value Map of the arguments, by name.
+ * @param what Name of the map, for the warnings.
+ * @return final_project::LaunchArgs Arguments, those with a value that is no scalar are dropped.
+ */
+final_project::LaunchArgs read_launch_args(XmlRpc::XmlRpcValue &value, const std::string &what)
+{
+  final_project::LaunchArgs args;
+  if (value.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+    ROS_WARN_STREAM(what << " is not a map of launch arguments, ignored");
+    return args;
+  }
+  for (auto &arg : value) {
+    std::string text;
+    if (!launch_value(arg.second, text)) {
+      ROS_WARN_STREAM("Argument " << arg.first << " of " << what << " is not a scalar, ignored");
+      continue;
+    }
+    args.emplace_back(arg.first, text);
+  }
+  return args;
+}
+
+/**
+ * @brief Method to read the jobs of ~sweep/jobs, a list of {name, args}.
+ *
+ * @param pnh Private node handle of the sweep.
+ * @return std::vector<final_project::SweepJob> Jobs, those without a usable name are dropped.
+ */
+std::vector<final_project::SweepJob> read_jobs(ros::NodeHandle &pnh)
+{
+  std::vector<final_project::SweepJob> jobs;
+  XmlRpc::XmlRpcValue list;
+  if (!pnh.getParam("sweep/jobs", list) || list.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+    ROS_ERROR("~sweep/jobs is not a list of jobs");
+    return jobs;
+  }
+  for (int i = 0; i < list.size(); i++) {
+    XmlRpc::XmlRpcValue &entry = list[i];
+    if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("name") ||
+        entry["name"].getType() != XmlRpc::XmlRpcValue::TypeString) {
+      ROS_WARN_STREAM("Job " << i << " of ~sweep/jobs has no name, ignored");
+      continue;
+    }
+    final_project::SweepJob job;
+    job.name = static_cast<std::string>(entry["name"]);
+    bool duplicate = false;
+    for (const final_project::SweepJob &other : jobs) {
+      duplicate = duplicate || other.name == job.name;
+    }
+    if (job.name.empty() || job.name.find('/') != std::string::npos || job.name[0] == '.' || duplicate) {
+      ROS_WARN_STREAM("Job " << i << " of ~sweep/jobs must have a distinct directory name, '" << job.name
+                      << "' ignored");
+      continue;
+    }
+    if (entry.hasMember("args")) {
+      job.args = read_launch_args(entry["args"], "job " + job.name);
+    }
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "final_project_sweep", ros::init_options::NoSigintHandler);
+  ros::NodeHandle pnh("~");
+
+  final_project::SweepExecutor::Params params;
+  pnh.param("sweep/workers", params.workers, params.workers);
+  pnh.param("sweep/base_port", params.base_port, params.base_port);
+  pnh.param("sweep/gazebo_base_port", params.gazebo_base_port, params.gazebo_base_port);
+  pnh.param("sweep/timeout", params.timeout, params.timeout);
+  pnh.param("sweep/grace", params.grace, params.grace);
+  pnh.param("sweep/package", params.package, params.package);
+  pnh.param("sweep/launch", params.launch, params.launch);
+  const char *ros_home = std::getenv("ROS_HOME");
+  const char *home = std::getenv("HOME");
+  const std::string ros_dir = ros_home ? std::string(ros_home) : std::string(home ? home : "/tmp") + "/.ros";
+  pnh.param<std::string>("sweep/report_dir", params.report_dir, ros_dir + "/final_project_sweep");
+  XmlRpc::XmlRpcValue common;
+  if (pnh.getParam("sweep/args", common)) {
+    params.args = read_launch_args(common, "~sweep/args");
+  }
+  const std::vector<final_project::SweepJob> jobs = read_jobs(pnh);
+  if (jobs.empty()) {
+    ROS_FATAL("No job to run");
+    return 1;
+  }
+
+  final_project::SweepExecutor sweep(params);
+  running_sweep = &sweep;
+  signal(SIGINT, interrupt);
+  signal(SIGTERM, interrupt);
+  ROS_INFO_STREAM("Running " << jobs.size() << " jobs, " << sweep.workers() << " at once, in "
+                  << params.report_dir);
+  const auto start = std::chrono::steady_clock::now();
+  const std::vector<final_project::SweepResult> results = sweep.run(jobs);
+  const double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  running_sweep = nullptr;
+
+  double job_time = 0;
+  std::size_t failed = 0;
+  for (const final_project::SweepResult &result : results) {
+    std::size_t completed = 0;
+    for (const final_project::BenchTrial &trial : result.trials) {
+      completed += trial.completed ? 1 : 0;
+    }
+    job_time += result.wall_time;
+    if (result.exit_status != 0 || result.trials.empty()) {
+      failed++;
+      ROS_WARN_STREAM(result.job << ": " << (result.timed_out ? "stopped" : "failed") << " after "
+                      << result.wall_time << " s, exit status " << result.exit_status << ", see "
+                      << params.report_dir << "/" << result.job << "/roslaunch.log");
+    } else {
+      ROS_INFO_STREAM(result.job << ": " << completed << "/" << result.trials.size() << " trials completed in "
+                      << result.wall_time << " s");
+    }
+  }
+  // The time the jobs took one after the other over that of the sweep, at most the workers.
+  ROS_INFO_STREAM(results.size() - failed << "/" << results.size() << " jobs in " << wall_time << " s, speedup "
+                  << (wall_time > 0 ? job_time / wall_time : 0.0) << " on " << sweep.workers() << " workers");
+
+  const std::string csv_path = params.report_dir + "/sweep.csv";
+  const std::string json_path = params.report_dir + "/sweep.json";
+  if (!final_project::write_sweep_csv(csv_path, results) || !final_project::write_sweep_json(json_path, results)) {
+    ROS_ERROR_STREAM("Could not write the sweep report to " << params.report_dir);
+    return 1;
+  }
+  ROS_INFO_STREAM("Sweep report written to " << csv_path << " and " << json_path);
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file target_registry.cpp
+ * @brief Lookup targets of the explorers and markers localized so far, sized at runtime.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/target_registry.h"
+
+namespace final_project {
+
+int TargetRegistry::add_target(double x, double y) {
+  LookupTarget target;
+  target.x = x;
+  target.y = y;
+  targets_.push_back(target);
+  return static_cast<int>(targets_.size()) - 1;
+}
+
+std::vector<std::array<double, 2>> TargetRegistry::target_points() const {
+  std::vector<std::array<double, 2>> points;
+  points.reserve(targets_.size());
+  for (const LookupTarget &target : targets_) {
+    points.push_back({{target.x, target.y}});
+  }
+  return points;
+}
+
+int TargetRegistry::update_marker(int fiducial_id, double x, double y, double yaw) {
+  int index = marker_of_id_.find(fiducial_id);
+  if (index < 0) {
+    index = static_cast<int>(markers_.size());
+    MarkerLocation marker;
+    marker.fiducial_id = fiducial_id;
+    markers_.push_back(marker);
+    marker_of_id_.insert(fiducial_id, index);
+  }
+  markers_[index].x = x;
+  markers_[index].y = y;
+  markers_[index].yaw = yaw;
+  return index;
+}
+
+void TargetRegistry::reserve_markers(std::size_t markers) {
+  markers_.reserve(markers);
+  marker_of_id_.reserve(markers);
+}
+
+void TargetRegistry::clear() {
+  targets_.clear();
+  markers_.clear();
+  marker_of_id_.clear();
+}
+
+}  // namespace final_project
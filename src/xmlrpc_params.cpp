@@ -0,0 +1,60 @@
+/**
+ * @file xmlrpc_params.cpp
+ * @brief Parsing of the structured parameters the mission and the simulator share.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "final_project/xmlrpc_params.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace final_project {
+
+bool xmlrpc_number(XmlRpc::XmlRpcValue &value, double &number) {
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble) {
+    number = static_cast<double>(value);
+    return true;
+  }
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt) {
+    number = static_cast<int>(value);
+    return true;
+  }
+  return false;
+}
+
+bool xmlrpc_point(XmlRpc::XmlRpcValue &value, std::array<double, 2> &point) {
+  return value.getType() == XmlRpc::XmlRpcValue::TypeArray && value.size() == 2 &&
+         xmlrpc_number(value[0], point[0]) && xmlrpc_number(value[1], point[1]);
+}
+
+std::vector<std::array<double, 2>> read_lookup_locations(ros::NodeHandle &nh) {
+  std::vector<std::array<double, 2>> targets;
+  XmlRpc::XmlRpcValue locations;
+  if (!nh.getParam("aruco_lookup_locations", locations) || locations.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+    return targets;
+  }
+  // The entries are named target_1, target_2, ..., sort them by number rather than by name.
+  std::vector<std::pair<long, std::string>> names;
+  for (auto it = locations.begin(); it != locations.end(); ++it) {
+    const std::string &name = it->first;
+    const std::size_t digits = name.find_last_not_of("0123456789") + 1;
+    names.emplace_back(digits < name.size() ? std::stol(name.substr(digits)) : -1, name);
+  }
+  std::sort(names.begin(), names.end());
+  for (const auto &name : names) {
+    std::array<double, 2> target;
+    if (!xmlrpc_point(locations[name.second], target)) {
+      ROS_WARN_STREAM("Ignoring aruco_lookup_locations/" << name.second << ", it is not a list [x, y]");
+      continue;
+    }
+    targets.push_back(target);
+  }
+  return targets;
+}
+
+}  // namespace final_project
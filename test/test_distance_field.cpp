@@ -0,0 +1,222 @@
+/**
+ * @file test_distance_field.cpp
+ * @brief Unit tests of the map bitmap, of the path lengths over it and of their cache on disk.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "final_project/distance_field.h"
+
+namespace final_project {
+namespace {
+
+// Maps of one meter cells from the origin, written to a directory of their own, removed when the test ends.
+class DistanceFieldTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/final_project_test_distance_field_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    directory_ = directory;
+  }
+
+  void TearDown() override {
+    for (const char *file : {"map.yaml", "map.pgm", "fields.bin", "fields.bin.tmp"}) {
+      std::remove((directory_ + "/" + file).c_str());
+    }
+    rmdir(directory_.c_str());
+  }
+
+  // Writes a map whose rows are given top first, '#' for a blocked cell and '.' for a free one.
+  std::string write_map(const std::vector<std::string> &rows, const std::string &yaml_extra = "",
+                        const std::string &pgm_header = "") {
+    std::ofstream yaml(directory_ + "/map.yaml");
+    yaml << "image: map.pgm\nresolution: 1.0\norigin: [0.0, 0.0, 0.0]\nnegate: 0\n"
+         << "occupied_thresh: 0.65\nfree_thresh: 0.196\n" << yaml_extra;
+    std::ofstream pgm(directory_ + "/map.pgm", std::ios::binary);
+    if (pgm_header.empty()) {
+      pgm << "P5\n" << rows[0].size() << " " << rows.size() << "\n255\n";
+    } else {
+      pgm << pgm_header;
+    }
+    for (const std::string &row : rows) {
+      for (const char c : row) {
+        pgm.put(static_cast<char>(c == '#' ? 0 : 254));
+      }
+    }
+    return directory_ + "/map.yaml";
+  }
+
+  std::string cache_path() const { return directory_ + "/fields.bin"; }
+
+  std::string directory_;
+};
+
+const double kDiagonal = std::sqrt(2.0);
+
+TEST_F(DistanceFieldTest, LoadsTheMapBottomRowFirst) {
+  OccupancyBitmap bitmap;
+  std::string error;
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({"#..", "..."}), bitmap, &error)) << error;
+  EXPECT_EQ(bitmap.width(), 3);
+  EXPECT_EQ(bitmap.height(), 2);
+  EXPECT_TRUE(bitmap.blocked(0, 1));
+  EXPECT_FALSE(bitmap.blocked(0, 0));
+  EXPECT_FALSE(bitmap.blocked(2, 1));
+  // Outside the map.
+  EXPECT_TRUE(bitmap.blocked(3, 0));
+  EXPECT_TRUE(bitmap.blocked(0, -1));
+}
+
+TEST_F(DistanceFieldTest, RejectsMalformedMaps) {
+  OccupancyBitmap bitmap;
+  std::string error;
+  EXPECT_FALSE(OccupancyBitmap::load(directory_ + "/missing.yaml", bitmap, &error));
+  EXPECT_FALSE(OccupancyBitmap::load(write_map({"..."}, "resolution: fine\n"), bitmap, &error));
+  EXPECT_NE(error.find("resolution"), std::string::npos);
+  EXPECT_FALSE(OccupancyBitmap::load(write_map({"..."}, "negate: 1x\n"), bitmap, &error));
+  EXPECT_NE(error.find("negate"), std::string::npos);
+  EXPECT_FALSE(OccupancyBitmap::load(write_map({"..."}, "", "P5\n-3 1\n255\n"), bitmap, &error));
+  EXPECT_NE(error.find("size"), std::string::npos);
+  EXPECT_FALSE(OccupancyBitmap::load(write_map({"..."}, "", "P5\n3 wide\n255\n"), bitmap, &error));
+  EXPECT_FALSE(OccupancyBitmap::load(write_map({"..."}, "", "P5\n3 1\n0\n"), bitmap, &error));
+  EXPECT_NE(error.find("maxval"), std::string::npos);
+  EXPECT_FALSE(OccupancyBitmap::load(write_map({"..."}, "", "P5\n3 1\n65535\n"), bitmap, &error));
+  EXPECT_FALSE(OccupancyBitmap::load(write_map({"..."}, "", "P5\n3 2\n255\n"), bitmap, &error));
+  EXPECT_NE(error.find("truncated"), std::string::npos);
+}
+
+TEST_F(DistanceFieldTest, InflationBlocksTheCellsNearAWall) {
+  OccupancyBitmap bitmap;
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({".....", "..#..", "....."}), bitmap));
+  bitmap.inflate(1.0);
+  EXPECT_TRUE(bitmap.blocked(1, 1));
+  EXPECT_TRUE(bitmap.blocked(2, 0));
+  // The corners are further than the radius.
+  EXPECT_FALSE(bitmap.blocked(1, 0));
+  EXPECT_FALSE(bitmap.blocked(0, 1));
+}
+
+TEST_F(DistanceFieldTest, PathLengthsOnAnOpenGrid) {
+  OccupancyBitmap bitmap;
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({".....", ".....", ".....", ".....", "....."}), bitmap));
+  DistanceFieldCache cache;
+  ASSERT_TRUE(cache.open(cache_path(), bitmap, {{{0.5, 0.5}}}));
+  EXPECT_NEAR(cache.distance(0, 4.5, 0.5), 4.0, 1e-5);
+  EXPECT_NEAR(cache.distance(0, 4.5, 4.5), 4 * kDiagonal, 1e-5);
+  EXPECT_NEAR(cache.distance(0, 2.5, 4.5), 2 * kDiagonal + 2, 1e-5);
+  // From the source, to the source and between two other points, the last computed on demand.
+  EXPECT_NEAR(cache.path_length(0.5, 0.5, 3.5, 1.5), 1 + kDiagonal + 1, 1e-5);
+  EXPECT_NEAR(cache.path_length(3.5, 1.5, 0.5, 0.5), 1 + kDiagonal + 1, 1e-5);
+  EXPECT_NEAR(cache.path_length(4.5, 4.5, 4.5, 0.5), 4.0, 1e-5);
+  EXPECT_NEAR(cache.path_length(4.5, 0.5, 4.5, 4.5), 4.0, 1e-5);
+}
+
+TEST_F(DistanceFieldTest, PathsGoAroundWallsWithoutCuttingCorners) {
+  OccupancyBitmap bitmap;
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({"...", ".#.", "..."}), bitmap));
+  DistanceFieldCache cache;
+  ASSERT_TRUE(cache.open(cache_path(), bitmap, {{{0.5, 0.5}}}));
+  // Along two sides, the diagonals would touch the blocked center.
+  EXPECT_NEAR(cache.path_length(0.5, 0.5, 2.5, 2.5), 4.0, 1e-5);
+  std::vector<std::array<double, 2>> waypoints;
+  ASSERT_TRUE(cache.path(2.5, 2.5, 0.5, 0.5, waypoints));
+  ASSERT_EQ(waypoints.size(), 4u);
+  EXPECT_DOUBLE_EQ(waypoints.back()[0], 0.5);
+  EXPECT_DOUBLE_EQ(waypoints.back()[1], 0.5);
+  for (const std::array<double, 2> &waypoint : waypoints) {
+    EXPECT_FALSE(waypoint[0] == 1.5 && waypoint[1] == 1.5);
+  }
+}
+
+TEST_F(DistanceFieldTest, WalledOffPointsHaveNoPath) {
+  OccupancyBitmap bitmap;
+  // Far enough from the wall that neither end is taken for a point in inflated space next to it.
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({"....#.....", "....#.....", "....#....."}), bitmap));
+  DistanceFieldCache cache;
+  ASSERT_TRUE(cache.open(cache_path(), bitmap, {{{0.5, 1.5}}}));
+  EXPECT_TRUE(std::isinf(cache.distance(0, 9.5, 1.5)));
+  EXPECT_TRUE(std::isinf(cache.path_length(0.5, 1.5, 9.5, 1.5)));
+  EXPECT_TRUE(std::isinf(cache.path_length(9.5, 1.5, 0.5, 1.5)));
+  std::vector<std::array<double, 2>> waypoints;
+  EXPECT_FALSE(cache.path(0.5, 1.5, 9.5, 1.5, waypoints));
+  EXPECT_TRUE(waypoints.empty());
+  // Outside the map.
+  EXPECT_TRUE(std::isinf(cache.distance(0, -5.0, 1.5)));
+}
+
+TEST_F(DistanceFieldTest, ReopenMapsTheCache) {
+  OccupancyBitmap bitmap;
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({"....", ".#..", "...."}), bitmap));
+  const std::vector<std::array<double, 2>> sources{{{0.5, 0.5}}, {{3.5, 2.5}}};
+  double computed = 0;
+  {
+    DistanceFieldCache cache;
+    std::string error;
+    ASSERT_TRUE(cache.open(cache_path(), bitmap, sources, &error));
+    EXPECT_TRUE(error.empty()) << error;
+    EXPECT_FALSE(cache.loaded_from_cache());
+    computed = cache.distance(1, 0.5, 2.5);
+  }
+  DistanceFieldCache cache;
+  ASSERT_TRUE(cache.open(cache_path(), bitmap, sources));
+  EXPECT_TRUE(cache.loaded_from_cache());
+  EXPECT_EQ(cache.source_count(), 2u);
+  EXPECT_EQ(cache.distance(1, 0.5, 2.5), computed);
+  EXPECT_NEAR(cache.distance(0, 3.5, 0.5), 3.0, 1e-5);
+}
+
+TEST_F(DistanceFieldTest, ChangedMapOrSourcesMakeTheCacheStale) {
+  OccupancyBitmap bitmap;
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({"....", "....", "...."}), bitmap));
+  const std::vector<std::array<double, 2>> sources{{{0.5, 1.5}}};
+  {
+    DistanceFieldCache cache;
+    ASSERT_TRUE(cache.open(cache_path(), bitmap, sources));
+    EXPECT_NEAR(cache.distance(0, 3.5, 1.5), 3.0, 1e-5);
+  }
+  const std::uint64_t before = bitmap.checksum();
+  bitmap.set_blocked(2, 1, true);
+  EXPECT_NE(bitmap.checksum(), before);
+  {
+    DistanceFieldCache cache;
+    ASSERT_TRUE(cache.open(cache_path(), bitmap, sources));
+    EXPECT_FALSE(cache.loaded_from_cache());
+    EXPECT_NEAR(cache.distance(0, 3.5, 1.5), 3 + kDiagonal, 1e-5);
+  }
+  DistanceFieldCache cache;
+  ASSERT_TRUE(cache.open(cache_path(), bitmap, {{{0.5, 0.5}}}));
+  EXPECT_FALSE(cache.loaded_from_cache());
+}
+
+TEST_F(DistanceFieldTest, FieldsOnDemandAreRecomputedOnceEvicted) {
+  OccupancyBitmap bitmap;
+  ASSERT_TRUE(OccupancyBitmap::load(write_map({".....", ".....", "....."}), bitmap));
+  DistanceFieldCache cache(1);
+  ASSERT_TRUE(cache.open(cache_path(), bitmap, {{{4.5, 2.5}}}));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR(cache.path_length(0.5, 0.5, 4.5, 0.5), 4.0, 1e-5);
+    EXPECT_NEAR(cache.path_length(0.5, 2.5, 4.5, 0.5), 2 + 2 * kDiagonal, 1e-5);
+  }
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_flat_index_map.cpp
+ * @brief Unit tests of the open-addressing map from the fiducial ids to the dense indices.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+#include "final_project/flat_index_map.h"
+
+namespace final_project {
+namespace {
+
+TEST(FlatIndexMap, FindsNothingWhenEmpty) {
+  FlatIndexMap map;
+  EXPECT_EQ(map.size(), 0u);
+  EXPECT_EQ(map.find(0), -1);
+  EXPECT_EQ(map.find(42), -1);
+}
+
+TEST(FlatIndexMap, FindsTheInsertedIndices) {
+  FlatIndexMap map;
+  map.insert(7, 0);
+  map.insert(-3, 1);
+  map.insert(0, 2);
+  map.insert(std::numeric_limits<int>::max(), 3);
+  EXPECT_EQ(map.size(), 4u);
+  EXPECT_EQ(map.find(7), 0);
+  EXPECT_EQ(map.find(-3), 1);
+  EXPECT_EQ(map.find(0), 2);
+  EXPECT_EQ(map.find(std::numeric_limits<int>::max()), 3);
+  EXPECT_EQ(map.find(8), -1);
+}
+
+TEST(FlatIndexMap, ReplacesTheIndexOfAKey) {
+  FlatIndexMap map;
+  map.insert(5, 1);
+  map.insert(5, 9);
+  EXPECT_EQ(map.size(), 1u);
+  EXPECT_EQ(map.find(5), 9);
+}
+
+TEST(FlatIndexMap, GrowsPastManyKeys) {
+  // Consecutive ids and ids a power of two apart, both of which collide under a masked identity hash.
+  FlatIndexMap map;
+  for (int i = 0; i < 5000; i++) {
+    map.insert(i % 2 ? i : i << 10, i);
+  }
+  EXPECT_EQ(map.size(), 5000u);
+  for (int i = 0; i < 5000; i++) {
+    ASSERT_EQ(map.find(i % 2 ? i : i << 10), i);
+  }
+  EXPECT_EQ(map.find(5001), -1);
+}
+
+TEST(FlatIndexMap, AgreesWithAStandardMap) {
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> key(-1000, 1000);
+  FlatIndexMap map;
+  std::unordered_map<int, int> expected;
+  for (int i = 0; i < 3000; i++) {
+    const int k = key(rng);
+    map.insert(k, i);
+    expected[k] = i;
+  }
+  EXPECT_EQ(map.size(), expected.size());
+  for (int k = -1100; k <= 1100; k++) {
+    const auto found = expected.find(k);
+    ASSERT_EQ(map.find(k), found == expected.end() ? -1 : found->second) << "key " << k;
+  }
+}
+
+TEST(FlatIndexMap, ClearKeepsTheMapUsable) {
+  FlatIndexMap map;
+  for (int i = 0; i < 100; i++) {
+    map.insert(i, i);
+  }
+  map.clear();
+  EXPECT_EQ(map.size(), 0u);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(map.find(i), -1);
+  }
+  map.insert(3, 30);
+  EXPECT_EQ(map.find(3), 30);
+  EXPECT_EQ(map.size(), 1u);
+}
+
+TEST(FlatIndexMap, ReserveKeepsTheKeys) {
+  FlatIndexMap map;
+  map.insert(1, 10);
+  map.reserve(1000);
+  EXPECT_EQ(map.find(1), 10);
+  for (int i = 2; i < 1000; i++) {
+    map.insert(i, i * 10);
+  }
+  for (int i = 1; i < 1000; i++) {
+    ASSERT_EQ(map.find(i), i * 10);
+  }
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,177 @@
+/**
+ * @file test_fleet_coordinator.cpp
+ * @brief Unit tests of the per-robot task deques and the work stealing between the robots.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "final_project/fleet_coordinator.h"
+
+namespace final_project {
+namespace {
+
+// Two robots at either end of a corridor, with two tasks next to each.
+FleetCoordinator corridor() {
+  FleetCoordinator fleet(2);
+  fleet.set_position(0, {{0, 0}});
+  fleet.set_position(1, {{10, 0}});
+  fleet.add_task({{1, 0}});
+  fleet.add_task({{9, 0}});
+  fleet.add_task({{2, 0}});
+  fleet.add_task({{8, 0}});
+  return fleet;
+}
+
+// Takes every task a robot is handed until none is pending anywhere.
+std::vector<int> drain(FleetCoordinator &fleet, int robot) {
+  std::vector<int> tasks;
+  for (int task = fleet.next(robot); task >= 0; task = fleet.next(robot)) {
+    tasks.push_back(task);
+  }
+  return tasks;
+}
+
+TEST(FleetCoordinator, DistributesTheTasksNearEachRobot) {
+  FleetCoordinator fleet = corridor();
+  EXPECT_EQ(fleet.task_count(), 4u);
+  EXPECT_EQ(fleet.pending(), 4u);
+  fleet.distribute();
+  bool stolen = true;
+  EXPECT_EQ(fleet.next(0, &stolen), 0);
+  EXPECT_FALSE(stolen);
+  EXPECT_EQ(fleet.next(1, &stolen), 1);
+  EXPECT_FALSE(stolen);
+  EXPECT_EQ(fleet.next(0), 2);
+  EXPECT_EQ(fleet.next(1), 3);
+  EXPECT_EQ(fleet.pending(), 0u);
+  EXPECT_EQ(fleet.next(0), -1);
+  EXPECT_EQ(fleet.steals(), 0u);
+}
+
+TEST(FleetCoordinator, StealsTheCheapestTaskWhenIdle) {
+  FleetCoordinator fleet = corridor();
+  fleet.distribute();
+  EXPECT_EQ(fleet.next(0), 0);
+  EXPECT_EQ(fleet.next(0), 2);
+  // Robot 0 stands at 2, the task at 8 is closer than the one at 9.
+  bool stolen = false;
+  EXPECT_EQ(fleet.next(0, &stolen), 3);
+  EXPECT_TRUE(stolen);
+  EXPECT_EQ(fleet.steals(), 1u);
+  EXPECT_EQ(fleet.next(1, &stolen), 1);
+  EXPECT_FALSE(stolen);
+  EXPECT_EQ(fleet.next(1), -1);
+}
+
+TEST(FleetCoordinator, HandsOutEveryTaskOnce) {
+  FleetCoordinator fleet(3);
+  for (int i = 0; i < 20; i++) {
+    fleet.add_task({{static_cast<double>(i % 5), static_cast<double>(i / 5)}});
+  }
+  fleet.distribute();
+  std::vector<int> handed(20, 0);
+  for (int round = 0; round < 20; round++) {
+    for (int robot = 0; robot < 3; robot++) {
+      const int task = fleet.next(robot);
+      if (task >= 0) {
+        handed[task]++;
+      }
+    }
+  }
+  for (int task = 0; task < 20; task++) {
+    EXPECT_EQ(handed[task], 1) << "task " << task;
+  }
+  EXPECT_EQ(fleet.pending(), 0u);
+}
+
+TEST(FleetCoordinator, SkipsCompletedTasks) {
+  FleetCoordinator fleet = corridor();
+  fleet.distribute();
+  fleet.complete(0);
+  fleet.complete(3);
+  EXPECT_TRUE(fleet.completed(0));
+  EXPECT_FALSE(fleet.completed(1));
+  EXPECT_EQ(fleet.pending(), 2u);
+  EXPECT_EQ(drain(fleet, 0), (std::vector<int>{2, 1}));
+}
+
+TEST(FleetCoordinator, DeferredTasksComeBackLast) {
+  FleetCoordinator fleet = corridor();
+  fleet.distribute();
+  const int first = fleet.next(0);
+  EXPECT_EQ(first, 0);
+  EXPECT_EQ(fleet.pending(), 3u);
+  fleet.defer(0, first);
+  EXPECT_EQ(fleet.pending(), 4u);
+  EXPECT_EQ(fleet.next(0), 2);
+  EXPECT_EQ(fleet.next(0), 0);
+}
+
+TEST(FleetCoordinator, AssignsToTheRobotThatReachesFirst) {
+  FleetCoordinator fleet = corridor();
+  fleet.distribute();
+  const int task = fleet.add_task({{7, 0}});
+  EXPECT_EQ(fleet.pending(), 5u);
+  EXPECT_EQ(fleet.assign(task), 1);
+  EXPECT_EQ(drain(fleet, 1), (std::vector<int>{1, 3, 4, 2, 0}));
+}
+
+TEST(FleetCoordinator, UsesTheGivenCost) {
+  // A wall at x = 5 that costs 100 to cross makes every task a robot's own.
+  FleetCoordinator fleet(2);
+  fleet.set_position(0, {{0, 0}});
+  fleet.set_position(1, {{10, 0}});
+  fleet.set_cost([](const std::array<double, 2> &from, const std::array<double, 2> &to) {
+    return std::fabs(to[0] - from[0]) + ((from[0] < 5) != (to[0] < 5) ? 100.0 : 0.0);
+  });
+  fleet.add_task({{4, 0}});
+  fleet.add_task({{3, 0}});
+  fleet.add_task({{6, 0}});
+  fleet.distribute();
+  EXPECT_EQ(fleet.next(1), 2);
+  EXPECT_EQ(fleet.next(0), 1);
+  EXPECT_EQ(fleet.next(0), 0);
+  EXPECT_EQ(fleet.location(0)[0], 4);
+}
+
+TEST(FleetCoordinator, UnreachableTasksDoNotPileOnOneRobot) {
+  FleetCoordinator fleet(2);
+  fleet.set_cost([](const std::array<double, 2> &, const std::array<double, 2> &) {
+    return std::numeric_limits<double>::infinity();
+  });
+  for (int i = 0; i < 4; i++) {
+    fleet.add_task({{static_cast<double>(i), 0}});
+  }
+  fleet.distribute();
+  EXPECT_GE(fleet.next(0), 0);
+  EXPECT_GE(fleet.next(1), 0);
+  EXPECT_GE(fleet.next(0), 0);
+  EXPECT_GE(fleet.next(1), 0);
+  EXPECT_EQ(fleet.steals(), 0u);
+}
+
+TEST(FleetCoordinator, HandlesNoRobots) {
+  FleetCoordinator fleet;
+  const int task = fleet.add_task({{1, 1}});
+  fleet.distribute();
+  EXPECT_EQ(fleet.assign(task), -1);
+  EXPECT_EQ(fleet.robot_count(), 0u);
+  EXPECT_EQ(fleet.pending(), 1u);
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
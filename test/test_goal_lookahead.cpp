@@ -0,0 +1,64 @@
+/**
+ * @file test_goal_lookahead.cpp
+ * @brief Unit tests of the decision to send a robot its next goal before it stops at the current one.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "final_project/goal_lookahead.h"
+
+namespace final_project {
+namespace {
+
+TEST(GoalLookahead, PassesWithinTheRadius) {
+  GoalLookahead lookahead(0.5);
+  lookahead.arm(2.0, 1.0, false);
+  EXPECT_FALSE(lookahead.passed(0.0, 1.0));
+  EXPECT_FALSE(lookahead.passed(1.4, 1.0));
+  EXPECT_TRUE(lookahead.passed(1.5, 1.0));
+  EXPECT_TRUE(lookahead.passed(2.3, 1.3));
+  EXPECT_TRUE(lookahead.passed(2.0, 1.0));
+}
+
+TEST(GoalLookahead, HeldGoalsAreNeverPassed) {
+  GoalLookahead lookahead(0.5);
+  lookahead.arm(2.0, 1.0, true);
+  EXPECT_FALSE(lookahead.passed(2.0, 1.0));
+  // Arming the next goal replaces the hold of the current one.
+  lookahead.arm(4.0, 1.0, false);
+  EXPECT_FALSE(lookahead.passed(2.0, 1.0));
+  EXPECT_TRUE(lookahead.passed(3.8, 1.0));
+}
+
+TEST(GoalLookahead, NothingIsPassedOnceDisarmed) {
+  GoalLookahead lookahead(0.5);
+  EXPECT_FALSE(lookahead.passed(0.0, 0.0));
+  lookahead.arm(0.0, 0.0, false);
+  EXPECT_TRUE(lookahead.passed(0.0, 0.0));
+  lookahead.disarm();
+  EXPECT_FALSE(lookahead.passed(0.0, 0.0));
+}
+
+TEST(GoalLookahead, ZeroRadiusDisablesTheLookahead) {
+  GoalLookahead lookahead;
+  EXPECT_DOUBLE_EQ(lookahead.radius(), 0.0);
+  lookahead.arm(1.0, 1.0, false);
+  EXPECT_FALSE(lookahead.passed(1.0, 1.0));
+  lookahead.set_radius(0.3);
+  EXPECT_DOUBLE_EQ(lookahead.radius(), 0.3);
+  EXPECT_TRUE(lookahead.passed(1.0, 1.2));
+  lookahead.set_radius(-1.0);
+  EXPECT_FALSE(lookahead.passed(1.0, 1.0));
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+/**
+ * @file test_goal_retry.cpp
+ * @brief Unit tests of the retries, deferrals and deadlines of the goals move_base fails.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "final_project/goal_retry.h"
+
+namespace final_project {
+namespace {
+
+using Decision = GoalRetryPolicy::Decision;
+
+TEST(GoalRetryPolicy, RetriesThenDefersThenGivesUp) {
+  GoalRetryPolicy::Params params;
+  params.max_retries = 2;
+  params.max_deferrals = 1;
+  GoalRetryPolicy policy(params);
+  EXPECT_EQ(policy.failed(3, true), Decision::Retry);
+  EXPECT_EQ(policy.retries(3), 1);
+  EXPECT_EQ(policy.failed(3, true), Decision::Retry);
+  EXPECT_EQ(policy.failed(3, true), Decision::Defer);
+  // The retries start over at the end of the route.
+  EXPECT_EQ(policy.retries(3), 0);
+  EXPECT_EQ(policy.failed(3, true), Decision::Retry);
+  EXPECT_EQ(policy.failed(3, true), Decision::Retry);
+  EXPECT_EQ(policy.failed(3, true), Decision::GiveUp);
+  EXPECT_EQ(policy.failures(), 6u);
+  EXPECT_EQ(policy.given_up(), 1u);
+  EXPECT_EQ(policy.retries(3), 0);
+}
+
+TEST(GoalRetryPolicy, LastGoalsAreNotDeferred) {
+  GoalRetryPolicy::Params params;
+  params.max_retries = 1;
+  GoalRetryPolicy policy(params);
+  EXPECT_EQ(policy.failed(0, false), Decision::Retry);
+  EXPECT_EQ(policy.failed(0, false), Decision::GiveUp);
+}
+
+TEST(GoalRetryPolicy, GoalsAreKeptApartAndForgottenOnceReached) {
+  GoalRetryPolicy policy;
+  EXPECT_EQ(policy.failed(1, true), Decision::Retry);
+  EXPECT_EQ(policy.failed(2, true), Decision::Retry);
+  EXPECT_EQ(policy.retries(1), 1);
+  policy.succeeded(1);
+  EXPECT_EQ(policy.retries(1), 0);
+  EXPECT_EQ(policy.retries(2), 1);
+  EXPECT_EQ(policy.failures(), 2u);
+}
+
+TEST(GoalRetryPolicy, PerturbsEachRetryInAnotherDirection) {
+  GoalRetryPolicy::Params params;
+  params.max_retries = 4;
+  params.perturbation = 0.1;
+  GoalRetryPolicy policy(params);
+  const std::array<double, 2> nominal = {{1.0, 2.0}};
+  EXPECT_EQ(policy.perturb(5, nominal), nominal);
+  std::vector<double> angles;
+  for (int retry = 1; retry <= 4; retry++) {
+    ASSERT_EQ(policy.failed(5, true), Decision::Retry);
+    const std::array<double, 2> moved = policy.perturb(5, nominal);
+    const double dx = moved[0] - nominal[0];
+    const double dy = moved[1] - nominal[1];
+    EXPECT_NEAR(std::hypot(dx, dy), 0.1 * retry, 1e-12);
+    angles.push_back(std::atan2(dy, dx));
+  }
+  for (std::size_t i = 0; i < angles.size(); i++) {
+    for (std::size_t j = i + 1; j < angles.size(); j++) {
+      EXPECT_GT(std::fabs(std::remainder(angles[i] - angles[j], 2 * M_PI)), 0.3);
+    }
+  }
+  params.perturbation = 0.0;
+  policy.set_params(params);
+  EXPECT_EQ(policy.perturb(5, nominal), nominal);
+  EXPECT_EQ(policy.retries(5), 4);
+}
+
+TEST(GoalRetryPolicy, DeadlinesFollowTheEta) {
+  GoalRetryPolicy::Params params;
+  params.speed = 0.2;
+  params.deadline_factor = 3.0;
+  params.min_deadline = 20.0;
+  GoalRetryPolicy policy(params);
+  EXPECT_DOUBLE_EQ(policy.deadline(10.0), 150.0);
+  EXPECT_DOUBLE_EQ(policy.deadline(1.0), 20.0);
+  EXPECT_DOUBLE_EQ(policy.deadline(-5.0), 20.0);
+  // An unknown length only gets the minimum.
+  EXPECT_DOUBLE_EQ(policy.deadline(std::numeric_limits<double>::infinity()), 20.0);
+  params.deadline_factor = 0.0;
+  policy.set_params(params);
+  EXPECT_DOUBLE_EQ(policy.deadline(10.0), 0.0);
+}
+
+TEST(GoalRetryPolicy, NamesEveryDecision) {
+  EXPECT_EQ(std::string(to_string(Decision::Retry)), "retried");
+  EXPECT_EQ(std::string(to_string(Decision::Defer)), "deferred");
+  EXPECT_EQ(std::string(to_string(Decision::GiveUp)), "given up");
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,195 @@
+/**
+ * @file test_marker_cache.cpp
+ * @brief Unit tests of the fused marker poses kept on disk between launches.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "final_project/marker_cache.h"
+
+namespace final_project {
+namespace {
+
+constexpr std::uint64_t kMap = 0x1234abcd5678ef00ull;
+
+// A cache file of the temporary directory, removed with its temporary file when the test ends.
+class MarkerCacheTest : public testing::Test {
+ protected:
+  MarkerCacheTest() : path_("/tmp/final_project_test_marker_cache_" + std::to_string(getpid()) + ".bin") {}
+
+  void TearDown() override {
+    std::remove(path_.c_str());
+    std::remove((path_ + ".tmp").c_str());
+  }
+
+  std::vector<char> read_bytes() const {
+    std::ifstream in(path_, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  void write_bytes(const std::vector<char> &bytes) const {
+    std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  }
+
+  std::string path_;
+};
+
+CachedMarker marker(int fiducial_id, double x, double y) {
+  CachedMarker m;
+  m.fiducial_id = fiducial_id;
+  m.samples = 12;
+  m.x = x;
+  m.y = y;
+  m.yaw = 0.25;
+  m.cov_xx = 0.0004;
+  m.cov_xy = 0.0001;
+  m.cov_yy = 0.0005;
+  m.yaw_std = 0.02;
+  m.effective_samples = 10.5;
+  m.localized_at = 1000;
+  return m;
+}
+
+void expect_same(const CachedMarker &a, const CachedMarker &b) {
+  EXPECT_EQ(a.fiducial_id, b.fiducial_id);
+  EXPECT_EQ(a.samples, b.samples);
+  EXPECT_EQ(a.x, b.x);
+  EXPECT_EQ(a.y, b.y);
+  EXPECT_EQ(a.yaw, b.yaw);
+  EXPECT_EQ(a.cov_xx, b.cov_xx);
+  EXPECT_EQ(a.cov_xy, b.cov_xy);
+  EXPECT_EQ(a.cov_yy, b.cov_yy);
+  EXPECT_EQ(a.yaw_std, b.yaw_std);
+  EXPECT_EQ(a.effective_samples, b.effective_samples);
+  EXPECT_EQ(a.localized_at, b.localized_at);
+}
+
+TEST_F(MarkerCacheTest, RoundTrip) {
+  const std::vector<CachedMarker> written{marker(3, 1.5, -2.0), marker(7, -0.5, 4.25)};
+  std::string error;
+  ASSERT_TRUE(write_marker_cache(path_, kMap, written, &error)) << error;
+  std::vector<CachedMarker> read;
+  ASSERT_TRUE(read_marker_cache(path_, kMap, read, &error)) << error;
+  ASSERT_EQ(read.size(), written.size());
+  for (std::size_t i = 0; i < read.size(); i++) {
+    expect_same(read[i], written[i]);
+  }
+  // The temporary file was renamed over the cache.
+  EXPECT_NE(access(path_.c_str(), F_OK), -1);
+  EXPECT_EQ(access((path_ + ".tmp").c_str(), F_OK), -1);
+}
+
+TEST_F(MarkerCacheTest, EmptyCacheRoundTrip) {
+  ASSERT_TRUE(write_marker_cache(path_, kMap, {}));
+  std::vector<CachedMarker> read{marker(1, 0, 0)};
+  EXPECT_TRUE(read_marker_cache(path_, kMap, read));
+  EXPECT_TRUE(read.empty());
+}
+
+TEST_F(MarkerCacheTest, MissingFileIsNotRead) {
+  std::vector<CachedMarker> read{marker(1, 0, 0)};
+  std::string error;
+  EXPECT_FALSE(read_marker_cache(path_, kMap, read, &error));
+  EXPECT_TRUE(read.empty());
+  EXPECT_FALSE(error.empty());
+}
+
+TEST_F(MarkerCacheTest, TruncatedFileIsRejected) {
+  ASSERT_TRUE(write_marker_cache(path_, kMap, {marker(3, 1.5, -2.0), marker(7, -0.5, 4.25)}));
+  std::vector<char> bytes = read_bytes();
+  std::vector<CachedMarker> read;
+  // Half of the last record, then half of the header.
+  bytes.resize(bytes.size() - sizeof(CachedMarker) / 2);
+  write_bytes(bytes);
+  EXPECT_FALSE(read_marker_cache(path_, kMap, read));
+  EXPECT_TRUE(read.empty());
+  bytes.resize(16);
+  write_bytes(bytes);
+  EXPECT_FALSE(read_marker_cache(path_, kMap, read));
+  EXPECT_TRUE(read.empty());
+}
+
+TEST_F(MarkerCacheTest, FlippedByteFailsTheRecordChecksum) {
+  ASSERT_TRUE(write_marker_cache(path_, kMap, {marker(3, 1.5, -2.0), marker(7, -0.5, 4.25)}));
+  std::vector<char> bytes = read_bytes();
+  bytes[bytes.size() - 20] ^= 0x01;
+  write_bytes(bytes);
+  std::vector<CachedMarker> read;
+  std::string error;
+  EXPECT_FALSE(read_marker_cache(path_, kMap, read, &error));
+  EXPECT_TRUE(read.empty());
+  EXPECT_NE(error.find("corrupt"), std::string::npos);
+}
+
+TEST_F(MarkerCacheTest, OtherMapIsRejected) {
+  ASSERT_TRUE(write_marker_cache(path_, kMap, {marker(3, 1.5, -2.0)}));
+  std::vector<CachedMarker> read;
+  std::string error;
+  EXPECT_FALSE(read_marker_cache(path_, kMap + 1, read, &error));
+  EXPECT_TRUE(read.empty());
+  EXPECT_NE(error.find("another map"), std::string::npos);
+}
+
+TEST_F(MarkerCacheTest, UnwritablePathFails) {
+  std::string error;
+  EXPECT_FALSE(write_marker_cache("/nonexistent/markers.bin", kMap, {marker(3, 1.5, -2.0)}, &error));
+  EXPECT_FALSE(error.empty());
+}
+
+TEST(MarkerCacheTrusted, AgeLimit) {
+  MarkerCacheFreshness freshness;
+  freshness.max_age = 100;
+  const CachedMarker m = marker(3, 1.5, -2.0);
+  EXPECT_TRUE(marker_cache_trusted(m, m.localized_at + 100, freshness));
+  EXPECT_FALSE(marker_cache_trusted(m, m.localized_at + 100.5, freshness));
+  // Any age once the limit is off.
+  freshness.max_age = 0;
+  EXPECT_TRUE(marker_cache_trusted(m, m.localized_at + 1e9, freshness));
+}
+
+TEST(MarkerCacheTrusted, PrecisionLimit) {
+  MarkerCacheFreshness freshness;
+  freshness.max_age = 0;
+  CachedMarker m = marker(3, 1.5, -2.0);
+  // The standard error of the position is sqrt((cov_xx + cov_yy) / effective_samples).
+  m.cov_xx = 0.0005;
+  m.cov_yy = 0.0004;
+  m.effective_samples = 1;
+  freshness.max_std_error = 0.031;
+  EXPECT_TRUE(marker_cache_trusted(m, 0, freshness));
+  freshness.max_std_error = 0.029;
+  EXPECT_FALSE(marker_cache_trusted(m, 0, freshness));
+  // More samples shrink the error.
+  m.effective_samples = 4;
+  EXPECT_TRUE(marker_cache_trusted(m, 0, freshness));
+  // Without samples the spread means nothing.
+  m.effective_samples = 0;
+  EXPECT_FALSE(marker_cache_trusted(m, 0, freshness));
+}
+
+TEST(MarkerCacheTrusted, EstimateRoundTrip) {
+  const CachedMarker m = marker(3, 1.5, -2.0);
+  expect_same(to_cached_marker(to_estimate(m), m.localized_at), m);
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,221 @@
+/**
+ * @file test_mission_state.cpp
+ * @brief Unit tests of the transition tables of the robots of a mission.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "final_project/mission_state.h"
+
+namespace final_project {
+namespace {
+
+const RobotState kStates[kRobotStates] = {RobotState::Idle, RobotState::Driving, RobotState::Looking,
+                                          RobotState::HeadingHome, RobotState::Home};
+const RobotEvent kEvents[kRobotEvents] = {RobotEvent::GoalSent, RobotEvent::GoalReached, RobotEvent::GoalFailed,
+                                          RobotEvent::MarkerLocalized, RobotEvent::SentHome};
+
+// Moves a fresh robot of a role to a state through allowed events.
+void reach(MissionStateMachine &machine, int robot, RobotState state) {
+  switch (state) {
+    case RobotState::Idle:
+      break;
+    case RobotState::Driving:
+      ASSERT_TRUE(machine.dispatch(robot, RobotEvent::GoalSent));
+      break;
+    case RobotState::Looking:
+      ASSERT_TRUE(machine.dispatch(robot, RobotEvent::GoalSent));
+      ASSERT_TRUE(machine.dispatch(robot, RobotEvent::GoalReached));
+      break;
+    case RobotState::HeadingHome:
+      ASSERT_TRUE(machine.dispatch(robot, RobotEvent::SentHome));
+      break;
+    case RobotState::Home:
+      ASSERT_TRUE(machine.dispatch(robot, RobotEvent::SentHome));
+      ASSERT_TRUE(machine.dispatch(robot, RobotEvent::GoalReached));
+      break;
+  }
+  ASSERT_TRUE(machine.in(robot, state));
+}
+
+TEST(MissionStateMachine, ExplorerLooksWhereItArrives) {
+  MissionStateMachine machine;
+  const int robot = machine.add_robot(RobotRole::Explorer);
+  EXPECT_TRUE(machine.in(robot, RobotState::Idle));
+  EXPECT_FALSE(machine.busy(robot));
+  EXPECT_TRUE(machine.dispatch(robot, RobotEvent::GoalSent, 1.0));
+  EXPECT_TRUE(machine.busy(robot));
+  EXPECT_TRUE(machine.dispatch(robot, RobotEvent::GoalReached, 2.0));
+  EXPECT_EQ(machine.state(robot), RobotState::Looking);
+  EXPECT_TRUE(machine.dispatch(robot, RobotEvent::MarkerLocalized, 3.0));
+  EXPECT_EQ(machine.state(robot), RobotState::Idle);
+  EXPECT_TRUE(machine.dispatch(robot, RobotEvent::SentHome, 4.0));
+  EXPECT_TRUE(machine.dispatch(robot, RobotEvent::GoalReached, 5.0));
+  EXPECT_EQ(machine.state(robot), RobotState::Home);
+  EXPECT_FALSE(machine.busy(robot));
+  ASSERT_EQ(machine.transitions().size(), 5u);
+  EXPECT_EQ(machine.transitions()[1].from, RobotState::Driving);
+  EXPECT_EQ(machine.transitions()[1].to, RobotState::Looking);
+  EXPECT_DOUBLE_EQ(machine.transitions()[4].time, 5.0);
+}
+
+TEST(MissionStateMachine, FollowerWaitsWhereItArrives) {
+  MissionStateMachine machine;
+  const int robot = machine.add_robot(RobotRole::Follower);
+  EXPECT_TRUE(machine.dispatch(robot, RobotEvent::GoalSent));
+  EXPECT_TRUE(machine.dispatch(robot, RobotEvent::GoalReached));
+  EXPECT_EQ(machine.state(robot), RobotState::Idle);
+}
+
+TEST(MissionStateMachine, RejectsIllegalTransitions) {
+  // The events each state of each role rejects, every other event is allowed.
+  struct Case {
+    RobotRole role;
+    RobotState state;
+    std::vector<RobotEvent> rejected;
+  };
+  const std::vector<Case> cases = {
+      {RobotRole::Explorer, RobotState::Idle,
+       {RobotEvent::GoalReached, RobotEvent::GoalFailed, RobotEvent::MarkerLocalized}},
+      {RobotRole::Explorer, RobotState::Driving, {}},
+      {RobotRole::Explorer, RobotState::Looking, {RobotEvent::GoalReached, RobotEvent::GoalFailed}},
+      {RobotRole::Explorer, RobotState::HeadingHome,
+       {RobotEvent::GoalSent, RobotEvent::MarkerLocalized, RobotEvent::SentHome}},
+      {RobotRole::Explorer, RobotState::Home,
+       {RobotEvent::GoalSent, RobotEvent::GoalReached, RobotEvent::GoalFailed, RobotEvent::MarkerLocalized,
+        RobotEvent::SentHome}},
+      {RobotRole::Follower, RobotState::Idle,
+       {RobotEvent::GoalReached, RobotEvent::GoalFailed, RobotEvent::MarkerLocalized}},
+      {RobotRole::Follower, RobotState::Driving, {RobotEvent::MarkerLocalized}},
+      {RobotRole::Follower, RobotState::HeadingHome,
+       {RobotEvent::GoalSent, RobotEvent::MarkerLocalized, RobotEvent::SentHome}},
+      {RobotRole::Follower, RobotState::Home,
+       {RobotEvent::GoalSent, RobotEvent::GoalReached, RobotEvent::GoalFailed, RobotEvent::MarkerLocalized,
+        RobotEvent::SentHome}},
+  };
+  for (const Case &c : cases) {
+    for (RobotEvent event : kEvents) {
+      const bool rejected = std::find(c.rejected.begin(), c.rejected.end(), event) != c.rejected.end();
+      MissionStateMachine machine;
+      const int robot = machine.add_robot(c.role);
+      reach(machine, robot, c.state);
+      const std::size_t logged = machine.transitions().size();
+      EXPECT_EQ(machine.dispatch(robot, event), !rejected)
+          << to_string(c.state) << " on " << to_string(event);
+      if (rejected) {
+        EXPECT_EQ(machine.state(robot), c.state);
+        EXPECT_EQ(machine.transitions().size(), logged);
+      }
+    }
+  }
+}
+
+TEST(MissionStateMachine, FollowerNeverLooks) {
+  for (RobotState state : kStates) {
+    for (RobotEvent event : kEvents) {
+      RobotState next;
+      if (MissionStateMachine::next(RobotRole::Follower, state, event, next)) {
+        EXPECT_NE(next, RobotState::Looking) << to_string(state) << " on " << to_string(event);
+      }
+    }
+  }
+  RobotState next;
+  EXPECT_FALSE(MissionStateMachine::next(RobotRole::Follower, RobotState::Looking, RobotEvent::GoalSent, next));
+  EXPECT_EQ(next, RobotState::Looking);
+}
+
+TEST(MissionStateMachine, LateCallbacksDoNotMoveTheRobotBack) {
+  MissionStateMachine machine;
+  const int robot = machine.add_robot(RobotRole::Explorer);
+  reach(machine, robot, RobotState::Home);
+  // The result of a goal preempted by the home goal comes in after the robot is back.
+  EXPECT_FALSE(machine.dispatch(robot, RobotEvent::GoalFailed));
+  EXPECT_FALSE(machine.dispatch(robot, RobotEvent::MarkerLocalized));
+  EXPECT_EQ(machine.state(robot), RobotState::Home);
+}
+
+TEST(MissionStateMachine, ReplaysItsLog) {
+  MissionStateMachine machine;
+  const int explorer = machine.add_robot(RobotRole::Explorer);
+  const int follower = machine.add_robot(RobotRole::Follower);
+  machine.dispatch(explorer, RobotEvent::GoalSent, 1.0);
+  machine.dispatch(follower, RobotEvent::GoalSent, 1.5);
+  machine.dispatch(explorer, RobotEvent::MarkerLocalized, 2.0);
+  machine.dispatch(follower, RobotEvent::GoalReached, 3.0);
+  machine.dispatch(explorer, RobotEvent::SentHome, 4.0);
+  EXPECT_EQ(machine.count(RobotState::Idle), 1u);
+  EXPECT_EQ(machine.count(RobotState::HeadingHome), 1u);
+
+  MissionStateMachine replayed;
+  replayed.add_robot(RobotRole::Explorer);
+  replayed.add_robot(RobotRole::Follower);
+  ASSERT_TRUE(replayed.replay(machine.transitions()));
+  EXPECT_EQ(replayed.state(explorer), RobotState::HeadingHome);
+  EXPECT_EQ(replayed.state(follower), RobotState::Idle);
+  EXPECT_EQ(replayed.transitions().size(), machine.transitions().size());
+
+  // A log that does not match the robots is refused at the first mismatch.
+  std::vector<StateTransition> tampered = machine.transitions();
+  tampered[2].to = RobotState::Looking;
+  MissionStateMachine refused;
+  refused.add_robot(RobotRole::Explorer);
+  refused.add_robot(RobotRole::Follower);
+  EXPECT_FALSE(refused.replay(tampered));
+  tampered = machine.transitions();
+  tampered[0].robot = 5;
+  EXPECT_FALSE(refused.replay(tampered));
+}
+
+TEST(MissionStateMachine, LogIsBounded) {
+  MissionStateMachine machine;
+  const int follower = machine.add_robot(RobotRole::Follower);
+  const std::size_t transitions = kMaxLoggedTransitions + 10;
+  for (std::size_t i = 0; i < transitions; i++) {
+    ASSERT_TRUE(machine.dispatch(follower, i % 2 == 0 ? RobotEvent::GoalSent : RobotEvent::GoalReached));
+  }
+  EXPECT_EQ(machine.transitions().size(), kMaxLoggedTransitions);
+  EXPECT_EQ(machine.unlogged(), 10u);
+  // The states still move once the log is full.
+  EXPECT_EQ(machine.state(follower), RobotState::Idle);
+
+  // The log kept is the start of the mission, it replays.
+  MissionStateMachine replayed;
+  replayed.add_robot(RobotRole::Follower);
+  EXPECT_TRUE(replayed.replay(machine.transitions()));
+  machine.clear();
+  EXPECT_TRUE(machine.transitions().empty());
+  EXPECT_EQ(machine.unlogged(), 0u);
+}
+
+TEST(MissionStateMachine, NamesEveryStateAndEvent) {
+  EXPECT_STREQ(to_string(RobotState::HeadingHome), "HeadingHome");
+  EXPECT_STREQ(to_string(RobotEvent::GoalReached), "GoalReached");
+  for (RobotState state : kStates) {
+    EXPECT_GT(std::strlen(to_string(state)), 0u);
+  }
+  for (RobotEvent event : kEvents) {
+    EXPECT_GT(std::strlen(to_string(event)), 0u);
+  }
+  MissionStateMachine machine;
+  machine.add_robot(RobotRole::Explorer);
+  machine.clear();
+  EXPECT_EQ(machine.robot_count(), 0u);
+  EXPECT_TRUE(machine.transitions().empty());
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
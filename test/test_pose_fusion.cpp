@@ -0,0 +1,176 @@
+/**
+ * @file test_pose_fusion.cpp
+ * @brief Unit tests of the incremental SE(2) fusion of the marker observations.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "final_project/pose_fusion.h"
+
+namespace final_project {
+namespace {
+
+// Observations of a marker at (1, 2, 0.3) with centimeter noise, always the same for a seed.
+class NoisyMarker {
+ public:
+  explicit NoisyMarker(unsigned seed) : rng_(seed) {}
+
+  bool add_to(PoseFusion &fusion, int fiducial_id) {
+    return fusion.add(fiducial_id, 1.0 + position_(rng_), 2.0 + position_(rng_), 0.3 + yaw_(rng_));
+  }
+
+ private:
+  std::mt19937 rng_;
+  std::normal_distribution<double> position_{0.0, 0.01};
+  std::normal_distribution<double> yaw_{0.0, 0.02};
+};
+
+TEST(PoseFusion, ConvergesToTheMeanOfTheObservations) {
+  PoseFusion fusion;
+  NoisyMarker marker(1);
+  Se2Estimate estimate;
+  EXPECT_FALSE(fusion.estimate(7, estimate));
+  for (int i = 0; i < 50; i++) {
+    ASSERT_TRUE(marker.add_to(fusion, 7));
+  }
+  ASSERT_TRUE(fusion.estimate(7, estimate));
+  EXPECT_EQ(estimate.fiducial_id, 7);
+  EXPECT_NEAR(estimate.x, 1.0, 0.01);
+  EXPECT_NEAR(estimate.y, 2.0, 0.01);
+  EXPECT_NEAR(estimate.yaw, 0.3, 0.02);
+  EXPECT_EQ(estimate.samples, 50u);
+  EXPECT_NEAR(estimate.effective_samples, 50.0, 1e-9);
+  EXPECT_TRUE(estimate.converged);
+  EXPECT_TRUE(fusion.converged(7));
+}
+
+TEST(PoseFusion, NeedsTheMinimumSamplesToConverge) {
+  PoseFusion::Params params;
+  params.min_samples = 5;
+  PoseFusion fusion(params);
+  for (int i = 0; i < 4; i++) {
+    fusion.add(3, 1.0, 2.0, 0.0);
+    EXPECT_FALSE(fusion.converged(3));
+  }
+  fusion.add(3, 1.0, 2.0, 0.0);
+  EXPECT_TRUE(fusion.converged(3));
+}
+
+TEST(PoseFusion, GateRejectsOutliersOnceWarm) {
+  PoseFusion fusion;
+  NoisyMarker marker(2);
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(marker.add_to(fusion, 1));
+  }
+  // Far in Mahalanobis distance, then off in yaw only.
+  EXPECT_FALSE(fusion.add(1, 1.5, 2.0, 0.3));
+  EXPECT_FALSE(fusion.add(1, 1.0, 2.0, 0.3 + 1.0));
+  Se2Estimate estimate;
+  ASSERT_TRUE(fusion.estimate(1, estimate));
+  EXPECT_EQ(estimate.rejected, 2u);
+  EXPECT_EQ(estimate.samples, 20u);
+  EXPECT_NEAR(estimate.x, 1.0, 0.01);
+  EXPECT_TRUE(estimate.converged);
+  // An inlier is still accepted after the outliers.
+  EXPECT_TRUE(fusion.add(1, 1.0, 2.0, 0.3));
+}
+
+TEST(PoseFusion, AcceptsEverythingBeforeTheMinimumSamples) {
+  PoseFusion::Params params;
+  params.min_samples = 5;
+  PoseFusion fusion(params);
+  EXPECT_TRUE(fusion.add(2, 0.0, 0.0, 0.0));
+  EXPECT_TRUE(fusion.add(2, 3.0, 0.0, 0.0));
+}
+
+TEST(PoseFusion, RestartsAfterConsecutiveRejects) {
+  PoseFusion::Params params;
+  params.reset_after_rejects = 3;
+  PoseFusion fusion(params);
+  for (int i = 0; i < 10; i++) {
+    fusion.add(4, 0.0, 0.0, 0.0);
+  }
+  // The first samples were wrong, the marker is really at (2, 0).
+  EXPECT_FALSE(fusion.add(4, 2.0, 0.0, 0.0));
+  EXPECT_FALSE(fusion.add(4, 2.0, 0.0, 0.0));
+  EXPECT_TRUE(fusion.add(4, 2.0, 0.0, 0.0));
+  for (int i = 0; i < 10; i++) {
+    fusion.add(4, 2.0, 0.0, 0.0);
+  }
+  Se2Estimate estimate;
+  ASSERT_TRUE(fusion.estimate(4, estimate));
+  EXPECT_NEAR(estimate.x, 2.0, 1e-9);
+  EXPECT_EQ(estimate.samples, 11u);
+  EXPECT_TRUE(estimate.converged);
+}
+
+TEST(PoseFusion, WeightsPullTheMean) {
+  PoseFusion fusion;
+  fusion.add(5, 0.0, 0.0, 0.0, 3.0);
+  fusion.add(5, 1.0, 0.0, 0.0, 1.0);
+  Se2Estimate estimate;
+  ASSERT_TRUE(fusion.estimate(5, estimate));
+  EXPECT_NEAR(estimate.x, 0.25, 1e-12);
+  // Weights 3 and 1 are worth 16 / 10 equally weighted samples.
+  EXPECT_NEAR(estimate.effective_samples, 1.6, 1e-12);
+}
+
+TEST(PoseFusion, AveragesYawAcrossTheWrap) {
+  PoseFusion fusion;
+  fusion.add(6, 0.0, 0.0, M_PI - 0.1);
+  fusion.add(6, 0.0, 0.0, -M_PI + 0.1);
+  Se2Estimate estimate;
+  ASSERT_TRUE(fusion.estimate(6, estimate));
+  EXPECT_NEAR(std::fabs(estimate.yaw), M_PI, 1e-9);
+}
+
+TEST(PoseFusion, KeepsMarkersApart) {
+  PoseFusion fusion;
+  fusion.add(1000000, 1.0, 1.0, 0.0);
+  fusion.add(3, 5.0, 5.0, 0.0);
+  Se2Estimate estimate;
+  ASSERT_TRUE(fusion.estimate(1000000, estimate));
+  EXPECT_DOUBLE_EQ(estimate.x, 1.0);
+  ASSERT_TRUE(fusion.estimate(3, estimate));
+  EXPECT_DOUBLE_EQ(estimate.x, 5.0);
+  ASSERT_EQ(fusion.fiducial_ids().size(), 2u);
+  EXPECT_EQ(fusion.fiducial_ids()[0], 1000000);
+  EXPECT_FALSE(fusion.add(-1, 0.0, 0.0, 0.0));
+  EXPECT_FALSE(fusion.add(3, 0.0, 0.0, 0.0, 0.0));
+}
+
+TEST(PoseFusion, RestoresAnEstimate) {
+  PoseFusion source;
+  NoisyMarker marker(3);
+  for (int i = 0; i < 30; i++) {
+    marker.add_to(source, 9);
+  }
+  Se2Estimate saved;
+  ASSERT_TRUE(source.estimate(9, saved));
+  PoseFusion restored;
+  restored.restore(saved);
+  Se2Estimate estimate;
+  ASSERT_TRUE(restored.estimate(9, estimate));
+  EXPECT_NEAR(estimate.x, saved.x, 1e-12);
+  EXPECT_NEAR(estimate.y, saved.y, 1e-12);
+  EXPECT_NEAR(estimate.yaw, saved.yaw, 1e-9);
+  EXPECT_NEAR(estimate.yaw_std, saved.yaw_std, 1e-9);
+  EXPECT_EQ(estimate.converged, saved.converged);
+  restored.reset(9);
+  EXPECT_FALSE(restored.estimate(9, estimate));
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
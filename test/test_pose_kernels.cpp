@@ -0,0 +1,114 @@
+/**
+ * @file test_pose_kernels.cpp
+ * @brief Unit tests of the batch marker localization against the tf2 composition it replaces.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <geometry_msgs/Transform.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2_ros/buffer.h>
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+#include "final_project/marker_localizer.h"
+#include "final_project/pose_kernels.h"
+
+namespace final_project {
+namespace {
+
+// Most markers of one image, as in the mission.
+constexpr std::size_t kMarkers = 8;
+constexpr double kOffset = 0.4;
+constexpr double kTolerance = 1e-9;
+
+// A position in a box and a uniform rotation.
+geometry_msgs::Transform random_transform(std::mt19937 &rng, double extent, double z) {
+  std::uniform_real_distribution<double> position(-extent, extent);
+  std::normal_distribution<double> component(0.0, 1.0);
+  tf2::Quaternion rotation(component(rng), component(rng), component(rng), component(rng));
+  rotation.normalize();
+  geometry_msgs::Transform transform;
+  transform.translation.x = position(rng);
+  transform.translation.y = position(rng);
+  transform.translation.z = z + position(rng);
+  transform.rotation.x = rotation.x();
+  transform.rotation.y = rotation.y();
+  transform.rotation.z = rotation.z();
+  transform.rotation.w = rotation.w();
+  return transform;
+}
+
+double yaw_difference(double a, double b) { return std::fabs(std::remainder(a - b, 2 * M_PI)); }
+
+TEST(PoseKernels, BatchAgreesWithTf2) {
+  // The tf2 path of MarkerLocalizer::compose(), the buffer is never looked up.
+  const tf2_ros::Buffer buffer;
+  const MarkerLocalizer localizer(buffer, "map", "camera", kOffset);
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<std::size_t> marker_count(1, kMarkers);
+  for (int image = 0; image < 2000; image++) {
+    const geometry_msgs::Transform map_to_camera = random_transform(rng, 5.0, 0.3);
+    geometry_msgs::Transform markers[kMarkers];
+    MarkerBatch<kMarkers> batch;
+    const std::size_t count = marker_count(rng);
+    for (std::size_t i = 0; i < count; i++) {
+      markers[i] = random_transform(rng, 1.0, 2.0);
+      ASSERT_EQ(batch.push(to_pose3(markers[i])), i);
+    }
+    PlanarPose goals[kMarkers];
+    ASSERT_EQ(localize_markers(to_pose3(map_to_camera), batch, kOffset, goals), count);
+    for (std::size_t i = 0; i < count; i++) {
+      const geometry_msgs::Transform map_to_goal = localizer.compose(map_to_camera, markers[i]);
+      EXPECT_NEAR(goals[i].x, map_to_goal.translation.x, kTolerance) << "image " << image << ", marker " << i;
+      EXPECT_NEAR(goals[i].y, map_to_goal.translation.y, kTolerance) << "image " << image << ", marker " << i;
+      EXPECT_LE(yaw_difference(goals[i].yaw, MarkerLocalizer::facing_yaw(map_to_goal)), kTolerance)
+          << "image " << image << ", marker " << i;
+    }
+  }
+}
+
+TEST(PoseKernels, ScalarPathAgreesWithTf2) {
+  const tf2_ros::Buffer buffer;
+  const MarkerLocalizer localizer(buffer, "map", "camera", kOffset);
+  std::mt19937 rng(2);
+  for (int i = 0; i < 2000; i++) {
+    const geometry_msgs::Transform map_to_camera = random_transform(rng, 5.0, 0.3);
+    const geometry_msgs::Transform camera_to_marker = random_transform(rng, 1.0, 2.0);
+    const geometry_msgs::Transform map_to_goal = localizer.compose(map_to_camera, camera_to_marker);
+    const PlanarPose goal =
+        project_facing(offset_along_z(compose(to_pose3(map_to_camera), to_pose3(camera_to_marker)), kOffset));
+    EXPECT_NEAR(goal.x, map_to_goal.translation.x, kTolerance);
+    EXPECT_NEAR(goal.y, map_to_goal.translation.y, kTolerance);
+    EXPECT_LE(yaw_difference(goal.yaw, MarkerLocalizer::facing_yaw(map_to_goal)), kTolerance);
+  }
+}
+
+TEST(PoseKernels, FullBatchIgnoresFurtherMarkers) {
+  MarkerBatch<2> batch;
+  Pose3 marker;
+  marker.translation.z = 1.0;
+  EXPECT_EQ(batch.push(marker), 0u);
+  EXPECT_EQ(batch.push(marker), 1u);
+  EXPECT_EQ(batch.push(marker), 2u);
+  EXPECT_EQ(batch.count, 2u);
+  // A marker straight ahead of a camera at the origin, its follower location is on the optical axis too.
+  PlanarPose goals[2];
+  EXPECT_EQ(localize_markers(Pose3(), batch, kOffset, goals), 2u);
+  EXPECT_NEAR(goals[1].x, 0.0, kTolerance);
+  EXPECT_NEAR(goals[1].y, 0.0, kTolerance);
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,208 @@
+/**
+ * @file test_route_planner.cpp
+ * @brief Unit tests of the ordering of the goals, against the brute force on small instances.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "final_project/route_planner.h"
+
+namespace final_project {
+namespace {
+
+// Euclidean costs between random points of a 10 m square.
+std::vector<double> random_points(int n, std::mt19937 &rng) {
+  std::uniform_real_distribution<double> coordinate(0.0, 10.0);
+  std::vector<double> x(n), y(n);
+  for (int i = 0; i < n; i++) {
+    x[i] = coordinate(rng);
+    y[i] = coordinate(rng);
+  }
+  std::vector<double> cost(n * n);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      cost[i * n + j] = std::hypot(x[i] - x[j], y[i] - y[j]);
+    }
+  }
+  return cost;
+}
+
+// Random asymmetric costs, as the path lengths of a map with one-way doors would be.
+std::vector<double> random_costs(int n, std::mt19937 &rng) {
+  std::uniform_real_distribution<double> leg(1.0, 20.0);
+  std::vector<double> cost(n * n, 0.0);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      if (i != j) {
+        cost[i * n + j] = leg(rng);
+      }
+    }
+  }
+  return cost;
+}
+
+// Cheapest route over every permutation of the visited nodes.
+double brute_force(const std::vector<double> &cost, int n, int start, int end) {
+  std::vector<int> visit;
+  for (int i = 0; i < n; i++) {
+    if (i != start && i != end) {
+      visit.push_back(i);
+    }
+  }
+  double best = std::numeric_limits<double>::infinity();
+  do {
+    std::vector<int> route = visit;
+    if (end >= 0) {
+      route.push_back(end);
+    }
+    best = std::min(best, route_cost(cost, n, start, route));
+  } while (std::next_permutation(visit.begin(), visit.end()));
+  return best;
+}
+
+// Checks that a route visits every node but 'start' once, 'end' last.
+void expect_valid(const std::vector<int> &route, int n, int start, int end) {
+  std::vector<int> seen(n, 0);
+  for (int node : route) {
+    ASSERT_GE(node, 0);
+    ASSERT_LT(node, n);
+    seen[node]++;
+  }
+  for (int i = 0; i < n; i++) {
+    if (i == start && i != end) {
+      EXPECT_EQ(seen[i], 0) << "node " << i;
+    } else {
+      EXPECT_EQ(seen[i], 1) << "node " << i;
+    }
+  }
+  if (end >= 0) {
+    ASSERT_FALSE(route.empty());
+    EXPECT_EQ(route.back(), end);
+  }
+}
+
+TEST(RoutePlanner, HeldKarpMatchesBruteForceOnRoundTrips) {
+  std::mt19937 rng(1);
+  for (int n = 2; n <= 8; n++) {
+    for (int trial = 0; trial < 5; trial++) {
+      const std::vector<double> cost = trial % 2 ? random_costs(n, rng) : random_points(n, rng);
+      const std::vector<int> route = plan_route(cost, n, 0, 0);
+      expect_valid(route, n, 0, 0);
+      EXPECT_NEAR(route_cost(cost, n, 0, route), brute_force(cost, n, 0, 0), 1e-9) << "n " << n;
+    }
+  }
+}
+
+TEST(RoutePlanner, HeldKarpMatchesBruteForceOnOpenRoutes) {
+  std::mt19937 rng(2);
+  for (int n = 2; n <= 8; n++) {
+    for (int trial = 0; trial < 5; trial++) {
+      const std::vector<double> cost = trial % 2 ? random_costs(n, rng) : random_points(n, rng);
+      const int start = trial % n;
+      const std::vector<int> route = plan_route(cost, n, start, -1);
+      expect_valid(route, n, start, -1);
+      EXPECT_NEAR(route_cost(cost, n, start, route), brute_force(cost, n, start, -1), 1e-9) << "n " << n;
+    }
+  }
+}
+
+TEST(RoutePlanner, HeldKarpMatchesBruteForceWithAnotherEnd) {
+  std::mt19937 rng(3);
+  for (int n = 3; n <= 8; n++) {
+    for (int trial = 0; trial < 5; trial++) {
+      const std::vector<double> cost = trial % 2 ? random_costs(n, rng) : random_points(n, rng);
+      const std::vector<int> route = plan_route(cost, n, 0, n - 1);
+      expect_valid(route, n, 0, n - 1);
+      EXPECT_NEAR(route_cost(cost, n, 0, route), brute_force(cost, n, 0, n - 1), 1e-9) << "n " << n;
+    }
+  }
+}
+
+TEST(RoutePlanner, HandlesTheTrivialRoutes) {
+  const std::vector<double> one(1, 0.0);
+  EXPECT_TRUE(plan_route(one, 1, 0, -1).empty());
+  EXPECT_EQ(plan_route(one, 1, 0, 0), std::vector<int>{0});
+  const std::vector<double> two = {0.0, 3.0, 4.0, 0.0};
+  EXPECT_EQ(plan_route(two, 2, 0, 0), (std::vector<int>{1, 0}));
+  EXPECT_DOUBLE_EQ(route_cost(two, 2, 0, plan_route(two, 2, 0, 0)), 7.0);
+}
+
+TEST(RoutePlanner, TwoOptIsNeverBelowTheOptimumNorAboveTheNearestNeighbour) {
+  std::mt19937 rng(4);
+  for (int n = 4; n <= 8; n++) {
+    for (int trial = 0; trial < 5; trial++) {
+      const std::vector<double> cost = random_points(n, rng);
+      // An exact limit of zero forces the heuristic.
+      const std::vector<int> route = plan_route(cost, n, 0, 0, 0);
+      expect_valid(route, n, 0, 0);
+      std::vector<int> greedy;
+      std::vector<bool> visited(n, false);
+      visited[0] = true;
+      for (int current = 0, k = 1; k < n; k++) {
+        int next = -1;
+        for (int j = 0; j < n; j++) {
+          if (!visited[j] && (next < 0 || cost[current * n + j] < cost[current * n + next])) {
+            next = j;
+          }
+        }
+        visited[next] = true;
+        greedy.push_back(next);
+        current = next;
+      }
+      greedy.push_back(0);
+      const double total = route_cost(cost, n, 0, route);
+      EXPECT_GE(total + 1e-9, brute_force(cost, n, 0, 0));
+      EXPECT_LE(total, route_cost(cost, n, 0, greedy) + 1e-9);
+    }
+  }
+}
+
+TEST(RoutePlanner, TwoOptUncrossesPointsInConvexPosition) {
+  // Points on a circle in shuffled order, a crossing-free round trip is the optimal one, the polygon.
+  constexpr int kPoints = 30;
+  std::vector<int> angle_of(kPoints);
+  for (int i = 0; i < kPoints; i++) {
+    angle_of[i] = i;
+  }
+  std::mt19937 rng(5);
+  std::shuffle(angle_of.begin() + 1, angle_of.end(), rng);
+  std::vector<double> cost(kPoints * kPoints);
+  for (int i = 0; i < kPoints; i++) {
+    for (int j = 0; j < kPoints; j++) {
+      const double a = 2 * M_PI * angle_of[i] / kPoints;
+      const double b = 2 * M_PI * angle_of[j] / kPoints;
+      cost[i * kPoints + j] = std::hypot(std::cos(a) - std::cos(b), std::sin(a) - std::sin(b));
+    }
+  }
+  const std::vector<int> route = plan_route(cost, kPoints, 0, 0);
+  expect_valid(route, kPoints, 0, 0);
+  EXPECT_NEAR(route_cost(cost, kPoints, 0, route), 2 * kPoints * std::sin(M_PI / kPoints), 1e-9);
+}
+
+TEST(RoutePlanner, TwoOptKeepsAValidOpenRoute) {
+  std::mt19937 rng(6);
+  const int n = 40;
+  const std::vector<double> cost = random_points(n, rng);
+  const std::vector<int> route = plan_route(cost, n, 5, -1);
+  expect_valid(route, n, 5, -1);
+  const std::vector<int> ended = plan_route(cost, n, 5, 7);
+  expect_valid(ended, n, 5, 7);
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,104 @@
+/**
+ * @file test_spsc_queue.cpp
+ * @brief Unit tests of the single-producer single-consumer queue handing detections to the localizer.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "final_project/spsc_queue.h"
+
+namespace final_project {
+namespace {
+
+TEST(SpscQueue, PopsInPushOrder) {
+  SpscQueue<int, 8> queue;
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(queue.try_push(i));
+  }
+  EXPECT_FALSE(queue.empty());
+  int item = -1;
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(queue.try_pop(item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_FALSE(queue.try_pop(item));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueue, RejectsAndCountsWhenFull) {
+  SpscQueue<int, 4> queue;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.try_push(i));
+  }
+  EXPECT_FALSE(queue.try_push(4));
+  EXPECT_FALSE(queue.try_push(5));
+  EXPECT_EQ(queue.dropped(), 2u);
+  // The oldest items are kept, not overwritten.
+  int item = -1;
+  ASSERT_TRUE(queue.try_pop(item));
+  EXPECT_EQ(item, 0);
+  EXPECT_TRUE(queue.try_push(6));
+  for (int expected : {1, 2, 3, 6}) {
+    ASSERT_TRUE(queue.try_pop(item));
+    EXPECT_EQ(item, expected);
+  }
+}
+
+TEST(SpscQueue, WrapsAroundManyTimes) {
+  SpscQueue<int, 4> queue;
+  int item = -1;
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(queue.try_push(i));
+    ASSERT_TRUE(queue.try_push(i + 1));
+    ASSERT_TRUE(queue.try_pop(item));
+    EXPECT_EQ(item, i);
+    ASSERT_TRUE(queue.try_pop(item));
+    EXPECT_EQ(item, i + 1);
+  }
+  EXPECT_EQ(queue.dropped(), 0u);
+}
+
+TEST(SpscQueue, LosesNothingAcrossThreads) {
+  constexpr std::uint64_t kItems = 200000;
+  SpscQueue<std::uint64_t, 64> queue;
+  std::thread producer([&queue]() {
+    for (std::uint64_t i = 0; i < kItems; i++) {
+      // Retry instead of dropping, so every item must come out.
+      while (!queue.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::vector<std::uint64_t> received;
+  received.reserve(kItems);
+  std::uint64_t item = 0;
+  while (received.size() < kItems) {
+    if (queue.try_pop(item)) {
+      received.push_back(item);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_FALSE(queue.try_pop(item));
+  for (std::uint64_t i = 0; i < kItems; i++) {
+    ASSERT_EQ(received[i], i);
+  }
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
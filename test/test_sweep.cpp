@@ -0,0 +1,121 @@
+/**
+ * @file test_sweep.cpp
+ * @brief Unit tests of the reports of a sweep, one row per job with a summary of its trials.
+ * @version 0.1
+ * @date 2021-12-15
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "final_project/sweep.h"
+
+namespace final_project {
+namespace {
+
+// A file of the temporary directory, removed when the test ends.
+class TempFile {
+ public:
+  explicit TempFile(const std::string &name)
+      : path_("/tmp/final_project_test_sweep_" + std::to_string(getpid()) + "_" + name) {}
+  ~TempFile() { std::remove(path_.c_str()); }
+  const std::string &path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+std::string read_file(const std::string &path) {
+  std::ifstream in(path);
+  std::ostringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+BenchTrial trial(bool completed, double mission_time, std::size_t markers) {
+  BenchTrial t;
+  t.completed = completed;
+  t.mission_time = mission_time;
+  t.markers = markers;
+  return t;
+}
+
+// Two completed trials out of three, the mission time averages the completed ones, the markers all of them.
+std::vector<SweepResult> results() {
+  SweepResult done;
+  done.job = "world_a";
+  done.exit_status = 0;
+  done.wall_time = 12.5;
+  done.report = "/sweep/world_a/bench.csv";
+  done.trials = {trial(true, 100, 4), trial(false, 900, 1), trial(true, 200, 4)};
+  SweepResult stopped;
+  stopped.job = "world_\"b\"";
+  stopped.timed_out = true;
+  stopped.wall_time = 3600;
+  stopped.report = "/sweep/world_b/bench.csv";
+  return {done, stopped};
+}
+
+TEST(Sweep, CsvHasOneSummaryRowPerJob) {
+  TempFile file("sweep.csv");
+  ASSERT_TRUE(write_sweep_csv(file.path(), results()));
+  EXPECT_EQ(read_file(file.path()),
+            "job,exit_status,timed_out,wall_time,trials,completed,mission_time,markers,report\n"
+            "world_a,0,0,12.5000,3,2,150.0000,3.0000,/sweep/world_a/bench.csv\n"
+            "world_\"b\",-1,1,3600.0000,0,0,0.0000,0.0000,/sweep/world_b/bench.csv\n");
+}
+
+TEST(Sweep, JsonHasTheFieldsOfTheCsv) {
+  TempFile file("sweep.json");
+  ASSERT_TRUE(write_sweep_json(file.path(), results()));
+  EXPECT_EQ(read_file(file.path()),
+            "[\n"
+            "  {\"job\": \"world_a\", \"exit_status\": 0, \"timed_out\": false, \"wall_time\": 12.5000, "
+            "\"trials\": 3, \"completed\": 2, \"mission_time\": 150.0000, \"markers\": 3.0000, "
+            "\"report\": \"/sweep/world_a/bench.csv\"},\n"
+            "  {\"job\": \"world_\\\"b\\\"\", \"exit_status\": -1, \"timed_out\": true, \"wall_time\": 3600.0000, "
+            "\"trials\": 0, \"completed\": 0, \"mission_time\": 0.0000, \"markers\": 0.0000, "
+            "\"report\": \"/sweep/world_b/bench.csv\"}\n"
+            "]\n");
+}
+
+TEST(Sweep, NoCompletedTrialHasNoMissionTime) {
+  SweepResult failed;
+  failed.job = "world_c";
+  failed.trials = {trial(false, 900, 2), trial(false, 900, 3)};
+  TempFile file("failed.csv");
+  ASSERT_TRUE(write_sweep_csv(file.path(), {failed}));
+  EXPECT_NE(read_file(file.path()).find("\nworld_c,-1,0,0.0000,2,0,0.0000,2.5000,\n"), std::string::npos);
+}
+
+TEST(Sweep, EmptySweepWritesTheHeaderOnly) {
+  TempFile csv("empty.csv");
+  TempFile json("empty.json");
+  ASSERT_TRUE(write_sweep_csv(csv.path(), {}));
+  ASSERT_TRUE(write_sweep_json(json.path(), {}));
+  EXPECT_EQ(read_file(csv.path()),
+            "job,exit_status,timed_out,wall_time,trials,completed,mission_time,markers,report\n");
+  EXPECT_EQ(read_file(json.path()), "[\n]\n");
+}
+
+TEST(Sweep, UnwritablePathFails) {
+  EXPECT_FALSE(write_sweep_csv("/nonexistent/sweep.csv", results()));
+  EXPECT_FALSE(write_sweep_json("/nonexistent/sweep.json", results()));
+}
+
+}  // namespace
+}  // namespace final_project
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}